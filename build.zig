@@ -73,6 +73,11 @@ pub fn build(b: *std.Build) void {
     const core_build_options = b.addOptions();
     core_build_options.addOption([]const u8, "app_version", app_version);
 
+    // Log calls below this level compile to nothing; release builds drop trace by default
+    const default_min_log_level: []const u8 = if (optimize == .Debug) "trace" else "debug";
+    const min_log_level = b.option([]const u8, "min-log-level", "Lowest log level compiled in: trace, debug, info, warn, error, fatal (default: trace for Debug, debug otherwise)") orelse default_min_log_level;
+    core_build_options.addOption([]const u8, "min_log_level", min_log_level);
+
     // build_options: for backends and integrations (feature flags)
     const build_options = b.addOptions();
 
@@ -158,6 +163,8 @@ pub fn build(b: *std.Build) void {
         },
     });
     integrations_mod.addOptions("build_options", build_options);
+    // proxmox-lxc drives lifecycle through the REST client when configured
+    backends_mod.addImport("integrations", integrations_mod);
 
     var libcrun_lib: ?*std.Build.Step.Compile = null;
 
@@ -0,0 +1,374 @@
+const std = @import("std");
+const core = @import("core");
+const integrations = @import("integrations");
+
+/// A pct invocation as the equivalent REST call; strings live in the arena
+pub const ApiCall = struct {
+    arena: std.heap.ArenaAllocator,
+    method: std.http.Method,
+    /// Under /api2/json; DELETE parameters are already in the query string
+    path: []const u8,
+    /// x-www-form-urlencoded body, empty when there is none
+    form: []const u8,
+
+    pub fn deinit(self: *ApiCall) void {
+        self.arena.deinit();
+    }
+};
+
+/// pct subcommands with a REST equivalent; everything else stays on pct
+const Verb = enum { create, clone, template, start, stop, destroy, set };
+
+/// Translate `pct <verb> <vmid> ... --key value` into its REST call on
+/// `node`; null for verbs that have no equivalent here
+///
+/// pct options and API parameters share names, so a compiled `pct create`
+/// argv maps one to one onto POST /nodes/{node}/lxc. Needs the Proxmox
+/// API integration, whose client does the form encoding.
+pub fn translate(allocator: std.mem.Allocator, node: []const u8, argv: []const []const u8) !?ApiCall {
+    const writeFormParam = integrations.proxmox_api.client.writeFormParam;
+    if (argv.len < 3 or !std.mem.eql(u8, argv[0], "pct")) return null;
+    const verb = std.meta.stringToEnum(Verb, argv[1]) orelse return null;
+    const vmid = std.fmt.parseInt(u32, argv[2], 10) catch return core.Error.InvalidInput;
+
+    var call = ApiCall{ .arena = std.heap.ArenaAllocator.init(allocator), .method = .POST, .path = "", .form = "" };
+    errdefer call.deinit();
+    const arena = call.arena.allocator();
+
+    var form = std.Io.Writer.Allocating.init(arena);
+    var vmid_buf: [16]u8 = undefined;
+    const vmid_str = std.fmt.bufPrint(&vmid_buf, "{d}", .{vmid}) catch unreachable;
+    var options = argv[3..];
+
+    switch (verb) {
+        .create => {
+            if (options.len == 0) return core.Error.InvalidInput;
+            try writeFormParam(&form.writer, "vmid", vmid_str);
+            try writeFormParam(&form.writer, "ostemplate", options[0]);
+            options = options[1..];
+            call.path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc", .{node});
+        },
+        .clone => {
+            if (options.len == 0) return core.Error.InvalidInput;
+            const newid = std.fmt.parseInt(u32, options[0], 10) catch return core.Error.InvalidInput;
+            var newid_buf: [16]u8 = undefined;
+            try writeFormParam(&form.writer, "newid", std.fmt.bufPrint(&newid_buf, "{d}", .{newid}) catch unreachable);
+            options = options[1..];
+            call.path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc/{d}/clone", .{ node, vmid });
+        },
+        .template => call.path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc/{d}/template", .{ node, vmid }),
+        .start, .stop => call.path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc/{d}/status/{s}", .{ node, vmid, @tagName(verb) }),
+        .destroy => {
+            call.method = .DELETE;
+            call.path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc/{d}", .{ node, vmid });
+        },
+        .set => {
+            call.method = .PUT;
+            call.path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc/{d}/config", .{ node, vmid });
+        },
+    }
+
+    var i: usize = 0;
+    while (i < options.len) : (i += 1) {
+        const flag = options[i];
+        if (!std.mem.startsWith(u8, flag, "--") or flag.len == 2) return core.Error.InvalidInput;
+        // Bare flags such as `--purge` are booleans
+        const has_value = i + 1 < options.len and !std.mem.startsWith(u8, options[i + 1], "--");
+        try writeFormParam(&form.writer, flag[2..], if (has_value) options[i + 1] else "1");
+        if (has_value) i += 1;
+    }
+
+    if (call.method == .DELETE) {
+        if (form.written().len > 0) call.path = try std.fmt.allocPrint(arena, "{s}?{s}", .{ call.path, form.written() });
+    } else {
+        call.form = form.written();
+    }
+    return call;
+}
+
+/// What `ApiLifecycle.submit` got back for a call
+pub const Submitted = union(enum) {
+    /// Refused, or finished without a worker task; looks like pct's result
+    done: core.exec.Result,
+    /// UPID of the worker task the call started, owned by the caller
+    task: []u8,
+};
+
+/// Called once per task of a `TaskGroup` as it ends, with its index in
+/// `add` order and a pct-like result the callee owns
+pub const GroupDoneFn = *const fn (ctx: ?*anyopaque, index: usize, result: core.exec.Result) void;
+
+/// LXC lifecycle over the Proxmox REST API
+///
+/// `run` stands in for forking pct: the call is sent over a connection of
+/// the client shared by every driver in the process, and the worker task
+/// it starts is awaited on its UPID. The result looks like pct's, so the
+/// driver's error mapping applies unchanged. `submit` sends the call
+/// without waiting, for callers that await many tasks in a `TaskGroup`.
+pub const ApiLifecycle = if (integrations.isProxmoxApiEnabled()) struct {
+    const Self = @This();
+    const api = integrations.proxmox_api;
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    client: *api.client.ProxmoxApiClient,
+    node: []const u8,
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, endpoint: core.types.ProxmoxApiEndpoint) !Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .client = try sharedClient(endpoint),
+            .node = endpoint.node,
+        };
+    }
+
+    /// Run `argv` through the API; null when it has no REST equivalent
+    pub fn run(self: *Self, argv: []const []const u8) !?core.exec.Result {
+        const upid = switch ((try self.submit(argv)) orelse return null) {
+            .done => |done| return done,
+            .task => |task| task,
+        };
+        defer self.allocator.free(upid);
+
+        var group = TaskGroup.init(self);
+        defer group.deinit();
+        try group.add(upid, argv[2]);
+        var result: ?core.exec.Result = null;
+        group.wait(&result, storeResult);
+        return result.?;
+    }
+
+    fn storeResult(ctx: ?*anyopaque, index: usize, result: core.exec.Result) void {
+        _ = index;
+        const slot: *?core.exec.Result = @ptrCast(@alignCast(ctx.?));
+        slot.* = result;
+    }
+
+    /// Send `argv` without waiting for the worker task it starts; null
+    /// when it has no REST equivalent
+    pub fn submit(self: *Self, argv: []const []const u8) !?Submitted {
+        var call = (try translate(self.allocator, self.node, argv)) orelse return null;
+        defer call.deinit();
+        const started = std.time.Instant.now() catch null;
+
+        var response = if (call.form.len > 0)
+            try self.client.makeRequestWithContentType(call.method, call.path, call.form, "application/x-www-form-urlencoded")
+        else
+            try self.client.makeRequest(call.method, call.path);
+        defer response.deinit();
+
+        if (response.success) {
+            if (api.tasks.responseUpid(&response)) |upid| return .{ .task = try self.allocator.dupe(u8, upid) };
+            return .{ .done = try self.pctResult(null, started) };
+        }
+
+        // Keep Proxmox's own words ("already exists", "does not exist", lock
+        // errors): mapPctError matches on them just as on pct's stderr
+        const reason = response.message orelse "";
+        const errors = if (response.data) |data| (if (data == .object) data.object.get("errors") else null) else null;
+        const failure = if (errors) |e|
+            try std.fmt.allocPrint(self.allocator, "HTTP {d}: {s} {f}", .{ response.status_code, reason, std.json.fmt(e, .{}) })
+        else
+            try std.fmt.allocPrint(self.allocator, "HTTP {d}: {s}", .{ response.status_code, reason });
+        if (self.logger) |log| log.debug("pct {s} via API failed: {s}", .{ argv[1], failure }) catch {};
+        return .{ .done = try self.pctResult(failure, started) };
+    }
+
+    /// pct-like result; `failure` becomes stderr and is owned by it
+    fn pctResult(self: *Self, failure: ?[]u8, started: ?std.time.Instant) !core.exec.Result {
+        errdefer if (failure) |message| self.allocator.free(message);
+        const stdout = try self.allocator.alloc(u8, 0);
+        errdefer self.allocator.free(stdout);
+        return core.exec.Result{
+            .stdout = stdout,
+            .stderr = failure orelse try self.allocator.alloc(u8, 0),
+            .exit_code = if (failure != null) 1 else 0,
+            .status = .exited,
+            .duration_ns = if (started) |t| (std.time.Instant.now() catch t).since(t) else 0,
+        };
+    }
+
+    /// LXC and QEMU guests of every cluster node from one /cluster/resources
+    /// request; templates are left out, as `pct list` leaves them out
+    pub fn listGuests(self: *Self, allocator: std.mem.Allocator) ![]core.ContainerInfo {
+        var listing = try api.cluster.listGuests(self.client, self.allocator);
+        defer listing.deinit();
+
+        var containers = std.ArrayListUnmanaged(core.ContainerInfo){};
+        errdefer {
+            for (containers.items) |*c| c.deinit();
+            containers.deinit(allocator);
+        }
+        try containers.ensureTotalCapacity(allocator, listing.guests.len);
+
+        for (listing.guests) |guest| {
+            if (guest.template) continue;
+            var info = core.ContainerInfo{
+                .allocator = allocator,
+                .id = try std.fmt.allocPrint(allocator, "{d}", .{guest.vmid}),
+                .name = "",
+                .status = "",
+                .backend_type = "",
+            };
+            errdefer allocator.free(info.id);
+            info.name = try allocator.dupe(u8, guest.name);
+            errdefer allocator.free(info.name);
+            info.status = try allocator.dupe(u8, guest.status);
+            errdefer allocator.free(info.status);
+            info.backend_type = try allocator.dupe(u8, switch (guest.kind) {
+                .lxc => "proxmox-lxc",
+                .qemu => "vm",
+            });
+            errdefer allocator.free(info.backend_type);
+            info.runtime = try allocator.dupe(u8, "api");
+            errdefer allocator.free(info.runtime.?);
+            info.node = try allocator.dupe(u8, guest.node);
+            containers.appendAssumeCapacity(info);
+        }
+        return containers.toOwnedSlice(allocator);
+    }
+} else struct {
+    const Self = @This();
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, endpoint: core.types.ProxmoxApiEndpoint) !Self {
+        _ = allocator;
+        _ = logger;
+        _ = endpoint;
+        return error.ProxmoxApiDisabled;
+    }
+
+    pub fn run(self: *Self, argv: []const []const u8) !?core.exec.Result {
+        _ = self;
+        _ = argv;
+        return null;
+    }
+
+    pub fn submit(self: *Self, argv: []const []const u8) !?Submitted {
+        _ = self;
+        _ = argv;
+        return null;
+    }
+
+    pub fn listGuests(self: *Self, allocator: std.mem.Allocator) ![]core.ContainerInfo {
+        _ = self;
+        _ = allocator;
+        return error.ProxmoxApiDisabled;
+    }
+};
+
+/// Worker tasks of many submitted calls, awaited together
+///
+/// One `TaskTracker` loop polls them all, so a batch of N lifecycle calls
+/// needs one waiting thread rather than N.
+pub const TaskGroup = if (integrations.isProxmoxApiEnabled()) struct {
+    const Self = @This();
+    const api = integrations.proxmox_api;
+
+    lifecycle: *ApiLifecycle,
+    tracker: api.tasks.TaskTracker,
+    started: std.ArrayListUnmanaged(?std.time.Instant) = .{},
+    ctx: ?*anyopaque = null,
+    on_done: ?GroupDoneFn = null,
+
+    pub fn init(lifecycle: *ApiLifecycle) Self {
+        return Self{
+            .lifecycle = lifecycle,
+            .tracker = api.tasks.TaskTracker.init(lifecycle.allocator, lifecycle.client, .{}),
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.tracker.deinit();
+        self.started.deinit(self.lifecycle.allocator);
+    }
+
+    /// Await `upid` with the others; `label` names it in log lines and is not owned
+    pub fn add(self: *Self, upid: []const u8, label: []const u8) !void {
+        try self.started.append(self.lifecycle.allocator, std.time.Instant.now() catch null);
+        errdefer _ = self.started.pop();
+        try self.tracker.track(upid, label);
+    }
+
+    /// Poll until every task has ended, calling `on_done` for each as it does
+    pub fn wait(self: *Self, ctx: ?*anyopaque, on_done: GroupDoneFn) void {
+        self.ctx = ctx;
+        self.on_done = on_done;
+        self.tracker.wait(self, taskDone);
+    }
+
+    fn taskDone(ctx: ?*anyopaque, task: *const api.tasks.Task) void {
+        const self: *Self = @ptrCast(@alignCast(ctx.?));
+        const index = (@intFromPtr(task) - @intFromPtr(self.tracker.tasks.items.ptr)) / @sizeOf(api.tasks.Task);
+        const failure: ?[]u8 = if (task.outcome == .ok)
+            null
+        else
+            self.lifecycle.allocator.dupe(u8, task.exit_status orelse "task did not finish in time") catch null;
+        if (failure) |message| {
+            if (self.lifecycle.logger) |log| log.debug("API task {s} of {s} failed: {s}", .{ task.upid, task.label, message }) catch {};
+        }
+        // Out of memory for the message still reports the task as failed
+        const result = self.lifecycle.pctResult(failure, self.started.items[index]) catch core.exec.Result{
+            .stdout = &.{},
+            .stderr = &.{},
+            .exit_code = 1,
+            .status = .exited,
+            .duration_ns = 0,
+        };
+        self.on_done.?(self.ctx, index, result);
+    }
+} else struct {
+    const Self = @This();
+
+    pub fn init(lifecycle: *ApiLifecycle) Self {
+        _ = lifecycle;
+        return Self{};
+    }
+
+    pub fn deinit(self: *Self) void {
+        _ = self;
+    }
+
+    pub fn add(self: *Self, upid: []const u8, label: []const u8) !void {
+        _ = self;
+        _ = upid;
+        _ = label;
+        return error.ProxmoxApiDisabled;
+    }
+
+    pub fn wait(self: *Self, ctx: ?*anyopaque, on_done: GroupDoneFn) void {
+        _ = self;
+        _ = ctx;
+        _ = on_done;
+    }
+};
+
+const SharedClient = if (integrations.isProxmoxApiEnabled()) *integrations.proxmox_api.client.ProxmoxApiClient else void;
+
+/// Clients live for the whole process so their pooled connections outlast
+/// any one driver; one per endpoint
+var shared_mutex: std.Thread.Mutex = .{};
+var shared_clients: std.ArrayListUnmanaged(SharedClient) = .{};
+
+fn sharedClient(endpoint: core.types.ProxmoxApiEndpoint) !SharedClient {
+    const api = integrations.proxmox_api;
+    shared_mutex.lock();
+    defer shared_mutex.unlock();
+
+    for (shared_clients.items) |client| {
+        if (client.port == endpoint.port and std.mem.eql(u8, client.hosts[0], endpoint.host) and
+            std.mem.eql(u8, client.token, endpoint.token) and std.mem.eql(u8, client.node, endpoint.node)) return client;
+    }
+
+    const allocator = std.heap.smp_allocator;
+    const client = try api.client.ProxmoxApiClient.init(allocator, .{
+        .allocator = allocator,
+        .host = endpoint.host,
+        .port = endpoint.port,
+        .token = endpoint.token,
+        .node = endpoint.node,
+    });
+    errdefer client.deinit();
+    try shared_clients.append(allocator, client);
+    return client;
+}
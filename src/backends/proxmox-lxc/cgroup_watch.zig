@@ -0,0 +1,112 @@
+const std = @import("std");
+const pve_config = @import("pve_config.zig");
+const container_signal = @import("container_signal.zig");
+
+const linux = std.os.linux;
+
+/// Default time stop/kill wait for a container to exit
+pub const DEFAULT_STOP_TIMEOUT_MS: u32 = 30_000;
+
+/// Polling bounds for hosts where neither inotify nor pidfd works
+const MIN_BACKOFF_MS: u64 = 10;
+const MAX_BACKOFF_MS: u64 = 250;
+
+/// Block until the container's cgroup is empty or `timeout_ms` elapses.
+/// Returns true once the container has stopped, null if the cgroup cannot
+/// tell and the caller has to ask `pct status`.
+///
+/// cgroup v2 reports `populated 0` in cgroup.events and signals the change as a
+/// file modification, so an inotify watch wakes us the moment the last task
+/// exits. Where inotify is unavailable we hold a pidfd on the container's init
+/// instead, whose exit ends the container. Both cost no forks and no CPU while
+/// waiting; plain backoff polling remains only as a last resort.
+pub fn waitStopped(pve: *const pve_config.PveConfigReader, vmid: []const u8, timeout_ms: u32) !?bool {
+    switch (pve.runState(vmid)) {
+        .stopped => return true,
+        .unknown => return null,
+        .running => {},
+    }
+    const deadline = std.time.milliTimestamp() + timeout_ms;
+
+    if (try waitEvents(pve, vmid, deadline)) |stopped| return stopped;
+    if (try waitPidfd(pve, vmid, deadline)) |stopped| return stopped;
+    return waitBackoff(pve, vmid, deadline);
+}
+
+/// Once the cgroup has been seen running, LXC removing it means the
+/// container is gone
+fn isStopped(pve: *const pve_config.PveConfigReader, vmid: []const u8) bool {
+    return pve.runState(vmid) != .running;
+}
+
+/// null if cgroup.events cannot be watched
+fn waitEvents(pve: *const pve_config.PveConfigReader, vmid: []const u8, deadline: i64) !?bool {
+    var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+    const path = try std.fmt.bufPrint(&path_buf, "{s}/lxc/{s}/cgroup.events", .{ pve.cgroup_root, vmid });
+
+    const fd = std.posix.inotify_init1(linux.IN.CLOEXEC | linux.IN.NONBLOCK) catch return null;
+    defer std.posix.close(fd);
+    _ = std.posix.inotify_add_watch(fd, path, linux.IN.MODIFY | linux.IN.DELETE_SELF) catch |err| switch (err) {
+        // The cgroup was removed between the first check and now
+        error.FileNotFound => return isStopped(pve, vmid),
+        else => return null,
+    };
+
+    var events_buf: [4096]u8 align(@alignOf(linux.inotify_event)) = undefined;
+    while (true) {
+        // Checked after arming the watch so an exit in between is not missed
+        if (isStopped(pve, vmid)) return true;
+
+        const remaining = deadline - std.time.milliTimestamp();
+        if (remaining <= 0) return false;
+
+        var fds = [_]std.posix.pollfd{.{ .fd = fd, .events = std.posix.POLL.IN, .revents = 0 }};
+        if (try std.posix.poll(&fds, @intCast(@min(remaining, std.math.maxInt(i32)))) == 0) {
+            return isStopped(pve, vmid);
+        }
+        // Drain; the event contents do not matter, only that something changed
+        while (true) {
+            _ = std.posix.read(fd, &events_buf) catch |err| switch (err) {
+                error.WouldBlock => break,
+                else => return err,
+            };
+        }
+    }
+}
+
+/// null if init could not be found or opened as a pidfd
+fn waitPidfd(pve: *const pve_config.PveConfigReader, vmid: []const u8, deadline: i64) !?bool {
+    while (true) {
+        const remaining = deadline - std.time.milliTimestamp();
+        if (remaining <= 0) return false;
+        const pid = container_signal.initPid(pve, vmid) orelse return null;
+
+        const rc = linux.pidfd_open(pid, 0);
+        switch (std.posix.errno(rc)) {
+            .SUCCESS => {},
+            // Exited before we could open it; look at the cgroup again
+            .SRCH => continue,
+            else => return null,
+        }
+        const pidfd: std.posix.fd_t = @intCast(rc);
+        defer std.posix.close(pidfd);
+
+        // A pidfd polls readable once its process has exited
+        var fds = [_]std.posix.pollfd{.{ .fd = pidfd, .events = std.posix.POLL.IN, .revents = 0 }};
+        if (try std.posix.poll(&fds, @intCast(@min(remaining, std.math.maxInt(i32)))) == 0) {
+            return isStopped(pve, vmid);
+        }
+        if (isStopped(pve, vmid)) return true;
+    }
+}
+
+fn waitBackoff(pve: *const pve_config.PveConfigReader, vmid: []const u8, deadline: i64) bool {
+    var backoff_ms = MIN_BACKOFF_MS;
+    while (!isStopped(pve, vmid)) {
+        const remaining = deadline - std.time.milliTimestamp();
+        if (remaining <= 0) return false;
+        std.Thread.sleep(@min(backoff_ms, @as(u64, @intCast(remaining))) * std.time.ns_per_ms);
+        backoff_ms = @min(backoff_ms * 2, MAX_BACKOFF_MS);
+    }
+    return true;
+}
@@ -0,0 +1,186 @@
+const std = @import("std");
+const core = @import("core");
+const locked_index = @import("locked_index.zig");
+
+/// Hostname of a template's base container
+pub const HOSTNAME_PREFIX = "nexcage-base-";
+
+pub const Base = struct {
+    /// Template volume the base was unpacked from
+    template: []const u8,
+    vmid: u32,
+    created_at: i64,
+    /// Linked clones whose rootfs is a `zfs clone` of this base's snapshot
+    dependents: std.ArrayListUnmanaged(u32) = .{},
+
+    /// `<vmid>\t<created_at>\t<dep>,<dep>...\t<template>`
+    pub fn parseLine(arena: std.mem.Allocator, line: []const u8) !?Base {
+        var fields = std.mem.splitScalar(u8, line, '\t');
+        const vmid = std.fmt.parseInt(u32, fields.next() orelse return null, 10) catch return null;
+        const created_at = std.fmt.parseInt(i64, fields.next() orelse return null, 10) catch return null;
+        const deps = fields.next() orelse return null;
+        const template = fields.next() orelse return null;
+        if (template.len == 0) return null;
+
+        var base = Base{ .template = template, .vmid = vmid, .created_at = created_at };
+        var dep_it = std.mem.tokenizeScalar(u8, deps, ',');
+        while (dep_it.next()) |dep| {
+            try base.dependents.append(arena, std.fmt.parseInt(u32, dep, 10) catch continue);
+        }
+        return base;
+    }
+
+    pub fn writeLine(self: Base, allocator: std.mem.Allocator, out: *std.ArrayListUnmanaged(u8)) !void {
+        try out.print(allocator, "{d}\t{d}\t", .{ self.vmid, self.created_at });
+        for (self.dependents.items, 0..) |dep, i| {
+            if (i > 0) try out.append(allocator, ',');
+            try out.print(allocator, "{d}", .{dep});
+        }
+        try out.print(allocator, "\t{s}\n", .{self.template});
+    }
+};
+
+pub fn baseHostname(buf: []u8, vmid: u32) ![]const u8 {
+    return std.fmt.bufPrint(buf, HOSTNAME_PREFIX ++ "{d}", .{vmid});
+}
+
+/// Template base containers for ZFS linked clones
+///
+/// Each template is unpacked once into a container that is then converted
+/// with `pct template`, which snapshots its ZFS subvolume. New containers are
+/// `pct clone`s of that base, i.e. a `zfs clone` of the snapshot: O(1) in time
+/// and space instead of extracting the template again. ZFS refuses to
+/// destroy a snapshot with clones, so every clone is recorded as a dependent
+/// and a base is only collected once it has none left. The registry is a
+/// `LockedIndex` named `clone-bases`.
+pub const CloneBases = struct {
+    const Self = @This();
+    const Index = locked_index.LockedIndex(Base, "clone-bases", 4 * 1024 * 1024);
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    state_dir: []const u8,
+    store: Index,
+
+    pub const INDEX_NAME = Index.INDEX_NAME;
+    pub const LOCK_NAME = Index.LOCK_NAME;
+    /// Held while a base is built so concurrent creates unpack a template once
+    pub const BUILD_LOCK_NAME = "clone-bases-build.lock";
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .state_dir = state_dir,
+            .store = Index.init(allocator, state_dir),
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.store.deinit();
+    }
+
+    /// VMID of the base container for `template`, if one was built
+    pub fn lookup(self: *Self, template: []const u8) !?u32 {
+        var lock = try self.store.lock();
+        defer lock.close();
+        const index = self.find(template) orelse return null;
+        return self.store.records.items[index].vmid;
+    }
+
+    /// Record a base container that has been converted with `pct template`
+    pub fn register(self: *Self, template: []const u8, vmid: u32) !void {
+        if (template.len == 0 or std.mem.indexOfAny(u8, template, "\t\n\r") != null) return core.Error.InvalidInput;
+
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        if (self.find(template)) |index| {
+            self.store.records.items[index].vmid = vmid;
+        } else {
+            try self.store.records.append(self.store.recordAllocator(), .{
+                .template = try self.store.recordAllocator().dupe(u8, template),
+                .vmid = vmid,
+                .created_at = std.time.timestamp(),
+            });
+        }
+        try self.store.save();
+    }
+
+    /// Record that `clone` was cloned from the base of `template`
+    pub fn addDependent(self: *Self, template: []const u8, clone: u32) !void {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        const index = self.find(template) orelse return;
+        const base = &self.store.records.items[index];
+        for (base.dependents.items) |dep| {
+            if (dep == clone) return;
+        }
+        try base.dependents.append(self.store.recordAllocator(), clone);
+        try self.store.save();
+    }
+
+    /// Drop `clone` from whichever base it depends on
+    pub fn removeDependent(self: *Self, clone: u32) !void {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        for (self.store.records.items) |*base| {
+            for (base.dependents.items, 0..) |dep, i| {
+                if (dep != clone) continue;
+                _ = base.dependents.swapRemove(i);
+                try self.store.save();
+                return;
+            }
+        }
+    }
+
+    /// Remove bases without dependents whose template `isStale` reports as
+    /// gone, and return their VMIDs for the caller to destroy
+    pub fn collect(
+        self: *Self,
+        allocator: std.mem.Allocator,
+        context: anytype,
+        comptime isStale: fn (@TypeOf(context), []const u8) bool,
+    ) ![]u32 {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        var collected = std.ArrayListUnmanaged(u32){};
+        errdefer collected.deinit(allocator);
+        var i: usize = 0;
+        while (i < self.store.records.items.len) {
+            const base = self.store.records.items[i];
+            if (base.dependents.items.len == 0 and isStale(context, base.template)) {
+                try collected.append(allocator, base.vmid);
+                _ = self.store.records.orderedRemove(i);
+                if (self.logger) |log| log.info("Collecting clone base {d} of {s}", .{ base.vmid, base.template }) catch {};
+            } else i += 1;
+        }
+        if (collected.items.len > 0) try self.store.save();
+        return collected.toOwnedSlice(allocator);
+    }
+
+    /// Snapshot of the index; valid until the next call on this registry
+    pub fn list(self: *Self) ![]const Base {
+        var lock = try self.store.lock();
+        defer lock.close();
+        return self.store.records.items;
+    }
+
+    /// Blocks until no other process is building a base; close the returned file to unlock
+    pub fn lockBuild(self: *Self) !std.fs.File {
+        try std.fs.cwd().makePath(self.state_dir);
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const lock_path = try std.fmt.bufPrint(&path_buf, "{s}/{s}", .{ self.state_dir, BUILD_LOCK_NAME });
+        return std.fs.cwd().createFile(lock_path, .{ .truncate = false, .lock = .exclusive });
+    }
+
+    fn find(self: *const Self, template: []const u8) ?usize {
+        for (self.store.records.items, 0..) |base, i| {
+            if (std.mem.eql(u8, base.template, template)) return i;
+        }
+        return null;
+    }
+};
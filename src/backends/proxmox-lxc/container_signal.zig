@@ -0,0 +1,142 @@
+const std = @import("std");
+const pve_config = @import("pve_config.zig");
+
+const linux = std.os.linux;
+const SIG = std.posix.SIG;
+
+const SignalName = struct { name: []const u8, number: u8 };
+
+const SIGNAL_NAMES = [_]SignalName{
+    .{ .name = "HUP", .number = SIG.HUP },
+    .{ .name = "INT", .number = SIG.INT },
+    .{ .name = "QUIT", .number = SIG.QUIT },
+    .{ .name = "ABRT", .number = SIG.ABRT },
+    .{ .name = "KILL", .number = SIG.KILL },
+    .{ .name = "USR1", .number = SIG.USR1 },
+    .{ .name = "USR2", .number = SIG.USR2 },
+    .{ .name = "PIPE", .number = SIG.PIPE },
+    .{ .name = "ALRM", .number = SIG.ALRM },
+    .{ .name = "TERM", .number = SIG.TERM },
+    .{ .name = "CHLD", .number = SIG.CHLD },
+    .{ .name = "CONT", .number = SIG.CONT },
+    .{ .name = "STOP", .number = SIG.STOP },
+    .{ .name = "TSTP", .number = SIG.TSTP },
+    .{ .name = "WINCH", .number = SIG.WINCH },
+};
+
+/// Accepts "TERM", "SIGTERM", "term" or "15"
+pub fn parseSignal(signal: []const u8) ?u8 {
+    if (std.fmt.parseInt(u8, signal, 10)) |number| {
+        return if (number > 0 and number < 65) number else null;
+    } else |_| {}
+
+    var upper_buf: [16]u8 = undefined;
+    if (signal.len > upper_buf.len) return null;
+    const upper = std.ascii.upperString(&upper_buf, signal);
+    const name = if (std.mem.startsWith(u8, upper, "SIG")) upper[3..] else upper;
+    for (SIGNAL_NAMES) |entry| {
+        if (std.mem.eql(u8, entry.name, name)) return entry.number;
+    }
+    return null;
+}
+
+/// Cgroup levels searched below lxc/<vmid>
+const MAX_CGROUP_DEPTH = 8;
+
+/// Host PID of the container's init, read from its cgroup
+///
+/// LXC moves the payload into the `ns` child cgroup and systemd guests move
+/// init further down into `ns/init.scope`, so the whole subtree of
+/// lxc/<vmid> is searched for the task that is PID 1 one namespace level
+/// below ours. Nested containers inside the guest sit deeper and do not
+/// match. There is no fallback to an arbitrary task: signalling the wrong
+/// process is worse than reporting that init was not found.
+pub fn initPid(pve: *const pve_config.PveConfigReader, vmid: []const u8) ?linux.pid_t {
+    const own_level = namespaceLevel(pve.proc_root, "self") orelse return null;
+
+    var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+    const path = std.fmt.bufPrint(&path_buf, "{s}/lxc/{s}", .{ pve.cgroup_root, vmid }) catch return null;
+    var dir = std.fs.cwd().openDir(path, .{ .iterate = true }) catch return null;
+    defer dir.close();
+    return findInit(pve, dir, own_level + 1, 0);
+}
+
+fn findInit(pve: *const pve_config.PveConfigReader, dir: std.fs.Dir, level: usize, depth: usize) ?linux.pid_t {
+    if (dir.readFileAlloc(pve.allocator, "cgroup.procs", 1024 * 1024)) |procs| {
+        defer pve.allocator.free(procs);
+        var lines = std.mem.tokenizeScalar(u8, procs, '\n');
+        while (lines.next()) |line| {
+            const pid = std.fmt.parseInt(linux.pid_t, line, 10) catch continue;
+            if (isNamespaceInit(pve.proc_root, pid, level)) return pid;
+        }
+    } else |_| {}
+
+    if (depth == MAX_CGROUP_DEPTH) return null;
+    var it = dir.iterate();
+    while (it.next() catch null) |entry| {
+        if (entry.kind != .directory) continue;
+        var child = dir.openDir(entry.name, .{ .iterate = true, .no_follow = true }) catch continue;
+        defer child.close();
+        if (findInit(pve, child, level, depth + 1)) |pid| return pid;
+    }
+    return null;
+}
+
+/// True when `pid` is PID 1 of a namespace at `level` (the host is level 1)
+fn isNamespaceInit(proc_root: []const u8, pid: linux.pid_t, level: usize) bool {
+    var pid_buf: [16]u8 = undefined;
+    const pid_str = std.fmt.bufPrint(&pid_buf, "{d}", .{pid}) catch return false;
+    var status_buf: [4096]u8 = undefined;
+    const ids = nsPids(&status_buf, proc_root, pid_str) orelse return false;
+
+    var it = std.mem.tokenizeAny(u8, ids, " \t");
+    var count: usize = 0;
+    var last: []const u8 = "";
+    while (it.next()) |id| {
+        count += 1;
+        last = id;
+    }
+    return count == level and std.mem.eql(u8, last, "1");
+}
+
+/// Number of PID namespaces `pid` is nested in, counting the host's
+fn namespaceLevel(proc_root: []const u8, pid: []const u8) ?usize {
+    var status_buf: [4096]u8 = undefined;
+    const ids = nsPids(&status_buf, proc_root, pid) orelse return null;
+    var it = std.mem.tokenizeAny(u8, ids, " \t");
+    var count: usize = 0;
+    while (it.next()) |_| count += 1;
+    return if (count == 0) null else count;
+}
+
+/// "<host pid>\t<ns pid>..." from the NSpid line of /proc/<pid>/status
+fn nsPids(buf: []u8, proc_root: []const u8, pid: []const u8) ?[]const u8 {
+    var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+    const path = std.fmt.bufPrint(&path_buf, "{s}/{s}/status", .{ proc_root, pid }) catch return null;
+    const status = std.fs.cwd().readFile(path, buf) catch return null;
+
+    const start = std.mem.indexOf(u8, status, "\nNSpid:") orelse return null;
+    const rest = status[start + "\nNSpid:".len ..];
+    return rest[0 .. std.mem.indexOfScalar(u8, rest, '\n') orelse rest.len];
+}
+
+/// Deliver `signal` through a pidfd, so a recycled PID is never signalled
+pub fn sendSignal(pid: linux.pid_t, signal: u8) !void {
+    const open_rc = linux.pidfd_open(pid, 0);
+    switch (std.posix.errno(open_rc)) {
+        .SUCCESS => {},
+        .SRCH => return error.ProcessNotFound,
+        // Pre-5.3 kernel: no pidfds, plain kill(2) is the best available
+        .NOSYS => return std.posix.kill(pid, signal),
+        else => |err| return std.posix.unexpectedErrno(err),
+    }
+    const pidfd: std.posix.fd_t = @intCast(open_rc);
+    defer std.posix.close(pidfd);
+
+    switch (std.posix.errno(linux.pidfd_send_signal(pidfd, signal, null, 0))) {
+        .SUCCESS => {},
+        .SRCH => return error.ProcessNotFound,
+        .PERM => return error.PermissionDenied,
+        else => |err| return std.posix.unexpectedErrno(err),
+    }
+}
@@ -4,19 +4,31 @@ const types = @import("types.zig");
 const oci_bundle = @import("oci_bundle.zig");
 const image_converter = @import("image_converter.zig");
 const template_manager = @import("template_manager.zig");
+const template_cache = @import("template_cache.zig");
+const inventory = @import("inventory.zig");
+const pve_config = @import("pve_config.zig");
+const vmid_allocator = @import("vmid_allocator.zig");
+const cgroup_watch = @import("cgroup_watch.zig");
+const container_signal = @import("container_signal.zig");
+const lxc_config = @import("lxc_config.zig");
+const warm_pool = @import("warm_pool.zig");
+const clone_bases = @import("clone_bases.zig");
+const api_lifecycle = @import("api_lifecycle.zig");
+const pct = @import("pct.zig");
+
+/// Default location of persistent backend state such as the VMID bitmap
+const DEFAULT_STATE_DIR = "/var/lib/nexcage";
+
+/// Rootfs size of clone base containers unless configured
+const DEFAULT_CLONE_ROOTFS_GB: u32 = 8;
+
+/// Interval between `pct status` checks where the cgroup cannot be watched
+const PCT_STATUS_POLL_MS: u64 = 500;
 
 /// Result of running a command
-const CommandResult = struct {
-    stdout: []u8,
-    stderr: []u8,
-    exit_code: u8,
-};
+const CommandResult = core.exec.Result;
 
-const NetDeviceRuntimeInfo = struct {
-    alias: []const u8,
-    bridge: []const u8,
-    host_name: ?[]const u8 = null,
-};
+const NetDeviceRuntimeInfo = lxc_config.NetDevice;
 
 fn writeJsonString(writer: anytype, value: []const u8) !void {
     try writer.writeByte('"');
@@ -45,6 +57,27 @@ fn writeJsonString(writer: anytype, value: []const u8) !void {
     try writer.writeByte('"');
 }
 
+/// Lifecycle calls that can be submitted and finished separately
+pub const LifecycleOp = enum {
+    start,
+    stop,
+    delete,
+
+    fn pctVerb(self: LifecycleOp) []const u8 {
+        return switch (self) {
+            .start => "start",
+            .stop => "stop",
+            .delete => "destroy",
+        };
+    }
+};
+
+/// A submitted lifecycle call whose worker task is still running; both owned
+pub const PendingLifecycle = struct {
+    vmid: []u8,
+    upid: []u8,
+};
+
 /// Proxmox LXC backend driver
 pub const ProxmoxLxcDriver = struct {
     const Self = @This();
@@ -54,7 +87,15 @@ pub const ProxmoxLxcDriver = struct {
     logger: ?*core.LogContext = null,
     debug_mode: bool = false,
     template_manager: template_manager.TemplateManager,
+    template_cache: template_cache.TemplateCache,
+    inventory: inventory.ContainerInventory,
+    shared_inventory: ?*inventory.ContainerInventory = null,
+    pve: pve_config.PveConfigReader,
     zfs_pool: ?[]const u8 = null,
+    /// Set up on first use when `config.proxmox_api` is configured
+    rest: ?api_lifecycle.ApiLifecycle = null,
+    /// Guards `rest` setup and the template cache for batches sharing the driver
+    mutex: std.Thread.Mutex = .{},
 
     pub fn init(allocator: std.mem.Allocator, config: core.types.ProxmoxLxcBackendConfig) !*Self {
         const driver = try allocator.alloc(Self, 1);
@@ -67,6 +108,12 @@ pub const ProxmoxLxcDriver = struct {
             .allocator = allocator,
             .config = config,
             .template_manager = template_mgr,
+            .template_cache = template_cache.TemplateCache.init(allocator, null, config.state_dir orelse DEFAULT_STATE_DIR, image_converter.TEMPLATE_CACHE_DIR, .{
+                .max_bytes = config.template_cache_max_bytes orelse (template_cache.Limits{}).max_bytes,
+                .max_entries = config.template_cache_max_entries orelse (template_cache.Limits{}).max_entries,
+            }),
+            .inventory = inventory.ContainerInventory.init(allocator, null),
+            .pve = pve_config.PveConfigReader.init(allocator),
             .zfs_pool = blk: {
                 if (config.zfs_pool) |p| break :blk try allocator.dupe(u8, p);
                 break :blk try allocator.dupe(u8, "tank/containers");
@@ -78,6 +125,8 @@ pub const ProxmoxLxcDriver = struct {
 
     pub fn deinit(self: *Self) void {
         self.template_manager.deinit();
+        self.template_cache.deinit();
+        self.inventory.deinit();
         if (self.zfs_pool) |pool| {
             self.allocator.free(pool);
         }
@@ -87,6 +136,22 @@ pub const ProxmoxLxcDriver = struct {
     /// Set logger
     pub fn setLogger(self: *Self, logger: *core.LogContext) void {
         self.logger = logger;
+        self.inventory.logger = logger;
+        self.template_cache.logger = logger;
+    }
+
+    /// Use an inventory shared with other drivers, e.g. batch workers
+    pub fn setInventory(self: *Self, shared: *inventory.ContainerInventory) void {
+        self.shared_inventory = shared;
+    }
+
+    fn containers(self: *Self) *inventory.ContainerInventory {
+        return self.shared_inventory orelse &self.inventory;
+    }
+
+    fn noteStatus(self: *Self, vmid: []const u8, status: []const u8) void {
+        const vmid_num = std.fmt.parseInt(u32, vmid, 10) catch return;
+        self.containers().setStatus(vmid_num, status);
     }
 
     /// Set debug mode
@@ -213,176 +278,65 @@ pub const ProxmoxLxcDriver = struct {
 
     /// Create ZFS dataset for container
     pub fn createContainerDataset(self: *Self, container_name: []const u8, vmid: []const u8) !?[]const u8 {
-        const stderr = std.fs.File.stderr();
-        stderr.writeAll("[DRIVER] createContainerDataset: ENTRY\n") catch {};
-        stderr.writeAll("[DRIVER] createContainerDataset: container_name = '") catch {};
-        stderr.writeAll(container_name) catch {};
-        stderr.writeAll("', vmid = '") catch {};
-        stderr.writeAll(vmid) catch {};
-        stderr.writeAll("'\n") catch {};
-
-        stderr.writeAll("[DRIVER] createContainerDataset: Checking ZFS availability and pool\n") catch {};
-        const zfs_avail = self.isZFSAvailable();
-        const pool_set = self.zfs_pool != null;
-        stderr.writeAll("[DRIVER] createContainerDataset: zfs_avail = ") catch {};
-        if (zfs_avail) {
-            stderr.writeAll("true") catch {};
-        } else {
-            stderr.writeAll("false") catch {};
-        }
-        stderr.writeAll(", pool_set = ") catch {};
-        if (pool_set) {
-            stderr.writeAll("true\n") catch {};
-        } else {
-            stderr.writeAll("false\n") catch {};
-        }
-
-        if (!zfs_avail or !pool_set) {
-            stderr.writeAll("[DRIVER] createContainerDataset: ZFS not available or pool not set, returning null\n") catch {};
-            // Skip logger to avoid segfault
-            // if (self.logger) |log| log.warn("ZFS not available, skipping dataset creation", .{}) catch {};
+        if (!self.isZFSAvailable() or self.zfs_pool == null) {
+            if (self.logger) |log| log.debug("ZFS not available or no pool configured, skipping dataset creation", .{}) catch {};
             return null;
         }
-
-        stderr.writeAll("[DRIVER] createContainerDataset: Getting pool value\n") catch {};
         const pool_config = self.zfs_pool.?;
-        stderr.writeAll("[DRIVER] createContainerDataset: pool_config = '") catch {};
-        stderr.writeAll(pool_config) catch {};
-        stderr.writeAll("'\n") catch {};
 
         // Extract pool name from config (e.g., "tank" from "tank/containers" or just "tank")
         const pool_name: []const u8 = if (std.mem.indexOf(u8, pool_config, "/")) |idx| pool_config[0..idx] else pool_config;
-        stderr.writeAll("[DRIVER] createContainerDataset: Extracted pool_name = '") catch {};
-        stderr.writeAll(pool_name) catch {};
-        stderr.writeAll("'\n") catch {};
 
         // Verify pool exists
-        stderr.writeAll("[DRIVER] createContainerDataset: Checking if pool exists\n") catch {};
         if (!self.poolExists(pool_name)) {
-            stderr.writeAll("[DRIVER] createContainerDataset: Pool does not exist, returning null\n") catch {};
+            if (self.logger) |log| log.debug("ZFS pool {s} not found, skipping dataset creation", .{pool_name}) catch {};
             return null;
         }
-        stderr.writeAll("[DRIVER] createContainerDataset: Pool exists\n") catch {};
 
         // Create dataset name: use pool_config as base if it contains path, otherwise use pool_name/containers
         // If pool_config is "tank/containers", use it directly, otherwise use "pool_name/containers"
         const base_path: []const u8 = if (std.mem.indexOf(u8, pool_config, "/")) |_| pool_config else try std.fmt.allocPrint(self.allocator, "{s}/containers", .{pool_name});
         defer if (base_path.ptr != pool_config.ptr) self.allocator.free(base_path);
 
-        stderr.writeAll("[DRIVER] createContainerDataset: base_path = '") catch {};
-        stderr.writeAll(base_path) catch {};
-        stderr.writeAll("'\n") catch {};
-
         // Create dataset name: base_path/container_name-vmid
-        stderr.writeAll("[DRIVER] createContainerDataset: Creating dataset name\n") catch {};
         const dataset_name = try std.fmt.allocPrint(self.allocator, "{s}/{s}-{s}", .{ base_path, container_name, vmid });
         defer self.allocator.free(dataset_name);
-        stderr.writeAll("[DRIVER] createContainerDataset: dataset_name = '") catch {};
-        stderr.writeAll(dataset_name) catch {};
-        stderr.writeAll("'\n") catch {};
 
         // Check if dataset already exists
-        stderr.writeAll("[DRIVER] createContainerDataset: Checking if dataset already exists\n") catch {};
         if (self.datasetExists(dataset_name)) {
-            stderr.writeAll("[DRIVER] createContainerDataset: Dataset already exists, returning existing name\n") catch {};
             // Return existing dataset name
             return try self.allocator.dupe(u8, dataset_name);
         }
-        stderr.writeAll("[DRIVER] createContainerDataset: Dataset does not exist, will create\n") catch {};
 
         // Check if parent dataset exists, create if missing
         if (self.getParentDataset(dataset_name)) |parent_dataset| {
-            stderr.writeAll("[DRIVER] createContainerDataset: Checking parent dataset: '") catch {};
-            stderr.writeAll(parent_dataset) catch {};
-            stderr.writeAll("'\n") catch {};
-
             if (!self.datasetExists(parent_dataset)) {
-                stderr.writeAll("[DRIVER] createContainerDataset: Parent dataset does not exist, creating\n") catch {};
                 const parent_args = [_][]const u8{ "zfs", "create", "-p", parent_dataset };
-                const parent_res = self.runCommand(&parent_args) catch {
-                    stderr.writeAll("[DRIVER] createContainerDataset: Failed to create parent dataset\n") catch {};
-                    return null;
-                };
+                const parent_res = self.runCommand(&parent_args) catch return null;
                 defer {
                     self.allocator.free(parent_res.stdout);
                     self.allocator.free(parent_res.stderr);
                 }
 
                 if (parent_res.exit_code != 0) {
-                    stderr.writeAll("[DRIVER] createContainerDataset: Parent dataset creation failed, stderr = '") catch {};
-                    stderr.writeAll(parent_res.stderr) catch {};
-                    stderr.writeAll("'\n") catch {};
+                    if (self.logger) |log| log.warn("Failed to create parent dataset {s}: {s}", .{ parent_dataset, parent_res.stderr }) catch {};
                     return null;
                 }
-                stderr.writeAll("[DRIVER] createContainerDataset: Parent dataset created successfully\n") catch {};
-            } else {
-                stderr.writeAll("[DRIVER] createContainerDataset: Parent dataset exists\n") catch {};
             }
         }
 
-        // Skip logger to avoid segfault
-        // if (self.logger) |log| log.info("Creating ZFS dataset for container: {s}", .{dataset_name}) catch {};
-        stderr.writeAll("[DRIVER] createContainerDataset: Logger skipped\n") catch {};
-
         // Create the dataset
-        stderr.writeAll("[DRIVER] createContainerDataset: Before zfs create command\n") catch {};
         {
-            const args = [_][]const u8{ "zfs", "create", dataset_name };
-            stderr.writeAll("[DRIVER] createContainerDataset: Executing zfs create\n") catch {};
+            // Properties are set at creation, not with one `zfs set` per property
+            const args = [_][]const u8{ "zfs", "create", "-o", "compression=lz4", "-o", "atime=off", "-o", "sync=disabled", dataset_name };
             const res = try self.runCommand(&args);
-            stderr.writeAll("[DRIVER] createContainerDataset: zfs create command returned\n") catch {};
-            stderr.writeAll("[DRIVER] createContainerDataset: res.stdout len = ") catch {};
-            const stdout_len_str = try std.fmt.allocPrint(self.allocator, "{d}", .{res.stdout.len});
-            defer self.allocator.free(stdout_len_str);
-            stderr.writeAll(stdout_len_str) catch {};
-            stderr.writeAll(", res.stderr len = ") catch {};
-            const stderr_len_str = try std.fmt.allocPrint(self.allocator, "{d}", .{res.stderr.len});
-            defer self.allocator.free(stderr_len_str);
-            stderr.writeAll(stderr_len_str) catch {};
-            stderr.writeAll("\n") catch {};
-
-            if (res.stderr.len > 0) {
-                stderr.writeAll("[DRIVER] createContainerDataset: zfs stderr = '") catch {};
-                stderr.writeAll(res.stderr) catch {};
-                stderr.writeAll("'\n") catch {};
-            }
-
-            stderr.writeAll("[DRIVER] createContainerDataset: res.exit_code = ") catch {};
-            const exit_str = try std.fmt.allocPrint(self.allocator, "{d}", .{res.exit_code});
-            defer self.allocator.free(exit_str);
-            stderr.writeAll(exit_str) catch {};
-            stderr.writeAll("\n") catch {};
             defer self.allocator.free(res.stdout);
             defer self.allocator.free(res.stderr);
-            stderr.writeAll("[DRIVER] createContainerDataset: Before exit_code check\n") catch {};
             if (res.exit_code != 0) {
-                stderr.writeAll("[DRIVER] createContainerDataset: zfs create failed, returning null (continuing without ZFS dataset)\n") catch {};
+                if (self.logger) |log| log.warn("zfs create {s} failed: {s}", .{ dataset_name, res.stderr }) catch {};
                 // Return null to continue without ZFS dataset instead of failing
                 return null;
             }
-            stderr.writeAll("[DRIVER] createContainerDataset: zfs create succeeded\n") catch {};
-        }
-        // Set compression and other properties
-        {
-            const args1 = [_][]const u8{ "zfs", "set", "compression=lz4", dataset_name };
-            const res1 = try self.runCommand(&args1);
-            defer self.allocator.free(res1.stdout);
-            defer self.allocator.free(res1.stderr);
-            if (res1.exit_code != 0) return core.Error.OperationFailed;
-        }
-        {
-            const args2 = [_][]const u8{ "zfs", "set", "atime=off", dataset_name };
-            const res2 = try self.runCommand(&args2);
-            defer self.allocator.free(res2.stdout);
-            defer self.allocator.free(res2.stderr);
-            if (res2.exit_code != 0) return core.Error.OperationFailed;
-        }
-        {
-            const args3 = [_][]const u8{ "zfs", "set", "sync=disabled", dataset_name };
-            const res3 = try self.runCommand(&args3);
-            defer self.allocator.free(res3.stdout);
-            defer self.allocator.free(res3.stderr);
-            if (res3.exit_code != 0) return core.Error.OperationFailed;
         }
 
         if (self.logger) |log| log.info("Successfully created ZFS dataset: {s}", .{dataset_name}) catch {};
@@ -447,16 +401,23 @@ pub const ProxmoxLxcDriver = struct {
             }
         }
 
-        // If no existing template found, convert OCI bundle to template
-        const template_name = try std.fmt.allocPrint(self.allocator, "{s}-{d}", .{ container_name, std.time.timestamp() });
-        defer self.allocator.free(template_name);
+        // Templates are named by content, so an unchanged bundle maps to the same one
+        const name_buf = try template_cache.bundleTemplateName(self.allocator, &cfg);
+        const template_name: []const u8 = &name_buf;
+        if (try self.template_cache.lookup(template_name)) {
+            if (self.logger) |log| log.info("Using cached template {s} for {s}", .{ template_name, container_name }) catch {};
+            return try self.allocator.dupe(u8, template_name);
+        }
 
         if (self.logger) |log| log.info("Converting OCI bundle to template: {s}", .{template_name}) catch {};
 
         var converter = image_converter.ImageConverter.init(self.allocator, self.logger);
+        if (self.config.template_zstd_level) |level| converter.pack_options.level = level;
+        if (self.config.template_zstd_workers) |workers| converter.pack_options.workers = workers;
         try converter.convertOciToProxmoxTemplate(bundle_path, template_name, "local");
 
         if (self.logger) |log| log.info("Successfully converted OCI bundle to template: {s}", .{template_name}) catch {};
+        try self.template_cache.insert(template_name, self.templateFileSize(template_name));
 
         // Add template to cache with metadata
         var template_info = try template_manager.TemplateInfo.init(self.allocator, template_name, 0, // Size will be updated later
@@ -571,21 +532,10 @@ pub const ProxmoxLxcDriver = struct {
 
     /// Create LXC container using pct command
     pub fn create(self: *Self, config: core.types.SandboxConfig) !void {
-        const stderr = std.fs.File.stderr();
+        const span = core.tracing.begin("create");
+        defer span.end();
         const stdout = std.fs.File.stdout();
 
-        // Use stderr for immediate output (unbuffered)
-        stderr.writeAll("[DRIVER] create: ENTRY\n") catch {};
-        stderr.writeAll("[DRIVER] create: container name = '") catch {};
-        stderr.writeAll(config.name) catch {};
-        stderr.writeAll("'\n") catch {};
-        stderr.writeAll("[DRIVER] create: debug_mode = ") catch {};
-        if (self.debug_mode) {
-            stderr.writeAll("true\n") catch {};
-        } else {
-            stderr.writeAll("false\n") catch {};
-        }
-
         if (self.debug_mode) {
             try stdout.writeAll("[DRIVER] create: Starting (detailed debug)\n");
             try stdout.writeAll("[DRIVER] create: container name = '");
@@ -593,58 +543,21 @@ pub const ProxmoxLxcDriver = struct {
             try stdout.writeAll("'\n");
         }
 
-        stderr.writeAll("[DRIVER] create: Before logger check\n") catch {};
-
-        // Use logger if available - with additional safety checks
-        if (self.logger) |log| {
-            const name = config.name;
-            if (name.len > 0) {
-                stderr.writeAll("[DRIVER] create: Checking logger validity\n") catch {};
-
-                // Additional safety checks before calling logger
-                // Check if allocator pointer is valid by trying to access it
-                _ = log.allocator;
-                stderr.writeAll("[DRIVER] create: Logger allocator check passed\n") catch {};
-
-                // Check if file is valid
-                _ = log.file;
-                stderr.writeAll("[DRIVER] create: Logger file check passed\n") catch {};
-
-                stderr.writeAll("[DRIVER] create: Calling logger.info\n") catch {};
-
-                // Try to use logger with explicit error handling
-                log.info("Creating Proxmox LXC container: {s}", .{name}) catch {
-                    stderr.writeAll("[DRIVER] create: Logger.info failed with error\n") catch {};
-                    // Continue execution even if logging fails
-                };
-                stderr.writeAll("[DRIVER] create: Logger.info completed\n") catch {};
-            }
-        } else {
-            stderr.writeAll("[DRIVER] create: No logger available\n") catch {};
-        }
-
-        stderr.writeAll("[DRIVER] create: Processing image\n") catch {};
+        if (self.logger) |log| log.info("Creating Proxmox LXC container: {s}", .{config.name}) catch {};
 
         if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Processing image (detailed)\n");
 
         // Process bundle image if provided (bundle path with config.json)
-        stderr.writeAll("[DRIVER] create: Initializing template_name variable\n") catch {};
         var template_name: ?[]const u8 = null;
         defer if (template_name) |tname| self.allocator.free(tname);
 
         // Keep track of original OCI bundle path for mounts and resources
-        stderr.writeAll("[DRIVER] create: Initializing oci_bundle_path variable\n") catch {};
         var oci_bundle_path: ?[]const u8 = null;
         // Store parsed bundle config for resources and namespaces
         var bundle_config: ?oci_bundle.OciBundleConfig = null;
         defer if (bundle_config) |*bc| bc.deinit();
 
-        stderr.writeAll("[DRIVER] create: Checking if config.image exists\n") catch {};
         if (config.image) |image_path| {
-            stderr.writeAll("[DRIVER] create: Image provided: '") catch {};
-            stderr.writeAll(image_path) catch {};
-            stderr.writeAll("'\n") catch {};
-
             if (self.debug_mode) {
                 try stdout.writeAll("[DRIVER] create: Image provided: '");
                 try stdout.writeAll(image_path);
@@ -657,38 +570,17 @@ pub const ProxmoxLxcDriver = struct {
             // - Otherwise:
             //   c) treat as OCI bundle path if directory exists
             //   d) strings like "ubuntu:20.04" are NOT proxmox templates
-            stderr.writeAll("[DRIVER] create: Checking image type\n") catch {};
             const is_tar = std.mem.endsWith(u8, image_path, ".tar.zst");
             const has_vztmpl = std.mem.indexOf(u8, image_path, ":vztmpl/") != null;
             const has_colon = std.mem.indexOf(u8, image_path, ":") != null;
             const has_slash = std.mem.indexOf(u8, image_path, "/") != null;
             const is_proxmox_template = is_tar or has_vztmpl;
-            stderr.writeAll("[DRIVER] create: is_tar = ") catch {};
-            if (is_tar) stderr.writeAll("true\n") catch {} else stderr.writeAll("false\n") catch {};
-            stderr.writeAll("[DRIVER] create: has_vztmpl = ") catch {};
-            if (has_vztmpl) stderr.writeAll("true\n") catch {} else stderr.writeAll("false\n") catch {};
-            stderr.writeAll("[DRIVER] create: has_colon = ") catch {};
-            if (has_colon) stderr.writeAll("true\n") catch {} else stderr.writeAll("false\n") catch {};
-            stderr.writeAll("[DRIVER] create: has_slash = ") catch {};
-            if (has_slash) stderr.writeAll("true\n") catch {} else stderr.writeAll("false\n") catch {};
 
             if (is_proxmox_template) {
-                stderr.writeAll("[DRIVER] create: Image classified as Proxmox template\n") catch {};
                 if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Image classified as Proxmox template\n");
                 // It's a Proxmox template, use it directly
-                stderr.writeAll("[DRIVER] create: Duplicating template name\n") catch {};
                 template_name = try self.allocator.dupe(u8, image_path);
-                stderr.writeAll("[DRIVER] create: Template name duplicated successfully\n") catch {};
-
-                stderr.writeAll("[DRIVER] create: After template_name assignment, checking next step\n") catch {};
-                stderr.writeAll("[DRIVER] create: template_name is set: ") catch {};
-                if (template_name) |_| {
-                    stderr.writeAll("yes\n") catch {};
-                } else {
-                    stderr.writeAll("no\n") catch {};
-                }
             } else {
-                stderr.writeAll("[DRIVER] create: Image is OCI bundle, processing\n") catch {};
                 if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Image is OCI bundle, processing\n");
                 // It's an OCI bundle - validate path boundaries and ensure directory exists
                 const safe_bundle_path = core.validation.PathSecurity.validateBundlePath(image_path, self.allocator) catch |verr| {
@@ -728,275 +620,172 @@ pub const ProxmoxLxcDriver = struct {
                 // Parse bundle config for resources and namespaces (before processing template)
                 if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Parsing bundle config for resources\n");
                 var bundle_parser = oci_bundle.OciBundleParser.init(self.allocator, self.logger);
-                const parsed_bundle_cfg = try bundle_parser.parseBundle(safe_bundle_path);
+                const parsed_bundle_cfg = blk: {
+                    const phase = core.tracing.begin("create.bundle_parse");
+                    defer phase.end();
+                    break :blk try bundle_parser.parseBundle(safe_bundle_path);
+                };
                 // Note: We'll defer deinit after using it for resources/namespaces
                 bundle_config = parsed_bundle_cfg;
 
                 // Process OCI bundle - convert to template if needed
                 if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Processing OCI bundle\n");
-                template_name = try self.processOciBundle(safe_bundle_path, config.name);
+                template_name = blk: {
+                    const phase = core.tracing.begin("create.image_conversion");
+                    defer phase.end();
+                    break :blk try self.processOciBundle(safe_bundle_path, config.name);
+                };
                 if (self.debug_mode) {
                     try stdout.writeAll("[DRIVER] create: OCI bundle processed, template_name set\n");
                 }
             }
         } else {
-            stderr.writeAll("[DRIVER] create: No image provided\n") catch {};
             if (self.debug_mode) try stdout.writeAll("[DRIVER] create: No image provided\n");
         }
 
-        stderr.writeAll("[DRIVER] create: After image processing, before VMID generation\n") catch {};
-        stderr.writeAll("[DRIVER] create: Generating VMID from name\n") catch {};
-        if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Generating VMID from name\n");
-
-        // Generate VMID from name (Proxmox requires numeric vmid)
-        stderr.writeAll("[DRIVER] create: Initializing hash\n") catch {};
-        var hasher = std.hash.Wyhash.init(0);
-        stderr.writeAll("[DRIVER] create: Updating hash with container name\n") catch {};
-        stderr.writeAll("[DRIVER] create: container name = '") catch {};
-        stderr.writeAll(config.name) catch {};
-        stderr.writeAll("'\n") catch {};
-        hasher.update(config.name);
-        stderr.writeAll("[DRIVER] create: Getting hash final value\n") catch {};
-        const vmid_num: u32 = @truncate(hasher.final());
-        stderr.writeAll("[DRIVER] create: Calculating VMID\n") catch {};
-        const vmid_calc: u32 = (vmid_num % 900000) + 100; // 100..900099
-        stderr.writeAll("[DRIVER] create: Allocating VMID string\n") catch {};
-        const vmid = try std.fmt.allocPrint(self.allocator, "{d}", .{vmid_calc});
-        defer self.allocator.free(vmid);
-        stderr.writeAll("[DRIVER] create: VMID allocated: ") catch {};
-        stderr.writeAll(vmid) catch {};
-        stderr.writeAll("\n") catch {};
-
-        if (self.debug_mode) {
-            try stdout.writeAll("[DRIVER] create: VMID calculated: ");
-            try stdout.writeAll(vmid);
-            try stdout.writeAll("\n");
-        }
-
-        // Validate VMID uniqueness - check if container with this VMID already exists
-        stderr.writeAll("[DRIVER] create: Checking VMID uniqueness\n") catch {};
-        if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Checking VMID uniqueness\n");
-
-        stderr.writeAll("[DRIVER] create: Before vmidExists call\n") catch {};
-        const vmid_exists = try self.vmidExists(vmid);
-        stderr.writeAll("[DRIVER] create: After vmidExists call, result = ") catch {};
-        if (vmid_exists) {
-            stderr.writeAll("true\n") catch {};
-        } else {
-            stderr.writeAll("false\n") catch {};
-        }
-
-        if (vmid_exists) {
-            if (self.logger) |log| {
-                log.err("Container with VMID {s} already exists. Try a different container name.", .{vmid}) catch {};
-            }
-            if (self.debug_mode) {
-                try stdout.writeAll("[DRIVER] create: ERROR: VMID already exists\n");
-            }
-            stderr.writeAll("[DRIVER] create: ERROR: VMID already exists\n") catch {};
-            return core.Error.OperationFailed; // Already exists
-        }
-        stderr.writeAll("[DRIVER] create: VMID is unique\n") catch {};
-        if (self.debug_mode) try stdout.writeAll("[DRIVER] create: VMID is unique\n");
-
-        stderr.writeAll("[DRIVER] create: Resolving template\n") catch {};
         if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Resolving template\n");
 
         // Resolve template to use: prefer converted template or find available one
-        stderr.writeAll("[DRIVER] create: Before template resolution\n") catch {};
         var template: []u8 = undefined;
-        stderr.writeAll("[DRIVER] create: Checking if template_name exists\n") catch {};
         if (template_name) |tname| {
-            stderr.writeAll("[DRIVER] create: template_name provided: '") catch {};
-            stderr.writeAll(tname) catch {};
-            stderr.writeAll("'\n") catch {};
             if (self.debug_mode) {
                 try stdout.writeAll("[DRIVER] create: Template name provided: '");
                 try stdout.writeAll(tname);
                 try stdout.writeAll("'\n");
             }
             // Check if template already has storage prefix (contains :)
-            stderr.writeAll("[DRIVER] create: Checking for storage prefix in template name\n") catch {};
             const has_storage = std.mem.indexOf(u8, tname, ":") != null;
             if (has_storage) {
-                stderr.writeAll("[DRIVER] create: Template has storage prefix, using as is\n") catch {};
                 if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Template has storage prefix, using as is\n");
                 // Template already has storage prefix, use as is
-                stderr.writeAll("[DRIVER] create: Duplicating template name\n") catch {};
                 template = try self.allocator.dupe(u8, tname);
-                stderr.writeAll("[DRIVER] create: Template duplicated\n") catch {};
             } else {
-                stderr.writeAll("[DRIVER] create: Template is just name, adding storage prefix\n") catch {};
                 if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Template is just name, adding storage prefix\n");
                 // Template is just a name, add storage prefix
-                stderr.writeAll("[DRIVER] create: Formatting template with storage prefix\n") catch {};
                 template = try std.fmt.allocPrint(self.allocator, "local:vztmpl/{s}.tar.zst", .{tname});
-                stderr.writeAll("[DRIVER] create: Template formatted\n") catch {};
             }
         } else {
-            stderr.writeAll("[DRIVER] create: No template name, finding available template\n") catch {};
             if (self.debug_mode) try stdout.writeAll("[DRIVER] create: No template name, finding available template\n");
-            stderr.writeAll("[DRIVER] create: Calling findAvailableTemplate\n") catch {};
-            const t = try self.findAvailableTemplate();
-            stderr.writeAll("[DRIVER] create: Template found, duplicating\n") catch {};
+            const t = blk: {
+                const phase = core.tracing.begin("create.template_lookup");
+                defer phase.end();
+                break :blk try self.findAvailableTemplate();
+            };
             template = try self.allocator.dupe(u8, t);
             self.allocator.free(t);
-            stderr.writeAll("[DRIVER] create: Template duplicated and free'd\n") catch {};
         }
         defer self.allocator.free(template);
 
-        stderr.writeAll("[DRIVER] create: Final template: '") catch {};
-        stderr.writeAll(template) catch {};
-        stderr.writeAll("'\n") catch {};
         if (self.debug_mode) {
             try stdout.writeAll("[DRIVER] create: Final template: '");
             try stdout.writeAll(template);
             try stdout.writeAll("'\n");
         }
 
-        stderr.writeAll("[DRIVER] create: Checking ZFS availability\n") catch {};
+        if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Reserving VMID\n");
+
+        const vmid_phase = core.tracing.begin("create.vmid_allocation");
+        // start/stop/delete resolve VMIDs by hostname, so names must stay unique
+        if (self.nameExists(config.name)) {
+            vmid_phase.end();
+            if (self.logger) |log| {
+                log.err("Container {s} already exists. Try a different container name.", .{config.name}) catch {};
+            }
+            return core.Error.OperationFailed;
+        }
+
+        // A warm container was created from this template ahead of time, so
+        // claiming one skips pct create and its rootfs extraction entirely
+        const warm_vmid = self.claimWarm(template);
+        // Proxmox requires a numeric vmid; the bitmap allocator skips anything taken
+        const vmid_num = warm_vmid orelse self.reserveVmid(config.name) catch |err| {
+            vmid_phase.end();
+            return err;
+        };
+        vmid_phase.end();
+        // The container already exists and only needs rebinding: warm or cloned
+        var provisioned = warm_vmid != null;
+        var vmid_committed = false;
+        defer if (!vmid_committed) {
+            // A half-rebound container cannot go back into the pool
+            if (provisioned) {
+                self.destroyVmid(vmid_num);
+                self.releaseClone(vmid_num);
+            }
+            self.releaseVmid(vmid_num);
+        };
+        const vmid = try std.fmt.allocPrint(self.allocator, "{d}", .{vmid_num});
+        defer self.allocator.free(vmid);
+
+        // A linked clone of the template's base is a zfs clone: no extraction, no copied blocks
+        if (!provisioned and self.config.clone_storage != null) {
+            const phase = core.tracing.begin("create.clone");
+            defer phase.end();
+            provisioned = self.cloneFromBase(template, vmid, config.name);
+        }
+
+        if (self.debug_mode) {
+            try stdout.writeAll("[DRIVER] create: VMID reserved: ");
+            try stdout.writeAll(vmid);
+            try stdout.writeAll("\n");
+        }
+
         if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Checking ZFS availability\n");
 
         // Create ZFS dataset for container if ZFS is available
-        stderr.writeAll("[DRIVER] create: Before ZFS dataset variable initialization\n") catch {};
         var zfs_dataset: ?[]const u8 = null;
         defer if (zfs_dataset) |dataset| self.allocator.free(dataset);
-        stderr.writeAll("[DRIVER] create: ZFS dataset variable initialized\n") catch {};
 
-        stderr.writeAll("[DRIVER] create: Before isZFSAvailable call\n") catch {};
-        const zfs_available = self.isZFSAvailable();
-        stderr.writeAll("[DRIVER] create: After isZFSAvailable call, result = ") catch {};
+        // A warm or cloned container already has its rootfs
+        const zfs_available = !provisioned and self.isZFSAvailable();
         if (zfs_available) {
-            stderr.writeAll("true\n") catch {};
-        } else {
-            stderr.writeAll("false\n") catch {};
-        }
-
-        if (zfs_available) {
-            stderr.writeAll("[DRIVER] create: ZFS available, creating dataset\n") catch {};
             if (self.debug_mode) try stdout.writeAll("[DRIVER] create: ZFS available, creating dataset\n");
-            stderr.writeAll("[DRIVER] create: Before createContainerDataset call\n") catch {};
-            zfs_dataset = try self.createContainerDataset(config.name, vmid);
-            stderr.writeAll("[DRIVER] create: After createContainerDataset call\n") catch {};
+            zfs_dataset = blk: {
+                const phase = core.tracing.begin("create.dataset");
+                defer phase.end();
+                break :blk try self.createContainerDataset(config.name, vmid);
+            };
             if (zfs_dataset) |dataset| {
-                stderr.writeAll("[DRIVER] create: ZFS dataset created: '") catch {};
-                stderr.writeAll(dataset) catch {};
-                stderr.writeAll("'\n") catch {};
-                // Skip logger to avoid segfault
-                // if (self.logger) |log| log.info("Created ZFS dataset for container: {s}", .{dataset}) catch {};
                 if (self.debug_mode) {
                     try stdout.writeAll("[DRIVER] create: ZFS dataset created: '");
                     try stdout.writeAll(dataset);
                     try stdout.writeAll("'\n");
                 }
-            } else {
-                stderr.writeAll("[DRIVER] create: ZFS dataset creation returned null\n") catch {};
             }
         } else {
-            stderr.writeAll("[DRIVER] create: ZFS not available, skipping dataset\n") catch {};
             if (self.debug_mode) try stdout.writeAll("[DRIVER] create: ZFS not available, skipping dataset\n");
         }
 
-        stderr.writeAll("[DRIVER] create: Building pct create command arguments\n") catch {};
-        if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Building pct create command arguments\n");
+        if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Compiling LXC config\n");
 
-        var args_builder = std.array_list.Managed([]const u8).init(self.allocator);
-        defer args_builder.deinit();
-
-        var allocated_args = std.array_list.Managed([]const u8).init(self.allocator);
-        defer {
-            for (allocated_args.items) |item| {
-                if (item.len > 0) self.allocator.free(item);
-            }
-            allocated_args.deinit();
-        }
-
-        try args_builder.appendSlice(&[_][]const u8{ "pct", "create", vmid, template, "--hostname", config.name });
-
-        // Build dynamic args from config, bundle config (priority), and defaults
-        // Priority: bundle_config.resources > config.resources > defaults
-        const mem_mb_str = blk: {
-            const mem_bytes = if (bundle_config) |bc| blk2: {
-                // Use bundle config memory limit if available (OCI bundle takes priority)
-                if (bc.memory_limit) |bundle_mem| break :blk2 bundle_mem;
-                break :blk2 if (config.resources) |r| r.memory orelse core.constants.DEFAULT_MEMORY_BYTES else core.constants.DEFAULT_MEMORY_BYTES;
-            } else if (config.resources) |r| r.memory orelse core.constants.DEFAULT_MEMORY_BYTES else core.constants.DEFAULT_MEMORY_BYTES;
-            const mb: u64 = mem_bytes / (1024 * 1024);
-            break :blk try std.fmt.allocPrint(self.allocator, "{d}", .{mb});
+        const default_bridge = self.config.default_bridge orelse core.constants.DEFAULT_BRIDGE_NAME;
+        // Resources, network, features and mount points all go into one pct
+        // create call, so /etc/pve/lxc/<vmid>.conf is written exactly once
+        const conf_input = lxc_config.Input{
+            .vmid = vmid,
+            .template = template,
+            .hostname = config.name,
+            .bundle = if (bundle_config) |*bc| bc else null,
+            .memory_bytes = if (config.resources) |r| r.memory else null,
+            .cpu = if (config.resources) |r| r.cpu else null,
+            .bridge = if (config.network) |net| net.bridge orelse default_bridge else default_bridge,
+            .ostype = self.config.default_ostype orelse "ubuntu",
+            .unprivileged = self.config.default_unprivileged orelse false,
+            .rootfs = zfs_dataset,
         };
-        defer self.allocator.free(mem_mb_str);
-        try args_builder.appendSlice(&[_][]const u8{ "--memory", mem_mb_str });
-
-        const cores_str = blk: {
-            const c: f64 = if (bundle_config) |bc| blk2: {
-                // Use bundle config CPU limit if available (OCI bundle takes priority)
-                if (bc.cpu_limit) |bundle_cpu| {
-                    // Convert CPU shares to cores (rough approximation: shares/1024 = cores ratio)
-                    // Ensure minimum of 1 core
-                    const calculated = bundle_cpu / 1024.0;
-                    break :blk2 if (calculated < 1.0) 1.0 else calculated;
-                }
-                break :blk2 if (config.resources) |r| (r.cpu orelse @as(f64, core.constants.DEFAULT_CPU_CORES)) else @as(f64, core.constants.DEFAULT_CPU_CORES);
-            } else if (config.resources) |r| (r.cpu orelse @as(f64, core.constants.DEFAULT_CPU_CORES)) else @as(f64, core.constants.DEFAULT_CPU_CORES);
-            // Ensure minimum of 1 core even after calculation
-            const final_cores = if (c < 1.0) 1.0 else c;
-            const ci: u32 = @intFromFloat(final_cores);
-            break :blk try std.fmt.allocPrint(self.allocator, "{d}", .{ci});
+        // Mounts and namespaces are part of the compiled config, not separate steps
+        var lxc_conf = blk: {
+            const phase = core.tracing.begin("create.config_compile");
+            defer phase.end();
+            break :blk if (provisioned)
+                try lxc_config.compileRebind(self.allocator, self.logger, conf_input)
+            else
+                try lxc_config.compile(self.allocator, self.logger, conf_input);
         };
-        defer self.allocator.free(cores_str);
-        try args_builder.appendSlice(&[_][]const u8{ "--cores", cores_str });
-
-        const default_bridge = self.config.default_bridge orelse core.constants.DEFAULT_BRIDGE_NAME;
-        const config_bridge = if (config.network) |net| net.bridge else null;
-        const fallback_bridge = config_bridge orelse default_bridge;
-
-        var net_runtime = std.array_list.Managed(NetDeviceRuntimeInfo).init(self.allocator);
-        defer net_runtime.deinit();
-
-        const bundle_net_devices = if (bundle_config) |*bc| bc.net_devices else null;
-        if (bundle_net_devices) |devices| {
-            if (devices.len > 0) {
-                for (devices, 0..) |device, idx| {
-                    const alias = device.alias;
-                    const host_link = device.name;
-                    const resolved_bridge = host_link orelse fallback_bridge;
-
-                    const net_flag = try std.fmt.allocPrint(self.allocator, "--net{d}", .{idx});
-                    try allocated_args.append(net_flag);
-                    try args_builder.append(net_flag);
-
-                    const net_value = try std.fmt.allocPrint(self.allocator, "name={s},bridge={s},ip=dhcp", .{ alias, resolved_bridge });
-                    try allocated_args.append(net_value);
-                    try args_builder.append(net_value);
-
-                    try net_runtime.append(NetDeviceRuntimeInfo{
-                        .alias = alias,
-                        .bridge = resolved_bridge,
-                        .host_name = host_link,
-                    });
-                }
-            } else {
-                const net_value = try std.fmt.allocPrint(self.allocator, "name=eth0,bridge={s},ip=dhcp", .{fallback_bridge});
-                try allocated_args.append(net_value);
-                try args_builder.appendSlice(&[_][]const u8{ "--net0", net_value });
-                try net_runtime.append(NetDeviceRuntimeInfo{ .alias = "eth0", .bridge = fallback_bridge, .host_name = null });
-            }
-        } else {
-            const net_value = try std.fmt.allocPrint(self.allocator, "name=eth0,bridge={s},ip=dhcp", .{fallback_bridge});
-            try allocated_args.append(net_value);
-            try args_builder.appendSlice(&[_][]const u8{ "--net0", net_value });
-            try net_runtime.append(NetDeviceRuntimeInfo{ .alias = "eth0", .bridge = fallback_bridge, .host_name = null });
-        }
+        defer lxc_conf.deinit();
+        if (self.logger) |log| log.info("Compiled LXC config for {s}: {d} mount points, {d} network devices", .{ vmid, lxc_conf.mount_count, lxc_conf.net_devices.items.len }) catch {};
 
-        const ostype = self.config.default_ostype orelse "ubuntu";
-        const unprivileged_str = if (self.config.default_unprivileged) |u| if (u) "1" else "0" else "0";
-        try args_builder.appendSlice(&[_][]const u8{ "--ostype", ostype, "--unprivileged", unprivileged_str });
-
-        if (zfs_dataset) |dataset| {
-            try args_builder.appendSlice(&[_][]const u8{ "--rootfs", dataset });
-        }
-
-        const args = args_builder.items;
+        const args = lxc_conf.argv.items;
 
         if (self.logger) |log| {
             log.debug("Proxmox LXC create: Creating container with pct create", .{}) catch {};
@@ -1081,31 +870,19 @@ pub const ProxmoxLxcDriver = struct {
         }
 
         if (self.debug_mode) try stdout.writeAll("[DRIVER] create: pct create succeeded\n");
-
-        // Apply mounts from bundle into /etc/pve/lxc/<vmid>.conf and verify via pct config
-        if (oci_bundle_path) |bundle_for_mounts| {
-            if (self.debug_mode) {
-                try stdout.writeAll("[DRIVER] create: Applying mounts from OCI bundle: '");
-                try stdout.writeAll(bundle_for_mounts);
-                try stdout.writeAll("'\n");
-            }
-            if (self.logger) |log| log.info("Applying mounts from OCI bundle: {s}", .{bundle_for_mounts}) catch {};
-            try self.applyMountsToLxcConfig(vmid, bundle_for_mounts);
-            try self.verifyMountsInConfig(vmid);
-            if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Mounts applied and verified\n");
-        }
-
-        // Apply namespaces from bundle (if available)
-        if (bundle_config) |bc| {
-            if (bc.namespaces) |namespaces| {
-                if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Applying namespaces from OCI bundle\n");
-                if (self.logger) |log| log.info("Applying {d} namespaces from OCI bundle", .{namespaces.len}) catch {};
-                try self.applyNamespacesToLxcConfig(vmid, namespaces);
-            }
+        vmid_committed = true;
+        self.containers().invalidate();
+        if (template_name) |tname| {
+            // Pins the cached template against eviction until this container is deleted
+            self.template_cache.acquire(tname, config.name) catch |err| {
+                if (self.logger) |log| log.warn("Failed to pin template {s}: {}", .{ tname, err }) catch {};
+            };
         }
 
+        const persist_phase = core.tracing.begin("create.persist_state");
+        errdefer persist_phase.end();
         const bundle_ptr: ?*const oci_bundle.OciBundleConfig = if (bundle_config) |*bc| bc else null;
-        try self.persistRuntimeMetadata(config.name, vmid, bundle_ptr, net_runtime.items);
+        try self.persistRuntimeMetadata(config.name, vmid, bundle_ptr, lxc_conf.net_devices.items);
 
         // Cleanup bundle config after use (moved to defer at declaration)
 
@@ -1162,6 +939,10 @@ pub const ProxmoxLxcDriver = struct {
             }
         }
 
+        persist_phase.end();
+
+        if (self.warmPoolSize() > 0) self.spawnRefill(template, config.name);
+
         if (self.debug_mode) try stdout.writeAll("[DRIVER] create: Finished\n");
     }
 
@@ -1324,237 +1105,97 @@ pub const ProxmoxLxcDriver = struct {
         return std.mem.indexOf(u8, res.stdout, entry) != null;
     }
 
-    /// Append mounts from bundle config to /etc/pve/lxc/<vmid>.conf using mpX syntax
-    fn applyMountsToLxcConfig(self: *Self, vmid: []const u8, bundle_path: []const u8) !void {
-        if (self.logger) |log| log.info("Parsing bundle for mounts: {s}", .{bundle_path}) catch {};
-
-        var parser = oci_bundle.OciBundleParser.init(self.allocator, self.logger);
-        var cfg = try parser.parseBundle(bundle_path);
-        defer cfg.deinit();
-
-        if (cfg.mounts == null) {
-            if (self.logger) |log| log.info("No mounts found in bundle config", .{}) catch {};
-            return;
-        }
-        const mounts = cfg.mounts.?;
-
-        if (self.logger) |log| log.info("Found {d} mounts in bundle", .{mounts.len}) catch {};
-
-        const conf_path = try std.fmt.allocPrint(self.allocator, "/etc/pve/lxc/{s}.conf", .{vmid});
-        defer self.allocator.free(conf_path);
-
-        // Read existing to determine next mp index
-        const existing_data = try self.readFileAll(conf_path);
-        defer if (existing_data) |buf| self.allocator.free(buf);
-        var next_idx: u32 = 0;
-        if (existing_data) |buf| {
-            next_idx = self.findNextMpIndex(buf);
-        }
-
-        // Open config for append
-        var file = try std.fs.openFileAbsolute(conf_path, .{ .mode = .read_write });
-        defer file.close();
-        try file.seekFromEnd(0);
-
-        var i: u32 = 0;
-        while (i < mounts.len) : (i += 1) {
-            const m = mounts[i];
-            if (m.destination == null) {
-                if (self.logger) |log| log.warn("Mount {d} has no destination, skipping", .{i}) catch {};
-                continue;
-            }
-            const dest = m.destination.?;
-
-            const src_opt = m.source;
-            if (src_opt == null) {
-                if (self.logger) |log| log.warn("Mount {d} has no source, skipping", .{i}) catch {};
-                continue;
-            }
-            const src = src_opt.?;
-
-            // Build mp line
-            const mp_line = try self.buildMpLine(next_idx, src, dest, m.options);
-            defer self.allocator.free(mp_line);
-
-            if (self.logger) |log| log.info("Adding mp{d}: {s}", .{ next_idx, mp_line }) catch {};
-            try file.writeAll(mp_line);
-            try file.writeAll("\n");
-            next_idx += 1;
+    /// Start LXC container using pct command
+    pub fn start(self: *Self, container_id: []const u8) !void {
+        if (self.logger) |log| {
+            log.info("Starting Proxmox LXC container: {s}", .{container_id}) catch {};
         }
+        try self.runLifecycle(.start, container_id);
     }
 
-    /// Apply namespaces from OCI bundle to LXC container via pct set --features
-    /// Maps OCI namespace types to LXC features where applicable
-    fn applyNamespacesToLxcConfig(self: *Self, vmid: []const u8, namespaces: []const oci_bundle.NamespaceConfig) !void {
-        if (self.logger) |log| log.info("Applying {d} namespaces to LXC container {s}", .{ namespaces.len, vmid }) catch {};
-
-        // Build features list based on namespaces
-        // Use ArrayListUnmanaged for slice elements as per Zig 0.15.1
-        var features = std.ArrayListUnmanaged([]const u8){};
-        errdefer {
-            for (features.items) |feat| self.allocator.free(feat);
-            features.deinit(self.allocator);
-        }
-        defer {
-            for (features.items) |feat| self.allocator.free(feat);
-            features.deinit(self.allocator);
-        }
-
-        // Track which namespaces we've seen
-        var has_user_ns = false;
-
-        // Parse namespaces and determine LXC features
-        for (namespaces) |ns| {
-            if (std.mem.eql(u8, ns.type, "user")) {
-                has_user_ns = true;
-                // user namespace typically means unprivileged (already set in pct create)
-                if (self.logger) |log| log.info("Found user namespace - unprivileged mode already enabled", .{}) catch {};
-            }
-            // Other namespaces (pid, network, ipc, uts, mount, cgroup) are default in LXC
-        }
-
-        // Add LXC-specific features based on namespace requirements
-        // If container needs nesting (e.g., for Docker-in-LXC or podman)
-        // We enable nesting if user namespace is present (common for container runtimes)
-        if (has_user_ns) {
-            try features.append(self.allocator, try self.allocator.dupe(u8, "nesting=1"));
-            try features.append(self.allocator, try self.allocator.dupe(u8, "keyctl=1"));
-        } else {
-            // Default minimal features for proper isolation
-            try features.append(self.allocator, try self.allocator.dupe(u8, "keyctl=1"));
-        }
-
-        // Build features string: "nesting=1,keyctl=1"
-        var features_str = std.ArrayListUnmanaged(u8){};
-        defer features_str.deinit(self.allocator);
-
-        for (features.items, 0..) |feat, i| {
-            if (i > 0) try features_str.append(self.allocator, ',');
-            try features_str.appendSlice(self.allocator, feat);
-        }
-
-        // Apply features via pct set
-        const vmid_str = try std.fmt.allocPrint(self.allocator, "{s}", .{vmid});
-        defer self.allocator.free(vmid_str);
-
-        const features_str_owned = try features_str.toOwnedSlice(self.allocator);
-        defer self.allocator.free(features_str_owned);
-
-        const args = [_][]const u8{ "pct", "set", vmid_str, "--features", features_str_owned };
-
-        if (self.debug_mode) {
-            const stdout = std.fs.File.stdout();
-            try stdout.writeAll("[DRIVER] applyNamespacesToLxcConfig: Running: pct set ");
-            try stdout.writeAll(vmid_str);
-            try stdout.writeAll(" --features ");
-            try stdout.writeAll(features_str_owned);
-            try stdout.writeAll("\n");
-        }
-
-        const result = try self.runCommand(&args);
-        defer {
-            self.allocator.free(result.stdout);
-            self.allocator.free(result.stderr);
-        }
-
-        if (result.exit_code != 0) {
-            if (self.logger) |log| {
-                log.err("Failed to apply namespaces/features to container {s}: {s}", .{ vmid_str, result.stderr }) catch {};
-            }
-            return core.Error.RuntimeError;
-        }
-
+    /// Stop LXC container using pct command
+    pub fn stop(self: *Self, container_id: []const u8) !void {
         if (self.logger) |log| {
-            log.info("Successfully applied features to container {s}: {s}", .{ vmid_str, features_str_owned }) catch {};
-        }
-
-        if (self.debug_mode) {
-            const stdout = std.fs.File.stdout();
-            try stdout.writeAll("[DRIVER] applyNamespacesToLxcConfig: Features applied successfully\n");
+            log.info("Stopping Proxmox LXC container: {s}", .{container_id}) catch {};
         }
+        try self.runLifecycle(.stop, container_id);
     }
 
-    /// Verify config contains mp entries via pct config
-    fn verifyMountsInConfig(self: *Self, vmid: []const u8) !void {
-        const args = [_][]const u8{ "pct", "config", vmid };
-        const res = try self.runCommand(&args);
-        defer self.allocator.free(res.stdout);
-        defer self.allocator.free(res.stderr);
-        if (res.exit_code != 0) return core.Error.OperationFailed;
-        // Presence of "mp" lines indicates success (best-effort)
-        if (std.mem.indexOf(u8, res.stdout, "mp0:") == null and std.mem.indexOf(u8, res.stdout, "mp1:") == null) {
-            if (self.logger) |log| log.warn("No mp entries visible in pct config after update", .{}) catch {};
+    /// Delete LXC container using pct command
+    pub fn delete(self: *Self, container_id: []const u8) !void {
+        if (self.logger) |log| {
+            log.info("Deleting Proxmox LXC container: {s}", .{container_id}) catch {};
         }
+        try self.runLifecycle(.delete, container_id);
     }
 
-    /// Build mpX line from src/dest/options
-    fn buildMpLine(self: *Self, idx: u32, src: []const u8, dest: []const u8, options: ?[]const u8) ![]u8 {
-        // If src looks like storage ref (<storage>:<path> and not absolute path)
-        const is_storage = (std.mem.indexOfScalar(u8, src, ':') != null) and (src.len > 0 and src[0] != '/');
-        const opt = options orelse "";
-        if (is_storage) {
-            return std.fmt.allocPrint(self.allocator, "mp{d}: {s},mp={s}{s}{s}", .{ idx, src, dest, if (opt.len > 0) "," else "", opt });
-        } else {
-            return std.fmt.allocPrint(self.allocator, "mp{d}: {s},mp={s}{s}{s}", .{ idx, src, dest, if (opt.len > 0) "," else "", opt });
-        }
-    }
+    fn runLifecycle(self: *Self, op: LifecycleOp, container_id: []const u8) !void {
+        // Resolve VMID by name via the cached inventory
+        if (self.logger) |log| log.info("Looking up VMID for container: {s}", .{container_id}) catch {};
+        const vmid = try self.getVmidByName(container_id);
+        defer self.allocator.free(vmid);
 
-    /// Read file to memory (optional)
-    fn readFileAll(self: *Self, path: []const u8) !?[]u8 {
-        const file = std.fs.openFileAbsolute(path, .{}) catch return null;
-        defer file.close();
-        const stat = try file.stat();
-        var buf = try self.allocator.alloc(u8, @intCast(stat.size));
-        const n = try file.readAll(buf);
-        return buf[0..n];
+        const args = [_][]const u8{ "pct", op.pctVerb(), vmid };
+        try self.finish(op, container_id, vmid, try self.runCommand(&args));
     }
 
-    /// Find next mp index from existing config content
-    fn findNextMpIndex(self: *Self, data: []const u8) u32 {
-        _ = self;
-        var max_idx: u32 = 0;
-        var lines = std.mem.splitScalar(u8, data, '\n');
-        while (lines.next()) |line| {
-            if (line.len < 4) continue;
-            if (line[0] == 'm' and line[1] == 'p') {
-                // parse digits until ':'
-                var j: usize = 2;
-                var val: u32 = 0;
-                var ok = false;
-                while (j < line.len and line[j] >= '0' and line[j] <= '9') : (j += 1) {
-                    val = val * 10 + @as(u32, @intCast(line[j] - '0'));
-                    ok = true;
-                }
-                if (ok and j < line.len and line[j] == ':') {
-                    if (val + 1 > max_idx) max_idx = val + 1;
+    /// Send `op` for `container_id` without waiting for the worker task it
+    /// starts; null when the call has already finished, as it does on pct
+    /// or when the API started no task. Safe to call from many threads.
+    ///
+    /// Hand the returned UPID to a `TaskGroup` from `taskGroup` and pass
+    /// each task's result to `finish`.
+    pub fn submit(self: *Self, op: LifecycleOp, container_id: []const u8) !?PendingLifecycle {
+        const vmid = try self.getVmidByName(container_id);
+        defer self.allocator.free(vmid);
+
+        const args = [_][]const u8{ "pct", op.pctVerb(), vmid };
+        if (self.restApi()) |rest| {
+            const submitted = rest.submit(&args) catch |err| {
+                if (self.logger) |log| log.err("Proxmox API call for pct {s} failed: {}", .{ args[1], err }) catch {};
+                return core.Error.OperationFailed;
+            };
+            if (submitted) |call| {
+                switch (call) {
+                    .task => |upid| {
+                        errdefer self.allocator.free(upid);
+                        return .{ .vmid = try self.allocator.dupe(u8, vmid), .upid = upid };
+                    },
+                    .done => |result| {
+                        try self.finish(op, container_id, vmid, result);
+                        return null;
+                    },
                 }
             }
         }
-        return max_idx;
+        try self.finish(op, container_id, vmid, try self.runCommand(&args));
+        return null;
     }
 
-    /// Start LXC container using pct command
-    pub fn start(self: *Self, container_id: []const u8) !void {
-        if (self.logger) |log| {
-            log.info("Starting Proxmox LXC container: {s}", .{container_id}) catch {};
-        }
-
-        // Resolve VMID by name via pct list
-        if (self.logger) |log| log.info("Looking up VMID for container: {s}", .{container_id}) catch {};
-        const vmid = try self.getVmidByName(container_id);
-        defer self.allocator.free(vmid);
-
-        // Build pct start command
-        const args = [_][]const u8{ "pct", "start", vmid };
+    /// Tasks of `submit`ted calls, awaited together; null without the API
+    pub fn taskGroup(self: *Self) ?api_lifecycle.TaskGroup {
+        const rest = self.restApi() orelse return null;
+        return api_lifecycle.TaskGroup.init(rest);
+    }
 
-        const result = try self.runCommand(&args);
+    /// Complete `op` once its call returned `result`, which is consumed
+    pub fn finish(self: *Self, op: LifecycleOp, container_id: []const u8, vmid: []const u8, result: CommandResult) !void {
         defer self.allocator.free(result.stdout);
         defer self.allocator.free(result.stderr);
 
         if (result.exit_code != 0) {
-            if (self.logger) |log| log.err("Failed to start Proxmox LXC container {s}: {s}", .{ container_id, result.stderr }) catch {};
+            if (self.logger) |log| log.err("Failed to {s} Proxmox LXC container {s}: {s}", .{ @tagName(op), container_id, result.stderr }) catch {};
             return self.mapPctError(result.exit_code, result.stderr);
         }
+        switch (op) {
+            .start => self.finishStart(container_id, vmid),
+            .stop => try self.finishStop(container_id, vmid),
+            .delete => self.finishDelete(container_id, vmid),
+        }
+    }
+
+    fn finishStart(self: *Self, container_id: []const u8, vmid: []const u8) void {
+        self.noteStatus(vmid, "running");
 
         if (self.logger) |log| {
             log.info("Proxmox LXC container started successfully: {s}", .{container_id}) catch {};
@@ -1566,27 +1207,13 @@ pub const ProxmoxLxcDriver = struct {
         self.writeOciState(container_id, "running", init_pid) catch {};
     }
 
-    /// Stop LXC container using pct command
-    pub fn stop(self: *Self, container_id: []const u8) !void {
-        if (self.logger) |log| {
-            log.info("Stopping Proxmox LXC container: {s}", .{container_id}) catch {};
-        }
-
-        // Resolve VMID by name via pct list
-        const vmid = try self.getVmidByName(container_id);
-        defer self.allocator.free(vmid);
-
-        // Build pct stop command
-        const args = [_][]const u8{ "pct", "stop", vmid };
-
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
-
-        if (result.exit_code != 0) {
-            if (self.logger) |log| log.err("Failed to stop Proxmox LXC container {s}: {s}", .{ container_id, result.stderr }) catch {};
-            return self.mapPctError(result.exit_code, result.stderr);
+    fn finishStop(self: *Self, container_id: []const u8, vmid: []const u8) !void {
+        // pct can return while LXC is still tearing the cgroup down
+        if (!self.waitStopped(vmid)) {
+            if (self.logger) |log| log.err("Container {s} did not stop in time", .{container_id}) catch {};
+            return core.Error.Timeout;
         }
+        self.noteStatus(vmid, "stopped");
 
         if (self.logger) |log| {
             log.info("Proxmox LXC container stopped successfully: {s}", .{container_id}) catch {};
@@ -1596,27 +1223,18 @@ pub const ProxmoxLxcDriver = struct {
         self.writeOciState(container_id, "stopped", 0) catch {};
     }
 
-    /// Delete LXC container using pct command
-    pub fn delete(self: *Self, container_id: []const u8) !void {
-        if (self.logger) |log| {
-            log.info("Deleting Proxmox LXC container: {s}", .{container_id}) catch {};
-        }
-
-        // Resolve VMID by name via pct list
-        const vmid = try self.getVmidByName(container_id);
-        defer self.allocator.free(vmid);
-
-        // Build pct destroy command
-        const args = [_][]const u8{ "pct", "destroy", vmid };
-
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
-
-        if (result.exit_code != 0) {
-            if (self.logger) |log| log.err("Failed to delete Proxmox LXC container {s}: {s}", .{ container_id, result.stderr }) catch {};
-            return self.mapPctError(result.exit_code, result.stderr);
+    fn finishDelete(self: *Self, container_id: []const u8, vmid: []const u8) void {
+        self.containers().invalidate();
+        if (std.fmt.parseInt(u32, vmid, 10)) |vmid_num| self.releaseVmid(vmid_num) else |_| {}
+        {
+            // Batch workers sharing this driver share its cache index too
+            self.mutex.lock();
+            defer self.mutex.unlock();
+            self.template_cache.release(container_id) catch |err| {
+                if (self.logger) |log| log.warn("Failed to release template references of {s}: {}", .{ container_id, err }) catch {};
+            };
         }
+        if (std.fmt.parseInt(u32, vmid, 10)) |vmid_num| self.releaseClone(vmid_num) else |_| {}
 
         // If ZFS used, rename dataset with -delete suffix instead of destroying
         if (self.zfs_pool) |pool| {
@@ -1661,23 +1279,43 @@ pub const ProxmoxLxcDriver = struct {
         try file.writeAll(json);
     }
 
-    /// Get PID 1 inside container by reading /proc/1/stat via pct exec
+    /// Host PID of the container init, resolved from its cgroup, or from
+    /// `lxc-info` where the cgroup layout is not the one initPid walks
     fn getInitPid(self: *Self, vmid: []const u8) ?i32 {
-        const args = [_][]const u8{ "pct", "exec", vmid, "--", "cat", "/proc/1/stat" };
-        const res = self.runCommand(&args) catch return null;
-        defer self.allocator.free(res.stdout);
-        defer self.allocator.free(res.stderr);
+        return container_signal.initPid(&self.pve, vmid) orelse self.lxcInfoPid(vmid);
+    }
+
+    /// Parse `PID: <pid>` from `lxc-info -p -n <vmid>`; null when not running
+    fn lxcInfoPid(self: *Self, vmid: []const u8) ?i32 {
+        const res = self.runCommand(&.{ "lxc-info", "-p", "-n", vmid }) catch return null;
+        defer {
+            self.allocator.free(res.stdout);
+            self.allocator.free(res.stderr);
+        }
         if (res.exit_code != 0) return null;
-        const trimmed = std.mem.trim(u8, res.stdout, " \t\r\n");
-        var it = std.mem.splitScalar(u8, trimmed, ' ');
-        if (it.next()) |first| {
-            const p = std.fmt.parseInt(i32, first, 10) catch return null;
-            return p;
+        const line = std.mem.trim(u8, res.stdout, " \t\r\n");
+        if (!std.mem.startsWith(u8, line, "PID:")) return null;
+        const pid = std.fmt.parseInt(i32, std.mem.trim(u8, line["PID:".len..], " \t"), 10) catch return null;
+        return if (pid > 0) pid else null;
+    }
+
+    /// Signal init through `pct exec`, for when its host PID cannot be found
+    fn pctExecKill(self: *Self, vmid: []const u8, signal: []const u8) bool {
+        const res = self.runCommand(&.{ "pct", "exec", vmid, "--", "kill", "-s", signal, "1" }) catch return false;
+        defer {
+            self.allocator.free(res.stdout);
+            self.allocator.free(res.stderr);
         }
-        return null;
+        if (self.debug_mode) {
+            var buf: [64]u8 = undefined;
+            const line = std.fmt.bufPrint(&buf, "[KILL] pct exec rc={d}\n", .{res.exit_code}) catch "";
+            _ = std.fs.File.stdout().writeAll(line) catch {};
+        }
+        return res.exit_code == 0;
     }
 
-    /// Send signal to container using pct exec kill
+    /// Send a signal to the container init from the host via pidfd, through
+    /// `pct exec` only when its host PID cannot be found
     pub fn kill(self: *Self, container_id: []const u8, signal: []const u8) !void {
         if (self.logger) |log| {
             log.info("Sending signal {s} to Proxmox LXC container: {s}", .{ signal, container_id }) catch {};
@@ -1687,129 +1325,54 @@ pub const ProxmoxLxcDriver = struct {
         defer self.allocator.free(vmid);
 
         // Check if container is already stopped - if so, kill is a no-op success
-        {
-            const st_args = [_][]const u8{ "pct", "status", vmid };
-            const st_res = self.runCommand(&st_args) catch null;
-            if (st_res) |r| {
-                defer self.allocator.free(r.stdout);
-                defer self.allocator.free(r.stderr);
-                if (r.exit_code == 0) {
-                    const trimmed = std.mem.trim(u8, r.stdout, " \t\r\n");
-                    if (self.debug_mode) {
-                        _ = std.fs.File.stdout().writeAll("[KILL] pre-check status=") catch {};
-                        _ = std.fs.File.stdout().writeAll(trimmed) catch {};
-                        _ = std.fs.File.stdout().writeAll("\n") catch {};
-                    }
-                    if (std.mem.indexOf(u8, trimmed, "stopped") != null) {
-                        // Container already stopped, no-op success
-                        if (self.logger) |log| log.info("Container {s} already stopped, kill is no-op", .{container_id}) catch {};
-                        return;
-                    }
-                }
+        if (self.runState(vmid) == .stopped) {
+            if (self.debug_mode) {
+                _ = std.fs.File.stdout().writeAll("[KILL] pre-check status=stopped\n") catch {};
             }
+            if (self.logger) |log| log.info("Container {s} already stopped, kill is no-op", .{container_id}) catch {};
+            return;
         }
 
-        // Try multiple ways to send SIG to PID 1 inside container; consider success if container transitions to stopped.
-        var success = false;
-        // Attempt 1: kill from PATH
-        {
-            const a = [_][]const u8{ "pct", "exec", vmid, "--", "kill", "-s", signal, "1" };
-            const r = self.runCommand(&a) catch null;
-            if (r) |res| {
-                if (self.debug_mode) {
-                    _ = std.fs.File.stdout().writeAll("[KILL] attempt1 rc=\n") catch {};
-                }
-                defer self.allocator.free(res.stdout);
-                defer self.allocator.free(res.stderr);
-                if (self.debug_mode) {
-                    _ = std.fs.File.stdout().writeAll("[KILL] attempt1 stdout=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stdout) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n[KILL] attempt1 stderr=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stderr) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n") catch {};
-                }
-                if (res.exit_code == 0) success = true;
-            }
-        }
-        // Attempt 2: /bin/kill
-        if (!success) {
-            const a = [_][]const u8{ "pct", "exec", vmid, "--", "/bin/kill", "-s", signal, "1" };
-            const r = self.runCommand(&a) catch null;
-            if (r) |res| {
-                defer self.allocator.free(res.stdout);
-                defer self.allocator.free(res.stderr);
-                if (self.debug_mode) {
-                    _ = std.fs.File.stdout().writeAll("[KILL] attempt2 stdout=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stdout) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n[KILL] attempt2 stderr=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stderr) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n") catch {};
-                }
-                if (res.exit_code == 0) success = true;
-            }
-        }
-        // Attempt 3: /usr/bin/kill
-        if (!success) {
-            const a = [_][]const u8{ "pct", "exec", vmid, "--", "/usr/bin/kill", "-s", signal, "1" };
-            const r = self.runCommand(&a) catch null;
-            if (r) |res| {
-                defer self.allocator.free(res.stdout);
-                defer self.allocator.free(res.stderr);
-                if (self.debug_mode) {
-                    _ = std.fs.File.stdout().writeAll("[KILL] attempt3 stdout=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stdout) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n[KILL] attempt3 stderr=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stderr) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n") catch {};
-                }
-                if (res.exit_code == 0) success = true;
-            }
-        }
-        // Attempt 4: shell fallback ignores failure
-        if (!success) {
-            const a = [_][]const u8{ "pct", "exec", vmid, "--", "/bin/sh", "-c", "kill -s TERM 1 || true" };
-            const r = self.runCommand(&a) catch null;
-            if (r) |res| {
-                defer self.allocator.free(res.stdout);
-                defer self.allocator.free(res.stderr);
-                if (self.debug_mode) {
-                    _ = std.fs.File.stdout().writeAll("[KILL] attempt4 stdout=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stdout) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n[KILL] attempt4 stderr=\n") catch {};
-                    _ = std.fs.File.stdout().writeAll(res.stderr) catch {};
-                    _ = std.fs.File.stdout().writeAll("\n") catch {};
-                }
-                success = true;
+        const sig = container_signal.parseSignal(signal) orelse {
+            if (self.logger) |log| log.err("Unknown signal {s}", .{signal}) catch {};
+            return core.Error.InvalidInput;
+        };
+
+        // Signal init from the host; no attach and no tools needed inside the guest
+        var delivered = false;
+        if (self.getInitPid(vmid)) |pid| {
+            if (container_signal.sendSignal(pid, sig)) {
+                delivered = true;
+            } else |err| switch (err) {
+                // Init exited in the meantime; the wait below decides
+                error.ProcessNotFound => {},
+                else => {
+                    if (self.logger) |log| log.err("Failed to send signal {s} to {s} (pid {d}): {}", .{ signal, container_id, pid, err }) catch {};
+                    return core.Error.OperationFailed;
+                },
             }
-        }
-        // If direct attempts failed, poll status a few times and accept success if container is stopped
-        if (!success) {
-            var tries: usize = 0;
-            while (tries < 10 and !success) : (tries += 1) {
-                const st_args = [_][]const u8{ "pct", "status", vmid };
-                const st_res = self.runCommand(&st_args) catch null;
-                if (st_res) |r| {
-                    defer self.allocator.free(r.stdout);
-                    defer self.allocator.free(r.stderr);
-                    if (r.exit_code == 0) {
-                        const trimmed = std.mem.trim(u8, r.stdout, " \t\r\n");
-                        if (self.debug_mode) {
-                            _ = std.fs.File.stdout().writeAll("[KILL] poll status=\n") catch {};
-                            _ = std.fs.File.stdout().writeAll(trimmed) catch {};
-                            _ = std.fs.File.stdout().writeAll("\n") catch {};
-                        }
-                        if (std.mem.indexOf(u8, trimmed, "stopped") != null) {
-                            success = true;
-                            break;
-                        }
-                    }
-                }
+            if (self.debug_mode) {
+                var buf: [64]u8 = undefined;
+                const line = std.fmt.bufPrint(&buf, "[KILL] pid={d} delivered={}\n", .{ pid, delivered }) catch "";
+                _ = std.fs.File.stdout().writeAll(line) catch {};
             }
+        } else {
+            // No host PID to be had; fall back to signalling init from inside the guest
+            delivered = self.pctExecKill(vmid, signal);
         }
-        if (!success) {
+
+        // Init gone before the signal reached it means the container is exiting;
+        // accept success once it has stopped
+        if (!delivered and !self.waitStopped(vmid)) {
             if (self.logger) |log| log.err("Failed to send signal {s} to {s}", .{ signal, container_id }) catch {};
             return core.Error.OperationFailed;
         }
+        // SIGKILL cannot be ignored, so return only once the container is gone
+        if (sig == std.posix.SIG.KILL and !self.waitStopped(vmid)) {
+            if (self.logger) |log| log.err("Container {s} still running after SIGKILL", .{container_id}) catch {};
+            return core.Error.Timeout;
+        }
+        self.containers().invalidate();
     }
 
     /// Find an available template for container creation
@@ -1943,117 +1506,342 @@ pub const ProxmoxLxcDriver = struct {
 
         return false;
     }
-    /// Check if VMID already exists in Proxmox
-    fn vmidExists(self: *Self, vmid: []const u8) !bool {
-        const pct_args = [_][]const u8{ "pct", "list" };
-        const pct_res = self.runCommand(&pct_args) catch return false;
-        defer self.allocator.free(pct_res.stdout);
-        defer self.allocator.free(pct_res.stderr);
+    /// Check if a container with this hostname already exists
+    fn nameExists(self: *Self, name: []const u8) bool {
+        self.containers().ensureFresh() catch return false;
+        return self.containers().lookupVmid(name) != null;
+    }
 
-        if (pct_res.exit_code != 0) return false;
+    /// Reserve a free VMID in the configured range, preferring the name hash
+    fn reserveVmid(self: *Self, name: []const u8) !u32 {
+        var vmids = try vmid_allocator.VmidAllocator.initWithReader(self.allocator, self.logger, self.stateDir(), self.pve);
+        defer vmids.deinit();
 
-        // Parse pct list output to find VMID
-        var lines = std.mem.splitScalar(u8, pct_res.stdout, '\n');
-        var first = true;
-        while (lines.next()) |line| {
-            if (first) {
-                first = false;
-                continue; // Skip header
+        const range = vmid_allocator.VmidRange{
+            .first = self.config.vmid_first orelse vmid_allocator.VMID_MIN,
+            .last = self.config.vmid_last orelse vmid_allocator.VMID_MAX,
+        };
+        try range.validate();
+        const span = range.last - range.first + 1;
+        const preferred: u32 = range.first + @as(u32, @intCast(std.hash.Wyhash.hash(0, name) % span));
+        const vmid = try vmids.reserve(range, preferred);
+        if (self.logger) |log| log.debug("Reserved VMID {d} for {s}", .{ vmid, name }) catch {};
+        return vmid;
+    }
+
+    fn releaseVmid(self: *Self, vmid: u32) void {
+        var vmids = vmid_allocator.VmidAllocator.initWithReader(self.allocator, self.logger, self.stateDir(), self.pve) catch return;
+        defer vmids.deinit();
+        vmids.release(vmid) catch {};
+    }
+
+    fn warmPoolSize(self: *const Self) u32 {
+        return self.config.warm_pool_size orelse 0;
+    }
+
+    /// Take a warm container for `template` out of the pool, dropping members
+    /// whose container no longer exists and keeping running ones pooled
+    fn claimWarm(self: *Self, template: []const u8) ?u32 {
+        if (self.warmPoolSize() == 0) return null;
+        var pool = warm_pool.WarmPool.init(self.allocator, self.logger, self.stateDir());
+        defer pool.deinit();
+
+        // Members found running go back into the pool once the claim is settled
+        var running: std.ArrayListUnmanaged(u32) = .{};
+        defer {
+            for (running.items) |vmid| pool.add(template, vmid) catch |err| {
+                if (self.logger) |log| log.warn("Failed to return warm container {d} to the pool: {}", .{ vmid, err }) catch {};
+            };
+            running.deinit(self.allocator);
+        }
+
+        while (true) {
+            const vmid = (pool.claim(template) catch |err| {
+                if (self.logger) |log| log.warn("Failed to claim a warm container: {}", .{err}) catch {};
+                return null;
+            }) orelse return null;
+
+            var vmid_buf: [16]u8 = undefined;
+            const vmid_str = std.fmt.bufPrint(&vmid_buf, "{d}", .{vmid}) catch return null;
+            if (self.pve.openLxcConfig(vmid_str)) |existing| {
+                var conf = existing;
+                conf.deinit();
+                // Only a container known to be stopped may be rebound
+                if (self.runState(vmid_str) == .stopped) return vmid;
+                // Started by hand; keep it pooled rather than rebinding a live container
+                if (self.logger) |log| log.warn("Warm container {d} is running, skipping it", .{vmid}) catch {};
+                running.append(self.allocator, vmid) catch {
+                    pool.add(template, vmid) catch {};
+                    return null;
+                };
+            } else |_| {
+                if (self.logger) |log| log.warn("Warm container {d} is gone, dropping it", .{vmid}) catch {};
+                self.releaseVmid(vmid);
             }
-            const trimmed = std.mem.trim(u8, line, " \t\r");
-            if (trimmed.len < 20) continue; // Skip short lines
+        }
+    }
 
-            // Extract VMID (first 10 characters)
-            const vmid_str = std.mem.trim(u8, trimmed[0..10], " \t");
+    /// Top up the warm pool from a detached `nexcage warm-pool refill`, so
+    /// create returns without waiting for pct create. `container_id` picks
+    /// the same VMID pool the create was routed to.
+    fn spawnRefill(self: *Self, template: []const u8, container_id: []const u8) void {
+        var exe_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const exe = std.fs.selfExePath(&exe_buf) catch |err| {
+            if (self.logger) |log| log.warn("Failed to start warm pool refill: {}", .{err}) catch {};
+            return;
+        };
+        core.exec.spawnDetached(self.allocator, &.{ exe, "warm-pool", "refill", template, container_id }) catch |err| {
+            if (self.logger) |log| log.warn("Failed to start warm pool refill: {}", .{err}) catch {};
+        };
+    }
 
-            if (std.mem.eql(u8, vmid_str, vmid)) {
-                return true;
+    /// Create stopped containers from `template` until the pool holds
+    /// `warm_pool_size` of them; returns at once if a refill is already running
+    pub fn refillWarmPool(self: *Self, template: []const u8) !void {
+        var pool = warm_pool.WarmPool.init(self.allocator, self.logger, self.stateDir());
+        defer pool.deinit();
+        const refill_lock = (try pool.tryLockRefill()) orelse return;
+        defer refill_lock.close();
+
+        while (try pool.count(template) < self.warmPoolSize()) {
+            const vmid_num = try self.reserveVmid(template);
+            errdefer self.releaseVmid(vmid_num);
+            var vmid_buf: [16]u8 = undefined;
+            const vmid = try std.fmt.bufPrint(&vmid_buf, "{d}", .{vmid_num});
+            var hostname_buf: [64]u8 = undefined;
+            const hostname = try warm_pool.warmHostname(&hostname_buf, vmid_num);
+
+            var conf = try lxc_config.compile(self.allocator, self.logger, .{
+                .vmid = vmid,
+                .template = template,
+                .hostname = hostname,
+                .bridge = self.config.default_bridge orelse core.constants.DEFAULT_BRIDGE_NAME,
+                .ostype = self.config.default_ostype orelse "ubuntu",
+                .unprivileged = self.config.default_unprivileged orelse false,
+            });
+            defer conf.deinit();
+
+            if (self.config.clone_storage == null or !self.cloneFromBase(template, vmid, hostname)) {
+                try self.runPct(conf.argv.items);
             }
+
+            try pool.add(template, vmid_num);
+            if (self.logger) |log| log.info("Warm container {d} ready for {s}", .{ vmid_num, template }) catch {};
         }
+    }
 
-        return false;
+    /// Linked-clone the base of `template` into `vmid`; false when the caller
+    /// should fall back to pct create
+    fn cloneFromBase(self: *Self, template: []const u8, vmid: []const u8, hostname: []const u8) bool {
+        const base_vmid = self.ensureCloneBase(template) catch |err| {
+            if (self.logger) |log| log.warn("No clone base for {s}, falling back to pct create: {}", .{ template, err }) catch {};
+            return false;
+        };
+        var base_buf: [16]u8 = undefined;
+        const base_str = std.fmt.bufPrint(&base_buf, "{d}", .{base_vmid}) catch return false;
+
+        // Cloning a template is linked by default; on ZFS storage that is a zfs clone of its snapshot
+        const args = [_][]const u8{ "pct", "clone", base_str, vmid, "--hostname", hostname };
+        self.runPct(&args) catch return false;
+
+        var bases = clone_bases.CloneBases.init(self.allocator, self.logger, self.stateDir());
+        defer bases.deinit();
+        const vmid_num = std.fmt.parseInt(u32, vmid, 10) catch return true;
+        bases.addDependent(template, vmid_num) catch |err| {
+            if (self.logger) |log| log.warn("Failed to record clone {s} of {s}: {}", .{ vmid, template, err }) catch {};
+        };
+        if (self.logger) |log| log.info("Cloned container {s} from base {s}", .{ vmid, base_str }) catch {};
+        return true;
     }
 
-    /// Get VMID by container name
-    fn getVmidByName(self: *Self, name: []const u8) ![]u8 {
-        if (self.debug_mode) std.debug.print("DEBUG: getVmidByName() called with name: {s}\n", .{name});
+    /// Base container for `template`, unpacked and converted with `pct template` on first use
+    fn ensureCloneBase(self: *Self, template: []const u8) !u32 {
+        var bases = clone_bases.CloneBases.init(self.allocator, self.logger, self.stateDir());
+        defer bases.deinit();
+        if (try bases.lookup(template)) |vmid| return vmid;
+
+        const build_lock = try bases.lockBuild();
+        defer build_lock.close();
+        if (try bases.lookup(template)) |vmid| return vmid;
+
+        const vmid_num = try self.reserveVmid(template);
+        errdefer self.releaseVmid(vmid_num);
+        var vmid_buf: [16]u8 = undefined;
+        const vmid = try std.fmt.bufPrint(&vmid_buf, "{d}", .{vmid_num});
+        var hostname_buf: [64]u8 = undefined;
+        const hostname = try clone_bases.baseHostname(&hostname_buf, vmid_num);
+        const rootfs = try std.fmt.allocPrint(self.allocator, "{s}:{d}", .{ self.config.clone_storage.?, self.config.clone_rootfs_gb orelse DEFAULT_CLONE_ROOTFS_GB });
+        defer self.allocator.free(rootfs);
+
+        var conf = try lxc_config.compile(self.allocator, self.logger, .{
+            .vmid = vmid,
+            .template = template,
+            .hostname = hostname,
+            .bridge = self.config.default_bridge orelse core.constants.DEFAULT_BRIDGE_NAME,
+            .ostype = self.config.default_ostype orelse "ubuntu",
+            .unprivileged = self.config.default_unprivileged orelse false,
+            .rootfs = rootfs,
+        });
+        defer conf.deinit();
+        try self.runPct(conf.argv.items);
+        errdefer self.destroyVmid(vmid_num);
+
+        const template_args = [_][]const u8{ "pct", "template", vmid };
+        try self.runPct(&template_args);
+        try bases.register(template, vmid_num);
+
+        if (self.logger) |log| log.info("Built clone base {s} for {s}", .{ vmid, template }) catch {};
+        return vmid_num;
+    }
 
-        const pct_args = [_][]const u8{ "pct", "list" };
-        if (self.logger) |log| log.info("Running pct list command", .{}) catch {};
-        if (self.debug_mode) std.debug.print("DEBUG: About to run pct list\n", .{});
+    /// Forget `vmid` as a clone and destroy bases that nothing depends on and
+    /// whose template has been evicted
+    fn releaseClone(self: *Self, vmid: u32) void {
+        if (self.config.clone_storage == null) return;
+        var bases = clone_bases.CloneBases.init(self.allocator, self.logger, self.stateDir());
+        defer bases.deinit();
 
-        const pct_res = try self.runCommand(&pct_args);
-        defer self.allocator.free(pct_res.stdout);
-        defer self.allocator.free(pct_res.stderr);
+        bases.removeDependent(vmid) catch |err| {
+            if (self.logger) |log| log.warn("Failed to release clone {d}: {}", .{ vmid, err }) catch {};
+            return;
+        };
+        const stale = bases.collect(self.allocator, self, templateGone) catch return;
+        defer self.allocator.free(stale);
+        for (stale) |base| {
+            self.destroyVmid(base);
+            self.releaseVmid(base);
+        }
+    }
 
-        if (self.logger) |log| log.info("pct list result: exit_code={d}, stdout='{s}', stderr='{s}'", .{ pct_res.exit_code, pct_res.stdout, pct_res.stderr }) catch {};
-        if (self.debug_mode) std.debug.print("DEBUG: pct list result: exit_code={d}, stdout='{s}', stderr='{s}'\n", .{ pct_res.exit_code, pct_res.stdout, pct_res.stderr });
+    /// Whether a template volume has been removed; only local cache archives can be checked
+    fn templateGone(self: *Self, template: []const u8) bool {
+        _ = self;
+        const marker = ":vztmpl/";
+        const index = std.mem.indexOf(u8, template, marker) orelse return false;
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = std.fmt.bufPrint(&path_buf, "{s}/{s}", .{ image_converter.TEMPLATE_CACHE_DIR, template[index + marker.len ..] }) catch return false;
+        std.fs.cwd().access(path, .{}) catch return true;
+        return false;
+    }
 
-        if (pct_res.exit_code != 0) {
-            if (self.debug_mode) std.debug.print("DEBUG: pct list failed with exit_code={d}\n", .{pct_res.exit_code});
-            return core.Error.NotFound;
+    /// Run a pct command, mapping a non-zero exit to a core error
+    fn runPct(self: *Self, args: []const []const u8) !void {
+        const result = try self.runCommand(args);
+        defer self.allocator.free(result.stdout);
+        defer self.allocator.free(result.stderr);
+        if (result.exit_code != 0) {
+            if (self.logger) |log| log.err("{s} {s} failed: {s}", .{ args[0], args[1], result.stderr }) catch {};
+            return self.mapPctError(result.exit_code, result.stderr);
         }
+    }
 
-        // Parse pct list output to find VMID by name
-        var lines = std.mem.splitScalar(u8, pct_res.stdout, '\n');
-        var first = true;
-        while (lines.next()) |line| {
-            if (first) {
-                first = false;
-                continue; // Skip header
-            }
-            const trimmed = std.mem.trim(u8, line, " \t\r");
-            if (trimmed.len == 0) continue;
-
-            // Parse fixed-width columns from pct list output
-            // Format: "VMID       Status     Lock         Name"
-            // Example: "101        stopped                 container-1"
-            if (self.debug_mode) std.debug.print("DEBUG: Processing line: '{s}' (len={d})\n", .{ trimmed, trimmed.len });
-            if (trimmed.len < 20) continue; // Skip short lines
-
-            // Extract VMID (first 10 characters)
-            const vmid_str = std.mem.trim(u8, trimmed[0..10], " \t");
-            if (vmid_str.len == 0) continue;
-
-            // Extract Name (last column, starting from position 33)
-            // Name column starts around position 33 in pct list output
-            const name_start = @min(33, trimmed.len);
-            const name_str = std.mem.trim(u8, trimmed[name_start..], " \t");
-
-            if (self.logger) |log| log.info("Checking: vmid='{s}', name='{s}', looking for='{s}'", .{ vmid_str, name_str, name }) catch {};
-            if (self.debug_mode) std.debug.print("DEBUG: Checking: vmid='{s}', name='{s}', looking for='{s}'\n", .{ vmid_str, name_str, name });
-
-            if (std.mem.eql(u8, name_str, name)) {
-                if (self.logger) |log| log.info("Found match: vmid='{s}', name='{s}'", .{ vmid_str, name_str }) catch {};
-                if (self.debug_mode) std.debug.print("DEBUG: Found match: vmid='{s}', name='{s}'\n", .{ vmid_str, name_str });
-                return self.allocator.dupe(u8, vmid_str);
-            }
+    /// Best-effort `pct destroy`, for containers that never got a name
+    fn destroyVmid(self: *Self, vmid: u32) void {
+        var vmid_buf: [16]u8 = undefined;
+        const vmid_str = std.fmt.bufPrint(&vmid_buf, "{d}", .{vmid}) catch return;
+        const args = [_][]const u8{ "pct", "destroy", vmid_str, "--purge" };
+        const result = self.runCommand(&args) catch return;
+        self.allocator.free(result.stdout);
+        self.allocator.free(result.stderr);
+        self.containers().invalidate();
+    }
+
+    /// Wait for the container's cgroup to empty, up to the configured stop timeout
+    fn waitStopped(self: *Self, vmid: []const u8) bool {
+        const timeout_ms = self.config.stop_timeout_ms orelse cgroup_watch.DEFAULT_STOP_TIMEOUT_MS;
+        const stopped = cgroup_watch.waitStopped(&self.pve, vmid, timeout_ms) catch |err| blk: {
+            if (self.logger) |log| log.warn("Waiting for container {s} failed: {}", .{ vmid, err }) catch {};
+            break :blk null;
+        };
+        return stopped orelse self.pollPctStopped(vmid, timeout_ms);
+    }
+
+    /// Poll `pct status` where the cgroup cannot tell; each check is a fork
+    fn pollPctStopped(self: *Self, vmid: []const u8, timeout_ms: u32) bool {
+        const deadline = std.time.milliTimestamp() + timeout_ms;
+        while (self.pctStatus(vmid) != .stopped) {
+            const remaining = deadline - std.time.milliTimestamp();
+            if (remaining <= 0) return false;
+            std.Thread.sleep(@min(PCT_STATUS_POLL_MS, @as(u64, @intCast(remaining))) * std.time.ns_per_ms);
         }
+        return true;
+    }
+
+    /// Run state from the cgroup, asking `pct status` when it cannot tell
+    fn runState(self: *Self, vmid: []const u8) pve_config.RunState {
+        const state = self.pve.runState(vmid);
+        if (state != .unknown) return state;
+        return self.pctStatus(vmid);
+    }
+
+    /// Parse `status: running|stopped` from `pct status <vmid>`
+    fn pctStatus(self: *Self, vmid: []const u8) pve_config.RunState {
+        const res = self.runCommand(&.{ "pct", "status", vmid }) catch return .unknown;
+        defer {
+            self.allocator.free(res.stdout);
+            self.allocator.free(res.stderr);
+        }
+        if (res.exit_code != 0) return .unknown;
+        const line = std.mem.trim(u8, res.stdout, " \t\r\n");
+        const value = std.mem.trim(u8, line[(std.mem.indexOfScalar(u8, line, ':') orelse return .unknown) + 1 ..], " ");
+        if (std.mem.eql(u8, value, "running")) return .running;
+        if (std.mem.eql(u8, value, "stopped")) return .stopped;
+        return .unknown;
+    }
+
+    fn stateDir(self: *const Self) []const u8 {
+        return self.config.state_dir orelse DEFAULT_STATE_DIR;
+    }
+
+    /// Size of a template archive in the cache directory, 0 if it cannot be read
+    fn templateFileSize(self: *Self, template_name: []const u8) u64 {
+        const path = std.fmt.allocPrint(self.allocator, "{s}/{s}.tar.zst", .{ image_converter.TEMPLATE_CACHE_DIR, template_name }) catch return 0;
+        defer self.allocator.free(path);
+        const stat = std.fs.cwd().statFile(path) catch return 0;
+        return stat.size;
+    }
 
-        return core.Error.NotFound;
+    /// Get VMID by container name
+    fn getVmidByName(self: *Self, name: []const u8) ![]u8 {
+        if (self.debug_mode) std.debug.print("DEBUG: getVmidByName() called with name: {s}\n", .{name});
+
+        self.containers().ensureFresh() catch return core.Error.NotFound;
+
+        const vmid = self.containers().lookupVmid(name) orelse return core.Error.NotFound;
+        if (self.logger) |log| log.debug("Resolved container {s} to VMID {d}", .{ name, vmid }) catch {};
+        return std.fmt.allocPrint(self.allocator, "{d}", .{vmid});
     }
 
-    /// Run a command and return result
+    /// REST lifecycle, set up on first use; null to stay on pct
+    fn restApi(self: *Self) ?*api_lifecycle.ApiLifecycle {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const endpoint = self.config.proxmox_api orelse return null;
+        if (self.rest == null) {
+            self.rest = api_lifecycle.ApiLifecycle.init(self.allocator, self.logger, endpoint) catch |err| {
+                if (self.logger) |log| log.warn("Proxmox API unavailable, falling back to pct: {}", .{err}) catch {};
+                self.config.proxmox_api = null;
+                return null;
+            };
+        }
+        return &self.rest.?;
+    }
+
+    /// Run a command and return result; pct lifecycle verbs go through the
+    /// REST API when one is configured
     fn runCommand(self: *Self, args: []const []const u8) !CommandResult {
-        const result = std.process.Child.run(.{
-            .allocator = self.allocator,
-            .argv = args,
-            .max_output_bytes = 1024 * 1024, // 1MB
-        }) catch |err| {
+        if (self.restApi()) |rest| {
+            const api_result = rest.run(args) catch |err| {
+                if (self.logger) |log| log.err("Proxmox API call for {s} {s} failed: {}", .{ args[0], args[1], err }) catch {};
+                return core.Error.OperationFailed;
+            };
+            if (api_result) |result| return result;
+        }
+        const timeout_ms: u32 = if (std.mem.eql(u8, args[0], "pct")) pct.DEFAULT_TIMEOUT_MS else 0;
+        return core.exec.run(self.allocator, args, .{ .timeout_ms = timeout_ms, .max_output_bytes = 1024 * 1024 }) catch |err| {
             if (self.logger) |log| log.err("Failed to run command: {}", .{err}) catch {};
             return core.Error.OperationFailed;
         };
-
-        const exit_code = switch (result.term) {
-            .Exited => |code| @as(u8, @intCast(@abs(code))),
-            else => 1,
-        };
-
-        return CommandResult{
-            .stdout = result.stdout,
-            .stderr = result.stderr,
-            .exit_code = exit_code,
-        };
     }
 
     /// Map pct command errors to core errors with enhanced error messages
@@ -2119,17 +1907,8 @@ pub const ProxmoxLxcDriver = struct {
             log.info("Listing LXC containers via pct command", .{}) catch {};
         }
 
-        const pct_args = [_][]const u8{ "pct", "list" };
-        const pct_res = try self.runCommand(&pct_args);
-        defer self.allocator.free(pct_res.stdout);
-        defer self.allocator.free(pct_res.stderr);
-
-        if (pct_res.exit_code != 0) {
-            return core.Error.OperationFailed;
-        }
+        try self.containers().ensureFresh();
 
-        // Parse pct list output
-        var lines = std.mem.splitScalar(u8, pct_res.stdout, '\n');
         var containers = std.ArrayListUnmanaged(core.ContainerInfo){};
         defer {
             for (containers.items) |*c| {
@@ -2138,26 +1917,21 @@ pub const ProxmoxLxcDriver = struct {
             containers.deinit(allocator);
         }
 
-        var first = true;
-        while (lines.next()) |line| {
-            if (first) {
-                first = false;
-                continue; // Skip header
-            }
-            const trimmed = std.mem.trim(u8, line, " \t\r");
-            if (trimmed.len == 0) continue;
-
-            // Split by whitespace columns
-            var it = std.mem.tokenizeScalar(u8, trimmed, ' ');
-            const vmid_str = it.next() orelse continue;
-            const status_str = it.next() orelse "unknown";
-            const name_str = it.next() orelse "unknown";
-
+        for (self.containers().items()) |entry| {
+            var vmid_buf: [16]u8 = undefined;
+            const vmid = try std.fmt.bufPrint(&vmid_buf, "{d}", .{entry.vmid});
+            // The inventory only changes with .vmlist, so its status may be stale;
+            // the cgroup says what is running right now. Where it cannot tell,
+            // keep the inventory's word rather than fork a pct status per container
+            const status = switch (self.pve.runState(vmid)) {
+                .unknown => entry.status,
+                else => |state| @tagName(state),
+            };
             const container = core.ContainerInfo{
                 .allocator = allocator,
-                .id = try allocator.dupe(u8, vmid_str),
-                .name = try allocator.dupe(u8, name_str),
-                .status = try allocator.dupe(u8, status_str),
+                .id = try allocator.dupe(u8, vmid),
+                .name = try allocator.dupe(u8, entry.name),
+                .status = try allocator.dupe(u8, status),
                 .backend_type = try allocator.dupe(u8, "proxmox-lxc"),
                 .runtime = try allocator.dupe(u8, "pct"),
             };
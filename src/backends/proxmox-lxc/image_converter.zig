@@ -1,11 +1,19 @@
 const std = @import("std");
 const core = @import("core");
 const oci_bundle = @import("oci_bundle.zig");
+const layer_extractor = @import("layer_extractor.zig");
+const tree_copier = @import("tree_copier.zig");
+const template_packer = @import("template_packer.zig");
+
+/// Proxmox `local:vztmpl` storage directory
+pub const TEMPLATE_CACHE_DIR = "/var/lib/vz/template/cache";
 
 /// Image converter for transforming OCI bundles into LXC rootfs and Proxmox templates
 pub const ImageConverter = struct {
     allocator: std.mem.Allocator,
     logger: ?*core.LogContext,
+    /// zstd level and worker count for template archives
+    pack_options: template_packer.Options = .{},
 
     const Self = @This();
 
@@ -54,12 +62,7 @@ pub const ImageConverter = struct {
     pub fn createProxmoxTemplate(self: *Self, rootfs_dir: []const u8, template_name: []const u8, storage: []const u8) !void {
         if (self.logger) |log| try log.info("Creating Proxmox LXC template: {s} from {s}", .{ template_name, rootfs_dir });
 
-        // Create template archive
-        const archive_path = try self.createTemplateArchive(rootfs_dir, template_name);
-        defer self.allocator.free(archive_path);
-
-        // Upload to Proxmox storage
-        try self.uploadTemplateToStorage(archive_path, template_name, storage);
+        try self.packTemplate(rootfs_dir, template_name, storage);
 
         if (self.logger) |log| try log.info("Successfully created Proxmox LXC template: {s}", .{template_name});
     }
@@ -113,13 +116,12 @@ pub const ImageConverter = struct {
     fn extractArchive(self: *Self, archive_path: []const u8, dest_path: []const u8) !void {
         if (self.logger) |log| try log.info("Extracting archive: {s} -> {s}", .{ archive_path, dest_path });
 
-        // Determine archive type and extract accordingly
-        if (std.mem.endsWith(u8, archive_path, ".tar.zst")) {
-            try self.extractTarZst(archive_path, dest_path);
-        } else if (std.mem.endsWith(u8, archive_path, ".tar.gz")) {
-            try self.extractTarGz(archive_path, dest_path);
-        } else if (std.mem.endsWith(u8, archive_path, ".tar")) {
-            try self.extractTar(archive_path, dest_path);
+        if (std.mem.endsWith(u8, archive_path, ".tar.zst") or
+            std.mem.endsWith(u8, archive_path, ".tar.gz") or
+            std.mem.endsWith(u8, archive_path, ".tgz") or
+            std.mem.endsWith(u8, archive_path, ".tar"))
+        {
+            try self.extractLayer(archive_path, dest_path);
         } else {
             // If not an archive, treat as directory and copy contents
             if (self.logger) |log| try log.info("Treating as directory: {s}", .{archive_path});
@@ -132,194 +134,47 @@ pub const ImageConverter = struct {
         }
     }
 
-    /// Extract tar.zst archive
-    fn extractTarZst(self: *Self, archive_path: []const u8, dest_path: []const u8) !void {
-        const args = [_][]const u8{ "tar", "--zstd", "-xf", archive_path, "-C", dest_path };
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
+    /// Extract a tar layer in-process; compression is detected from the stream
+    fn extractLayer(self: *Self, archive_path: []const u8, dest_path: []const u8) !void {
+        try std.fs.cwd().makePath(dest_path);
+        var dest_dir = try std.fs.cwd().openDir(dest_path, .{});
+        defer dest_dir.close();
 
-        if (result.exit_code != 0) {
-            if (self.logger) |log| try log.err("Failed to extract tar.zst: {s}", .{result.stderr});
-            return error.ExtractionFailed;
-        }
-    }
-
-    /// Extract tar.gz archive
-    fn extractTarGz(self: *Self, archive_path: []const u8, dest_path: []const u8) !void {
-        const args = [_][]const u8{ "tar", "-zxf", archive_path, "-C", dest_path };
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
+        var extractor = try layer_extractor.LayerExtractor.init(self.allocator, self.logger, dest_dir, .{
+            .progress = .{ .ctx = self, .report = reportExtractProgress },
+        });
+        defer extractor.deinit();
 
-        if (result.exit_code != 0) {
-            if (self.logger) |log| try log.err("Failed to extract tar.gz: {s}", .{result.stderr});
+        extractor.extractFile(archive_path) catch |err| {
+            if (self.logger) |log| try log.err("Failed to extract {s}: {}", .{ archive_path, err });
             return error.ExtractionFailed;
-        }
+        };
     }
 
-    /// Extract tar archive
-    fn extractTar(self: *Self, archive_path: []const u8, dest_path: []const u8) !void {
-        const args = [_][]const u8{ "tar", "-xf", archive_path, "-C", dest_path };
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
-
-        if (result.exit_code != 0) {
-            if (self.logger) |log| try log.err("Failed to extract tar: {s}", .{result.stderr});
-            return error.ExtractionFailed;
-        }
+    fn reportExtractProgress(ctx: ?*anyopaque, stats: *const layer_extractor.ExtractStats) void {
+        const self: *Self = @ptrCast(@alignCast(ctx.?));
+        if (self.logger) |log| log.info("Extracted {d} entries, {d} MiB", .{ stats.entries, stats.bytes / (1024 * 1024) }) catch {};
     }
 
-    /// Copy directory recursively with detailed logging and error handling
+    /// Copy a directory tree into dest_path using the parallel tree copier
     fn copyDirectoryRecursive(self: *Self, source_dir: std.fs.Dir, dest_path: []const u8) !void {
-        var file_count: usize = 0;
-        var dir_count: usize = 0;
-        var symlink_count: usize = 0;
-        var error_count: usize = 0;
-
-        // Always output to stderr for debugging even if logger fails
-        std.debug.print("[IMAGE_CONVERTER] Starting recursive copy to: {s}\n", .{dest_path});
-
-        if (self.logger) |log| {
-            log.info("Starting recursive copy to: {s}", .{dest_path}) catch |err| {
-                std.debug.print("[IMAGE_CONVERTER] Logger failed: {}\n", .{err});
-            };
-        }
-
-        var iterator = source_dir.iterate();
-        while (try iterator.next()) |entry| {
-            const dest_file_path = try std.fmt.allocPrint(self.allocator, "{s}/{s}", .{ dest_path, entry.name });
-            defer self.allocator.free(dest_file_path);
-
-            switch (entry.kind) {
-                .directory => {
-                    if (self.logger) |log| {
-                        try log.debug("Copying directory: {s} -> {s}", .{ entry.name, dest_file_path });
-                    }
-                    dir_count += 1;
-                    std.fs.cwd().makePath(dest_file_path) catch |err| {
-                        if (self.logger) |log| {
-                            try log.err("Failed to create directory {s}: {}", .{ dest_file_path, err });
-                        }
-                        error_count += 1;
-                        return err;
-                    };
-
-                    var subdir = source_dir.openDir(entry.name, .{ .iterate = true }) catch |err| {
-                        if (self.logger) |log| {
-                            try log.err("Failed to open subdirectory {s}: {}", .{ entry.name, err });
-                        }
-                        error_count += 1;
-                        return err;
-                    };
-                    defer subdir.close();
-
-                    try self.copyDirectoryRecursive(subdir, dest_file_path);
-                },
-                .file => {
-                    std.debug.print("[IMAGE_CONVERTER] Copying file: {s} -> {s}\n", .{ entry.name, dest_file_path });
-
-                    if (self.logger) |log| {
-                        log.debug("Copying file: {s} -> {s}", .{ entry.name, dest_file_path }) catch {};
-                    }
-                    file_count += 1;
-
-                    const source_file = source_dir.openFile(entry.name, .{}) catch |err| {
-                        if (self.logger) |log| {
-                            try log.err("Failed to open source file {s}: {}", .{ entry.name, err });
-                        }
-                        error_count += 1;
-                        return err;
-                    };
-                    defer source_file.close();
-
-                    // Ensure parent directory exists
-                    const parent_dir = std.fs.path.dirname(dest_file_path) orelse dest_path;
-                    std.fs.cwd().makePath(parent_dir) catch |err| switch (err) {
-                        error.PathAlreadyExists => {},
-                        else => {
-                            if (self.logger) |log| {
-                                try log.err("Failed to create parent directory {s}: {}", .{ parent_dir, err });
-                            }
-                            error_count += 1;
-                            return err;
-                        },
-                    };
-
-                    const dest_file = std.fs.cwd().createFile(dest_file_path, .{}) catch |err| {
-                        if (self.logger) |log| {
-                            try log.err("Failed to create destination file {s}: {}", .{ dest_file_path, err });
-                        }
-                        error_count += 1;
-                        return err;
-                    };
-                    defer dest_file.close();
-
-                    _ = try source_file.copyRangeAll(0, dest_file, 0, std.math.maxInt(u64));
-
-                    if (self.logger) |log| {
-                        try log.debug("Successfully copied file: {s}", .{entry.name});
-                    }
-                },
-                .sym_link => {
-                    if (self.logger) |log| {
-                        try log.debug("Copying symlink: {s} -> {s}", .{ entry.name, dest_file_path });
-                    }
-                    symlink_count += 1;
-
-                    // Ensure parent directory exists
-                    const parent_dir = std.fs.path.dirname(dest_file_path) orelse dest_path;
-                    std.fs.cwd().makePath(parent_dir) catch |err| switch (err) {
-                        error.PathAlreadyExists => {},
-                        else => {
-                            if (self.logger) |log| {
-                                try log.err("Failed to create parent directory for symlink {s}: {}", .{ parent_dir, err });
-                            }
-                            error_count += 1;
-                            return err;
-                        },
-                    };
+        if (self.logger) |log| log.info("Starting recursive copy to: {s}", .{dest_path}) catch {};
 
-                    const link_target = source_dir.readLink(entry.name, &[_]u8{}) catch |err| {
-                        if (self.logger) |log| {
-                            try log.err("Failed to read symlink target {s}: {}", .{ entry.name, err });
-                        }
-                        error_count += 1;
-                        return err;
-                    };
+        try std.fs.cwd().makePath(dest_path);
+        var dest_dir = try std.fs.cwd().openDir(dest_path, .{});
+        defer dest_dir.close();
 
-                    std.fs.cwd().symLink(link_target, dest_file_path, .{}) catch |err| {
-                        if (self.logger) |log| {
-                            try log.err("Failed to create symlink {s} -> {s}: {}", .{ dest_file_path, link_target, err });
-                        }
-                        error_count += 1;
-                        return err;
-                    };
-                },
-                else => {
-                    if (self.logger) |log| {
-                        try log.warn("Skipping unsupported entry type {s}: {s}", .{ @tagName(entry.kind), entry.name });
-                    }
-                },
-            }
-        }
-
-        // Always output to stderr for debugging
-        std.debug.print("[IMAGE_CONVERTER] Copy completed: {d} files, {d} directories, {d} symlinks, {d} errors in {s}\n", .{ file_count, dir_count, symlink_count, error_count, dest_path });
+        var copier = tree_copier.TreeCopier.init(self.allocator, self.logger, source_dir, dest_dir, .{});
+        const stats = copier.run() catch |err| {
+            if (self.logger) |log| log.err("Copy to {s} failed: {}", .{ dest_path, err }) catch {};
+            return core.Error.CopyFailed;
+        };
 
         if (self.logger) |log| {
-            log.info("Copy completed: {d} files, {d} directories, {d} symlinks, {d} errors in {s}", .{ file_count, dir_count, symlink_count, error_count, dest_path }) catch {};
-        }
-
-        if (error_count > 0) {
-            if (self.logger) |log| {
-                try log.err("Copy operation had {d} errors", .{error_count});
-            }
-            return core.Error.CopyFailed;
+            log.info("Copy completed: {d} files ({d} reflinked, {d} bytes), {d} directories, {d} symlinks, {d} skipped in {s}", .{ stats.files, stats.reflinked, stats.bytes, stats.dirs, stats.symlinks, stats.skipped, dest_path }) catch {};
         }
 
-        if (file_count == 0 and dir_count == 0) {
+        if (stats.files == 0 and stats.dirs == 0) {
             if (self.logger) |log| {
                 try log.warn("No files or directories copied to {s}", .{dest_path});
             }
@@ -646,79 +501,43 @@ pub const ImageConverter = struct {
         }
     }
 
-    /// Create template archive from rootfs
-    fn createTemplateArchive(self: *Self, rootfs_dir: []const u8, template_name: []const u8) ![]const u8 {
+    /// Pack rootfs straight into the template cache as <name>.tar.zst
+    fn packTemplate(self: *Self, rootfs_dir: []const u8, template_name: []const u8, storage: []const u8) !void {
+        _ = storage;
         // Validate rootfs before creating archive
         try self.validateRootfsDirectory(rootfs_dir);
 
         const archive_name = try std.fmt.allocPrint(self.allocator, "{s}.tar.zst", .{template_name});
-        const archive_path = try std.fmt.allocPrint(self.allocator, "/tmp/{s}", .{archive_name});
         defer self.allocator.free(archive_name);
 
         if (self.logger) |log| {
-            try log.info("Creating template archive: {s} from {s}", .{ archive_path, rootfs_dir });
+            try log.info("Packing template archive: {s}/{s} from {s}", .{ TEMPLATE_CACHE_DIR, archive_name, rootfs_dir });
         }
 
-        const args = [_][]const u8{ "tar", "--zstd", "-cf", archive_path, "-C", rootfs_dir, "." };
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
+        var rootfs = try std.fs.cwd().openDir(rootfs_dir, .{ .iterate = true });
+        defer rootfs.close();
+        var cache_dir = try std.fs.cwd().makeOpenPath(TEMPLATE_CACHE_DIR, .{});
+        defer cache_dir.close();
 
-        if (result.exit_code != 0) {
+        var packer = try template_packer.TemplatePacker.init(self.allocator, self.logger, self.pack_options);
+        defer packer.deinit();
+        const stats = packer.pack(rootfs, cache_dir, archive_name) catch |err| {
             if (self.logger) |log| {
-                try log.err("Failed to create template archive (exit code {d}): {s}", .{ result.exit_code, result.stderr });
-            }
-            return core.Error.ArchiveCreationFailed;
-        }
-
-        // Verify archive was created and has reasonable size
-        var archive_file = std.fs.cwd().openFile(archive_path, .{}) catch |err| {
-            if (self.logger) |log| {
-                try log.err("Failed to verify archive file: {s} ({})", .{ archive_path, err });
+                try log.err("Failed to create template archive {s}: {}", .{ archive_name, err });
             }
             return core.Error.ArchiveCreationFailed;
         };
-        defer archive_file.close();
 
-        const archive_stat = try archive_file.stat();
         if (self.logger) |log| {
-            try log.info("Template archive created: {s} ({d} bytes)", .{ archive_path, archive_stat.size });
+            try log.info("Template archive created: {s} ({d} entries, {d} bytes)", .{ archive_name, stats.entries, stats.archive_bytes });
         }
 
         // Warn if archive is suspiciously small (< 500 bytes typically indicates only metadata)
-        if (archive_stat.size < 500) {
+        if (stats.archive_bytes < 500) {
             if (self.logger) |log| {
-                try log.warn("Archive is very small ({d} bytes), may not contain rootfs content", .{archive_stat.size});
+                try log.warn("Archive is very small ({d} bytes), may not contain rootfs content", .{stats.archive_bytes});
             }
         }
-
-        return archive_path;
-    }
-
-    /// Upload template to Proxmox storage
-    fn uploadTemplateToStorage(self: *Self, archive_path: []const u8, template_name: []const u8, storage: []const u8) !void {
-        _ = storage;
-        const storage_path = try std.fmt.allocPrint(self.allocator, "/var/lib/vz/template/cache/{s}.tar.zst", .{template_name});
-        defer self.allocator.free(storage_path);
-
-        if (self.logger) |log| try log.info("Uploading template to storage: {s} -> {s}", .{ archive_path, storage_path });
-
-        // Copy archive to Proxmox template storage
-        const args = [_][]const u8{ "cp", archive_path, storage_path };
-        const result = try self.runCommand(&args);
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
-
-        if (result.exit_code != 0) {
-            if (self.logger) |log| try log.err("Failed to upload template: {s}", .{result.stderr});
-            return error.UploadFailed;
-        }
-
-        // Set proper permissions
-        const chmod_args = [_][]const u8{ "chmod", "644", storage_path };
-        const chmod_result = try self.runCommand(&chmod_args);
-        defer self.allocator.free(chmod_result.stdout);
-        defer self.allocator.free(chmod_result.stderr);
     }
 
     /// Cleanup directory
@@ -733,31 +552,9 @@ pub const ImageConverter = struct {
 
     /// Run shell command
     fn runCommand(self: *Self, args: []const []const u8) !CommandResult {
-        var child = std.process.Child.init(args, self.allocator);
-        child.stdout_behavior = .Pipe;
-        child.stderr_behavior = .Pipe;
-
-        try child.spawn();
-
-        const stdout = try child.stdout.?.readToEndAlloc(self.allocator, 1024 * 1024);
-        const stderr = try child.stderr.?.readToEndAlloc(self.allocator, 1024 * 1024);
-
-        const term = try child.wait();
-
-        return CommandResult{
-            .stdout = stdout,
-            .stderr = stderr,
-            .exit_code = switch (term) {
-                .Exited => |code| @intCast(code),
-                else => 1,
-            },
-        };
+        return core.exec.run(self.allocator, args, .{ .max_output_bytes = 1024 * 1024 });
     }
 };
 
 /// Command execution result
-const CommandResult = struct {
-    stdout: []u8,
-    stderr: []u8,
-    exit_code: u8,
-};
+const CommandResult = core.exec.Result;
@@ -0,0 +1,182 @@
+const std = @import("std");
+const core = @import("core");
+
+/// pmxcfs bumps the mtime of this file whenever a guest is created, destroyed or migrated
+pub const VMLIST_PATH = "/etc/pve/.vmlist";
+
+/// `pct list` only reads configs; far longer means pmxcfs is hung
+const LIST_TIMEOUT_MS: u32 = 30_000;
+
+/// Single row of the container inventory
+pub const InventoryEntry = struct {
+    vmid: u32,
+    status: []const u8,
+    name: []const u8,
+};
+
+/// Cached container inventory indexed by name and VMID
+/// Built from one `pct list` and reused until /etc/pve/.vmlist changes.
+/// Starts and stops do not touch .vmlist, so `status` is only what `pct list`
+/// and this process last saw; read the live state from the cgroup instead
+/// Lookups are safe to share between batch workers; items() and statusOf() are not
+pub const ContainerInventory = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext = null,
+    arena: std.heap.ArenaAllocator,
+    entries: std.ArrayListUnmanaged(InventoryEntry) = .{},
+    by_name: std.StringHashMapUnmanaged(usize) = .{},
+    by_vmid: std.AutoHashMapUnmanaged(u32, usize) = .{},
+    vmlist_path: []const u8 = VMLIST_PATH,
+    vmlist_mtime: ?i128 = null,
+    loaded: bool = false,
+    mutex: std.Thread.Mutex = .{},
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .arena = std.heap.ArenaAllocator.init(allocator),
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.entries.deinit(self.allocator);
+        self.by_name.deinit(self.allocator);
+        self.by_vmid.deinit(self.allocator);
+        self.arena.deinit();
+    }
+
+    /// Drop cached data so the next lookup reloads it
+    pub fn invalidate(self: *Self) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.loaded = false;
+    }
+
+    /// Reload the inventory if it was never loaded or .vmlist changed since
+    pub fn ensureFresh(self: *Self) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const mtime = self.currentMtime();
+        if (self.loaded and sameMtime(mtime, self.vmlist_mtime)) return;
+
+        try self.reload();
+        self.vmlist_mtime = mtime;
+    }
+
+    /// Rebuild the indexes from `pct list` output
+    pub fn load(self: *Self, output: []const u8) !void {
+        self.clear();
+        const arena = self.arena.allocator();
+
+        var lines = std.mem.splitScalar(u8, output, '\n');
+        while (lines.next()) |line| {
+            // Columns: VMID Status [Lock] Name; Lock is blank unless the CT is locked
+            var fields: [4][]const u8 = undefined;
+            var count: usize = 0;
+            var it = std.mem.tokenizeAny(u8, line, " \t\r");
+            while (it.next()) |field| {
+                if (count < fields.len) fields[count] = field;
+                count += 1;
+            }
+            if (count < 3) continue;
+
+            // Header row and garbage fail here
+            const vmid = std.fmt.parseInt(u32, fields[0], 10) catch continue;
+            const name = fields[@min(count, fields.len) - 1];
+
+            const idx = self.entries.items.len;
+            try self.entries.append(self.allocator, .{
+                .vmid = vmid,
+                .status = try arena.dupe(u8, fields[1]),
+                .name = try arena.dupe(u8, name),
+            });
+            try self.by_vmid.put(self.allocator, vmid, idx);
+
+            // Hostnames are not unique in Proxmox; keep the first match like `pct list` order
+            const gop = try self.by_name.getOrPut(self.allocator, self.entries.items[idx].name);
+            if (!gop.found_existing) gop.value_ptr.* = idx;
+        }
+
+        self.loaded = true;
+    }
+
+    /// Look up VMID by container name
+    pub fn lookupVmid(self: *Self, name: []const u8) ?u32 {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const idx = self.by_name.get(name) orelse return null;
+        return self.entries.items[idx].vmid;
+    }
+
+    /// Check whether a VMID is present
+    pub fn contains(self: *Self, vmid: u32) bool {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        return self.by_vmid.contains(vmid);
+    }
+
+    /// Status reported by `pct list` for a VMID
+    pub fn statusOf(self: *const Self, vmid: u32) ?[]const u8 {
+        const idx = self.by_vmid.get(vmid) orelse return null;
+        return self.entries.items[idx].status;
+    }
+
+    /// Record a status change made by this process without rescanning
+    pub fn setStatus(self: *Self, vmid: u32, status: []const u8) void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const idx = self.by_vmid.get(vmid) orelse return;
+        const owned = self.arena.allocator().dupe(u8, status) catch return;
+        self.entries.items[idx].status = owned;
+    }
+
+    /// All entries in `pct list` order
+    pub fn items(self: *const Self) []const InventoryEntry {
+        return self.entries.items;
+    }
+
+    fn clear(self: *Self) void {
+        self.entries.clearRetainingCapacity();
+        self.by_name.clearRetainingCapacity();
+        self.by_vmid.clearRetainingCapacity();
+        _ = self.arena.reset(.retain_capacity);
+        self.loaded = false;
+    }
+
+    fn reload(self: *Self) !void {
+        if (self.logger) |log| log.debug("Refreshing container inventory via pct list", .{}) catch {};
+
+        var result = core.exec.run(self.allocator, &.{ "pct", "list" }, .{
+            .timeout_ms = LIST_TIMEOUT_MS,
+            .max_output_bytes = 4 * 1024 * 1024,
+        }) catch |err| {
+            if (self.logger) |log| log.err("Failed to run pct list: {}", .{err}) catch {};
+            return core.Error.OperationFailed;
+        };
+        defer result.deinit(self.allocator);
+
+        if (result.exit_code != 0) {
+            if (self.logger) |log| log.warn("pct list failed: {s}", .{result.stderr}) catch {};
+            return core.Error.OperationFailed;
+        }
+
+        try self.load(result.stdout);
+    }
+
+    fn currentMtime(self: *const Self) ?i128 {
+        const stat = std.fs.cwd().statFile(self.vmlist_path) catch return null;
+        return stat.mtime;
+    }
+
+    fn sameMtime(a: ?i128, b: ?i128) bool {
+        if (a) |x| {
+            if (b) |y| return x == y;
+            return false;
+        }
+        return b == null;
+    }
+};
@@ -0,0 +1,658 @@
+const std = @import("std");
+const core = @import("core");
+
+const linux = std.os.linux;
+
+/// Layer compression, detected from the stream magic rather than the file name
+pub const Compression = enum {
+    none,
+    gzip,
+    zstd,
+
+    pub fn detect(magic: []const u8) Compression {
+        if (std.mem.startsWith(u8, magic, "\x1f\x8b")) return .gzip;
+        if (std.mem.startsWith(u8, magic, "\x28\xb5\x2f\xfd")) return .zstd;
+        return .none;
+    }
+};
+
+/// Running totals for one extraction
+pub const ExtractStats = struct {
+    entries: u64 = 0,
+    bytes: u64 = 0,
+    skipped: u64 = 0,
+    whiteouts: u64 = 0,
+};
+
+/// Progress callback, invoked roughly every `every_bytes` of file data
+pub const Progress = struct {
+    ctx: ?*anyopaque = null,
+    report: *const fn (ctx: ?*anyopaque, stats: *const ExtractStats) void,
+    every_bytes: u64 = 64 * 1024 * 1024,
+};
+
+pub const Options = struct {
+    /// Apply OCI `.wh.` whiteouts against what lower layers left in the destination
+    whiteouts: bool = true,
+    /// chown entries to the archive uid/gid (only effective as root)
+    preserve_owner: bool = true,
+    progress: ?Progress = null,
+};
+
+/// File data is copied through a buffer this large to keep write syscalls big
+const WRITE_BUFFER_SIZE = 1024 * 1024;
+const READ_BUFFER_SIZE = 256 * 1024;
+const BLOCK = 512;
+
+const WHITEOUT_PREFIX = ".wh.";
+const OPAQUE_WHITEOUT = ".wh..wh..opq";
+
+const EntryKind = enum { file, hardlink, symlink, char_device, block_device, directory, fifo };
+
+const Xattr = struct {
+    name: [:0]const u8,
+    value: []const u8,
+};
+
+/// Fields gathered from the ustar header plus any preceding PAX/GNU records
+const Entry = struct {
+    kind: EntryKind,
+    path: []const u8,
+    link: []const u8,
+    size: u64,
+    mode: u32,
+    uid: u32,
+    gid: u32,
+    mtime: i64,
+    dev_major: u32,
+    dev_minor: u32,
+    xattrs: []const Xattr,
+};
+
+/// Streaming tar extractor for OCI layers and rootfs archives
+///
+/// Reads the archive once, decompressing gzip/zstd in-process, and writes each
+/// entry straight into `dest`. Handles PAX and GNU long names, hardlinks,
+/// symlinks, device nodes, FIFOs, SCHILY xattrs and OCI whiteouts. Layers are
+/// applied in order by calling extractFile once per layer on the same
+/// destination.
+pub const LayerExtractor = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    dest: std.fs.Dir,
+    options: Options,
+    stats: ExtractStats = .{},
+    write_buf: []u8,
+    /// Per-entry scratch for names, PAX records and xattrs
+    entry_arena: std.heap.ArenaAllocator,
+    /// Paths created by the current layer; opaque whiteouts must not remove them
+    layer_paths: std.StringHashMapUnmanaged(void) = .{},
+    layer_arena: std.heap.ArenaAllocator,
+    last_parent: std.ArrayListUnmanaged(u8) = .{},
+    parent_dir: ?std.fs.Dir = null,
+    parent_valid: bool = false,
+    reported_bytes: u64 = 0,
+    is_root: bool,
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, dest: std.fs.Dir, options: Options) !Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .dest = dest,
+            .options = options,
+            .write_buf = try allocator.alloc(u8, WRITE_BUFFER_SIZE),
+            .entry_arena = std.heap.ArenaAllocator.init(allocator),
+            .layer_arena = std.heap.ArenaAllocator.init(allocator),
+            .is_root = linux.geteuid() == 0,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.closeParent();
+        self.allocator.free(self.write_buf);
+        self.entry_arena.deinit();
+        self.layer_paths.deinit(self.allocator);
+        self.layer_arena.deinit();
+        self.last_parent.deinit(self.allocator);
+    }
+
+    /// Extract one (optionally compressed) tar file into the destination
+    pub fn extractFile(self: *Self, archive_path: []const u8) !void {
+        const file = try std.fs.cwd().openFile(archive_path, .{});
+        defer file.close();
+
+        const read_buf = try self.allocator.alloc(u8, READ_BUFFER_SIZE);
+        defer self.allocator.free(read_buf);
+        var file_reader = file.reader(read_buf);
+        const input = &file_reader.interface;
+
+        const magic = input.peek(4) catch |err| switch (err) {
+            error.EndOfStream => return error.InvalidArchive,
+            else => return err,
+        };
+        const compression = Compression.detect(magic);
+        if (self.logger) |log| log.debug("Extracting {s} ({s})", .{ archive_path, @tagName(compression) }) catch {};
+
+        switch (compression) {
+            .none => try self.extractStream(input),
+            .gzip => {
+                const window = try self.allocator.alloc(u8, std.compress.flate.max_window_len);
+                defer self.allocator.free(window);
+                var gz = std.compress.flate.Decompress.init(input, .gzip, window);
+                try self.extractStream(&gz.reader);
+            },
+            .zstd => {
+                const window = try self.allocator.alloc(u8, std.compress.zstd.default_window_len + std.compress.zstd.block_size_max);
+                defer self.allocator.free(window);
+                var zs = std.compress.zstd.Decompress.init(input, window, .{});
+                try self.extractStream(&zs.reader);
+            },
+        }
+    }
+
+    /// Extract an uncompressed tar stream
+    pub fn extractStream(self: *Self, reader: *std.Io.Reader) !void {
+        self.beginLayer();
+
+        var long_path: ?[]const u8 = null;
+        var long_link: ?[]const u8 = null;
+        var pax = PaxRecords{};
+
+        while (true) {
+            var block: [BLOCK]u8 = undefined;
+            reader.readSliceAll(&block) catch |err| switch (err) {
+                // Some producers omit the two terminating zero blocks
+                error.EndOfStream => break,
+                else => return err,
+            };
+            if (std.mem.allEqual(u8, &block, 0)) break;
+            if (!checksumValid(&block)) return error.InvalidArchive;
+
+            const arena = self.entry_arena.allocator();
+            const header_size = try parseNumeric(block[124..136]);
+            const typeflag = block[156];
+
+            switch (typeflag) {
+                'x' => {
+                    const data = try readPadded(arena, reader, header_size);
+                    try pax.parse(arena, data);
+                    continue;
+                },
+                'g' => {
+                    try skipPadded(reader, header_size);
+                    continue;
+                },
+                'L' => {
+                    long_path = trimNul(try readPadded(arena, reader, header_size));
+                    continue;
+                },
+                'K' => {
+                    long_link = trimNul(try readPadded(arena, reader, header_size));
+                    continue;
+                },
+                else => {},
+            }
+
+            const size = pax.size orelse header_size;
+            const raw_path = pax.path orelse long_path orelse try ustarPath(arena, &block);
+            const entry = Entry{
+                .kind = entryKind(typeflag, raw_path) orelse {
+                    if (self.logger) |log| log.warn("Skipping unsupported tar entry type '{c}' for {s}", .{ typeflag, raw_path }) catch {};
+                    self.stats.skipped += 1;
+                    try skipPadded(reader, size);
+                    self.resetEntry(&long_path, &long_link, &pax);
+                    continue;
+                },
+                .path = raw_path,
+                .link = pax.linkpath orelse long_link orelse trimNul(block[157..257]),
+                .size = size,
+                .mode = (try parseU32(block[100..108])) & 0o7777,
+                .uid = pax.uid orelse try parseU32(block[108..116]),
+                .gid = pax.gid orelse try parseU32(block[116..124]),
+                .mtime = pax.mtime orelse std.math.cast(i64, try parseNumeric(block[136..148])) orelse 0,
+                .dev_major = try parseU32(block[329..337]),
+                .dev_minor = try parseU32(block[337..345]),
+                .xattrs = pax.xattrs.items,
+            };
+
+            const consumed = try self.applyEntry(reader, entry);
+            if (!consumed) try reader.discardAll64(entry.size);
+            try reader.discardAll(padding(entry.size));
+
+            self.stats.entries += 1;
+            self.reportProgress(false);
+            self.resetEntry(&long_path, &long_link, &pax);
+        }
+
+        self.reportProgress(true);
+        if (self.logger) |log| log.info("Extracted {d} entries ({d} bytes, {d} whiteouts, {d} skipped)", .{ self.stats.entries, self.stats.bytes, self.stats.whiteouts, self.stats.skipped }) catch {};
+    }
+
+    fn beginLayer(self: *Self) void {
+        self.layer_paths.clearRetainingCapacity();
+        _ = self.layer_arena.reset(.retain_capacity);
+        self.closeParent();
+    }
+
+    fn resetEntry(self: *Self, long_path: *?[]const u8, long_link: *?[]const u8, pax: *PaxRecords) void {
+        long_path.* = null;
+        long_link.* = null;
+        pax.* = .{};
+        _ = self.entry_arena.reset(.retain_capacity);
+    }
+
+    /// Apply one entry; returns true if its data was consumed from the reader
+    ///
+    /// Every path is resolved beneath `dest` one component at a time without
+    /// following symlinks, so a link planted by an earlier entry or a lower
+    /// layer cannot redirect a write, link or delete outside the rootfs.
+    fn applyEntry(self: *Self, reader: *std.Io.Reader, entry: Entry) !bool {
+        const path = normalizePath(entry.path) orelse {
+            if (self.logger) |log| log.warn("Skipping unsafe tar path: {s}", .{entry.path}) catch {};
+            self.stats.skipped += 1;
+            return false;
+        };
+        if (path.len == 0) return false;
+
+        const base = std.fs.path.basename(path);
+        const parent_path = std.fs.path.dirname(path) orelse "";
+        if (self.options.whiteouts and std.mem.startsWith(u8, base, WHITEOUT_PREFIX)) {
+            try self.applyWhiteout(parent_path, base);
+            return false;
+        }
+
+        const parent = self.parentDir(parent_path) catch |err| switch (err) {
+            error.UnsafePath => {
+                if (self.logger) |log| log.warn("Skipping {s}: a parent is a symlink or not a directory", .{path}) catch {};
+                self.stats.skipped += 1;
+                return false;
+            },
+            else => return err,
+        };
+        try self.notePath(path);
+
+        switch (entry.kind) {
+            .directory => {
+                var dir = openNoFollow(parent, base) catch |err| switch (err) {
+                    // Whatever a lower layer left here is replaced, never followed
+                    error.FileNotFound, error.UnsafePath => blk: {
+                        try self.removeExisting(parent, base);
+                        try parent.makeDir(base);
+                        break :blk try openNoFollow(parent, base);
+                    },
+                    else => return err,
+                };
+                defer dir.close();
+                self.applyMetadata(dir.fd, entry);
+                return false;
+            },
+            .file => {
+                try self.removeExisting(parent, base);
+                // O_EXCL: never open through a symlink at the final component
+                const file = try parent.createFile(base, .{ .mode = entry.mode, .exclusive = true });
+                defer file.close();
+
+                var writer = file.writer(self.write_buf);
+                try reader.streamExact64(&writer.interface, entry.size);
+                try writer.interface.flush();
+
+                self.stats.bytes += entry.size;
+                self.applyMetadata(file.handle, entry);
+                file.updateTimes(entry.mtime * std.time.ns_per_s, entry.mtime * std.time.ns_per_s) catch {};
+                return true;
+            },
+            .symlink => {
+                try self.removeExisting(parent, base);
+                try parent.symLink(entry.link, base, .{});
+                if (self.options.preserve_owner and self.is_root) {
+                    const base_z = try std.posix.toPosixPath(base);
+                    _ = linux.fchownat(parent.fd, &base_z, entry.uid, entry.gid, linux.AT.SYMLINK_NOFOLLOW);
+                }
+                return false;
+            },
+            .hardlink => {
+                const target = normalizePath(entry.link) orelse "";
+                const target_base = std.fs.path.basename(target);
+                var target_dir = if (isPlainName(target_base))
+                    self.openBeneath(std.fs.path.dirname(target) orelse "", false) catch |err| switch (err) {
+                        error.FileNotFound, error.UnsafePath => null,
+                        else => return err,
+                    }
+                else
+                    null;
+                if (target_dir == null) {
+                    if (self.logger) |log| log.warn("Skipping hardlink with unsafe target: {s} -> {s}", .{ path, entry.link }) catch {};
+                    self.stats.skipped += 1;
+                    return false;
+                }
+                defer target_dir.?.close();
+
+                try self.removeExisting(parent, base);
+                // No AT_SYMLINK_FOLLOW: a symlink target is linked, not resolved
+                try std.posix.linkat(target_dir.?.fd, target_base, parent.fd, base, 0);
+                return false;
+            },
+            .char_device, .block_device, .fifo => {
+                try self.removeExisting(parent, base);
+                const file_type: u32 = switch (entry.kind) {
+                    .char_device => linux.S.IFCHR,
+                    .block_device => linux.S.IFBLK,
+                    else => linux.S.IFIFO,
+                };
+                const base_z = try std.posix.toPosixPath(base);
+                const rc = linux.mknodat(parent.fd, &base_z, file_type | entry.mode, encodeDev(entry.dev_major, entry.dev_minor));
+                switch (std.posix.errno(rc)) {
+                    .SUCCESS => {},
+                    // Unprivileged extraction cannot create device nodes; tar skips them too
+                    .PERM => {
+                        if (self.logger) |log| log.warn("No permission to create device node {s}, skipping", .{path}) catch {};
+                        self.stats.skipped += 1;
+                    },
+                    else => |e| return std.posix.unexpectedErrno(e),
+                }
+                return false;
+            },
+        }
+    }
+
+    fn applyWhiteout(self: *Self, parent_path: []const u8, base: []const u8) !void {
+        self.stats.whiteouts += 1;
+        const opaque_dir = std.mem.eql(u8, base, OPAQUE_WHITEOUT);
+        const target = base[WHITEOUT_PREFIX.len..];
+        if (!opaque_dir and !isPlainName(target)) {
+            if (self.logger) |log| log.warn("Skipping unsafe whiteout: {s}", .{base}) catch {};
+            self.stats.skipped += 1;
+            return;
+        }
+
+        // Nothing to white out when the directory is missing, and never through a symlink
+        var dir = self.openBeneath(parent_path, false) catch |err| switch (err) {
+            error.FileNotFound, error.UnsafePath => {
+                if (self.logger) |log| log.debug("Whiteout {s} in {s} not applied: {}", .{ base, parent_path, err }) catch {};
+                return;
+            },
+            else => return err,
+        };
+        defer dir.close();
+        self.invalidateParent();
+
+        if (opaque_dir) {
+            try self.clearLowerEntries(dir, parent_path);
+            return;
+        }
+        dir.deleteTree(target) catch |err| {
+            if (self.logger) |log| log.debug("Whiteout target {s} not removed: {}", .{ target, err }) catch {};
+        };
+    }
+
+    /// Opaque directory: drop everything lower layers put there, keep this layer's entries
+    fn clearLowerEntries(self: *Self, dir: std.fs.Dir, dir_path: []const u8) !void {
+        const arena = self.entry_arena.allocator();
+        var doomed = std.ArrayListUnmanaged([]const u8){};
+        var it = dir.iterate();
+        while (try it.next()) |child| {
+            const child_path = if (dir_path.len == 0)
+                child.name
+            else
+                try std.fs.path.join(arena, &.{ dir_path, child.name });
+            if (self.layer_paths.contains(child_path)) continue;
+            try doomed.append(arena, try arena.dupe(u8, child.name));
+        }
+        for (doomed.items) |name| try dir.deleteTree(name);
+    }
+
+    /// Parent directory of the entry being applied, opened beneath dest
+    ///
+    /// Entries are usually grouped by directory, so the handle is kept until
+    /// the next entry names another parent or something is removed.
+    fn parentDir(self: *Self, parent: []const u8) !std.fs.Dir {
+        if (self.parent_dir) |dir| {
+            if (self.parent_valid and std.mem.eql(u8, parent, self.last_parent.items)) return dir;
+        }
+        self.closeParent();
+        const dir = try self.openBeneath(parent, true);
+        self.parent_dir = dir;
+        try self.last_parent.appendSlice(self.allocator, parent);
+        self.parent_valid = true;
+        return dir;
+    }
+
+    /// A removal may have taken the cached parent with it; reopen on next use
+    fn invalidateParent(self: *Self) void {
+        self.parent_valid = false;
+    }
+
+    fn closeParent(self: *Self) void {
+        if (self.parent_dir) |*dir| dir.close();
+        self.parent_dir = null;
+        self.parent_valid = false;
+        self.last_parent.clearRetainingCapacity();
+    }
+
+    /// Open `rel` under dest one component at a time with O_NOFOLLOW,
+    /// creating missing directories when `create` is set. error.UnsafePath
+    /// when a component is a symlink or not a directory.
+    fn openBeneath(self: *Self, rel: []const u8, create: bool) !std.fs.Dir {
+        var dir = std.fs.Dir{ .fd = try std.posix.openat(self.dest.fd, ".", .{ .DIRECTORY = true, .CLOEXEC = true }, 0) };
+        errdefer dir.close();
+
+        var components = std.mem.tokenizeScalar(u8, rel, '/');
+        while (components.next()) |component| {
+            if (std.mem.eql(u8, component, ".")) continue;
+            const next = openNoFollow(dir, component) catch |err| switch (err) {
+                error.FileNotFound => if (create) blk: {
+                    dir.makeDir(component) catch |e| switch (e) {
+                        error.PathAlreadyExists => {},
+                        else => return e,
+                    };
+                    break :blk try openNoFollow(dir, component);
+                } else return err,
+                else => return err,
+            };
+            dir.close();
+            dir = next;
+        }
+        return dir;
+    }
+
+    /// Replace whatever a lower layer left at `name`, never writing through it
+    fn removeExisting(self: *Self, parent: std.fs.Dir, name: []const u8) !void {
+        parent.deleteFile(name) catch |err| switch (err) {
+            error.FileNotFound => {},
+            error.IsDir => {
+                self.invalidateParent();
+                try parent.deleteTree(name);
+            },
+            else => return err,
+        };
+    }
+
+    fn notePath(self: *Self, path: []const u8) !void {
+        if (!self.options.whiteouts) return;
+        const gop = try self.layer_paths.getOrPut(self.allocator, path);
+        if (!gop.found_existing) gop.key_ptr.* = try self.layer_arena.allocator().dupe(u8, path);
+    }
+
+    fn applyMetadata(self: *Self, fd: std.posix.fd_t, entry: Entry) void {
+        if (self.options.preserve_owner and self.is_root) {
+            std.posix.fchown(fd, entry.uid, entry.gid) catch {};
+        }
+        // After chown, which clears setuid bits; and the create mode was masked by umask
+        std.posix.fchmod(fd, entry.mode) catch {};
+
+        for (entry.xattrs) |xattr| {
+            const rc = linux.fsetxattr(@intCast(fd), xattr.name.ptr, xattr.value.ptr, xattr.value.len, 0);
+            if (std.posix.errno(rc) != .SUCCESS) {
+                if (self.logger) |log| log.debug("Failed to set xattr {s} on {s}", .{ xattr.name, entry.path }) catch {};
+            }
+        }
+    }
+
+    fn reportProgress(self: *Self, final: bool) void {
+        const progress = self.options.progress orelse return;
+        if (!final and self.stats.bytes - self.reported_bytes < progress.every_bytes) return;
+        self.reported_bytes = self.stats.bytes;
+        progress.report(progress.ctx, &self.stats);
+    }
+};
+
+/// PAX extended header values that override the following entry
+const PaxRecords = struct {
+    path: ?[]const u8 = null,
+    linkpath: ?[]const u8 = null,
+    size: ?u64 = null,
+    uid: ?u32 = null,
+    gid: ?u32 = null,
+    mtime: ?i64 = null,
+    xattrs: std.ArrayListUnmanaged(Xattr) = .{},
+
+    /// Records are `<len> <key>=<value>\n`, where len counts the whole record
+    fn parse(self: *PaxRecords, arena: std.mem.Allocator, data: []const u8) !void {
+        var rest = data;
+        while (rest.len > 0) {
+            const space = std.mem.indexOfScalar(u8, rest, ' ') orelse return error.InvalidArchive;
+            const len = std.fmt.parseInt(usize, rest[0..space], 10) catch return error.InvalidArchive;
+            if (len <= space + 1 or len > rest.len or rest[len - 1] != '\n') return error.InvalidArchive;
+
+            const record = rest[space + 1 .. len - 1];
+            rest = rest[len..];
+            const eq = std.mem.indexOfScalar(u8, record, '=') orelse continue;
+            const key = record[0..eq];
+            const value = record[eq + 1 ..];
+
+            if (std.mem.eql(u8, key, "path")) {
+                self.path = value;
+            } else if (std.mem.eql(u8, key, "linkpath")) {
+                self.linkpath = value;
+            } else if (std.mem.eql(u8, key, "size")) {
+                self.size = std.fmt.parseInt(u64, value, 10) catch return error.InvalidArchive;
+            } else if (std.mem.eql(u8, key, "uid")) {
+                self.uid = std.fmt.parseInt(u32, value, 10) catch null;
+            } else if (std.mem.eql(u8, key, "gid")) {
+                self.gid = std.fmt.parseInt(u32, value, 10) catch null;
+            } else if (std.mem.eql(u8, key, "mtime")) {
+                // Fractional seconds are dropped
+                const whole = value[0 .. std.mem.indexOfScalar(u8, value, '.') orelse value.len];
+                self.mtime = std.fmt.parseInt(i64, whole, 10) catch null;
+            } else if (std.mem.startsWith(u8, key, "SCHILY.xattr.")) {
+                try self.xattrs.append(arena, .{
+                    .name = try arena.dupeZ(u8, key["SCHILY.xattr.".len..]),
+                    .value = value,
+                });
+            }
+        }
+    }
+};
+
+fn entryKind(typeflag: u8, path: []const u8) ?EntryKind {
+    return switch (typeflag) {
+        // Pre-POSIX archives mark directories only by a trailing slash
+        0, '0', '7' => if (std.mem.endsWith(u8, path, "/")) .directory else .file,
+        '1' => .hardlink,
+        '2' => .symlink,
+        '3' => .char_device,
+        '4' => .block_device,
+        '5' => .directory,
+        '6' => .fifo,
+        else => null,
+    };
+}
+
+/// Strip leading `/` and `./`, trailing `/`; null if the path escapes the root
+fn normalizePath(raw: []const u8) ?[]const u8 {
+    var path = raw;
+    while (true) {
+        if (std.mem.startsWith(u8, path, "/")) {
+            path = path[1..];
+        } else if (std.mem.startsWith(u8, path, "./")) {
+            path = path[2..];
+        } else break;
+    }
+    path = std.mem.trimRight(u8, path, "/");
+    if (std.mem.eql(u8, path, ".")) return "";
+
+    var components = std.mem.splitScalar(u8, path, '/');
+    while (components.next()) |component| {
+        if (std.mem.eql(u8, component, "..")) return null;
+    }
+    return path;
+}
+
+/// Open a directory entry of `dir` without following a symlink there
+fn openNoFollow(dir: std.fs.Dir, name: []const u8) !std.fs.Dir {
+    const fd = std.posix.openat(dir.fd, name, .{ .DIRECTORY = true, .NOFOLLOW = true, .CLOEXEC = true }, 0) catch |err| switch (err) {
+        error.SymLinkLoop, error.NotDir => return error.UnsafePath,
+        else => return err,
+    };
+    return .{ .fd = fd };
+}
+
+/// A single path component that names something inside its directory
+fn isPlainName(name: []const u8) bool {
+    return name.len > 0 and !std.mem.eql(u8, name, ".") and !std.mem.eql(u8, name, "..") and
+        std.mem.indexOfScalar(u8, name, '/') == null;
+}
+
+fn ustarPath(arena: std.mem.Allocator, block: *const [BLOCK]u8) ![]const u8 {
+    const name = trimNul(block[0..100]);
+    const prefix = if (std.mem.eql(u8, block[257..262], "ustar")) trimNul(block[345..500]) else "";
+    if (prefix.len == 0) return name;
+    return std.fmt.allocPrint(arena, "{s}/{s}", .{ prefix, name });
+}
+
+fn trimNul(field: []const u8) []const u8 {
+    const end = std.mem.indexOfScalar(u8, field, 0) orelse field.len;
+    return field[0..end];
+}
+
+/// Octal ASCII, or GNU base-256 when the high bit of the first byte is set
+fn parseNumeric(field: []const u8) !u64 {
+    if (field.len > 0 and field[0] & 0x80 != 0) {
+        var value: u64 = field[0] & 0x7f;
+        for (field[1..]) |byte| {
+            value = std.math.shlExact(u64, value, 8) catch return error.InvalidArchive;
+            value |= byte;
+        }
+        return value;
+    }
+    const trimmed = std.mem.trim(u8, trimNul(field), " ");
+    if (trimmed.len == 0) return 0;
+    return std.fmt.parseInt(u64, trimmed, 8) catch error.InvalidArchive;
+}
+
+fn parseU32(field: []const u8) !u32 {
+    return std.math.cast(u32, try parseNumeric(field)) orelse error.InvalidArchive;
+}
+
+fn checksumValid(block: *const [BLOCK]u8) bool {
+    const expected = parseNumeric(block[148..156]) catch return false;
+    var sum: u64 = 0;
+    for (block, 0..) |byte, i| {
+        sum += if (i >= 148 and i < 156) ' ' else byte;
+    }
+    return sum == expected;
+}
+
+fn padding(size: u64) usize {
+    return @intCast((BLOCK - size % BLOCK) % BLOCK);
+}
+
+fn readPadded(arena: std.mem.Allocator, reader: *std.Io.Reader, size: u64) ![]u8 {
+    if (size > 16 * 1024 * 1024) return error.InvalidArchive;
+    const data = try arena.alloc(u8, @intCast(size));
+    try reader.readSliceAll(data);
+    try reader.discardAll(padding(size));
+    return data;
+}
+
+fn skipPadded(reader: *std.Io.Reader, size: u64) !void {
+    try reader.discardAll64(size);
+    try reader.discardAll(padding(size));
+}
+
+/// Kernel `new_encode_dev` layout expected by mknodat
+fn encodeDev(major: u32, minor: u32) u32 {
+    return (minor & 0xff) | ((major & 0xfff) << 8) | ((minor & ~@as(u32, 0xff)) << 12);
+}
@@ -0,0 +1,91 @@
+const std = @import("std");
+
+/// Line-per-record index shared by concurrent CLI processes
+///
+/// The index lives in `<state_dir>/<name>.idx` and is rewritten atomically
+/// (tmp + rename, both fsynced) under an flock on `<name>.lock`, so every
+/// process always sees a consistent view. `lock` reloads it; records and
+/// their strings live in an arena that is reset on every reload.
+///
+/// `Record` provides `parseLine(arena, line) !?Record`, null skipping a
+/// malformed line, and `writeLine(record, allocator, out) !void`, which
+/// appends the line including its `\n`.
+pub fn LockedIndex(comptime Record: type, comptime name: []const u8, comptime max_bytes: usize) type {
+    return struct {
+        const Self = @This();
+
+        pub const INDEX_NAME = name ++ ".idx";
+        pub const LOCK_NAME = name ++ ".lock";
+
+        allocator: std.mem.Allocator,
+        state_dir: []const u8,
+        arena: std.heap.ArenaAllocator,
+        records: std.ArrayListUnmanaged(Record) = .{},
+
+        pub fn init(allocator: std.mem.Allocator, state_dir: []const u8) Self {
+            return Self{
+                .allocator = allocator,
+                .state_dir = state_dir,
+                .arena = std.heap.ArenaAllocator.init(allocator),
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            self.arena.deinit();
+        }
+
+        /// Allocator for strings of records added while locked
+        pub fn recordAllocator(self: *Self) std.mem.Allocator {
+            return self.arena.allocator();
+        }
+
+        /// Take the index lock and reload the index; close the returned file to unlock
+        pub fn lock(self: *Self) !std.fs.File {
+            try std.fs.cwd().makePath(self.state_dir);
+            var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+            const lock_path = try std.fmt.bufPrint(&path_buf, "{s}/{s}", .{ self.state_dir, LOCK_NAME });
+            const file = try std.fs.cwd().createFile(lock_path, .{ .truncate = false, .lock = .exclusive });
+            errdefer file.close();
+            try self.load();
+            return file;
+        }
+
+        fn load(self: *Self) !void {
+            self.records = .{};
+            _ = self.arena.reset(.retain_capacity);
+            const arena = self.arena.allocator();
+
+            var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+            const index_path = try std.fmt.bufPrint(&path_buf, "{s}/{s}", .{ self.state_dir, INDEX_NAME });
+            const data = std.fs.cwd().readFileAlloc(arena, index_path, max_bytes) catch |err| switch (err) {
+                error.FileNotFound => return,
+                else => return err,
+            };
+
+            var lines = std.mem.splitScalar(u8, data, '\n');
+            while (lines.next()) |line| {
+                if (line.len == 0) continue;
+                const record = try Record.parseLine(arena, line) orelse continue;
+                try self.records.append(arena, record);
+            }
+        }
+
+        /// Caller holds the lock
+        pub fn save(self: *Self) !void {
+            var data = std.ArrayListUnmanaged(u8){};
+            defer data.deinit(self.allocator);
+            for (self.records.items) |record| try record.writeLine(self.allocator, &data);
+
+            var dir = try std.fs.cwd().openDir(self.state_dir, .{});
+            defer dir.close();
+            {
+                const tmp = try dir.createFile(INDEX_NAME ++ ".tmp", .{ .truncate = true });
+                defer tmp.close();
+                try tmp.writeAll(data.items);
+                try tmp.sync();
+            }
+            try dir.rename(INDEX_NAME ++ ".tmp", INDEX_NAME);
+            std.posix.fsync(dir.fd) catch {};
+        }
+    };
+}
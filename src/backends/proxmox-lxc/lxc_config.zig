@@ -0,0 +1,175 @@
+const std = @import("std");
+const core = @import("core");
+const oci_bundle = @import("oci_bundle.zig");
+
+/// Everything that decides a new container's LXC config
+pub const Input = struct {
+    vmid: []const u8,
+    template: []const u8,
+    hostname: []const u8,
+    /// Parsed config.json; its resources win over the sandbox request
+    bundle: ?*const oci_bundle.OciBundleConfig = null,
+    memory_bytes: ?u64 = null,
+    cpu: ?f64 = null,
+    /// Bridge for NICs that do not name their own host link
+    bridge: []const u8,
+    ostype: []const u8,
+    unprivileged: bool,
+    /// ZFS dataset or storage volume for the rootfs
+    rootfs: ?[]const u8 = null,
+};
+
+pub const NetDevice = struct {
+    alias: []const u8,
+    bridge: []const u8,
+    host_name: ?[]const u8 = null,
+};
+
+/// Compiled config; all strings live in the arena
+pub const CompiledConfig = struct {
+    arena: std.heap.ArenaAllocator,
+    /// Complete `pct create` argv
+    argv: std.ArrayListUnmanaged([]const u8) = .{},
+    net_devices: std.ArrayListUnmanaged(NetDevice) = .{},
+    mount_count: usize = 0,
+
+    pub fn deinit(self: *CompiledConfig) void {
+        self.arena.deinit();
+    }
+};
+
+/// Mount points LXC sets up itself; bundle entries for them are not mpX volumes
+const LXC_MANAGED_DESTINATIONS = [_][]const u8{ "/proc", "/sys", "/dev", "/dev/pts", "/dev/shm", "/dev/mqueue", "/sys/fs/cgroup" };
+
+/// OCI mount options pct accepts in `mountoptions=`
+const PCT_MOUNT_OPTIONS = [_][]const u8{ "noatime", "nodev", "nosuid", "noexec" };
+
+/// Compile a container's full LXC config (resources, network, features and
+/// mount points) into a single `pct create` invocation
+///
+/// pct validates the whole config against its schema and writes
+/// /etc/pve/lxc/<vmid>.conf once, so no follow-up `pct set`, conf appends or
+/// read-back are needed.
+pub fn compile(allocator: std.mem.Allocator, logger: ?*core.LogContext, input: Input) !CompiledConfig {
+    var compiled = CompiledConfig{ .arena = std.heap.ArenaAllocator.init(allocator) };
+    errdefer compiled.deinit();
+    const arena = compiled.arena.allocator();
+
+    try compiled.argv.appendSlice(arena, &.{ "pct", "create", input.vmid, input.template, "--hostname", input.hostname });
+    try compileSettable(arena, logger, &compiled, input);
+    try compiled.argv.appendSlice(arena, &.{ "--ostype", input.ostype, "--unprivileged", if (input.unprivileged) "1" else "0" });
+    if (input.rootfs) |rootfs| try compiled.argv.appendSlice(arena, &.{ "--rootfs", rootfs });
+    return compiled;
+}
+
+/// Compile the options of `compile` that an existing container can change
+/// into one `pct set` call; rebinds a pre-created warm container to a new
+/// name and bundle. Template, ostype, privilege and rootfs are fixed at
+/// creation and therefore ignored.
+pub fn compileRebind(allocator: std.mem.Allocator, logger: ?*core.LogContext, input: Input) !CompiledConfig {
+    var compiled = CompiledConfig{ .arena = std.heap.ArenaAllocator.init(allocator) };
+    errdefer compiled.deinit();
+    const arena = compiled.arena.allocator();
+
+    try compiled.argv.appendSlice(arena, &.{ "pct", "set", input.vmid, "--hostname", input.hostname });
+    try compileSettable(arena, logger, &compiled, input);
+    return compiled;
+}
+
+fn compileSettable(arena: std.mem.Allocator, logger: ?*core.LogContext, compiled: *CompiledConfig, input: Input) !void {
+    const argv = &compiled.argv;
+
+    // Priority: bundle > sandbox request > defaults
+    const bundle = input.bundle;
+    const memory_bytes = if (bundle) |bc| bc.memory_limit orelse input.memory_bytes else input.memory_bytes;
+    const memory_mb = (memory_bytes orelse core.constants.DEFAULT_MEMORY_BYTES) / (1024 * 1024);
+    try argv.appendSlice(arena, &.{ "--memory", try std.fmt.allocPrint(arena, "{d}", .{memory_mb}) });
+
+    // CPU shares map to cores at roughly 1024 shares per core
+    const bundle_cores: ?f64 = if (bundle) |bc| if (bc.cpu_limit) |shares| shares / 1024.0 else null else null;
+    const cores = @max(bundle_cores orelse input.cpu orelse @as(f64, core.constants.DEFAULT_CPU_CORES), 1.0);
+    try argv.appendSlice(arena, &.{ "--cores", try std.fmt.allocPrint(arena, "{d}", .{@as(u32, @intFromFloat(cores))}) });
+
+    try compileNet(arena, compiled, input);
+
+    if (bundle) |bc| {
+        if (bc.namespaces) |namespaces| {
+            try argv.appendSlice(arena, &.{ "--features", featuresFor(namespaces) });
+        }
+        if (bc.mounts) |mounts| {
+            for (mounts) |*mount| {
+                const value = try mountPointValue(arena, mount) orelse {
+                    if (logger) |log| log.debug("Skipping bundle mount {s} -> {s}", .{ mount.source orelse "-", mount.destination orelse "-" }) catch {};
+                    continue;
+                };
+                const flag = try std.fmt.allocPrint(arena, "--mp{d}", .{compiled.mount_count});
+                try argv.appendSlice(arena, &.{ flag, value });
+                compiled.mount_count += 1;
+            }
+        }
+    }
+}
+
+fn compileNet(arena: std.mem.Allocator, compiled: *CompiledConfig, input: Input) !void {
+    const devices: []const oci_bundle.NetDeviceConfig = if (input.bundle) |bc| bc.net_devices orelse &.{} else &.{};
+    if (devices.len == 0) {
+        try compiled.argv.appendSlice(arena, &.{ "--net0", try std.fmt.allocPrint(arena, "name=eth0,bridge={s},ip=dhcp", .{input.bridge}) });
+        try compiled.net_devices.append(arena, .{ .alias = "eth0", .bridge = input.bridge });
+        return;
+    }
+
+    for (devices, 0..) |device, idx| {
+        // device.name is the preferred host link
+        const bridge = device.name orelse input.bridge;
+        try compiled.argv.appendSlice(arena, &.{
+            try std.fmt.allocPrint(arena, "--net{d}", .{idx}),
+            try std.fmt.allocPrint(arena, "name={s},bridge={s},ip=dhcp", .{ device.alias, bridge }),
+        });
+        try compiled.net_devices.append(arena, .{ .alias = device.alias, .bridge = bridge, .host_name = device.name });
+    }
+}
+
+/// OCI namespaces map onto LXC features; pid, net, ipc, uts, mount and cgroup
+/// namespaces are always on in LXC. A user namespace usually means a nested
+/// container runtime, which needs nesting.
+fn featuresFor(namespaces: []const oci_bundle.NamespaceConfig) []const u8 {
+    for (namespaces) |ns| {
+        if (std.mem.eql(u8, ns.type, "user")) return "nesting=1,keyctl=1";
+    }
+    return "keyctl=1";
+}
+
+/// `<source>,mp=<dest>[,ro=1][,mountoptions=a;b]`, or null for mounts that
+/// are not a host path or storage volume (proc, tmpfs, ...)
+fn mountPointValue(arena: std.mem.Allocator, mount: *const oci_bundle.MountConfig) !?[]const u8 {
+    const source = mount.source orelse return null;
+    const dest = mount.destination orelse return null;
+    for (LXC_MANAGED_DESTINATIONS) |managed| {
+        if (std.mem.eql(u8, dest, managed)) return null;
+    }
+    const is_host_path = source.len > 0 and source[0] == '/';
+    const is_storage = !is_host_path and std.mem.indexOfScalar(u8, source, ':') != null;
+    if (!is_host_path and !is_storage) return null;
+
+    var value = std.ArrayListUnmanaged(u8){};
+    try value.print(arena, "{s},mp={s}", .{ source, dest });
+
+    if (mount.options) |options| {
+        var mount_options = std.ArrayListUnmanaged(u8){};
+        var it = std.mem.tokenizeScalar(u8, options, ',');
+        while (it.next()) |option| {
+            if (std.mem.eql(u8, option, "ro")) {
+                try value.appendSlice(arena, ",ro=1");
+                continue;
+            }
+            for (PCT_MOUNT_OPTIONS) |supported| {
+                if (!std.mem.eql(u8, option, supported)) continue;
+                if (mount_options.items.len > 0) try mount_options.append(arena, ';');
+                try mount_options.appendSlice(arena, option);
+            }
+            // bind/rbind/rw and propagation flags are implied by an mpX bind mount
+        }
+        if (mount_options.items.len > 0) try value.print(arena, ",mountoptions={s}", .{mount_options.items});
+    }
+    return value.items;
+}
@@ -0,0 +1,320 @@
+const std = @import("std");
+const core = @import("core");
+
+/// Container ID to VMID mapping entry
+pub const MappingEntry = struct {
+    container_id: []const u8,
+    vmid: u32,
+    created_at: i64, // Unix timestamp
+    bundle_path: []const u8,
+
+    pub fn deinit(self: *MappingEntry, allocator: std.mem.Allocator) void {
+        allocator.free(self.container_id);
+        allocator.free(self.bundle_path);
+    }
+};
+
+/// Append-only container ID -> VMID store
+///
+/// Every mutation appends one checksummed line to `mapping.log` while holding an
+/// flock on `mapping.lock`, so concurrent CLI processes never lose each other's
+/// writes. Readers replay only the bytes appended since their last look. Torn
+/// or corrupted records fail their CRC and are skipped. The log is rewritten
+/// atomically (tmp + rename) once dead records outnumber live ones.
+///
+/// Record: `<crc32 hex>\t+\t<id>\t<vmid>\t<created_at>\t<bundle>\n` or `<crc32 hex>\t-\t<id>\n`
+pub const MappingStore = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    state_dir: []const u8,
+    log_path: []const u8,
+    lock_path: []const u8,
+    entries: std.StringHashMapUnmanaged(MappingEntry) = .{},
+    by_vmid: std.AutoHashMapUnmanaged(u32, void) = .{},
+    log_inode: ?std.fs.File.INode = null,
+    replayed_offset: u64 = 0,
+    record_count: usize = 0,
+    pending_sync: u32 = 0,
+    /// fsync after this many appends; the rest are synced on deinit
+    sync_batch: u32 = 16,
+
+    pub const LOG_NAME = "mapping.log";
+    pub const LOCK_NAME = "mapping.lock";
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8) !Self {
+        const log_path = try std.fs.path.join(allocator, &[_][]const u8{ state_dir, LOG_NAME });
+        errdefer allocator.free(log_path);
+        const lock_path = try std.fs.path.join(allocator, &[_][]const u8{ state_dir, LOCK_NAME });
+
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .state_dir = state_dir,
+            .log_path = log_path,
+            .lock_path = lock_path,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        if (self.pending_sync > 0) self.syncLog() catch {};
+        self.clear();
+        self.entries.deinit(self.allocator);
+        self.by_vmid.deinit(self.allocator);
+        self.allocator.free(self.log_path);
+        self.allocator.free(self.lock_path);
+    }
+
+    /// Current mapping for a container, if any. The entry is owned by the store.
+    pub fn get(self: *Self, container_id: []const u8) !?MappingEntry {
+        try self.refresh();
+        return self.entries.get(container_id);
+    }
+
+    /// Whether any container is mapped to this VMID
+    pub fn vmidInUse(self: *Self, vmid: u32) !bool {
+        try self.refresh();
+        return self.by_vmid.contains(vmid);
+    }
+
+    /// Number of live mappings
+    pub fn count(self: *Self) !usize {
+        try self.refresh();
+        return self.entries.count();
+    }
+
+    /// Record or replace a mapping
+    pub fn put(self: *Self, container_id: []const u8, vmid: u32, created_at: i64, bundle_path: []const u8) !void {
+        if (!isFieldSafe(container_id) or !isFieldSafe(bundle_path)) return core.Error.InvalidInput;
+
+        var payload_buf: [4096]u8 = undefined;
+        const payload = std.fmt.bufPrint(&payload_buf, "+\t{s}\t{d}\t{d}\t{s}", .{ container_id, vmid, created_at, bundle_path }) catch return core.Error.InvalidInput;
+        try self.appendRecord(payload);
+    }
+
+    /// Drop a mapping; returns false if it did not exist
+    pub fn remove(self: *Self, container_id: []const u8) !bool {
+        if (!isFieldSafe(container_id)) return core.Error.InvalidInput;
+
+        var lock = try self.lockWriter();
+        defer lock.close();
+        try self.refresh();
+        if (!self.entries.contains(container_id)) return false;
+
+        var payload_buf: [1024]u8 = undefined;
+        const payload = std.fmt.bufPrint(&payload_buf, "-\t{s}", .{container_id}) catch return core.Error.InvalidInput;
+        try self.appendLocked(payload);
+        return true;
+    }
+
+    /// Iterate live mappings (refresh() first for an up-to-date view)
+    pub fn iterator(self: *const Self) std.StringHashMapUnmanaged(MappingEntry).Iterator {
+        return self.entries.iterator();
+    }
+
+    /// Replay records appended since the last call
+    pub fn refresh(self: *Self) !void {
+        const file = std.fs.cwd().openFile(self.log_path, .{}) catch |err| switch (err) {
+            error.FileNotFound => {
+                self.clear();
+                return;
+            },
+            else => return err,
+        };
+        defer file.close();
+
+        const stat = try file.stat();
+        // Compaction swaps the inode; a shorter file means we cannot trust our offset
+        if (self.log_inode == null or self.log_inode.? != stat.inode or stat.size < self.replayed_offset) {
+            self.clear();
+            self.log_inode = stat.inode;
+        }
+        if (stat.size == self.replayed_offset) return;
+
+        const len: usize = @intCast(stat.size - self.replayed_offset);
+        const buf = try self.allocator.alloc(u8, len);
+        defer self.allocator.free(buf);
+        const n = try file.preadAll(buf, self.replayed_offset);
+
+        // Only consume whole lines; a torn tail is re-read next time
+        const end = if (std.mem.lastIndexOfScalar(u8, buf[0..n], '\n')) |i| i + 1 else 0;
+        var lines = std.mem.splitScalar(u8, buf[0..end], '\n');
+        while (lines.next()) |line| {
+            if (line.len == 0) continue;
+            try self.applyLine(line);
+        }
+        self.replayed_offset += end;
+    }
+
+    /// Rewrite the log with only live records
+    pub fn compact(self: *Self) !void {
+        var lock = try self.lockWriter();
+        defer lock.close();
+        try self.refresh();
+        try self.compactLocked();
+    }
+
+    fn appendRecord(self: *Self, payload: []const u8) !void {
+        var lock = try self.lockWriter();
+        defer lock.close();
+        try self.refresh();
+        try self.appendLocked(payload);
+    }
+
+    /// Caller holds the writer lock and has refreshed
+    fn appendLocked(self: *Self, payload: []const u8) !void {
+        var line_buf: [4200]u8 = undefined;
+        const line = try std.fmt.bufPrint(&line_buf, "{x:0>8}\t{s}\n", .{ std.hash.Crc32.hash(payload), payload });
+
+        const file = try std.fs.cwd().createFile(self.log_path, .{ .truncate = false, .read = true });
+        defer file.close();
+
+        var size = (try file.stat()).size;
+        if (size > 0) {
+            // Terminate a torn record left by a crashed writer so ours stays parseable
+            var last: [1]u8 = undefined;
+            if (try file.preadAll(&last, size - 1) == 1 and last[0] != '\n') {
+                try file.pwriteAll("\n", size);
+                size += 1;
+            }
+        }
+        try file.pwriteAll(line, size);
+
+        self.pending_sync += 1;
+        if (self.pending_sync >= self.sync_batch) {
+            try file.sync();
+            self.pending_sync = 0;
+        }
+
+        const stat = try file.stat();
+        if (self.log_inode == null) self.log_inode = stat.inode;
+        try self.applyLine(line[0 .. line.len - 1]);
+        self.replayed_offset = size + line.len;
+
+        if (self.record_count > 2 * self.entries.count() + 64) {
+            try self.compactLocked();
+        }
+    }
+
+    fn compactLocked(self: *Self) !void {
+        const tmp_path = try std.fmt.allocPrint(self.allocator, "{s}.tmp", .{self.log_path});
+        defer self.allocator.free(tmp_path);
+
+        var data = std.ArrayListUnmanaged(u8){};
+        defer data.deinit(self.allocator);
+
+        var it = self.entries.iterator();
+        while (it.next()) |kv| {
+            const e = kv.value_ptr.*;
+            const payload = try std.fmt.allocPrint(self.allocator, "+\t{s}\t{d}\t{d}\t{s}", .{ e.container_id, e.vmid, e.created_at, e.bundle_path });
+            defer self.allocator.free(payload);
+            const line = try std.fmt.allocPrint(self.allocator, "{x:0>8}\t{s}\n", .{ std.hash.Crc32.hash(payload), payload });
+            defer self.allocator.free(line);
+            try data.appendSlice(self.allocator, line);
+        }
+
+        {
+            const tmp = try std.fs.cwd().createFile(tmp_path, .{ .truncate = true });
+            defer tmp.close();
+            try tmp.writeAll(data.items);
+            try tmp.sync();
+        }
+        try std.fs.cwd().rename(tmp_path, self.log_path);
+        self.syncStateDir();
+
+        const file = try std.fs.cwd().openFile(self.log_path, .{});
+        defer file.close();
+        const stat = try file.stat();
+        self.log_inode = stat.inode;
+        self.replayed_offset = stat.size;
+        self.record_count = self.entries.count();
+        self.pending_sync = 0;
+
+        if (self.logger) |log| log.debug("Compacted {s} to {d} records", .{ self.log_path, self.record_count }) catch {};
+    }
+
+    fn applyLine(self: *Self, line: []const u8) !void {
+        const tab = std.mem.indexOfScalar(u8, line, '\t') orelse return;
+        const crc = std.fmt.parseInt(u32, line[0..tab], 16) catch return;
+        const payload = line[tab + 1 ..];
+        if (std.hash.Crc32.hash(payload) != crc) {
+            if (self.logger) |log| log.warn("Skipping corrupt record in {s}", .{self.log_path}) catch {};
+            return;
+        }
+
+        self.record_count += 1;
+        var fields = std.mem.splitScalar(u8, payload, '\t');
+        const op = fields.next() orelse return;
+        const container_id = fields.next() orelse return;
+
+        if (std.mem.eql(u8, op, "-")) {
+            self.dropEntry(container_id);
+            return;
+        }
+        if (!std.mem.eql(u8, op, "+")) return;
+
+        const vmid = std.fmt.parseInt(u32, fields.next() orelse return, 10) catch return;
+        const created_at = std.fmt.parseInt(i64, fields.next() orelse return, 10) catch return;
+        const bundle_path = fields.next() orelse return;
+
+        self.dropEntry(container_id);
+        const entry = MappingEntry{
+            .container_id = try self.allocator.dupe(u8, container_id),
+            .vmid = vmid,
+            .created_at = created_at,
+            .bundle_path = try self.allocator.dupe(u8, bundle_path),
+        };
+        try self.entries.put(self.allocator, entry.container_id, entry);
+        try self.by_vmid.put(self.allocator, vmid, {});
+    }
+
+    fn dropEntry(self: *Self, container_id: []const u8) void {
+        if (self.entries.fetchRemove(container_id)) |kv| {
+            _ = self.by_vmid.remove(kv.value.vmid);
+            var e = kv.value;
+            e.deinit(self.allocator);
+        }
+    }
+
+    fn clear(self: *Self) void {
+        var it = self.entries.valueIterator();
+        while (it.next()) |e| e.deinit(self.allocator);
+        self.entries.clearRetainingCapacity();
+        self.by_vmid.clearRetainingCapacity();
+        self.log_inode = null;
+        self.replayed_offset = 0;
+        self.record_count = 0;
+    }
+
+    fn lockWriter(self: *Self) !std.fs.File {
+        const lock = try std.fs.cwd().createFile(self.lock_path, .{ .truncate = false, .lock = .exclusive });
+        return lock;
+    }
+
+    /// Flush batched appends to disk
+    pub fn sync(self: *Self) !void {
+        if (self.pending_sync == 0) return;
+        try self.syncLog();
+    }
+
+    fn syncLog(self: *Self) !void {
+        const file = std.fs.cwd().openFile(self.log_path, .{}) catch |err| switch (err) {
+            error.FileNotFound => return,
+            else => return err,
+        };
+        defer file.close();
+        try file.sync();
+        self.pending_sync = 0;
+    }
+
+    fn syncStateDir(self: *Self) void {
+        var dir = std.fs.cwd().openDir(self.state_dir, .{}) catch return;
+        defer dir.close();
+        std.posix.fsync(dir.fd) catch {};
+    }
+
+    fn isFieldSafe(value: []const u8) bool {
+        return std.mem.indexOfAny(u8, value, "\t\n\r") == null;
+    }
+};
@@ -9,3 +9,17 @@ pub const state_manager = @import("state_manager.zig");
 pub const performance = @import("performance.zig");
 pub const pct = @import("pct.zig");
 pub const image_converter = @import("image_converter.zig");
+pub const inventory = @import("inventory.zig");
+pub const pve_config = @import("pve_config.zig");
+pub const mapping_store = @import("mapping_store.zig");
+pub const vmid_allocator = @import("vmid_allocator.zig");
+pub const layer_extractor = @import("layer_extractor.zig");
+pub const tree_copier = @import("tree_copier.zig");
+pub const template_packer = @import("template_packer.zig");
+pub const template_cache = @import("template_cache.zig");
+pub const cgroup_watch = @import("cgroup_watch.zig");
+pub const container_signal = @import("container_signal.zig");
+pub const lxc_config = @import("lxc_config.zig");
+pub const warm_pool = @import("warm_pool.zig");
+pub const clone_bases = @import("clone_bases.zig");
+pub const api_lifecycle = @import("api_lifecycle.zig");
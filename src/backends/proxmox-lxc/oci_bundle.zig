@@ -52,17 +52,22 @@ pub const OciBundleParser = struct {
         };
         defer rootfs_dir.close();
 
-        // Read and parse config.json
-        const content = try config_file.readToEndAlloc(self.allocator, 10 * 1024 * 1024); // 10MB max
-        defer self.allocator.free(content);
+        // config.json, metadata.json and every string taken from them live in
+        // one arena owned by the result; strings without escapes are slices
+        // of the file contents rather than copies
+        const arena = try self.allocator.create(std.heap.ArenaAllocator);
+        arena.* = std.heap.ArenaAllocator.init(self.allocator);
+        errdefer {
+            arena.deinit();
+            self.allocator.destroy(arena);
+        }
+        const arena_allocator = arena.allocator();
 
-        const parsed = try std.json.parseFromSlice(std.json.Value, self.allocator, content, .{
-            .allocate = .alloc_always,
-            .ignore_unknown_fields = true,
-        });
-        defer parsed.deinit();
+        const content = try config_file.readToEndAlloc(arena_allocator, 10 * 1024 * 1024); // 10MB max
+        const spec = try self.decode(SpecDocument, arena_allocator, content, "config.json");
 
-        var bundle_config = try self.parseOciConfig(&parsed.value, rootfs_path);
+        var bundle_config = try self.parseOciConfig(arena_allocator, &spec, rootfs_path);
+        bundle_config.arena = arena;
 
         // Try to parse metadata.json if it exists
         const metadata_path = try std.fs.path.join(self.allocator, &[_][]const u8{ bundle_path, "metadata.json" });
@@ -71,26 +76,19 @@ pub const OciBundleParser = struct {
         if (std.fs.cwd().openFile(metadata_path, .{})) |metadata_file| {
             defer metadata_file.close();
 
-            const metadata_content = metadata_file.readToEndAlloc(self.allocator, 1024 * 1024) catch |err| {
+            const metadata_content = metadata_file.readToEndAlloc(arena_allocator, 1024 * 1024) catch |err| {
                 if (self.logger) |log| {
                     try log.warn("Failed to read metadata.json: {}", .{err});
                 }
                 return bundle_config;
             };
-            defer self.allocator.free(metadata_content);
 
-            const metadata_parsed = std.json.parseFromSlice(std.json.Value, self.allocator, metadata_content, .{
-                .allocate = .alloc_always,
-                .ignore_unknown_fields = true,
-            }) catch |err| {
-                if (self.logger) |log| {
-                    try log.warn("Failed to parse metadata.json: {}", .{err});
-                }
-                return bundle_config;
+            const metadata = self.decode(MetadataDocument, arena_allocator, metadata_content, "metadata.json") catch |err| switch (err) {
+                error.OutOfMemory => return err,
+                else => return bundle_config,
             };
-            defer metadata_parsed.deinit();
 
-            try self.parseMetadata(&metadata_parsed.value, &bundle_config);
+            try self.parseMetadata(&metadata, &bundle_config);
         } else |_| {
             if (self.logger) |log| {
                 try log.info("No metadata.json found in bundle, using config.json only", .{});
@@ -100,413 +98,141 @@ pub const OciBundleParser = struct {
         return bundle_config;
     }
 
-    /// Parse OCI config.json and extract relevant fields
-    fn parseOciConfig(self: *OciBundleParser, config: *const std.json.Value, rootfs_path: []const u8) !OciBundleConfig {
+    /// Decode `content` straight into `T`; fields not in `T` are skipped
+    fn decode(self: *OciBundleParser, comptime T: type, arena: std.mem.Allocator, content: []const u8, file_name: []const u8) !T {
+        return std.json.parseFromSliceLeaky(T, arena, content, .{
+            .allocate = .alloc_if_needed,
+            .ignore_unknown_fields = true,
+        }) catch |err| switch (err) {
+            error.OutOfMemory => return error.OutOfMemory,
+            else => {
+                if (self.logger) |log| {
+                    try log.err("Invalid {s}: {}", .{ file_name, err });
+                }
+                return error.InvalidConfigFormat;
+            },
+        };
+    }
+
+    /// Map the decoded config.json onto the bundle configuration; `arena`
+    /// already owns every string in `spec`
+    fn parseOciConfig(self: *OciBundleParser, arena: std.mem.Allocator, spec: *const SpecDocument, rootfs_path: []const u8) !OciBundleConfig {
         var bundle_config = OciBundleConfig{
             .allocator = self.allocator,
-            .rootfs_path = try self.allocator.dupe(u8, rootfs_path),
-            .hostname = null,
-            .process_args = null,
-            .environment = null,
-            .mounts = null,
-            .memory_limit = null,
-            .cpu_limit = null,
-            .capabilities = null,
-            .seccomp_profile = null,
+            .rootfs_path = try arena.dupe(u8, rootfs_path),
+            .hostname = spec.hostname,
         };
 
-        if (config.* != .object) {
-            return error.InvalidConfigFormat;
-        }
-
-        const obj = config.object;
+        if (spec.process) |process| {
+            bundle_config.process_args = process.args;
+            bundle_config.environment = process.env;
 
-        // Parse hostname
-        if (obj.get("hostname")) |hostname_val| {
-            if (hostname_val == .string) {
-                bundle_config.hostname = try self.allocator.dupe(u8, hostname_val.string);
+            if (process.capabilities != null) {
+                // TODO: Parse capabilities and convert to LXC format
+                if (self.logger) |log| {
+                    try log.info("Capabilities found in OCI config, will be converted to LXC format", .{});
+                }
             }
         }
 
-        // Parse process
-        if (obj.get("process")) |process_val| {
-            if (process_val == .object) {
-                const process_obj = process_val.object;
-
-                // Parse args (command to run)
-                if (process_obj.get("args")) |args_val| {
-                    if (args_val == .array) {
-                        const args_array = args_val.array;
-                        var process_args = try self.allocator.alloc([]const u8, args_array.items.len);
-                        for (args_array.items, 0..) |arg_val, i| {
-                            if (arg_val == .string) {
-                                process_args[i] = try self.allocator.dupe(u8, arg_val.string);
-                            }
-                        }
-                        bundle_config.process_args = process_args;
-                    }
-                }
+        if (spec.mounts) |spec_mounts| {
+            const mounts = try arena.alloc(MountConfig, spec_mounts.len);
+            for (spec_mounts, mounts) |m, *mount| {
+                mount.* = MountConfig{
+                    .allocator = arena,
+                    .source = m.source,
+                    .destination = m.destination,
+                    .type = m.type,
+                    // lxc_config splits these again on ','
+                    .options = if (m.options) |options| try std.mem.join(arena, ",", options) else null,
+                };
+            }
+            bundle_config.mounts = mounts;
+        }
 
-                // Parse environment variables
-                if (process_obj.get("env")) |env_val| {
-                    if (env_val == .array) {
-                        const env_array = env_val.array;
-                        var environment = try self.allocator.alloc([]const u8, env_array.items.len);
-                        for (env_array.items, 0..) |env_val_item, i| {
-                            if (env_val_item == .string) {
-                                environment[i] = try self.allocator.dupe(u8, env_val_item.string);
-                            }
-                        }
-                        bundle_config.environment = environment;
-                    }
-                }
+        const linux = spec.linux orelse {
+            if (self.logger) |log| {
+                try log.info("Successfully parsed OCI bundle configuration", .{});
+            }
+            return bundle_config;
+        };
 
-                // Parse capabilities
-                if (process_obj.get("capabilities")) |caps_val| {
-                    if (caps_val == .object) {
-                        // TODO: Parse capabilities and convert to LXC format
-                        if (self.logger) |log| {
-                            try log.info("Capabilities found in OCI config, will be converted to LXC format", .{});
-                        }
-                    }
+        if (linux.resources) |resources| {
+            if (resources.memory) |memory| {
+                // -1 means unlimited
+                if (memory.limit) |limit| {
+                    if (limit >= 0) bundle_config.memory_limit = @intCast(limit);
                 }
             }
+            if (resources.cpu) |cpu| {
+                if (cpu.shares) |shares| bundle_config.cpu_limit = @floatFromInt(shares);
+            }
         }
 
-        // Parse mounts
-        if (obj.get("mounts")) |mounts_val| {
-            if (mounts_val == .array) {
-                const mounts_array = mounts_val.array;
-                var mounts = try self.allocator.alloc(MountConfig, mounts_array.items.len);
-                for (mounts_array.items, 0..) |mount_val, i| {
-                    if (mount_val == .object) {
-                        const mount_obj = mount_val.object;
-                        mounts[i] = MountConfig{
-                            .allocator = self.allocator,
-                            .source = if (mount_obj.get("source")) |s|
-                                if (s == .string) try self.allocator.dupe(u8, s.string) else null
-                            else
-                                null,
-                            .destination = if (mount_obj.get("destination")) |d|
-                                if (d == .string) try self.allocator.dupe(u8, d.string) else null
-                            else
-                                null,
-                            .type = if (mount_obj.get("type")) |t|
-                                if (t == .string) try self.allocator.dupe(u8, t.string) else null
-                            else
-                                null,
-                            .options = null, // TODO: Parse mount options
-                        };
+        // Parse memory policy (NUMA)
+        if (linux.memoryPolicy) |spec_policy| {
+            var policy = MemoryPolicyConfig{ .allocator = arena };
+            if (spec_policy.mode) |mode| policy.mode = try self.checked(parseMemoryPolicyMode(mode), "linux.memoryPolicy.mode");
+            policy.nodes = spec_policy.nodes;
+            if (spec_policy.flags) |spec_flags| {
+                if (spec_flags.len > 0) {
+                    const flags = try arena.alloc(MemoryPolicyFlag, spec_flags.len);
+                    for (spec_flags, flags) |name, *flag| {
+                        flag.* = try self.checked(parseMemoryPolicyFlag(name), "linux.memoryPolicy.flags");
                     }
+                    policy.flags = flags;
                 }
-                bundle_config.mounts = mounts;
             }
+            bundle_config.memory_policy = policy;
         }
 
-        // Parse Linux resources
-        if (obj.get("linux")) |linux_val| {
-            if (linux_val == .object) {
-                const linux_obj = linux_val.object;
-
-                // Parse memory limit
-                if (linux_obj.get("resources")) |resources_val| {
-                    if (resources_val == .object) {
-                        const resources_obj = resources_val.object;
-
-                        if (resources_obj.get("memory")) |memory_val| {
-                            if (memory_val == .object) {
-                                const memory_obj = memory_val.object;
-                                if (memory_obj.get("limit")) |limit_val| {
-                                    if (limit_val == .integer) {
-                                        bundle_config.memory_limit = @as(u64, @intCast(limit_val.integer));
-                                    }
-                                }
-                            }
-                        }
-
-                        // Parse CPU limit
-                        if (resources_obj.get("cpu")) |cpu_val| {
-                            if (cpu_val == .object) {
-                                const cpu_obj = cpu_val.object;
-                                if (cpu_obj.get("shares")) |shares_val| {
-                                    if (shares_val == .integer) {
-                                        bundle_config.cpu_limit = @as(f64, @floatFromInt(shares_val.integer));
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-
-                // Parse memory policy (NUMA)
-                if (linux_obj.get("memoryPolicy")) |policy_val| {
-                    if (policy_val != .object) {
-                        if (self.logger) |log| {
-                            try log.err("Invalid linux.memoryPolicy format (expected object)", .{});
-                        }
-                        return error.InvalidConfigFormat;
-                    }
-
-                    const policy_obj = policy_val.object;
-                    var policy = MemoryPolicyConfig{ .allocator = self.allocator };
-
-                    if (policy_obj.get("mode")) |mode_val| {
-                        if (mode_val == .string) {
-                            policy.mode = try parseMemoryPolicyMode(mode_val.string);
-                        } else {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.memoryPolicy.mode type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-                    }
-
-                    if (policy_obj.get("nodes")) |nodes_val| {
-                        if (nodes_val == .string) {
-                            policy.nodes = try self.allocator.dupe(u8, nodes_val.string);
-                        } else {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.memoryPolicy.nodes type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-                    }
-
-                    if (policy_obj.get("flags")) |flags_val| {
-                        if (flags_val != .array) {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.memoryPolicy.flags type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-
-                        const flags_array = flags_val.array;
-                        if (flags_array.items.len > 0) {
-                            var flags = try self.allocator.alloc(MemoryPolicyFlag, flags_array.items.len);
-                            errdefer {
-                                self.allocator.free(flags);
-                            }
-
-                            for (flags_array.items, 0..) |flag_val, i| {
-                                if (flag_val != .string) {
-                                    if (self.logger) |log| {
-                                        try log.err("Invalid linux.memoryPolicy.flags entry", .{});
-                                    }
-                                    return error.InvalidConfigFormat;
-                                }
-                                flags[i] = try parseMemoryPolicyFlag(flag_val.string);
-                            }
-
-                            policy.flags = flags;
-                        }
-                    }
-
-                    bundle_config.memory_policy = policy;
-                }
-
-                // Parse Intel RDT settings
-                if (linux_obj.get("intelRdt")) |rdt_val| {
-                    if (rdt_val != .object) {
-                        if (self.logger) |log| {
-                            try log.err("Invalid linux.intelRdt format (expected object)", .{});
-                        }
-                        return error.InvalidConfigFormat;
-                    }
-
-                    const rdt_obj = rdt_val.object;
-                    var intel = IntelRdtConfig{ .allocator = self.allocator };
-
-                    if (rdt_obj.get("closID")) |clos_val| {
-                        if (clos_val == .string) {
-                            intel.clos_id = try self.allocator.dupe(u8, clos_val.string);
-                        } else {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.intelRdt.closID type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-                    }
-
-                    if (rdt_obj.get("schemata")) |schemata_val| {
-                        if (schemata_val != .array) {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.intelRdt.schemata type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-
-                        const schemata_array = schemata_val.array;
-                        if (schemata_array.items.len > 0) {
-                            var schemata = try self.allocator.alloc([]const u8, schemata_array.items.len);
-                            var filled: usize = 0;
-                            errdefer {
-                                while (filled > 0) {
-                                    filled -= 1;
-                                    self.allocator.free(schemata[filled]);
-                                }
-                                self.allocator.free(schemata);
-                            }
-
-                            for (schemata_array.items, 0..) |schema_val, i| {
-                                if (schema_val != .string) {
-                                    if (self.logger) |log| {
-                                        try log.err("Invalid linux.intelRdt.schemata entry", .{});
-                                    }
-                                    return error.InvalidConfigFormat;
-                                }
-                                schemata[i] = try self.allocator.dupe(u8, schema_val.string);
-                                filled = i + 1;
-                            }
-
-                            intel.schemata = schemata;
-                        }
-                    }
-
-                    if (rdt_obj.get("l3CacheSchema")) |schema_val| {
-                        if (schema_val == .string) {
-                            intel.l3_cache_schema = try self.allocator.dupe(u8, schema_val.string);
-                        } else {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.intelRdt.l3CacheSchema type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-                    }
-
-                    if (rdt_obj.get("memBwSchema")) |schema_val| {
-                        if (schema_val == .string) {
-                            intel.mem_bw_schema = try self.allocator.dupe(u8, schema_val.string);
-                        } else {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.intelRdt.memBwSchema type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-                    }
-
-                    if (rdt_obj.get("enableMonitoring")) |monitor_val| {
-                        if (monitor_val == .bool) {
-                            intel.enable_monitoring = monitor_val.bool;
-                        } else {
-                            if (self.logger) |log| {
-                                try log.err("Invalid linux.intelRdt.enableMonitoring type", .{});
-                            }
-                            return error.InvalidConfigFormat;
-                        }
-                    }
+        // Parse Intel RDT settings
+        if (linux.intelRdt) |rdt| {
+            bundle_config.intel_rdt = IntelRdtConfig{
+                .allocator = arena,
+                .clos_id = rdt.closID,
+                .schemata = if (rdt.schemata) |schemata| (if (schemata.len > 0) try arena.dupe([]const u8, schemata) else null) else null,
+                .l3_cache_schema = rdt.l3CacheSchema,
+                .mem_bw_schema = rdt.memBwSchema,
+                .enable_monitoring = rdt.enableMonitoring,
+            };
+        }
 
-                    bundle_config.intel_rdt = intel;
+        // Parse netDevices map
+        if (linux.netDevices) |spec_devices| {
+            const count = spec_devices.map.count();
+            if (count > 0) {
+                const net_devices = try arena.alloc(NetDeviceConfig, count);
+                for (spec_devices.map.keys(), spec_devices.map.values(), net_devices) |alias, device, *net_device| {
+                    net_device.* = NetDeviceConfig{
+                        .allocator = arena,
+                        .alias = alias,
+                        .name = device.name,
+                    };
                 }
+                bundle_config.net_devices = net_devices;
+            }
+        }
 
-                // Parse netDevices map
-                if (linux_obj.get("netDevices")) |net_val| {
-                    if (net_val != .object) {
-                        if (self.logger) |log| {
-                            try log.err("Invalid linux.netDevices format (expected object)", .{});
-                        }
-                        return error.InvalidConfigFormat;
-                    }
-
-                    const net_obj = net_val.object;
-                    const count = net_obj.count();
-                    if (count > 0) {
-                        var net_devices = try self.allocator.alloc(NetDeviceConfig, count);
-                        var idx: usize = 0;
-                        errdefer {
-                            while (idx > 0) {
-                                idx -= 1;
-                                net_devices[idx].deinit();
-                            }
-                            self.allocator.free(net_devices);
-                        }
-
-                        var iter = net_obj.iterator();
-                        while (iter.next()) |entry| {
-                            const alias_copy = try self.allocator.dupe(u8, entry.key_ptr.*);
-                            var device = NetDeviceConfig{
-                                .allocator = self.allocator,
-                                .alias = alias_copy,
-                                .name = null,
-                            };
-
-                            const device_val = entry.value_ptr.*;
-                            if (device_val != .object) {
-                                device.deinit();
-                                if (self.logger) |log| {
-                                    try log.err("Invalid linux.netDevices entry type", .{});
-                                }
-                                return error.InvalidConfigFormat;
-                            }
-
-                            const device_obj = device_val.object;
-                            if (device_obj.get("name")) |name_val| {
-                                if (name_val == .string) {
-                                    device.name = try self.allocator.dupe(u8, name_val.string);
-                                } else {
-                                    device.deinit();
-                                    if (self.logger) |log| {
-                                        try log.err("Invalid linux.netDevices.name type", .{});
-                                    }
-                                    return error.InvalidConfigFormat;
-                                }
-                            }
-
-                            net_devices[idx] = device;
-                            idx += 1;
-                        }
-
-                        std.debug.assert(idx == count);
-                        bundle_config.net_devices = net_devices;
-                    }
-                }
+        // Parse seccomp profile
+        if (linux.seccomp) |seccomp| {
+            bundle_config.seccomp_profile = seccomp.defaultAction;
+        }
 
-                // Parse seccomp profile
-                if (linux_obj.get("seccomp")) |seccomp_val| {
-                    if (seccomp_val == .object) {
-                        const seccomp_obj = seccomp_val.object;
-                        if (seccomp_obj.get("defaultAction")) |action_val| {
-                            if (action_val == .string) {
-                                bundle_config.seccomp_profile = try self.allocator.dupe(u8, action_val.string);
-                            }
-                        }
-                    }
-                }
+        // Parse namespaces
+        if (linux.namespaces) |spec_namespaces| {
+            const namespaces = try arena.alloc(NamespaceConfig, spec_namespaces.len);
+            for (spec_namespaces, namespaces) |ns, *namespace| {
+                namespace.* = NamespaceConfig{
+                    .allocator = arena,
+                    .type = ns.type,
+                    .path = ns.path,
+                };
+            }
+            bundle_config.namespaces = namespaces;
 
-                // Parse namespaces
-                if (linux_obj.get("namespaces")) |namespaces_val| {
-                    if (namespaces_val == .array) {
-                        const ns_array = namespaces_val.array;
-                        var namespaces = try self.allocator.alloc(NamespaceConfig, ns_array.items.len);
-                        for (ns_array.items, 0..) |ns_val, i| {
-                            if (ns_val == .object) {
-                                const ns_obj = ns_val.object;
-                                namespaces[i] = NamespaceConfig{
-                                    .allocator = self.allocator,
-                                    .type = if (ns_obj.get("type")) |t|
-                                        if (t == .string) try self.allocator.dupe(u8, t.string) else try self.allocator.dupe(u8, "pid")
-                                    else
-                                        try self.allocator.dupe(u8, "pid"),
-                                    .path = if (ns_obj.get("path")) |p|
-                                        if (p == .string) try self.allocator.dupe(u8, p.string) else null
-                                    else
-                                        null,
-                                };
-                            } else {
-                                // Default to pid namespace if not an object
-                                namespaces[i] = NamespaceConfig{
-                                    .allocator = self.allocator,
-                                    .type = try self.allocator.dupe(u8, "pid"),
-                                    .path = null,
-                                };
-                            }
-                        }
-                        bundle_config.namespaces = namespaces;
-
-                        if (self.logger) |log| {
-                            try log.info("Parsed {d} namespaces from OCI bundle", .{ns_array.items.len});
-                        }
-                    }
-                }
+            if (self.logger) |log| {
+                try log.info("Parsed {d} namespaces from OCI bundle", .{namespaces.len});
             }
         }
 
@@ -517,89 +243,115 @@ pub const OciBundleParser = struct {
         return bundle_config;
     }
 
-    /// Parse metadata.json and extract image information
-    fn parseMetadata(self: *OciBundleParser, metadata: *const std.json.Value, config: *OciBundleConfig) !void {
-        if (metadata.* != .object) {
-            return;
-        }
-
-        const obj = metadata.object;
+    fn checked(self: *OciBundleParser, value: anytype, field: []const u8) !@typeInfo(@TypeOf(value)).error_union.payload {
+        return value catch |err| {
+            if (self.logger) |log| {
+                try log.err("Invalid {s} value", .{field});
+            }
+            return err;
+        };
+    }
 
+    /// Map the decoded metadata.json onto the bundle configuration
+    fn parseMetadata(self: *OciBundleParser, metadata: *const MetadataDocument, config: *OciBundleConfig) !void {
         // Parse image name and tag from metadata.json
-        if (obj.get("image")) |image_val| {
-            if (image_val == .string) {
-                const image_str = image_val.string;
-
-                // Split image:tag format if colon is present
-                if (std.mem.indexOf(u8, image_str, ":")) |colon_pos| {
-                    config.image_name = try self.allocator.dupe(u8, image_str[0..colon_pos]);
-                    config.image_tag = try self.allocator.dupe(u8, image_str[colon_pos + 1 ..]);
-                } else {
-                    config.image_name = try self.allocator.dupe(u8, image_str);
-                }
+        if (metadata.image) |image_str| {
+            // Split image:tag format if colon is present
+            if (std.mem.indexOf(u8, image_str, ":")) |colon_pos| {
+                config.image_name = image_str[0..colon_pos];
+                config.image_tag = image_str[colon_pos + 1 ..];
+            } else {
+                config.image_name = image_str;
+            }
 
-                if (self.logger) |log| {
-                    try log.info("Parsed image from metadata: {s}", .{image_str});
-                }
+            if (self.logger) |log| {
+                try log.info("Parsed image from metadata: {s}", .{image_str});
             }
         }
 
         // Parse ENTRYPOINT from metadata.json
-        if (obj.get("entrypoint")) |entrypoint_val| {
-            if (entrypoint_val == .array) {
-                const entrypoint_array = entrypoint_val.array;
-                var entrypoint = try self.allocator.alloc([]const u8, entrypoint_array.items.len);
-
-                for (entrypoint_array.items, 0..) |ep_val, i| {
-                    if (ep_val == .string) {
-                        entrypoint[i] = try self.allocator.dupe(u8, ep_val.string);
-                    }
-                }
-
-                config.entrypoint = entrypoint;
+        if (metadata.entrypoint) |entrypoint| {
+            config.entrypoint = entrypoint;
 
-                if (self.logger) |log| {
-                    try log.info("Parsed ENTRYPOINT from metadata: {d} args", .{entrypoint_array.items.len});
-                }
+            if (self.logger) |log| {
+                try log.info("Parsed ENTRYPOINT from metadata: {d} args", .{entrypoint.len});
             }
         }
 
         // Parse CMD from metadata.json
-        if (obj.get("cmd")) |cmd_val| {
-            if (cmd_val == .array) {
-                const cmd_array = cmd_val.array;
-                var cmd = try self.allocator.alloc([]const u8, cmd_array.items.len);
-
-                for (cmd_array.items, 0..) |cmd_item, i| {
-                    if (cmd_item == .string) {
-                        cmd[i] = try self.allocator.dupe(u8, cmd_item.string);
-                    }
-                }
-
-                config.cmd = cmd;
+        if (metadata.cmd) |cmd| {
+            config.cmd = cmd;
 
-                if (self.logger) |log| {
-                    try log.info("Parsed CMD from metadata: {d} args", .{cmd_array.items.len});
-                }
+            if (self.logger) |log| {
+                try log.info("Parsed CMD from metadata: {d} args", .{cmd.len});
             }
         }
 
         // Parse working directory from metadata.json
-        if (obj.get("workingDir")) |workdir_val| {
-            if (workdir_val == .string) {
-                config.working_directory = try self.allocator.dupe(u8, workdir_val.string);
+        if (metadata.workingDir) |workdir| {
+            config.working_directory = workdir;
 
-                if (self.logger) |log| {
-                    try log.info("Parsed working directory from metadata: {s}", .{workdir_val.string});
-                }
+            if (self.logger) |log| {
+                try log.info("Parsed working directory from metadata: {s}", .{workdir});
             }
         }
     }
 };
 
+/// The parts of config.json this backend reads, decoded in a single pass
+const SpecDocument = struct {
+    hostname: ?[]const u8 = null,
+    process: ?struct {
+        args: ?[]const []const u8 = null,
+        env: ?[]const []const u8 = null,
+        /// Only presence is checked for now
+        capabilities: ?struct {} = null,
+    } = null,
+    mounts: ?[]const struct {
+        source: ?[]const u8 = null,
+        destination: ?[]const u8 = null,
+        type: ?[]const u8 = null,
+        options: ?[]const []const u8 = null,
+    } = null,
+    linux: ?struct {
+        resources: ?struct {
+            memory: ?struct { limit: ?i64 = null } = null,
+            cpu: ?struct { shares: ?u64 = null } = null,
+        } = null,
+        memoryPolicy: ?struct {
+            mode: ?[]const u8 = null,
+            nodes: ?[]const u8 = null,
+            flags: ?[]const []const u8 = null,
+        } = null,
+        intelRdt: ?struct {
+            closID: ?[]const u8 = null,
+            schemata: ?[]const []const u8 = null,
+            l3CacheSchema: ?[]const u8 = null,
+            memBwSchema: ?[]const u8 = null,
+            enableMonitoring: ?bool = null,
+        } = null,
+        netDevices: ?std.json.ArrayHashMap(struct { name: ?[]const u8 = null }) = null,
+        seccomp: ?struct { defaultAction: ?[]const u8 = null } = null,
+        namespaces: ?[]const struct {
+            type: []const u8 = "pid",
+            path: ?[]const u8 = null,
+        } = null,
+    } = null,
+};
+
+/// metadata.json written next to config.json when an image is unpacked
+const MetadataDocument = struct {
+    image: ?[]const u8 = null,
+    entrypoint: ?[]const []const u8 = null,
+    cmd: ?[]const []const u8 = null,
+    workingDir: ?[]const u8 = null,
+};
+
 /// OCI Bundle configuration extracted from config.json
 pub const OciBundleConfig = struct {
     allocator: std.mem.Allocator,
+    /// Set by `parseBundle`: owns every field below, which are then freed together
+    arena: ?*std.heap.ArenaAllocator = null,
     rootfs_path: []const u8,
     hostname: ?[]const u8 = null,
     process_args: ?[]const []const u8 = null,
@@ -635,6 +387,11 @@ pub const OciBundleConfig = struct {
     working_directory: ?[]const u8 = null,
 
     pub fn deinit(self: *OciBundleConfig) void {
+        if (self.arena) |arena| {
+            arena.deinit();
+            self.allocator.destroy(arena);
+            return;
+        }
         self.allocator.free(self.rootfs_path);
         if (self.hostname) |h| self.allocator.free(h);
         if (self.process_args) |args| {
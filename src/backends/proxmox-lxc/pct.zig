@@ -1,6 +1,10 @@
 const std = @import("std");
 const core = @import("core");
 
+/// A pct stuck on a pmxcfs or container lock is killed after this long;
+/// the same bound the REST path waits on a worker task
+pub const DEFAULT_TIMEOUT_MS: u32 = 10 * 60 * 1000;
+
 pub const Pct = struct {
 	const Self = @This();
 
@@ -23,18 +27,16 @@ pub const Pct = struct {
 	};
 
 	pub fn run(self: *Self, argv: []const []const u8) !RunOutput {
-		const result = try std.process.Child.run(.{ .allocator = self.allocator, .argv = argv });
-		defer self.allocator.free(result.stdout);
-		defer self.allocator.free(result.stderr);
+		const result = try core.exec.run(self.allocator, argv, .{ .timeout_ms = DEFAULT_TIMEOUT_MS });
 
 		if (self.logger) |log| {
-			try log.debug("pct exec argv={any} exit={d}", .{ argv, result.term.Exited });
+			log.debug("pct exec argv={any} exit={d} status={s}", .{ argv, result.exit_code, @tagName(result.status) }) catch {};
 		}
 
 		return RunOutput{
-			.stdout = try self.allocator.dupe(u8, result.stdout),
-			.stderr = try self.allocator.dupe(u8, result.stderr),
-			.exit_code = @intCast(result.term.Exited),
+			.stdout = result.stdout,
+			.stderr = result.stderr,
+			.exit_code = result.exit_code,
 		};
 	}
 
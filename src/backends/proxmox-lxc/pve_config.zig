@@ -0,0 +1,274 @@
+const std = @import("std");
+const core = @import("core");
+
+/// Default pmxcfs mount point
+pub const PVE_ROOT = "/etc/pve";
+/// Default cgroup2 mount point
+pub const CGROUP_ROOT = "/sys/fs/cgroup";
+/// Default procfs mount point
+pub const PROC_ROOT = "/proc";
+
+/// Read-only file contents, mmap'd when the filesystem allows it
+pub const MappedFile = struct {
+    allocator: std.mem.Allocator,
+    data: []const u8 = &[_]u8{},
+    mapping: ?[]align(std.heap.page_size_min) u8 = null,
+    owned: ?[]u8 = null,
+
+    pub fn open(allocator: std.mem.Allocator, path: []const u8) !MappedFile {
+        const file = try std.fs.cwd().openFile(path, .{});
+        defer file.close();
+
+        var self = MappedFile{ .allocator = allocator };
+        const size: usize = @intCast((try file.stat()).size);
+        if (size > 0) {
+            if (std.posix.mmap(null, size, std.posix.PROT.READ, .{ .TYPE = .PRIVATE }, file.handle, 0)) |mapping| {
+                self.mapping = mapping;
+                self.data = mapping;
+                return self;
+            } else |_| {}
+        }
+
+        // pmxcfs and procfs-like files may refuse mmap or report size 0
+        const buf = try file.readToEndAlloc(allocator, 16 * 1024 * 1024);
+        self.owned = buf;
+        self.data = buf;
+        return self;
+    }
+
+    pub fn deinit(self: *MappedFile) void {
+        if (self.mapping) |m| std.posix.munmap(m);
+        if (self.owned) |buf| self.allocator.free(buf);
+        self.* = undefined;
+    }
+};
+
+/// Zero-copy line iterator; returned slices point into the source buffer
+pub const LineTokenizer = struct {
+    buffer: []const u8,
+    index: usize = 0,
+
+    pub fn init(buffer: []const u8) LineTokenizer {
+        return .{ .buffer = buffer };
+    }
+
+    /// Next line without the trailing "\r\n" or "\n"
+    pub fn next(self: *LineTokenizer) ?[]const u8 {
+        if (self.index >= self.buffer.len) return null;
+        const rest = self.buffer[self.index..];
+        const end = std.mem.indexOfScalar(u8, rest, '\n') orelse rest.len;
+        self.index += end + 1;
+        return std.mem.trimRight(u8, rest[0..end], "\r");
+    }
+};
+
+/// `key: value` pair from an LXC config
+pub const ConfigEntry = struct {
+    key: []const u8,
+    value: []const u8,
+};
+
+/// Iterates the current (non-snapshot) section of a <vmid>.conf
+pub const ConfigIterator = struct {
+    lines: LineTokenizer,
+
+    pub fn next(self: *ConfigIterator) ?ConfigEntry {
+        while (self.lines.next()) |line| {
+            if (line.len == 0 or line[0] == '#') continue;
+            // Snapshot sections follow the live config
+            if (line[0] == '[') return null;
+            const colon = std.mem.indexOfScalar(u8, line, ':') orelse continue;
+            return .{
+                .key = std.mem.trim(u8, line[0..colon], " \t"),
+                .value = std.mem.trim(u8, line[colon + 1 ..], " \t"),
+            };
+        }
+        return null;
+    }
+};
+
+/// Parsed view of /etc/pve/lxc/<vmid>.conf
+pub const LxcConfig = struct {
+    file: MappedFile,
+
+    pub fn deinit(self: *LxcConfig) void {
+        self.file.deinit();
+    }
+
+    pub fn iterator(self: *const LxcConfig) ConfigIterator {
+        return .{ .lines = LineTokenizer.init(self.file.data) };
+    }
+
+    /// Value of the first entry with the given key
+    pub fn get(self: *const LxcConfig, key: []const u8) ?[]const u8 {
+        var it = self.iterator();
+        while (it.next()) |entry| {
+            if (std.mem.eql(u8, entry.key, key)) return entry.value;
+        }
+        return null;
+    }
+
+    /// Number of mpN entries
+    pub fn mountCount(self: *const LxcConfig) usize {
+        var count: usize = 0;
+        var it = self.iterator();
+        while (it.next()) |entry| {
+            if (mpIndex(entry.key) != null) count += 1;
+        }
+        return count;
+    }
+
+    /// First mp index above every existing mpN entry
+    pub fn nextMpIndex(self: *const LxcConfig) u32 {
+        return nextMpIndexIn(self.file.data);
+    }
+};
+
+/// First mp index above every mpN entry in raw config data
+pub fn nextMpIndexIn(data: []const u8) u32 {
+    var max_idx: u32 = 0;
+    var it = ConfigIterator{ .lines = LineTokenizer.init(data) };
+    while (it.next()) |entry| {
+        if (mpIndex(entry.key)) |idx| {
+            if (idx + 1 > max_idx) max_idx = idx + 1;
+        }
+    }
+    return max_idx;
+}
+
+fn mpIndex(key: []const u8) ?u32 {
+    if (key.len < 3 or !std.mem.startsWith(u8, key, "mp")) return null;
+    return std.fmt.parseInt(u32, key[2..], 10) catch null;
+}
+
+pub const GuestType = enum { lxc, qemu };
+
+/// Guest record from /etc/pve/.vmlist
+pub const VmlistEntry = struct {
+    vmid: u32,
+    node: []const u8,
+    guest_type: GuestType,
+};
+
+/// Iterates `"<vmid>": { "node": ..., "type": ... }` lines of .vmlist
+pub const VmlistIterator = struct {
+    lines: LineTokenizer,
+
+    pub fn next(self: *VmlistIterator) ?VmlistEntry {
+        while (self.lines.next()) |raw| {
+            const line = std.mem.trim(u8, raw, " \t");
+            if (line.len < 3 or line[0] != '"') continue;
+            const id_end = std.mem.indexOfScalarPos(u8, line, 1, '"') orelse continue;
+            const vmid = std.fmt.parseInt(u32, line[1..id_end], 10) catch continue;
+            const rest = line[id_end + 1 ..];
+            const guest_type: GuestType = blk: {
+                const t = jsonField(rest, "type") orelse continue;
+                if (std.mem.eql(u8, t, "lxc")) break :blk .lxc;
+                if (std.mem.eql(u8, t, "qemu")) break :blk .qemu;
+                continue;
+            };
+            return .{
+                .vmid = vmid,
+                .node = jsonField(rest, "node") orelse "",
+                .guest_type = guest_type,
+            };
+        }
+        return null;
+    }
+
+    fn jsonField(line: []const u8, comptime name: []const u8) ?[]const u8 {
+        const marker = "\"" ++ name ++ "\"";
+        const pos = std.mem.indexOf(u8, line, marker) orelse return null;
+        const open = std.mem.indexOfScalarPos(u8, line, pos + marker.len, '"') orelse return null;
+        const close = std.mem.indexOfScalarPos(u8, line, open + 1, '"') orelse return null;
+        return line[open + 1 .. close];
+    }
+};
+
+/// Parsed view of /etc/pve/.vmlist
+pub const VmList = struct {
+    file: MappedFile,
+
+    pub fn deinit(self: *VmList) void {
+        self.file.deinit();
+    }
+
+    pub fn iterator(self: *const VmList) VmlistIterator {
+        return .{ .lines = LineTokenizer.init(self.file.data) };
+    }
+
+    pub fn find(self: *const VmList, vmid: u32) ?VmlistEntry {
+        var it = self.iterator();
+        while (it.next()) |entry| {
+            if (entry.vmid == vmid) return entry;
+        }
+        return null;
+    }
+};
+
+/// Container run state derived from its cgroup; `unknown` when the cgroup
+/// cannot tell and the caller has to ask `pct status`
+pub const RunState = enum { running, stopped, unknown };
+
+/// Reads pmxcfs and cgroupfs directly instead of going through `pct`
+pub const PveConfigReader = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    pve_root: []const u8 = PVE_ROOT,
+    cgroup_root: []const u8 = CGROUP_ROOT,
+    /// Where task status files are read from; a fixture directory in tests
+    proc_root: []const u8 = PROC_ROOT,
+
+    pub fn init(allocator: std.mem.Allocator) Self {
+        return Self{ .allocator = allocator };
+    }
+
+    /// Use alternate roots, e.g. a fixture directory in tests
+    pub fn initWithRoots(allocator: std.mem.Allocator, pve_root: []const u8, cgroup_root: []const u8) Self {
+        return Self{
+            .allocator = allocator,
+            .pve_root = pve_root,
+            .cgroup_root = cgroup_root,
+        };
+    }
+
+    pub fn openVmlist(self: *const Self) !VmList {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = try std.fmt.bufPrint(&path_buf, "{s}/.vmlist", .{self.pve_root});
+        return VmList{ .file = try MappedFile.open(self.allocator, path) };
+    }
+
+    pub fn openLxcConfig(self: *const Self, vmid: []const u8) !LxcConfig {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = try self.lxcConfigPath(&path_buf, vmid);
+        const file = MappedFile.open(self.allocator, path) catch |err| switch (err) {
+            error.FileNotFound => return core.Error.NotFound,
+            else => return err,
+        };
+        return LxcConfig{ .file = file };
+    }
+
+    pub fn lxcConfigPath(self: *const Self, buf: []u8, vmid: []const u8) ![]const u8 {
+        return std.fmt.bufPrint(buf, "{s}/lxc/{s}.conf", .{ self.pve_root, vmid });
+    }
+
+    /// Running while /sys/fs/cgroup/lxc/<vmid> reports `populated 1`
+    ///
+    /// A missing directory is not proof the container is stopped: cgroup v1
+    /// hosts keep lxc/<vmid> under each controller rather than at the root,
+    /// and a container can be set up under another cgroup path. Only
+    /// cgroup.events says for sure, so anything else is `unknown`.
+    pub fn runState(self: *const Self, vmid: []const u8) RunState {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const dir_path = std.fmt.bufPrint(&path_buf, "{s}/lxc/{s}", .{ self.cgroup_root, vmid }) catch return .unknown;
+        var dir = std.fs.cwd().openDir(dir_path, .{}) catch return .unknown;
+        defer dir.close();
+
+        var events_buf: [256]u8 = undefined;
+        const events = dir.readFile("cgroup.events", &events_buf) catch return .unknown;
+        if (std.mem.indexOf(u8, events, "populated 0") != null) return .stopped;
+        if (std.mem.indexOf(u8, events, "populated 1") != null) return .running;
+        return .unknown;
+    }
+};
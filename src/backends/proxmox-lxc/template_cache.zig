@@ -0,0 +1,368 @@
+const std = @import("std");
+const core = @import("core");
+const oci_bundle = @import("oci_bundle.zig");
+const locked_index = @import("locked_index.zig");
+
+const linux = std.os.linux;
+const Blake3 = std.crypto.hash.Blake3;
+
+/// Bump when the converter output changes so older templates stop matching
+const KEY_VERSION = "nexcage-template-v1";
+const READ_BUFFER_SIZE = 1024 * 1024;
+
+/// Template file stems are `nexcage-<first 16 bytes of the digest in hex>`
+pub const NAME_PREFIX = "nexcage-";
+pub const NAME_LEN = NAME_PREFIX.len + 32;
+
+pub const Limits = struct {
+    /// Evict unreferenced templates once the cache grows past this
+    max_bytes: u64 = 20 * 1024 * 1024 * 1024,
+    max_entries: usize = 64,
+};
+
+pub const Entry = struct {
+    /// Template stem; the file is `<template_dir>/<name>.tar.zst`
+    name: []const u8,
+    size: u64,
+    created_at: i64,
+    last_used: i64,
+    /// Names of containers created from this template
+    refs: std.ArrayListUnmanaged([]const u8) = .{},
+
+    /// `<name>\t<size>\t<created_at>\t<last_used>\t<ref>,<ref>...`
+    pub fn parseLine(arena: std.mem.Allocator, line: []const u8) !?Entry {
+        var fields = std.mem.splitScalar(u8, line, '\t');
+        const name = fields.next() orelse return null;
+        const size = std.fmt.parseInt(u64, fields.next() orelse return null, 10) catch return null;
+        const created_at = std.fmt.parseInt(i64, fields.next() orelse return null, 10) catch return null;
+        const last_used = std.fmt.parseInt(i64, fields.next() orelse return null, 10) catch return null;
+
+        var entry = Entry{ .name = name, .size = size, .created_at = created_at, .last_used = last_used };
+        var refs = std.mem.splitScalar(u8, fields.next() orelse "", ',');
+        while (refs.next()) |ref| {
+            if (ref.len > 0) try entry.refs.append(arena, ref);
+        }
+        return entry;
+    }
+
+    pub fn writeLine(self: Entry, allocator: std.mem.Allocator, out: *std.ArrayListUnmanaged(u8)) !void {
+        try out.print(allocator, "{s}\t{d}\t{d}\t{d}\t", .{ self.name, self.size, self.created_at, self.last_used });
+        for (self.refs.items, 0..) |ref, i| {
+            if (i > 0) try out.append(allocator, ',');
+            try out.appendSlice(allocator, ref);
+        }
+        try out.append(allocator, '\n');
+    }
+};
+
+/// Template name for a bundle: a Blake3 digest over its rootfs and the
+/// config.json fields the converter bakes into the template
+pub fn bundleTemplateName(allocator: std.mem.Allocator, cfg: *const oci_bundle.OciBundleConfig) ![NAME_LEN]u8 {
+    var hasher = Blake3.init(.{});
+    hasher.update(KEY_VERSION);
+
+    hashField(&hasher, "hostname", cfg.hostname orelse "");
+    hashList(&hasher, "args", cfg.process_args);
+    hashList(&hasher, "entrypoint", cfg.entrypoint);
+    hashList(&hasher, "cmd", cfg.cmd);
+    if (cfg.net_devices) |devices| {
+        for (devices) |device| {
+            hashField(&hasher, "net.alias", device.alias);
+            hashField(&hasher, "net.name", device.name orelse "");
+        }
+    }
+
+    const buf = try allocator.alloc(u8, READ_BUFFER_SIZE);
+    defer allocator.free(buf);
+
+    // rootfs may be a directory or a layer archive
+    if (std.fs.cwd().openDir(cfg.rootfs_path, .{ .iterate = true })) |dir_handle| {
+        var dir = dir_handle;
+        defer dir.close();
+        var path = std.ArrayListUnmanaged(u8){};
+        defer path.deinit(allocator);
+        try hashTree(allocator, &hasher, dir, &path, buf);
+    } else |err| switch (err) {
+        error.NotDir => {
+            const file = try std.fs.cwd().openFile(cfg.rootfs_path, .{});
+            defer file.close();
+            try hashContents(&hasher, file, buf);
+        },
+        else => return err,
+    }
+
+    var digest: [Blake3.digest_length]u8 = undefined;
+    hasher.final(&digest);
+
+    var name: [NAME_LEN]u8 = undefined;
+    @memcpy(name[0..NAME_PREFIX.len], NAME_PREFIX);
+    const hex = std.fmt.bytesToHex(digest[0..16].*, .lower);
+    @memcpy(name[NAME_PREFIX.len..], &hex);
+    return name;
+}
+
+fn hashField(hasher: *Blake3, key: []const u8, value: []const u8) void {
+    // NUL separators keep ("ab","c") and ("a","bc") apart
+    hasher.update(key);
+    hasher.update("\x00");
+    hasher.update(value);
+    hasher.update("\x00");
+}
+
+fn hashList(hasher: *Blake3, key: []const u8, values: ?[]const []const u8) void {
+    for (values orelse &[_][]const u8{}) |value| hashField(hasher, key, value);
+}
+
+/// Paths, types, modes, ownership, link targets and file contents in sorted order
+fn hashTree(allocator: std.mem.Allocator, hasher: *Blake3, dir: std.fs.Dir, path: *std.ArrayListUnmanaged(u8), buf: []u8) !void {
+    var names = std.ArrayListUnmanaged([]u8){};
+    defer {
+        for (names.items) |name| allocator.free(name);
+        names.deinit(allocator);
+    }
+    var it = dir.iterate();
+    while (try it.next()) |entry| {
+        const name = try allocator.dupe(u8, entry.name);
+        errdefer allocator.free(name);
+        try names.append(allocator, name);
+    }
+    std.mem.sort([]u8, names.items, {}, nameLessThan);
+
+    const prefix_len = path.items.len;
+    defer path.shrinkRetainingCapacity(prefix_len);
+
+    for (names.items) |name| {
+        path.shrinkRetainingCapacity(prefix_len);
+        try path.appendSlice(allocator, name);
+
+        const st = try std.posix.fstatat(dir.fd, name, linux.AT.SYMLINK_NOFOLLOW);
+        var meta_buf: [64]u8 = undefined;
+        const meta = std.fmt.bufPrint(&meta_buf, "{o}:{d}:{d}", .{ st.mode, st.uid, st.gid }) catch unreachable;
+        hashField(hasher, path.items, meta);
+
+        switch (st.mode & linux.S.IFMT) {
+            linux.S.IFDIR => {
+                try path.append(allocator, '/');
+                var sub = try dir.openDir(name, .{ .iterate = true, .no_follow = true });
+                defer sub.close();
+                try hashTree(allocator, hasher, sub, path, buf);
+            },
+            linux.S.IFREG => {
+                const file = try dir.openFile(name, .{});
+                defer file.close();
+                try hashContents(hasher, file, buf);
+            },
+            linux.S.IFLNK => {
+                var target_buf: [std.fs.max_path_bytes]u8 = undefined;
+                hashField(hasher, "link", try dir.readLink(name, &target_buf));
+            },
+            else => {
+                var rdev_buf: [24]u8 = undefined;
+                hashField(hasher, "rdev", std.fmt.bufPrint(&rdev_buf, "{d}", .{st.rdev}) catch unreachable);
+            },
+        }
+    }
+}
+
+fn hashContents(hasher: *Blake3, file: std.fs.File, buf: []u8) !void {
+    var size: u64 = 0;
+    while (true) {
+        const n = try file.read(buf);
+        if (n == 0) break;
+        hasher.update(buf[0..n]);
+        size += n;
+    }
+    var size_buf: [24]u8 = undefined;
+    hashField(hasher, "size", std.fmt.bufPrint(&size_buf, "{d}", .{size}) catch unreachable);
+}
+
+fn nameLessThan(_: void, a: []u8, b: []u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+/// Persistent content-addressed template cache
+///
+/// Maps template names from bundleTemplateName to the `.tar.zst` files in the
+/// Proxmox template directory, so a bundle that was converted once is reused
+/// by every later create. Containers created from a template hold a reference
+/// to it; only unreferenced templates are evicted, least recently used first,
+/// once the cache exceeds its size or entry limit. The index is a
+/// `LockedIndex` named `template-cache`.
+pub const TemplateCache = struct {
+    const Self = @This();
+    const Index = locked_index.LockedIndex(Entry, "template-cache", 16 * 1024 * 1024);
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    state_dir: []const u8,
+    template_dir: []const u8,
+    limits: Limits,
+    store: Index,
+
+    pub const INDEX_NAME = Index.INDEX_NAME;
+    pub const LOCK_NAME = Index.LOCK_NAME;
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8, template_dir: []const u8, limits: Limits) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .state_dir = state_dir,
+            .template_dir = template_dir,
+            .limits = limits,
+            .store = Index.init(allocator, state_dir),
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.store.deinit();
+    }
+
+    /// Whether a ready template exists for `name`; marks it as recently used
+    pub fn lookup(self: *Self, name: []const u8) !bool {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        const index = self.find(name) orelse return false;
+        if (!self.templateFileExists(name)) {
+            // Removed behind our back, e.g. with pveam remove
+            if (self.logger) |log| log.warn("Cached template {s} is missing, dropping it", .{name}) catch {};
+            _ = self.store.records.orderedRemove(index);
+            try self.store.save();
+            return false;
+        }
+
+        self.store.records.items[index].last_used = std.time.timestamp();
+        try self.store.save();
+        return true;
+    }
+
+    /// Record a freshly built template, then evict if over the limits
+    pub fn insert(self: *Self, name: []const u8, size: u64) !void {
+        if (!isFieldSafe(name)) return core.Error.InvalidInput;
+
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        const now = std.time.timestamp();
+        if (self.find(name)) |index| {
+            const entry = &self.store.records.items[index];
+            entry.size = size;
+            entry.last_used = now;
+        } else {
+            try self.store.records.append(self.store.recordAllocator(), .{
+                .name = try self.store.recordAllocator().dupe(u8, name),
+                .size = size,
+                .created_at = now,
+                .last_used = now,
+            });
+        }
+
+        _ = self.evictLocked(name);
+        try self.store.save();
+    }
+
+    /// Pin `name` for as long as `container` exists
+    pub fn acquire(self: *Self, name: []const u8, container: []const u8) !void {
+        if (!isFieldSafe(container)) return core.Error.InvalidInput;
+
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        const index = self.find(name) orelse return;
+        const entry = &self.store.records.items[index];
+        for (entry.refs.items) |ref| {
+            if (std.mem.eql(u8, ref, container)) return;
+        }
+        try entry.refs.append(self.store.recordAllocator(), try self.store.recordAllocator().dupe(u8, container));
+        try self.store.save();
+    }
+
+    /// Drop every reference held by `container`, then evict if over the limits
+    pub fn release(self: *Self, container: []const u8) !void {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        var changed = false;
+        for (self.store.records.items) |*entry| {
+            var i: usize = 0;
+            while (i < entry.refs.items.len) {
+                if (std.mem.eql(u8, entry.refs.items[i], container)) {
+                    _ = entry.refs.swapRemove(i);
+                    changed = true;
+                } else i += 1;
+            }
+        }
+
+        if (self.evictLocked(null) > 0) changed = true;
+        if (changed) try self.store.save();
+    }
+
+    /// Evict unreferenced templates until within the limits; returns how many were removed
+    pub fn evict(self: *Self) !usize {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        const removed = self.evictLocked(null);
+        if (removed > 0) try self.store.save();
+        return removed;
+    }
+
+    /// Snapshot of the index; valid until the next call on this cache
+    pub fn list(self: *Self) ![]const Entry {
+        var lock = try self.store.lock();
+        defer lock.close();
+        return self.store.records.items;
+    }
+
+    /// Caller holds the lock. `keep` is never evicted, so a template that was
+    /// just built survives until its container takes a reference.
+    fn evictLocked(self: *Self, keep: ?[]const u8) usize {
+        var total: u64 = 0;
+        for (self.store.records.items) |entry| total += entry.size;
+
+        var removed: usize = 0;
+        while (total > self.limits.max_bytes or self.store.records.items.len > self.limits.max_entries) {
+            var victim: ?usize = null;
+            for (self.store.records.items, 0..) |entry, i| {
+                if (entry.refs.items.len > 0) continue;
+                if (keep) |k| if (std.mem.eql(u8, entry.name, k)) continue;
+                if (victim == null or entry.last_used < self.store.records.items[victim.?].last_used) victim = i;
+            }
+            const index = victim orelse break;
+            const entry = self.store.records.orderedRemove(index);
+            total -= entry.size;
+            removed += 1;
+
+            self.deleteTemplateFile(entry.name);
+            if (self.logger) |log| log.info("Evicted template {s} ({d} bytes)", .{ entry.name, entry.size }) catch {};
+        }
+        return removed;
+    }
+
+    fn find(self: *const Self, name: []const u8) ?usize {
+        for (self.store.records.items, 0..) |entry, i| {
+            if (std.mem.eql(u8, entry.name, name)) return i;
+        }
+        return null;
+    }
+
+    fn templateFileExists(self: *Self, name: []const u8) bool {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = std.fmt.bufPrint(&path_buf, "{s}/{s}.tar.zst", .{ self.template_dir, name }) catch return false;
+        std.fs.cwd().access(path, .{}) catch return false;
+        return true;
+    }
+
+    fn deleteTemplateFile(self: *Self, name: []const u8) void {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = std.fmt.bufPrint(&path_buf, "{s}/{s}.tar.zst", .{ self.template_dir, name }) catch return;
+        std.fs.cwd().deleteFile(path) catch |err| switch (err) {
+            error.FileNotFound => {},
+            else => if (self.logger) |log| log.warn("Failed to delete template {s}: {}", .{ path, err }) catch {},
+        };
+    }
+
+    fn isFieldSafe(value: []const u8) bool {
+        return value.len > 0 and std.mem.indexOfAny(u8, value, "\t\n\r,") == null;
+    }
+};
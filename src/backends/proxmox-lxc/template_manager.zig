@@ -182,25 +182,7 @@ pub const TemplateManager = struct {
 
     /// Run shell command
     fn runCommand(self: *Self, args: []const []const u8) !CommandResult {
-        var child = std.process.Child.init(args, self.allocator);
-        child.stdout_behavior = .Pipe;
-        child.stderr_behavior = .Pipe;
-
-        try child.spawn();
-
-        const stdout = try child.stdout.?.readToEndAlloc(self.allocator, 1024 * 1024);
-        const stderr = try child.stderr.?.readToEndAlloc(self.allocator, 1024 * 1024);
-
-        const term = try child.wait();
-
-        return CommandResult{
-            .stdout = stdout,
-            .stderr = stderr,
-            .exit_code = switch (term) {
-                .Exited => |code| @intCast(code),
-                else => 1,
-            },
-        };
+        return core.exec.run(self.allocator, args, .{ .max_output_bytes = 1024 * 1024 });
     }
 };
 
@@ -414,8 +396,4 @@ pub const TemplateMetadata = struct {
 };
 
 /// Command execution result
-const CommandResult = struct {
-    stdout: []u8,
-    stderr: []u8,
-    exit_code: u8,
-};
+const CommandResult = core.exec.Result;
@@ -0,0 +1,424 @@
+const std = @import("std");
+const core = @import("core");
+
+const linux = std.os.linux;
+
+pub const Options = struct {
+    /// zstd compression level, clamped to 1-19
+    level: u8 = 3,
+    /// Compression threads; 0 lets zstd use every core
+    workers: u32 = 0,
+    /// Record on-disk uid/gid; false stores every entry as root
+    preserve_owner: bool = true,
+};
+
+/// Totals for one packed archive
+pub const PackStats = struct {
+    entries: u64 = 0,
+    bytes: u64 = 0,
+    skipped: u64 = 0,
+    /// Compressed size of the published file
+    archive_bytes: u64 = 0,
+};
+
+const BLOCK = 512;
+const READ_BUFFER_SIZE = 1024 * 1024;
+
+const MAX_OCTAL_7: u64 = 0o7777777;
+const MAX_OCTAL_11: u64 = 0o77777777777;
+
+const EntryKind = enum(u8) {
+    file = '0',
+    hardlink = '1',
+    symlink = '2',
+    char_device = '3',
+    block_device = '4',
+    directory = '5',
+    fifo = '6',
+};
+
+const InodeKey = struct {
+    dev: u64,
+    ino: u64,
+};
+
+/// Streaming rootfs -> .tar.zst packer for Proxmox templates
+///
+/// Walks the rootfs in sorted order and writes ustar entries (PAX for long
+/// names and large values) straight into a multithreaded `zstd` process. The
+/// compressed stream lands in an unnamed O_TMPFILE inode inside the target
+/// directory, which is linked into place only once compression succeeded, so
+/// readers never see a partial template and nothing is staged in /tmp.
+pub const TemplatePacker = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    options: Options,
+    stats: PackStats = .{},
+    read_buf: []u8,
+    /// Archive path of the entry being written, always starting with "./"
+    path: std.ArrayListUnmanaged(u8) = .{},
+    pax: std.ArrayListUnmanaged(u8) = .{},
+    /// First archive path seen for each multiply-linked inode
+    hardlinks: std.AutoHashMapUnmanaged(InodeKey, []u8) = .{},
+    trace_enabled: bool,
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, options: Options) !Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .options = options,
+            .read_buf = try allocator.alloc(u8, READ_BUFFER_SIZE),
+            .trace_enabled = if (logger) |log| log.level == .trace else false,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.allocator.free(self.read_buf);
+        self.path.deinit(self.allocator);
+        self.pax.deinit(self.allocator);
+        self.clearHardlinks();
+        self.hardlinks.deinit(self.allocator);
+    }
+
+    /// Pack `rootfs` into `dest_dir/file_name`, replacing any existing file atomically
+    pub fn pack(self: *Self, rootfs: std.fs.Dir, dest_dir: std.fs.Dir, file_name: []const u8) !PackStats {
+        var output = try self.openOutput(dest_dir, file_name);
+        defer output.close(self.allocator, dest_dir);
+
+        var level_buf: [8]u8 = undefined;
+        var workers_buf: [16]u8 = undefined;
+        const level_arg = try std.fmt.bufPrint(&level_buf, "-{d}", .{std.math.clamp(self.options.level, 1, 19)});
+        const workers_arg = try std.fmt.bufPrint(&workers_buf, "-T{d}", .{self.options.workers});
+        const argv = [_][]const u8{ "zstd", "-q", "-c", level_arg, workers_arg };
+
+        var feed = Feed{ .packer = self, .rootfs = rootfs };
+        var sink = OutputSink{ .dest = output.file };
+        var result = core.exec.run(self.allocator, &argv, .{
+            .stdin = .{ .context = &feed, .produce = Feed.produce },
+            .on_stdout = .{ .context = &sink, .write = OutputSink.write },
+            .retain_stdout = false,
+        }) catch |err| {
+            if (self.logger) |log| log.err("Failed to pack {s}: {}", .{ file_name, err }) catch {};
+            return err;
+        };
+        defer result.deinit(self.allocator);
+
+        if (result.exit_code != 0) {
+            if (self.logger) |log| log.err("zstd failed while packing {s}: {s}", .{ file_name, result.stderr }) catch {};
+            return core.Error.ArchiveCreationFailed;
+        }
+        if (sink.err) |err| return err;
+
+        // O_TMPFILE and createFile modes are both masked by umask
+        try std.posix.fchmod(output.file.handle, 0o644);
+        try self.publish(&output, dest_dir, file_name);
+
+        self.stats.archive_bytes = sink.bytes;
+        if (self.logger) |log| log.info("Packed {d} entries ({d} bytes) into {s} ({d} bytes)", .{ self.stats.entries, self.stats.bytes, file_name, sink.bytes }) catch {};
+        return self.stats;
+    }
+
+    /// Write `rootfs` as an uncompressed tar stream, entries sorted by name
+    pub fn writeArchive(self: *Self, rootfs: std.fs.Dir, writer: *std.Io.Writer) !void {
+        self.stats = .{};
+        self.clearHardlinks();
+        self.path.clearRetainingCapacity();
+        try self.path.appendSlice(self.allocator, "./");
+
+        const st = try std.posix.fstat(rootfs.fd);
+        try self.writeEntry(writer, .directory, st, "", 0);
+        try self.packDir(rootfs, writer);
+
+        try writer.splatByteAll(0, 2 * BLOCK);
+        try writer.flush();
+    }
+
+    fn packDir(self: *Self, dir: std.fs.Dir, writer: *std.Io.Writer) !void {
+        var names = std.ArrayListUnmanaged([]u8){};
+        defer {
+            for (names.items) |name| self.allocator.free(name);
+            names.deinit(self.allocator);
+        }
+
+        var it = dir.iterate();
+        while (try it.next()) |entry| {
+            const name = try self.allocator.dupe(u8, entry.name);
+            errdefer self.allocator.free(name);
+            try names.append(self.allocator, name);
+        }
+        // Sorted so identical trees always produce identical archives
+        std.mem.sort([]u8, names.items, {}, nameLessThan);
+
+        const prefix_len = self.path.items.len;
+        defer self.path.shrinkRetainingCapacity(prefix_len);
+
+        for (names.items) |name| {
+            self.path.shrinkRetainingCapacity(prefix_len);
+            try self.path.appendSlice(self.allocator, name);
+
+            const st = try std.posix.fstatat(dir.fd, name, linux.AT.SYMLINK_NOFOLLOW);
+            switch (st.mode & linux.S.IFMT) {
+                linux.S.IFDIR => {
+                    try self.path.append(self.allocator, '/');
+                    try self.writeEntry(writer, .directory, st, "", 0);
+                    var sub = try dir.openDir(name, .{ .iterate = true, .no_follow = true });
+                    defer sub.close();
+                    try self.packDir(sub, writer);
+                },
+                linux.S.IFREG => try self.packFile(dir, name, st, writer),
+                linux.S.IFLNK => {
+                    var target_buf: [std.fs.max_path_bytes]u8 = undefined;
+                    const target = try dir.readLink(name, &target_buf);
+                    try self.writeEntry(writer, .symlink, st, target, 0);
+                },
+                linux.S.IFCHR => try self.writeEntry(writer, .char_device, st, "", 0),
+                linux.S.IFBLK => try self.writeEntry(writer, .block_device, st, "", 0),
+                linux.S.IFIFO => try self.writeEntry(writer, .fifo, st, "", 0),
+                else => {
+                    self.stats.skipped += 1;
+                    if (self.logger) |log| log.debug("Skipping socket {s}", .{self.path.items}) catch {};
+                },
+            }
+        }
+    }
+
+    fn packFile(self: *Self, dir: std.fs.Dir, name: []const u8, st: std.posix.Stat, writer: *std.Io.Writer) !void {
+        if (st.nlink > 1) {
+            const key = InodeKey{ .dev = @intCast(st.dev), .ino = @intCast(st.ino) };
+            const gop = try self.hardlinks.getOrPut(self.allocator, key);
+            if (gop.found_existing) {
+                return self.writeEntry(writer, .hardlink, st, gop.value_ptr.*, 0);
+            }
+            gop.value_ptr.* = self.allocator.dupe(u8, self.path.items) catch |err| {
+                _ = self.hardlinks.remove(key);
+                return err;
+            };
+        }
+
+        const file = try dir.openFile(name, .{});
+        defer file.close();
+        const size: u64 = @intCast(st.size);
+
+        try self.writeEntry(writer, .file, st, "", size);
+        var file_reader = file.reader(self.read_buf);
+        try file_reader.interface.streamExact64(writer, size);
+        try writer.splatByteAll(0, padding(size));
+    }
+
+    fn writeEntry(self: *Self, writer: *std.Io.Writer, kind: EntryKind, st: std.posix.Stat, link: []const u8, size: u64) !void {
+        const path = self.path.items;
+        const uid: u64 = if (self.options.preserve_owner) st.uid else 0;
+        const gid: u64 = if (self.options.preserve_owner) st.gid else 0;
+        const mtime_sec = st.mtime().sec;
+        const mtime: u64 = if (mtime_sec > 0) @intCast(mtime_sec) else 0;
+
+        self.pax.clearRetainingCapacity();
+        if (path.len > 100) try self.appendPax("path", path);
+        if (link.len > 100) try self.appendPax("linkpath", link);
+        if (size > MAX_OCTAL_11) try self.appendPaxNumber("size", size);
+        if (uid > MAX_OCTAL_7) try self.appendPaxNumber("uid", uid);
+        if (gid > MAX_OCTAL_7) try self.appendPaxNumber("gid", gid);
+        if (self.pax.items.len > 0) {
+            const pax_len: u64 = self.pax.items.len;
+            try writeHeader(writer, .{ .name = "././@PaxHeader", .typeflag = 'x', .mode = 0o644, .size = pax_len, .mtime = mtime });
+            try writer.writeAll(self.pax.items);
+            try writer.splatByteAll(0, padding(pax_len));
+        }
+
+        const rdev: u64 = @intCast(st.rdev);
+        try writeHeader(writer, .{
+            .name = path,
+            .typeflag = @intFromEnum(kind),
+            .mode = st.mode & 0o7777,
+            .uid = uid,
+            .gid = gid,
+            .size = size,
+            .mtime = mtime,
+            .link = link,
+            .dev_major = if (kind == .char_device or kind == .block_device) devMajor(rdev) else 0,
+            .dev_minor = if (kind == .char_device or kind == .block_device) devMinor(rdev) else 0,
+        });
+
+        self.stats.entries += 1;
+        self.stats.bytes += size;
+        if (self.trace_enabled) {
+            if (self.logger) |log| log.trace("pack {s} {s} ({d} bytes)", .{ @tagName(kind), path, size }) catch {};
+        }
+    }
+
+    fn appendPax(self: *Self, key: []const u8, value: []const u8) !void {
+        // The record length counts its own digits
+        const base = key.len + value.len + 3;
+        var len = base + 1;
+        while (std.math.log10_int(len) + 1 + base != len) len += 1;
+        try self.pax.print(self.allocator, "{d} {s}={s}\n", .{ len, key, value });
+    }
+
+    fn appendPaxNumber(self: *Self, key: []const u8, value: u64) !void {
+        var buf: [24]u8 = undefined;
+        try self.appendPax(key, try std.fmt.bufPrint(&buf, "{d}", .{value}));
+    }
+
+    fn clearHardlinks(self: *Self) void {
+        var it = self.hardlinks.valueIterator();
+        while (it.next()) |path| self.allocator.free(path.*);
+        self.hardlinks.clearRetainingCapacity();
+    }
+
+    /// Unnamed inode in dest_dir, or a hidden temp file where O_TMPFILE is unsupported
+    fn openOutput(self: *Self, dest_dir: std.fs.Dir, file_name: []const u8) !Output {
+        const fd = std.posix.openat(dest_dir.fd, ".", .{ .ACCMODE = .WRONLY, .DIRECTORY = true, .TMPFILE = true, .CLOEXEC = true }, 0o644) catch |err| {
+            if (self.logger) |log| log.debug("O_TMPFILE unavailable ({}), using a temp name", .{err}) catch {};
+            const tmp_name = try std.fmt.allocPrint(self.allocator, ".{s}.{d}.tmp", .{ file_name, linux.getpid() });
+            errdefer self.allocator.free(tmp_name);
+            dest_dir.deleteFile(tmp_name) catch {};
+            const file = try dest_dir.createFile(tmp_name, .{ .exclusive = true, .mode = 0o644 });
+            return .{ .file = file, .tmp_name = tmp_name };
+        };
+        return .{ .file = .{ .handle = fd } };
+    }
+
+    fn publish(self: *Self, output: *Output, dest_dir: std.fs.Dir, file_name: []const u8) !void {
+        try std.posix.fsync(output.file.handle);
+
+        if (output.tmp_name) |tmp_name| {
+            try dest_dir.rename(tmp_name, file_name);
+        } else {
+            var proc_buf: [32]u8 = undefined;
+            const proc_path = try std.fmt.bufPrint(&proc_buf, "/proc/self/fd/{d}", .{output.file.handle});
+            std.posix.linkat(linux.AT.FDCWD, proc_path, dest_dir.fd, file_name, linux.AT.SYMLINK_FOLLOW) catch |err| switch (err) {
+                // linkat never replaces, so link beside the old file and rename over it
+                error.PathAlreadyExists => {
+                    const link_name = try std.fmt.allocPrint(self.allocator, ".{s}.{d}.link", .{ file_name, linux.getpid() });
+                    defer self.allocator.free(link_name);
+                    dest_dir.deleteFile(link_name) catch {};
+                    try std.posix.linkat(linux.AT.FDCWD, proc_path, dest_dir.fd, link_name, linux.AT.SYMLINK_FOLLOW);
+                    errdefer dest_dir.deleteFile(link_name) catch {};
+                    try dest_dir.rename(link_name, file_name);
+                },
+                else => return err,
+            };
+        }
+        output.published = true;
+        std.posix.fsync(dest_dir.fd) catch {};
+    }
+};
+
+const Output = struct {
+    file: std.fs.File,
+    /// Set only for the named-temp-file fallback
+    tmp_name: ?[]u8 = null,
+    published: bool = false,
+
+    fn close(self: *Output, allocator: std.mem.Allocator, dest_dir: std.fs.Dir) void {
+        self.file.close();
+        if (self.tmp_name) |tmp_name| {
+            if (!self.published) dest_dir.deleteFile(tmp_name) catch {};
+            allocator.free(tmp_name);
+        }
+    }
+};
+
+/// Feeds the tar stream to zstd's stdin
+const Feed = struct {
+    packer: *TemplatePacker,
+    rootfs: std.fs.Dir,
+
+    fn produce(context: *anyopaque, writer: *std.Io.Writer) anyerror!void {
+        const self: *Feed = @ptrCast(@alignCast(context));
+        try self.packer.writeArchive(self.rootfs, writer);
+    }
+};
+
+/// Writes zstd's output into the archive file
+const OutputSink = struct {
+    dest: std.fs.File,
+    bytes: u64 = 0,
+    err: ?anyerror = null,
+
+    fn write(context: *anyopaque, index: usize, chunk: []const u8) void {
+        _ = index;
+        const self: *OutputSink = @ptrCast(@alignCast(context));
+        // After a write error keep consuming so zstd never blocks on a full pipe
+        if (self.err != null) return;
+        self.dest.writeAll(chunk) catch |err| {
+            self.err = err;
+            return;
+        };
+        self.bytes += chunk.len;
+    }
+};
+
+const Header = struct {
+    name: []const u8,
+    typeflag: u8,
+    mode: u32,
+    uid: u64 = 0,
+    gid: u64 = 0,
+    size: u64 = 0,
+    mtime: u64 = 0,
+    link: []const u8 = "",
+    dev_major: u32 = 0,
+    dev_minor: u32 = 0,
+};
+
+/// One ustar header block; values too large for their field are written as 0
+/// and carried by the preceding PAX record instead
+fn writeHeader(writer: *std.Io.Writer, header: Header) !void {
+    var block = [_]u8{0} ** BLOCK;
+    copyTruncated(block[0..100], header.name);
+    writeOctal(block[100..108], header.mode);
+    writeOctal(block[108..116], if (header.uid > MAX_OCTAL_7) 0 else header.uid);
+    writeOctal(block[116..124], if (header.gid > MAX_OCTAL_7) 0 else header.gid);
+    writeOctal(block[124..136], if (header.size > MAX_OCTAL_11) 0 else header.size);
+    writeOctal(block[136..148], @min(header.mtime, MAX_OCTAL_11));
+    block[156] = header.typeflag;
+    copyTruncated(block[157..257], header.link);
+    @memcpy(block[257..263], "ustar\x00");
+    @memcpy(block[263..265], "00");
+    writeOctal(block[329..337], header.dev_major & MAX_OCTAL_7);
+    writeOctal(block[337..345], header.dev_minor & MAX_OCTAL_7);
+
+    @memset(block[148..156], ' ');
+    var sum: u64 = 0;
+    for (block) |byte| sum += byte;
+    writeOctal(block[148..155], sum);
+
+    try writer.writeAll(&block);
+}
+
+/// Zero-padded octal, NUL-terminated
+fn writeOctal(field: []u8, value: u64) void {
+    var v = value;
+    var i = field.len - 1;
+    field[i] = 0;
+    while (i > 0) {
+        i -= 1;
+        field[i] = '0' + @as(u8, @intCast(v & 7));
+        v >>= 3;
+    }
+}
+
+fn copyTruncated(field: []u8, value: []const u8) void {
+    const len = @min(field.len, value.len);
+    @memcpy(field[0..len], value[0..len]);
+}
+
+fn padding(size: u64) usize {
+    return @intCast((BLOCK - size % BLOCK) % BLOCK);
+}
+
+fn nameLessThan(_: void, a: []u8, b: []u8) bool {
+    return std.mem.lessThan(u8, a, b);
+}
+
+/// Inverse of the kernel `new_encode_dev` layout used in st_rdev
+fn devMajor(rdev: u64) u32 {
+    return @truncate(((rdev >> 8) & 0xfff) | ((rdev >> 32) & ~@as(u64, 0xfff)));
+}
+
+fn devMinor(rdev: u64) u32 {
+    return @truncate((rdev & 0xff) | ((rdev >> 12) & ~@as(u64, 0xff)));
+}
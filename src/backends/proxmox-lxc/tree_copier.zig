@@ -0,0 +1,221 @@
+const std = @import("std");
+const core = @import("core");
+
+const linux = std.os.linux;
+
+/// _IOW(0x94, 9, int): share the source extents with the destination file
+const FICLONE: u32 = 0x40049409;
+
+/// Totals for one copy; updated atomically by the workers
+pub const CopyStats = struct {
+    files: u64 = 0,
+    dirs: u64 = 0,
+    symlinks: u64 = 0,
+    bytes: u64 = 0,
+    reflinked: u64 = 0,
+    skipped: u64 = 0,
+};
+
+pub const Options = struct {
+    /// Worker threads; 0 picks the CPU count, capped at 16
+    jobs: usize = 0,
+    /// Try FICLONE before falling back to copy_file_range
+    reflink: bool = true,
+    /// chown to the source uid/gid (only effective as root)
+    preserve_owner: bool = true,
+};
+
+/// Parallel directory tree copier
+///
+/// Each directory is one pool task: it creates all of its subdirectories in one
+/// pass, queues them as new tasks and copies its own files. Idle workers pick
+/// up whichever directory is queued next, so deep and wide trees both keep every
+/// worker busy. Files are reflinked when source and destination share a
+/// CoW filesystem (ZFS, Btrfs, XFS) and copied with copy_file_range otherwise,
+/// so data never passes through userspace.
+///
+/// Tasks carry relative paths, not open handles, so a large queue does not
+/// exhaust file descriptors. The allocator is shared by workers and must be
+/// thread-safe.
+pub const TreeCopier = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    source: std.fs.Dir,
+    dest: std.fs.Dir,
+    options: Options,
+    pool: std.Thread.Pool = undefined,
+    wg: std.Thread.WaitGroup = .{},
+
+    files: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    dirs: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    symlinks: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    bytes: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    reflinked: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    skipped: std.atomic.Value(u64) = std.atomic.Value(u64).init(0),
+    /// Cleared after the first EXDEV/EOPNOTSUPP so later files go straight to copy_file_range
+    reflink_ok: std.atomic.Value(bool) = std.atomic.Value(bool).init(true),
+
+    first_error: ?anyerror = null,
+    error_mutex: std.Thread.Mutex = .{},
+    aborted: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+
+    trace_enabled: bool,
+    is_root: bool,
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, source: std.fs.Dir, dest: std.fs.Dir, options: Options) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .source = source,
+            .dest = dest,
+            .options = options,
+            .reflink_ok = std.atomic.Value(bool).init(options.reflink),
+            // Checked once so per-entry logging costs nothing unless tracing
+            .trace_enabled = if (logger) |log| log.level == .trace else false,
+            .is_root = linux.geteuid() == 0,
+        };
+    }
+
+    /// Copy the whole source tree into dest; dest must already exist
+    pub fn run(self: *Self) !CopyStats {
+        const jobs = if (self.options.jobs != 0) self.options.jobs else @min(std.Thread.getCpuCount() catch 1, 16);
+        try self.pool.init(.{ .allocator = self.allocator, .n_jobs = jobs });
+        defer self.pool.deinit();
+
+        const root = try self.allocator.dupe(u8, ".");
+        self.pool.spawnWg(&self.wg, copyDirTask, .{ self, root });
+        self.pool.waitAndWork(&self.wg);
+
+        if (self.first_error) |err| return err;
+        return self.stats();
+    }
+
+    pub fn stats(self: *const Self) CopyStats {
+        return .{
+            .files = self.files.load(.monotonic),
+            .dirs = self.dirs.load(.monotonic),
+            .symlinks = self.symlinks.load(.monotonic),
+            .bytes = self.bytes.load(.monotonic),
+            .reflinked = self.reflinked.load(.monotonic),
+            .skipped = self.skipped.load(.monotonic),
+        };
+    }
+
+    fn copyDirTask(self: *Self, rel_path: []u8) void {
+        defer self.allocator.free(rel_path);
+        if (self.failed()) return;
+        self.copyDir(rel_path) catch |err| self.recordError(rel_path, err);
+    }
+
+    fn copyDir(self: *Self, rel_path: []const u8) !void {
+        var src_dir = try self.source.openDir(rel_path, .{ .iterate = true });
+        defer src_dir.close();
+        var dst_dir = try self.dest.openDir(rel_path, .{});
+        defer dst_dir.close();
+
+        var it = src_dir.iterate();
+        while (try it.next()) |entry| {
+            if (self.failed()) return;
+
+            switch (entry.kind) {
+                .directory => {
+                    const st = try std.posix.fstatat(src_dir.fd, entry.name, linux.AT.SYMLINK_NOFOLLOW);
+                    dst_dir.makeDir(entry.name) catch |err| switch (err) {
+                        error.PathAlreadyExists => {},
+                        else => return err,
+                    };
+                    var sub = try dst_dir.openDir(entry.name, .{});
+                    defer sub.close();
+                    self.applyOwnerAndMode(sub.fd, st);
+                    _ = self.dirs.fetchAdd(1, .monotonic);
+
+                    const child = try std.fs.path.join(self.allocator, &.{ rel_path, entry.name });
+                    self.pool.spawnWg(&self.wg, copyDirTask, .{ self, child });
+                },
+                .file => try self.copyFile(src_dir, dst_dir, entry.name, rel_path),
+                .sym_link => {
+                    var target_buf: [std.fs.max_path_bytes]u8 = undefined;
+                    const target = try src_dir.readLink(entry.name, &target_buf);
+                    dst_dir.deleteFile(entry.name) catch {};
+                    try dst_dir.symLink(target, entry.name, .{});
+                    _ = self.symlinks.fetchAdd(1, .monotonic);
+                    if (self.trace_enabled) self.trace("symlink {s}/{s} -> {s}", .{ rel_path, entry.name, target });
+                },
+                else => {
+                    _ = self.skipped.fetchAdd(1, .monotonic);
+                    if (self.logger) |log| log.debug("Skipping {s} entry {s}/{s}", .{ @tagName(entry.kind), rel_path, entry.name }) catch {};
+                },
+            }
+        }
+    }
+
+    fn copyFile(self: *Self, src_dir: std.fs.Dir, dst_dir: std.fs.Dir, name: []const u8, rel_path: []const u8) !void {
+        const src = try src_dir.openFile(name, .{});
+        defer src.close();
+        const st = try std.posix.fstat(src.handle);
+        const size: u64 = @intCast(st.size);
+
+        const dst = try dst_dir.createFile(name, .{ .truncate = true, .mode = st.mode & 0o7777 });
+        defer dst.close();
+
+        if (self.reflink_ok.load(.monotonic) and self.reflink(src, dst)) {
+            _ = self.reflinked.fetchAdd(1, .monotonic);
+        } else {
+            var offset: u64 = 0;
+            while (offset < size) {
+                const n = try std.posix.copy_file_range(src.handle, offset, dst.handle, offset, @intCast(@min(size - offset, 1 << 30)), 0);
+                if (n == 0) break;
+                offset += n;
+            }
+        }
+
+        self.applyOwnerAndMode(dst.handle, st);
+        _ = self.files.fetchAdd(1, .monotonic);
+        _ = self.bytes.fetchAdd(size, .monotonic);
+        if (self.trace_enabled) self.trace("file {s}/{s} ({d} bytes)", .{ rel_path, name, size });
+    }
+
+    /// FICLONE; false if the filesystem cannot share extents between these files
+    fn reflink(self: *Self, src: std.fs.File, dst: std.fs.File) bool {
+        const rc = linux.ioctl(dst.handle, FICLONE, @intCast(src.handle));
+        switch (std.posix.errno(rc)) {
+            .SUCCESS => return true,
+            // Different filesystems or no CoW support: stop trying for the rest of the tree
+            .XDEV, .OPNOTSUPP, .INVAL, .NOTTY => {
+                if (self.reflink_ok.swap(false, .monotonic)) {
+                    if (self.logger) |log| log.debug("Reflink unavailable, using copy_file_range", .{}) catch {};
+                }
+                return false;
+            },
+            else => return false,
+        }
+    }
+
+    fn applyOwnerAndMode(self: *Self, fd: std.posix.fd_t, st: std.posix.Stat) void {
+        if (self.options.preserve_owner and self.is_root) {
+            std.posix.fchown(fd, st.uid, st.gid) catch {};
+        }
+        // After chown, which drops setuid bits; createFile/makeDir modes are also masked by umask
+        std.posix.fchmod(fd, st.mode & 0o7777) catch {};
+    }
+
+    fn trace(self: *Self, comptime format: []const u8, args: anytype) void {
+        if (self.logger) |log| log.trace(format, args) catch {};
+    }
+
+    fn failed(self: *const Self) bool {
+        return self.aborted.load(.monotonic);
+    }
+
+    fn recordError(self: *Self, rel_path: []const u8, err: anyerror) void {
+        self.error_mutex.lock();
+        defer self.error_mutex.unlock();
+        if (self.first_error == null) {
+            self.first_error = err;
+            self.aborted.store(true, .monotonic);
+            if (self.logger) |log| log.err("Copy failed in {s}: {}", .{ rel_path, err }) catch {};
+        }
+    }
+};
@@ -0,0 +1,293 @@
+const std = @import("std");
+const core = @import("core");
+const pve_config = @import("pve_config.zig");
+
+/// VMIDs accepted by Proxmox
+pub const VMID_MIN: u32 = 100;
+pub const VMID_MAX: u32 = 999999;
+
+/// Inclusive VMID range, e.g. one per tenant or pool
+pub const VmidRange = struct {
+    first: u32 = VMID_MIN,
+    last: u32 = VMID_MAX,
+
+    pub fn contains(self: VmidRange, vmid: u32) bool {
+        return vmid >= self.first and vmid <= self.last;
+    }
+
+    pub fn validate(self: VmidRange) !void {
+        if (self.first < VMID_MIN or self.last > VMID_MAX or self.first > self.last) return core.Error.InvalidInput;
+    }
+};
+
+pub const FULL_RANGE = VmidRange{};
+
+const BITS: usize = VMID_MAX - VMID_MIN + 1;
+const WORDS: usize = (BITS + 63) / 64;
+const SUMMARY_WORDS: usize = (WORDS + 63) / 64;
+const MAGIC = "NXVMID01".*;
+/// vmlist_mtime before the cluster bitmap was ever built
+const NEVER_SYNCED: i64 = std.math.minInt(i64);
+
+const Header = extern struct {
+    magic: [8]u8,
+    /// Non-zero while a mutation is in progress; summary is rebuilt if a writer died
+    dirty: u32,
+    _reserved: u32,
+    /// mtime (ns) of .vmlist the cluster bitmap was built from, 0 if it did not exist
+    vmlist_mtime: i64,
+    _pad: [40]u8,
+};
+
+const FILE_SIZE = @sizeOf(Header) + (2 * WORDS + SUMMARY_WORDS) * @sizeOf(u64);
+
+/// Free-VMID allocator backed by a two-level bitmap in the state dir
+///
+/// The file holds three bitmaps over 100..999999: VMIDs reserved through this
+/// allocator, VMIDs present in the cluster .vmlist, and a summary with one bit per
+/// fully-used word. A VMID is free when it is in neither of the first two. Finding
+/// a free VMID walks at most SUMMARY_WORDS + a few words, independent of how many
+/// guests exist. The cluster bitmap is rebuilt only when .vmlist changes.
+///
+/// The file is mmap'd shared; every operation holds an flock on it so separate
+/// nexcage processes see one consistent allocator.
+pub const VmidAllocator = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    pve: pve_config.PveConfigReader,
+    file: std.fs.File,
+    mapping: []align(std.heap.page_size_min) u8,
+    header: *Header,
+    reserved: []u64,
+    cluster: []u64,
+    summary: []u64,
+    // flock does not exclude threads sharing one open file
+    mutex: std.Thread.Mutex = .{},
+
+    pub const BITMAP_NAME = "vmid.bitmap";
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8) !Self {
+        return initWithReader(allocator, logger, state_dir, pve_config.PveConfigReader.init(allocator));
+    }
+
+    /// Use a custom pmxcfs root, e.g. a fixture tree
+    pub fn initWithReader(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8, pve: pve_config.PveConfigReader) !Self {
+        try std.fs.cwd().makePath(state_dir);
+
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = try std.fmt.bufPrint(&path_buf, "{s}/{s}", .{ state_dir, BITMAP_NAME });
+
+        const file = try std.fs.cwd().createFile(path, .{ .truncate = false, .read = true });
+        errdefer file.close();
+
+        try file.lock(.exclusive);
+        defer file.unlock();
+
+        const size_ok = (try file.stat()).size == FILE_SIZE;
+        if (!size_ok) {
+            try file.setEndPos(0);
+            try file.setEndPos(FILE_SIZE);
+        }
+
+        const mapping = try std.posix.mmap(null, FILE_SIZE, std.posix.PROT.READ | std.posix.PROT.WRITE, .{ .TYPE = .SHARED }, file.handle, 0);
+        errdefer std.posix.munmap(mapping);
+
+        const words: [*]u64 = @ptrCast(@alignCast(mapping.ptr + @sizeOf(Header)));
+        var self = Self{
+            .allocator = allocator,
+            .logger = logger,
+            .pve = pve,
+            .file = file,
+            .mapping = mapping,
+            .header = @ptrCast(@alignCast(mapping.ptr)),
+            .reserved = words[0..WORDS],
+            .cluster = words[WORDS .. 2 * WORDS],
+            .summary = words[2 * WORDS .. 2 * WORDS + SUMMARY_WORDS],
+        };
+
+        if (!size_ok or !std.mem.eql(u8, &self.header.magic, &MAGIC)) {
+            if (logger) |log| log.info("Initialising VMID bitmap at {s}", .{path}) catch {};
+            self.format();
+        }
+
+        return self;
+    }
+
+    pub fn deinit(self: *Self) void {
+        std.posix.munmap(self.mapping);
+        self.file.close();
+    }
+
+    /// Reserve a free VMID in `range`, starting the search at `preferred` and wrapping
+    pub fn reserve(self: *Self, range: VmidRange, preferred: ?u32) !u32 {
+        try range.validate();
+        try self.begin();
+        defer self.end();
+
+        const lo = bitOf(range.first);
+        const hi = bitOf(range.last);
+        const start = if (preferred) |p| if (range.contains(p)) bitOf(p) else lo else lo;
+
+        const bit = self.findFree(start, hi) orelse
+            (if (start > lo) self.findFree(lo, start - 1) else null) orelse {
+            if (self.logger) |log| log.err("No free VMID in range {d}-{d}", .{ range.first, range.last }) catch {};
+            return error.VmidRangeExhausted;
+        };
+
+        self.setReserved(bit);
+        return vmidOf(bit);
+    }
+
+    /// Reserve a specific VMID; false if it is already taken
+    pub fn reserveExact(self: *Self, vmid: u32) !bool {
+        if (!FULL_RANGE.contains(vmid)) return core.Error.InvalidInput;
+        try self.begin();
+        defer self.end();
+
+        const bit = bitOf(vmid);
+        if (self.isUsedBit(bit)) return false;
+        self.setReserved(bit);
+        return true;
+    }
+
+    /// Return a VMID to the pool; the cluster bit clears once .vmlist drops it
+    pub fn release(self: *Self, vmid: u32) !void {
+        if (!FULL_RANGE.contains(vmid)) return core.Error.InvalidInput;
+        try self.begin();
+        defer self.end();
+
+        const bit = bitOf(vmid);
+        self.reserved[bit / 64] &= ~(@as(u64, 1) << @intCast(bit % 64));
+        self.updateSummary(bit / 64);
+    }
+
+    /// Whether a VMID is neither reserved nor present in the cluster
+    pub fn isFree(self: *Self, vmid: u32) !bool {
+        if (!FULL_RANGE.contains(vmid)) return false;
+        try self.begin();
+        defer self.end();
+        return !self.isUsedBit(bitOf(vmid));
+    }
+
+    fn begin(self: *Self) !void {
+        self.mutex.lock();
+        errdefer self.mutex.unlock();
+        try self.file.lock(.exclusive);
+        errdefer self.file.unlock();
+
+        if (self.header.dirty != 0) self.rebuildSummary();
+        self.header.dirty = 1;
+        try self.syncCluster();
+    }
+
+    fn end(self: *Self) void {
+        self.header.dirty = 0;
+        self.file.unlock();
+        self.mutex.unlock();
+    }
+
+    /// Rebuild the cluster bitmap if .vmlist changed since it was last read
+    fn syncCluster(self: *Self) !void {
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const path = try std.fmt.bufPrint(&path_buf, "{s}/.vmlist", .{self.pve.pve_root});
+        const mtime: i64 = if (std.fs.cwd().statFile(path)) |st| @truncate(st.mtime) else |_| 0;
+        if (mtime == self.header.vmlist_mtime) return;
+
+        @memset(self.cluster, 0);
+        var guests: usize = 0;
+        if (self.pve.openVmlist()) |vmlist_const| {
+            var vmlist = vmlist_const;
+            defer vmlist.deinit();
+            var it = vmlist.iterator();
+            while (it.next()) |entry| {
+                // VMIDs are cluster-wide and shared with QEMU guests
+                if (!FULL_RANGE.contains(entry.vmid)) continue;
+                const bit = bitOf(entry.vmid);
+                self.cluster[bit / 64] |= @as(u64, 1) << @intCast(bit % 64);
+                guests += 1;
+            }
+        } else |err| {
+            if (self.logger) |log| log.debug("No cluster vmlist ({}), treating cluster as empty", .{err}) catch {};
+        }
+
+        self.header.vmlist_mtime = mtime;
+        self.rebuildSummary();
+        if (self.logger) |log| log.debug("VMID bitmap synced with {d} cluster guests", .{guests}) catch {};
+    }
+
+    /// First free bit in [a, b], skipping full words via the summary
+    fn findFree(self: *const Self, a: usize, b: usize) ?usize {
+        if (a > b) return null;
+        const first_w = a / 64;
+        const last_w = b / 64;
+
+        var w = first_w;
+        while (w <= last_w) {
+            const sw = w / 64;
+            const not_full = ~self.summary[sw] & (~@as(u64, 0) << @intCast(w % 64));
+            if (not_full == 0) {
+                w = (sw + 1) * 64;
+                continue;
+            }
+            w = sw * 64 + @ctz(not_full);
+            if (w > last_w) return null;
+
+            var free = ~(self.reserved[w] | self.cluster[w]);
+            if (w == first_w) free &= ~@as(u64, 0) << @intCast(a % 64);
+            if (w == last_w) free &= maskThrough(b % 64);
+            if (free != 0) return w * 64 + @ctz(free);
+            w += 1;
+        }
+        return null;
+    }
+
+    fn isUsedBit(self: *const Self, bit: usize) bool {
+        const mask = @as(u64, 1) << @intCast(bit % 64);
+        return (self.reserved[bit / 64] | self.cluster[bit / 64]) & mask != 0;
+    }
+
+    fn setReserved(self: *Self, bit: usize) void {
+        self.reserved[bit / 64] |= @as(u64, 1) << @intCast(bit % 64);
+        self.updateSummary(bit / 64);
+    }
+
+    fn updateSummary(self: *Self, w: usize) void {
+        const mask = @as(u64, 1) << @intCast(w % 64);
+        if (self.reserved[w] | self.cluster[w] == ~@as(u64, 0)) {
+            self.summary[w / 64] |= mask;
+        } else {
+            self.summary[w / 64] &= ~mask;
+        }
+    }
+
+    fn rebuildSummary(self: *Self) void {
+        @memset(self.summary, 0);
+        for (0..WORDS) |w| self.updateSummary(w);
+        // Slots past the last word never have room
+        for (WORDS..SUMMARY_WORDS * 64) |w| self.summary[w / 64] |= @as(u64, 1) << @intCast(w % 64);
+    }
+
+    fn format(self: *Self) void {
+        @memset(self.mapping, 0);
+        self.header.magic = MAGIC;
+        self.header.vmlist_mtime = NEVER_SYNCED;
+        // Bits past VMID_MAX in the last word are permanently taken
+        for (BITS..WORDS * 64) |bit| self.reserved[bit / 64] |= @as(u64, 1) << @intCast(bit % 64);
+        self.rebuildSummary();
+    }
+
+    fn bitOf(vmid: u32) usize {
+        return vmid - VMID_MIN;
+    }
+
+    fn vmidOf(bit: usize) u32 {
+        return @intCast(bit + VMID_MIN);
+    }
+
+    fn maskThrough(n: usize) u64 {
+        if (n == 63) return ~@as(u64, 0);
+        return (@as(u64, 1) << @intCast(n + 1)) - 1;
+    }
+};
@@ -1,5 +1,7 @@
 const std = @import("std");
 const core = @import("core");
+const vmid_allocator = @import("vmid_allocator.zig");
+const mapping_store = @import("mapping_store.zig");
 
 /// VMID Manager for Proxmox LXC containers
 /// Handles VMID generation, collision detection, and mapping storage
@@ -8,25 +10,42 @@ pub const VmidManager = struct {
     logger: ?*core.LogContext,
     state_dir: []const u8,
     mapping_file: []const u8,
+    vmids: vmid_allocator.VmidAllocator,
+    store: mapping_store.MappingStore,
 
-    const VMID_START = 100;
-    const VMID_END = 999999;
+    const VMID_START = vmid_allocator.VMID_MIN;
+    const VMID_END = vmid_allocator.VMID_MAX;
 
     pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8) !VmidManager {
         const mapping_file = try std.fs.path.join(allocator, &[_][]const u8{ state_dir, "mapping.json" });
-        
+        errdefer allocator.free(mapping_file);
+
         // Ensure state directory exists
         try std.fs.cwd().makePath(state_dir);
 
-        return VmidManager{
+        var vmids = try vmid_allocator.VmidAllocator.init(allocator, logger, state_dir);
+        errdefer vmids.deinit();
+        const store = try mapping_store.MappingStore.init(allocator, logger, state_dir);
+
+        var manager = VmidManager{
             .allocator = allocator,
             .logger = logger,
             .state_dir = state_dir,
             .mapping_file = mapping_file,
+            .vmids = vmids,
+            .store = store,
         };
+
+        manager.migrateLegacyMappings() catch |err| {
+            manager.store.deinit();
+            return err;
+        };
+        return manager;
     }
 
     pub fn deinit(self: *VmidManager) void {
+        self.store.deinit();
+        self.vmids.deinit();
         self.allocator.free(self.mapping_file);
     }
 
@@ -41,170 +60,65 @@ pub const VmidManager = struct {
         return @as(u32, @intCast(VMID_START + (hash_value % range)));
     }
 
-    /// Check if VMID exists in Proxmox using pct list
-    fn vmidExistsInProxmox(self: *VmidManager, vmid: u32) !bool {
-        const result = try std.process.Child.run(.{
-            .allocator = self.allocator,
-            .argv = &[_][]const u8{ "pct", "list" },
-        });
-        defer self.allocator.free(result.stdout);
-        defer self.allocator.free(result.stderr);
-
-        if (result.term.Exited != 0) {
-            if (self.logger) |log| {
-                try log.warn("Failed to list containers: {s}", .{result.stderr});
-            }
-            return false;
-        }
-
-        const vmid_str = try std.fmt.allocPrint(self.allocator, "{d}", .{vmid});
-        defer self.allocator.free(vmid_str);
-
-        return std.mem.indexOf(u8, result.stdout, vmid_str) != null;
-    }
-
-    /// Load existing mappings from file
-    fn loadMappings(self: *VmidManager) !std.StringHashMap(MappingEntry) {
-        var mappings = std.StringHashMap(MappingEntry).init(self.allocator);
+    /// One mapping.json value; the container ID is its key
+    const LegacyEntry = struct {
+        vmid: u32,
+        created_at: i64 = 0,
+        bundle_path: []const u8,
+    };
 
+    /// Load mappings from the legacy mapping.json; strings borrow from the
+    /// file contents, which live in `arena` along with everything else
+    fn loadMappings(self: *VmidManager, arena: std.mem.Allocator) ![]MappingEntry {
         const file = std.fs.cwd().openFile(self.mapping_file, .{}) catch |err| {
             if (err == error.FileNotFound) {
                 if (self.logger) |log| {
                     try log.debug("Mapping file not found, starting with empty mappings", .{});
                 }
-                return mappings;
+                return &.{};
             }
             return err;
         };
         defer file.close();
 
-        const content = try file.readToEndAlloc(self.allocator, 10 * 1024 * 1024); // 10MB max
-        defer self.allocator.free(content);
-
-        const parsed = try std.json.parseFromSlice(std.json.Value, self.allocator, content, .{});
-        defer parsed.deinit();
-
-        if (parsed.value != .object) {
-            return mappings;
-        }
-
-        var it = parsed.value.object.iterator();
-        while (it.next()) |entry| {
-            const container_id = entry.key_ptr.*;
-            const value = entry.value_ptr.*;
-
-            if (value != .object) continue;
-
-            const vmid = if (value.object.get("vmid")) |v| 
-                if (v == .integer) @as(u32, @intCast(v.integer)) else continue
-            else continue;
-
-            const created_at = if (value.object.get("created_at")) |v|
-                if (v == .integer) v.integer else 0
-            else 0;
-
-            const bundle_path = if (value.object.get("bundle_path")) |v|
-                if (v == .string) try self.allocator.dupe(u8, v.string) else continue
-            else continue;
+        const content = try file.readToEndAlloc(arena, 10 * 1024 * 1024); // 10MB max
+        const parsed = try std.json.parseFromSliceLeaky(std.json.ArrayHashMap(LegacyEntry), arena, content, .{
+            .allocate = .alloc_if_needed,
+            .ignore_unknown_fields = true,
+        });
 
-            try mappings.put(try self.allocator.dupe(u8, container_id), .{
-                .container_id = try self.allocator.dupe(u8, container_id),
-                .vmid = vmid,
-                .created_at = created_at,
-                .bundle_path = bundle_path,
-            });
+        const mappings = try arena.alloc(MappingEntry, parsed.map.count());
+        for (parsed.map.keys(), parsed.map.values(), mappings) |container_id, value, *mapping| {
+            mapping.* = .{
+                .container_id = container_id,
+                .vmid = value.vmid,
+                .created_at = value.created_at,
+                .bundle_path = value.bundle_path,
+            };
         }
-
         return mappings;
     }
 
-    /// Save mappings to file
-    fn saveMappings(self: *VmidManager, mappings: *std.StringHashMap(MappingEntry)) !void {
-        var json_obj = std.json.ObjectMap.init(self.allocator);
-        defer json_obj.deinit();
-
-        var it = mappings.iterator();
-        while (it.next()) |entry| {
-            var entry_obj = std.json.ObjectMap.init(self.allocator);
-            
-            try entry_obj.put("vmid", .{ .integer = entry.value_ptr.vmid });
-            try entry_obj.put("created_at", .{ .integer = entry.value_ptr.created_at });
-            try entry_obj.put("bundle_path", .{ .string = entry.value_ptr.bundle_path });
+    /// Import a legacy mapping.json into the store once, then set it aside
+    fn migrateLegacyMappings(self: *VmidManager) !void {
+        std.fs.cwd().access(self.mapping_file, .{}) catch return;
 
-            try json_obj.put(entry.key_ptr.*, .{ .object = entry_obj });
-        }
+        var arena = std.heap.ArenaAllocator.init(self.allocator);
+        defer arena.deinit();
+        const mappings = try self.loadMappings(arena.allocator());
 
-        // Simple JSON serialization
-        var json_buffer = std.ArrayListUnmanaged(u8){};
-        defer json_buffer.deinit(self.allocator);
-        
-        try json_buffer.append(self.allocator, '{');
-        var first = true;
-        var json_it = json_obj.iterator();
-        while (json_it.next()) |entry| {
-            if (!first) try json_buffer.append(self.allocator, ',');
-            first = false;
-            
-            try json_buffer.append(self.allocator, '\n');
-            try json_buffer.append(self.allocator, ' ');
-            try json_buffer.append(self.allocator, ' ');
-            try json_buffer.append(self.allocator, '"');
-            try json_buffer.appendSlice(self.allocator, entry.key_ptr.*);
-            try json_buffer.append(self.allocator, '"');
-            try json_buffer.append(self.allocator, ':');
-            try json_buffer.append(self.allocator, ' ');
-            
-            const value = entry.value_ptr.*;
-            if (value == .object) {
-                const obj = value.object;
-                try json_buffer.append(self.allocator, '{');
-                var first_field = true;
-                var field_it = obj.iterator();
-                while (field_it.next()) |field| {
-                    if (!first_field) try json_buffer.append(self.allocator, ',');
-                    first_field = false;
-                    
-                    try json_buffer.append(self.allocator, '\n');
-                    try json_buffer.append(self.allocator, ' ');
-                    try json_buffer.append(self.allocator, ' ');
-                    try json_buffer.append(self.allocator, ' ');
-                    try json_buffer.append(self.allocator, ' ');
-                    try json_buffer.append(self.allocator, '"');
-                    try json_buffer.appendSlice(self.allocator, field.key_ptr.*);
-                    try json_buffer.append(self.allocator, '"');
-                    try json_buffer.append(self.allocator, ':');
-                    try json_buffer.append(self.allocator, ' ');
-                    
-                    const field_value = field.value_ptr.*;
-                    if (field_value == .string) {
-                        try json_buffer.append(self.allocator, '"');
-                        try json_buffer.appendSlice(self.allocator, field_value.string);
-                        try json_buffer.append(self.allocator, '"');
-                    } else if (field_value == .integer) {
-                        const int_str = try std.fmt.allocPrint(self.allocator, "{d}", .{field_value.integer});
-                        defer self.allocator.free(int_str);
-                        try json_buffer.appendSlice(self.allocator, int_str);
-                    }
-                }
-                try json_buffer.append(self.allocator, '\n');
-                try json_buffer.append(self.allocator, ' ');
-                try json_buffer.append(self.allocator, ' ');
-                try json_buffer.append(self.allocator, '}');
-            }
+        for (mappings) |e| {
+            if ((try self.store.get(e.container_id)) != null) continue;
+            try self.store.put(e.container_id, e.vmid, e.created_at, e.bundle_path);
         }
-        try json_buffer.append(self.allocator, '\n');
-        try json_buffer.append(self.allocator, '}');
-        
-        const json_string = try json_buffer.toOwnedSlice(self.allocator);
-        defer self.allocator.free(json_string);
+        try self.store.sync();
 
-        try std.fs.cwd().writeFile(.{
-            .sub_path = self.mapping_file,
-            .data = json_string,
-        });
+        const migrated = try std.fmt.allocPrint(self.allocator, "{s}.migrated", .{self.mapping_file});
+        defer self.allocator.free(migrated);
+        try std.fs.cwd().rename(self.mapping_file, migrated);
 
         if (self.logger) |log| {
-            try log.debug("Mappings saved to {s}", .{self.mapping_file});
+            try log.info("Migrated {d} mappings from {s}", .{ mappings.len, self.mapping_file });
         }
     }
 
@@ -214,54 +128,29 @@ pub const VmidManager = struct {
             try log.info("Generating VMID for container: {s}", .{container_id});
         }
 
-        var mappings = try self.loadMappings();
-        defer {
-            var it = mappings.iterator();
-            while (it.next()) |entry| {
-                var e = entry.value_ptr.*;
-                e.deinit(self.allocator);
-            }
-            mappings.deinit();
-        }
-
         // Check if mapping already exists
-        if (mappings.get(container_id)) |entry| {
+        if (try self.store.get(container_id)) |entry| {
             if (self.logger) |log| {
                 try log.info("Found existing VMID {d} for container {s}", .{ entry.vmid, container_id });
             }
             return entry.vmid;
         }
 
-        // Generate new VMID
-        var vmid = generateVmidFromHash(container_id);
-        var attempts: u32 = 0;
-        const max_attempts: u32 = 1000;
+        // Start at the hashed VMID so IDs stay stable, the bitmap finds the next free one
+        const preferred = generateVmidFromHash(container_id);
+        var attempts: usize = 0;
+        const max_attempts = (try self.store.count()) + 1;
 
         while (attempts < max_attempts) : (attempts += 1) {
-            // Check if VMID is already used in mappings
-            var is_used = false;
-            var it = mappings.iterator();
-            while (it.next()) |entry| {
-                if (entry.value_ptr.vmid == vmid) {
-                    is_used = true;
-                    break;
-                }
-            }
+            const vmid = try self.vmids.reserve(vmid_allocator.FULL_RANGE, preferred);
 
-            // Check if VMID exists in Proxmox
-            if (!is_used) {
-                is_used = try self.vmidExistsInProxmox(vmid);
-            }
+            // Mappings imported from mapping.json may predate the bitmap; keep those reserved
+            if (try self.store.vmidInUse(vmid)) continue;
 
-            if (!is_used) {
-                if (self.logger) |log| {
-                    try log.info("Generated VMID {d} for container {s}", .{ vmid, container_id });
-                }
-                return vmid;
+            if (self.logger) |log| {
+                try log.info("Generated VMID {d} for container {s}", .{ vmid, container_id });
             }
-
-            // Collision detected, try next VMID
-            vmid = if (vmid >= VMID_END) VMID_START else vmid + 1;
+            return vmid;
         }
 
         if (self.logger) |log| {
@@ -276,26 +165,8 @@ pub const VmidManager = struct {
             try log.info("Storing mapping: {s} -> VMID {d}", .{ container_id, vmid });
         }
 
-        var mappings = try self.loadMappings();
-        defer {
-            var it = mappings.iterator();
-            while (it.next()) |entry| {
-                var e = entry.value_ptr.*;
-                e.deinit(self.allocator);
-            }
-            mappings.deinit();
-        }
+        try self.store.put(container_id, vmid, std.time.timestamp(), bundle_path);
 
-        const timestamp = std.time.timestamp();
-        
-        try mappings.put(try self.allocator.dupe(u8, container_id), .{
-            .container_id = try self.allocator.dupe(u8, container_id),
-            .vmid = vmid,
-            .created_at = timestamp,
-            .bundle_path = try self.allocator.dupe(u8, bundle_path),
-        });
-
-        try self.saveMappings(&mappings);
         if (self.logger) |log| {
             try log.info("Mapping stored successfully", .{});
         }
@@ -303,17 +174,7 @@ pub const VmidManager = struct {
 
     /// Get VMID for container ID
     pub fn getVmid(self: *VmidManager, container_id: []const u8) !u32 {
-        var mappings = try self.loadMappings();
-        defer {
-            var it = mappings.iterator();
-            while (it.next()) |entry| {
-                var e = entry.value_ptr.*;
-                e.deinit(self.allocator);
-            }
-            mappings.deinit();
-        }
-
-        if (mappings.get(container_id)) |entry| {
+        if (try self.store.get(container_id)) |entry| {
             return entry.vmid;
         }
 
@@ -326,20 +187,11 @@ pub const VmidManager = struct {
             try log.info("Removing mapping for container: {s}", .{container_id});
         }
 
-        var mappings = try self.loadMappings();
-        defer {
-            var it = mappings.iterator();
-            while (it.next()) |entry| {
-                var e = entry.value_ptr.*;
-                e.deinit(self.allocator);
-            }
-            mappings.deinit();
-        }
+        const entry = try self.store.get(container_id);
+        const vmid = if (entry) |e| e.vmid else null;
 
-        if (mappings.fetchRemove(container_id)) |removed| {
-            var e = removed.value;
-            e.deinit(self.allocator);
-            try self.saveMappings(&mappings);
+        if (try self.store.remove(container_id)) {
+            if (vmid) |v| try self.vmids.release(v);
             if (self.logger) |log| {
                 try log.info("Mapping removed successfully", .{});
             }
@@ -352,14 +204,4 @@ pub const VmidManager = struct {
 };
 
 /// Container ID to VMID mapping entry
-pub const MappingEntry = struct {
-    container_id: []const u8,
-    vmid: u32,
-    created_at: i64, // Unix timestamp
-    bundle_path: []const u8,
-
-    pub fn deinit(self: *MappingEntry, allocator: std.mem.Allocator) void {
-        allocator.free(self.container_id);
-        allocator.free(self.bundle_path);
-    }
-};
+pub const MappingEntry = mapping_store.MappingEntry;
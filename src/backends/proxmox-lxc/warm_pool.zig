@@ -0,0 +1,144 @@
+const std = @import("std");
+const core = @import("core");
+const locked_index = @import("locked_index.zig");
+
+/// Hostname of a container while it waits in the pool
+pub const HOSTNAME_PREFIX = "nexcage-warm-";
+
+pub const Member = struct {
+    /// Template volume the container was created from
+    template: []const u8,
+    vmid: u32,
+    created_at: i64,
+
+    /// `<vmid>\t<created_at>\t<template>`
+    pub fn parseLine(arena: std.mem.Allocator, line: []const u8) !?Member {
+        _ = arena;
+        var fields = std.mem.splitScalar(u8, line, '\t');
+        const vmid = std.fmt.parseInt(u32, fields.next() orelse return null, 10) catch return null;
+        const created_at = std.fmt.parseInt(i64, fields.next() orelse return null, 10) catch return null;
+        const template = fields.next() orelse return null;
+        if (template.len == 0) return null;
+        return .{ .template = template, .vmid = vmid, .created_at = created_at };
+    }
+
+    pub fn writeLine(self: Member, allocator: std.mem.Allocator, out: *std.ArrayListUnmanaged(u8)) !void {
+        try out.print(allocator, "{d}\t{d}\t{s}\n", .{ self.vmid, self.created_at, self.template });
+    }
+};
+
+pub fn warmHostname(buf: []u8, vmid: u32) ![]const u8 {
+    return std.fmt.bufPrint(buf, HOSTNAME_PREFIX ++ "{d}", .{vmid});
+}
+
+/// Pre-created, stopped containers per template
+///
+/// `create` claims a member instead of running `pct create`, which skips the
+/// rootfs extraction entirely; the pool is then topped up again in the
+/// background. Claims pop the oldest member under an flock, so two CLI
+/// processes never receive the same container. The index is a
+/// `LockedIndex` named `warm-pool`.
+pub const WarmPool = struct {
+    const Self = @This();
+    const Index = locked_index.LockedIndex(Member, "warm-pool", 1024 * 1024);
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    state_dir: []const u8,
+    store: Index,
+
+    pub const INDEX_NAME = Index.INDEX_NAME;
+    pub const LOCK_NAME = Index.LOCK_NAME;
+    /// Held for the whole refill so concurrent creates start only one
+    pub const REFILL_LOCK_NAME = "warm-pool-refill.lock";
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, state_dir: []const u8) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .state_dir = state_dir,
+            .store = Index.init(allocator, state_dir),
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.store.deinit();
+    }
+
+    /// Take the oldest warm container for `template` out of the pool
+    pub fn claim(self: *Self, template: []const u8) !?u32 {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        var oldest: ?usize = null;
+        for (self.store.records.items, 0..) |member, i| {
+            if (!std.mem.eql(u8, member.template, template)) continue;
+            if (oldest == null or member.created_at < self.store.records.items[oldest.?].created_at) oldest = i;
+        }
+        const index = oldest orelse return null;
+        const member = self.store.records.orderedRemove(index);
+        try self.store.save();
+
+        if (self.logger) |log| log.info("Claimed warm container {d} for {s}", .{ member.vmid, template }) catch {};
+        return member.vmid;
+    }
+
+    /// Add a freshly created, stopped container to the pool
+    pub fn add(self: *Self, template: []const u8, vmid: u32) !void {
+        if (template.len == 0 or std.mem.indexOfAny(u8, template, "\t\n\r") != null) return core.Error.InvalidInput;
+
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        try self.store.records.append(self.store.recordAllocator(), .{
+            .template = try self.store.recordAllocator().dupe(u8, template),
+            .vmid = vmid,
+            .created_at = std.time.timestamp(),
+        });
+        try self.store.save();
+    }
+
+    /// Drop `vmid` from the pool, e.g. after its container vanished
+    pub fn remove(self: *Self, vmid: u32) !bool {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        for (self.store.records.items, 0..) |member, i| {
+            if (member.vmid != vmid) continue;
+            _ = self.store.records.orderedRemove(i);
+            try self.store.save();
+            return true;
+        }
+        return false;
+    }
+
+    /// Warm containers currently available for `template`
+    pub fn count(self: *Self, template: []const u8) !usize {
+        var lock = try self.store.lock();
+        defer lock.close();
+
+        var n: usize = 0;
+        for (self.store.records.items) |member| {
+            if (std.mem.eql(u8, member.template, template)) n += 1;
+        }
+        return n;
+    }
+
+    /// Snapshot of the index; valid until the next call on this pool
+    pub fn list(self: *Self) ![]const Member {
+        var lock = try self.store.lock();
+        defer lock.close();
+        return self.store.records.items;
+    }
+
+    /// Non-blocking; null when another process is already refilling
+    pub fn tryLockRefill(self: *Self) !?std.fs.File {
+        try std.fs.cwd().makePath(self.state_dir);
+        var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+        const lock_path = try std.fmt.bufPrint(&path_buf, "{s}/{s}", .{ self.state_dir, REFILL_LOCK_NAME });
+        return std.fs.cwd().createFile(lock_path, .{ .truncate = false, .lock = .exclusive, .lock_nonblocking = true }) catch |err| switch (err) {
+            error.WouldBlock => null,
+            else => err,
+        };
+    }
+};
@@ -122,16 +122,12 @@ pub const ProxmoxVmDriver = struct {
     /// List VMs
     pub fn listVms(self: *Self) ![]types.VmInfo {
         if (self.logger) |log| {
-            try log.info("Listing VMs");
+            try log.info("Listing VMs", .{});
         }
 
-        const api_vms = try self.operations.listVms();
-        defer {
-            for (api_vms) |vm| {
-                vm.deinit();
-            }
-            self.allocator.free(api_vms);
-        }
+        const listed = try self.operations.listVms();
+        defer listed.deinit();
+        const api_vms = listed.value;
 
         var result = try self.allocator.alloc(types.VmInfo, api_vms.len);
 
@@ -166,33 +166,19 @@ pub const RuncDriver = struct {
 
     /// Run a command and return the result
     fn runCommand(self: *Self, args: []const []const u8) !CommandResult {
-        const res = std.process.Child.run(.{
-            .allocator = self.allocator,
-            .argv = args,
-            .max_output_bytes = 1024 * 1024,
-        }) catch |err| {
+        return core.exec.run(self.allocator, args, .{ .max_output_bytes = 1024 * 1024 }) catch |err| {
             // Return a synthetic result for missing binaries
             if (err == error.FileNotFound) {
                 return CommandResult{
                     .stdout = try self.allocator.dupe(u8, ""),
                     .stderr = try self.allocator.dupe(u8, "command not found"),
                     .exit_code = 127,
+                    .status = .exited,
+                    .duration_ns = 0,
                 };
             }
             return err;
         };
-
-        const exit_code: u8 = switch (res.term) {
-            .Exited => |code| code,
-            .Signal => |sig| @as(u8, @intCast(128 + sig)),
-            else => 1,
-        };
-
-        return CommandResult{
-            .stdout = res.stdout,
-            .stderr = res.stderr,
-            .exit_code = exit_code,
-        };
     }
 
     /// Generate basic OCI config.json
@@ -209,8 +195,4 @@ pub const RuncDriver = struct {
     }
 };
 
-const CommandResult = struct {
-    stdout: []u8,
-    stderr: []u8,
-    exit_code: u8,
-};
+const CommandResult = core.exec.Result;
@@ -0,0 +1,288 @@
+const std = @import("std");
+const core = @import("core");
+const backends = @import("backends");
+const router = @import("router.zig");
+
+const api_lifecycle = backends.proxmox_lxc.api_lifecycle;
+const ProxmoxLxcDriver = backends.proxmox_lxc.driver.ProxmoxLxcDriver;
+const LifecycleOp = backends.proxmox_lxc.driver.LifecycleOp;
+const PendingLifecycle = backends.proxmox_lxc.driver.PendingLifecycle;
+
+/// Operations that can run in batch mode
+pub const BatchOperation = enum { create, start, stop, delete };
+
+/// One manifest line: `<container-id> [image]`
+pub const BatchItem = struct {
+    container_id: []const u8,
+    image: ?[]const u8 = null,
+};
+
+/// Parse a manifest; blank lines and `#` comments are skipped.
+/// Returned items reference `data`, only the slice itself is allocated.
+pub fn parseManifest(allocator: std.mem.Allocator, data: []const u8) ![]BatchItem {
+    var items = std.ArrayListUnmanaged(BatchItem){};
+    errdefer items.deinit(allocator);
+
+    var lines = std.mem.splitScalar(u8, data, '\n');
+    while (lines.next()) |raw| {
+        const line = std.mem.trim(u8, raw, " \t\r");
+        if (line.len == 0 or line[0] == '#') continue;
+
+        var fields = std.mem.tokenizeAny(u8, line, " \t");
+        const id = fields.next() orelse continue;
+        try items.append(allocator, .{ .container_id = id, .image = fields.next() });
+    }
+
+    return items.toOwnedSlice(allocator);
+}
+
+const lock_stripes = 64;
+
+/// Runs one operation over many containers on a bounded worker pool
+pub const BatchRunner = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    debug_mode: bool = false,
+    parallel: u32 = 1,
+    app_config: *const core.Config,
+    inventory: backends.proxmox_lxc.inventory.ContainerInventory,
+    // Striped by container id, so operations on the same container run one at a time
+    locks: [lock_stripes]std.Thread.Mutex = [_]std.Thread.Mutex{.{}} ** lock_stripes,
+    output_mutex: std.Thread.Mutex = .{},
+    failures: std.atomic.Value(u32) = std.atomic.Value(u32).init(0),
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, app_config: *const core.Config, parallel: u32) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .parallel = if (parallel == 0) 1 else parallel,
+            .app_config = app_config,
+            .inventory = backends.proxmox_lxc.inventory.ContainerInventory.init(allocator, logger),
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.inventory.deinit();
+    }
+
+    /// Run `operation` for every item and stream one JSON line per result to stdout.
+    /// Returns the number of failed items.
+    pub fn run(self: *Self, operation: BatchOperation, items: []const BatchItem, default_image: ?[]const u8) !u32 {
+        if (self.logger) |log| log.info("Batch {s}: {d} items, parallel={d}", .{ @tagName(operation), items.len, self.parallel }) catch {};
+
+        const lifecycle_op: ?LifecycleOp = switch (operation) {
+            .create => null,
+            .start => .start,
+            .stop => .stop,
+            .delete => .delete,
+        };
+        // With the REST API, submits return as soon as Proxmox has queued
+        // the worker task, and one loop awaits them all afterwards
+        var queued: ?*ProxmoxLxcDriver = null;
+        defer if (queued) |driver| driver.deinit();
+        var group: ?api_lifecycle.TaskGroup = null;
+        defer if (group) |*g| g.deinit();
+        if (lifecycle_op != null and items.len > 0 and self.app_config.container_config.proxmox_api != null) {
+            queued = try self.queueDriver(items[0].container_id);
+            group = queued.?.taskGroup();
+        }
+
+        var queue = Queue{ .group = if (group) |*g| g else null };
+        defer queue.deinit(self.allocator);
+
+        var pool: std.Thread.Pool = undefined;
+        try pool.init(.{ .allocator = self.allocator, .n_jobs = @as(usize, self.parallel) });
+        defer pool.deinit();
+
+        var wg: std.Thread.WaitGroup = .{};
+        for (items) |item| {
+            if (queue.group != null and self.routesToProxmoxLxc(item.container_id)) {
+                pool.spawnWg(&wg, submitItem, .{ self, queued.?, &queue, lifecycle_op.?, item });
+            } else {
+                pool.spawnWg(&wg, runItem, .{ self, operation, item, default_image });
+            }
+        }
+        pool.waitAndWork(&wg);
+
+        // One poll loop for every worker task the submits started
+        if (queue.group) |g| {
+            var finisher = Finisher{ .runner = self, .driver = queued.?, .queue = &queue, .op = lifecycle_op.? };
+            g.wait(&finisher, Finisher.taskDone);
+        }
+
+        const failed = self.failures.load(.acquire);
+        if (self.logger) |log| log.info("Batch {s} finished: {d} ok, {d} failed", .{ @tagName(operation), items.len - failed, failed }) catch {};
+        return failed;
+    }
+
+    fn runItem(self: *Self, operation: BatchOperation, item: BatchItem, default_image: ?[]const u8) void {
+        const started = std.time.milliTimestamp();
+
+        const stripe = std.hash.Wyhash.hash(0, item.container_id) % lock_stripes;
+        self.locks[stripe].lock();
+        const result = self.execute(operation, item, default_image);
+        self.locks[stripe].unlock();
+
+        const elapsed: i64 = std.time.milliTimestamp() - started;
+        if (result) |_| {} else |_| {
+            _ = self.failures.fetchAdd(1, .acq_rel);
+        }
+        self.report(operation, item.container_id, result, elapsed);
+    }
+
+    /// Driver shared by every submit of a batch; VMID pools only matter to
+    /// create, which is never queued, so any item's id will do
+    fn queueDriver(self: *Self, container_id: []const u8) !*ProxmoxLxcDriver {
+        var backend_router = router.BackendRouter.initWithDebug(self.allocator, self.logger, self.debug_mode);
+        backend_router.app_config = self.app_config;
+        backend_router.inventory = &self.inventory;
+        return backend_router.proxmoxLxcDriver(self.app_config, container_id, null);
+    }
+
+    fn routesToProxmoxLxc(self: *Self, container_id: []const u8) bool {
+        return switch (self.app_config.getRoutedRuntime(container_id)) {
+            .crun, .runc, .vm => false,
+            else => true,
+        };
+    }
+
+    /// Send one lifecycle call; items whose call finished right away are
+    /// reported here, the rest once their worker task ends
+    fn submitItem(self: *Self, driver: *ProxmoxLxcDriver, queue: *Queue, op: LifecycleOp, item: BatchItem) void {
+        const started = std.time.milliTimestamp();
+
+        const stripe = std.hash.Wyhash.hash(0, item.container_id) % lock_stripes;
+        self.locks[stripe].lock();
+        const submitted = driver.submit(op, item.container_id);
+        self.locks[stripe].unlock();
+
+        const pending = submitted catch |err| return self.finishItem(op, item.container_id, err, started);
+        const call = pending orelse return self.finishItem(op, item.container_id, {}, started);
+        defer self.allocator.free(call.upid);
+        queue.add(self.allocator, call, item.container_id, started) catch |err| {
+            self.allocator.free(call.vmid);
+            self.finishItem(op, item.container_id, err, started);
+        };
+    }
+
+    fn finishItem(self: *Self, op: LifecycleOp, container_id: []const u8, result: anyerror!void, started: i64) void {
+        if (result) |_| {} else |_| {
+            _ = self.failures.fetchAdd(1, .acq_rel);
+        }
+        const operation: BatchOperation = switch (op) {
+            .start => .start,
+            .stop => .stop,
+            .delete => .delete,
+        };
+        self.report(operation, container_id, result, std.time.milliTimestamp() - started);
+    }
+
+    fn execute(self: *Self, operation: BatchOperation, item: BatchItem, default_image: ?[]const u8) !void {
+        var backend_router = router.BackendRouter.initWithDebug(self.allocator, self.logger, self.debug_mode);
+        backend_router.app_config = self.app_config;
+        backend_router.inventory = &self.inventory;
+
+        const op: router.Operation = switch (operation) {
+            .create => blk: {
+                try core.validation.SecurityValidation.validateHostname(item.container_id);
+                const image = item.image orelse default_image orelse return core.Error.InvalidInput;
+                break :blk .{ .create = .{ .image = image } };
+            },
+            .start => .{ .start = {} },
+            .stop => .{ .stop = {} },
+            .delete => .{ .delete = {} },
+        };
+
+        try backend_router.routeAndExecute(op, item.container_id, null);
+    }
+
+    fn report(self: *Self, operation: BatchOperation, container_id: []const u8, result: anyerror!void, elapsed_ms: i64) void {
+        var buf: [1024]u8 = undefined;
+        const line = if (result) |_|
+            std.fmt.bufPrint(&buf, "{{\"id\":{f},\"operation\":\"{s}\",\"ok\":true,\"duration_ms\":{d}}}\n", .{ std.json.fmt(container_id, .{}), @tagName(operation), elapsed_ms })
+        else |err|
+            std.fmt.bufPrint(&buf, "{{\"id\":{f},\"operation\":\"{s}\",\"ok\":false,\"error\":\"{s}\",\"duration_ms\":{d}}}\n", .{ std.json.fmt(container_id, .{}), @tagName(operation), @errorName(err), elapsed_ms });
+        const out = line catch return;
+
+        self.output_mutex.lock();
+        defer self.output_mutex.unlock();
+        std.fs.File.stdout().writeAll(out) catch {};
+    }
+};
+
+/// Lifecycle calls whose worker tasks are still running, in `TaskGroup` order
+const Queue = struct {
+    const Pending = struct {
+        container_id: []const u8,
+        /// Owned
+        vmid: []u8,
+        started: i64,
+    };
+
+    group: ?*api_lifecycle.TaskGroup,
+    mutex: std.Thread.Mutex = .{},
+    pending: std.ArrayListUnmanaged(Pending) = .{},
+
+    fn deinit(self: *Queue, allocator: std.mem.Allocator) void {
+        for (self.pending.items) |p| allocator.free(p.vmid);
+        self.pending.deinit(allocator);
+    }
+
+    /// Takes `call.vmid` on success; `call.upid` stays the caller's
+    fn add(self: *Queue, allocator: std.mem.Allocator, call: PendingLifecycle, container_id: []const u8, started: i64) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        try self.pending.ensureUnusedCapacity(allocator, 1);
+        try self.group.?.add(call.upid, container_id);
+        self.pending.appendAssumeCapacity(.{ .container_id = container_id, .vmid = call.vmid, .started = started });
+    }
+};
+
+/// Completes queued items as their worker tasks end
+const Finisher = struct {
+    runner: *BatchRunner,
+    driver: *ProxmoxLxcDriver,
+    queue: *Queue,
+    op: LifecycleOp,
+
+    fn taskDone(ctx: ?*anyopaque, index: usize, result: core.exec.Result) void {
+        const self: *Finisher = @ptrCast(@alignCast(ctx.?));
+        const item = self.queue.pending.items[index];
+        const finished = self.driver.finish(self.op, item.container_id, item.vmid, result);
+        self.runner.finishItem(self.op, item.container_id, finished, item.started);
+    }
+};
+
+/// Entry point used by create/start/stop/delete when `--batch` is given
+pub fn executeBatch(
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    operation: BatchOperation,
+    options: core.types.RuntimeOptions,
+) !void {
+    const source = options.batch_file orelse return core.Error.InvalidInput;
+
+    const data = if (std.mem.eql(u8, source, "-"))
+        try std.fs.File.stdin().readToEndAlloc(allocator, 16 * 1024 * 1024)
+    else
+        try std.fs.cwd().readFileAlloc(allocator, source, 16 * 1024 * 1024);
+    defer allocator.free(data);
+
+    const items = try parseManifest(allocator, data);
+    defer allocator.free(items);
+    if (items.len == 0) return;
+
+    // Load config once for every item instead of once per routeAndExecute
+    var config_loader = core.config.ConfigLoader.init(allocator);
+    var cfg = try config_loader.loadDefault();
+    defer cfg.deinit();
+
+    var runner = BatchRunner.init(allocator, logger, &cfg, options.parallel);
+    defer runner.deinit();
+    runner.debug_mode = options.debug;
+
+    const failed = try runner.run(operation, items, options.image);
+    if (failed > 0) return core.Error.OperationFailed;
+}
@@ -3,6 +3,7 @@ const core = @import("core");
 
 const backends = @import("backends");
 const router = @import("router.zig");
+const batch = @import("batch.zig");
 const constants = core.constants;
 const validation = @import("validation.zig");
 const base_command = @import("base_command.zig");
@@ -59,12 +60,19 @@ pub const CreateCommand = struct {
             try out.writeAll("    --image <img>   Container image (required)\n");
             try out.writeAll("    --runtime <rt>  Runtime type (lxc, crun, runc, vm)\n");
             try out.writeAll("    --config <cfg>  Configuration file path\n");
+            try out.writeAll("    --batch <file>  Manifest of '<id> [image]' lines, '-' for stdin\n");
+            try out.writeAll("    --parallel <n>  Worker count for --batch (default: 1)\n");
             try out.writeAll("    --verbose       Enable verbose logging\n");
             try out.writeAll("    --debug         Enable debug logging\n");
             try out.writeAll("\n");
+            try out.writeAll("  Global options (before the command):\n");
+            try out.writeAll("    --trace <file>        Write a span trace of every create phase\n");
+            try out.writeAll("    --trace-format <fmt>  chrome (default) or otlp\n");
+            try out.writeAll("\n");
             try out.writeAll("  Examples:\n");
             try out.writeAll("    nexcage create --name my-container --image ubuntu:20.04\n");
             try out.writeAll("    nexcage create --name kube-ovn-1 --image nginx --runtime crun\n");
+            try out.writeAll("    nexcage --trace create.json create --name web-1 --image local:vztmpl/debian-12.tar.zst\n");
             return;
         }
 
@@ -72,6 +80,10 @@ pub const CreateCommand = struct {
             try stdout.writeAll("DEBUG: Before validation\n");
         }
         
+        if (options.batch_file != null) {
+            return batch.executeBatch(allocator, self.base.logger, .create, options);
+        }
+
         // Validate required options using validation utility
         const validated = try validation.ValidationUtils.requireContainerIdAndImage(options, self.base.logger, "create");
         const container_id = validated.container_id;
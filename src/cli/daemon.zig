@@ -0,0 +1,362 @@
+const std = @import("std");
+const core = @import("core");
+
+/// Default daemon socket; override with NEXCAGE_DAEMON_SOCKET
+pub const DEFAULT_SOCKET_PATH = "/run/nexcage/daemon.sock";
+
+/// Upper bound for a single request frame
+const MAX_REQUEST_BYTES = 1024 * 1024;
+const MAX_ARGS = 1024;
+
+/// Handles one forwarded command line; runs with fds 1 and 2 redirected to the client
+pub const RequestHandler = *const fn (ctx: *anyopaque, allocator: std.mem.Allocator, args: []const []const u8) anyerror!void;
+
+/// Socket path from the environment or the default
+pub fn socketPath() []const u8 {
+    return std.posix.getenv("NEXCAGE_DAEMON_SOCKET") orelse DEFAULT_SOCKET_PATH;
+}
+
+/// Unix-socket server that executes forwarded commands in a warm process.
+/// Requests are served one at a time because stdout/stderr are process-wide.
+pub const Server = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    logger: ?*core.LogContext,
+    socket_path: []const u8,
+    ctx: *anyopaque,
+    handler: RequestHandler,
+    listener: ?std.net.Server = null,
+    /// `configIdentity` when the daemon started, i.e. of the config it routes with
+    config_identity: []const u8 = "",
+
+    pub fn init(allocator: std.mem.Allocator, logger: ?*core.LogContext, socket_path: []const u8, ctx: *anyopaque, handler: RequestHandler) Self {
+        return Self{
+            .allocator = allocator,
+            .logger = logger,
+            .socket_path = socket_path,
+            .ctx = ctx,
+            .handler = handler,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        if (self.listener) |*l| l.deinit();
+        self.allocator.free(self.config_identity);
+        std.fs.cwd().deleteFile(self.socket_path) catch {};
+    }
+
+    /// Bind the socket and serve until the process is terminated
+    pub fn serve(self: *Self) !void {
+        try self.bind();
+        if (self.logger) |log| log.info("nexcage daemon listening on {s}", .{self.socket_path}) catch {};
+        while (true) self.serveOne();
+    }
+
+    /// Create the socket, reachable by its owner only
+    pub fn bind(self: *Self) !void {
+        self.allocator.free(self.config_identity);
+        self.config_identity = try configIdentity(self.allocator);
+
+        if (std.fs.path.dirname(self.socket_path)) |dir| try std.fs.cwd().makePath(dir);
+        std.fs.cwd().deleteFile(self.socket_path) catch {};
+
+        // Only root may drive the daemon, same as running pct directly. The
+        // umask applies at bind, so there is no window with a wider mode.
+        const old_umask = std.os.linux.syscall1(.umask, 0o077);
+        defer _ = std.os.linux.syscall1(.umask, old_umask);
+        const address = try std.net.Address.initUnix(self.socket_path);
+        self.listener = try address.listen(.{});
+        try std.posix.fchmodat(std.posix.AT.FDCWD, self.socket_path, 0o600, 0);
+    }
+
+    /// Accept and answer one request
+    pub fn serveOne(self: *Self) void {
+        const conn = self.listener.?.accept() catch |err| {
+            if (self.logger) |log| log.warn("daemon accept failed: {}", .{err}) catch {};
+            return;
+        };
+        defer conn.stream.close();
+        self.handleConnection(conn.stream.handle) catch |err| {
+            if (self.logger) |log| log.warn("daemon request failed: {}", .{err}) catch {};
+        };
+    }
+
+    fn handleConnection(self: *Self, fd: std.posix.fd_t) !void {
+        var arena = std.heap.ArenaAllocator.init(self.allocator);
+        defer arena.deinit();
+        const request = try readRequest(arena.allocator(), fd);
+        if (!envMatches(request.env)) {
+            if (self.logger) |log| log.info("daemon declined a request: client NEXCAGE_* environment differs", .{}) catch {};
+            return writeHeader(fd, .declined, 0, 0, 0);
+        }
+        if (!std.mem.eql(u8, request.config, self.config_identity)) {
+            if (self.logger) |log| log.info("daemon declined a request: client would load {s}", .{request.config}) catch {};
+            return writeHeader(fd, .declined, 0, 0, 0);
+        }
+
+        var out = try Capture.begin(std.posix.STDOUT_FILENO, "nexcage-stdout");
+        defer out.deinit();
+        var err_out = try Capture.begin(std.posix.STDERR_FILENO, "nexcage-stderr");
+        defer err_out.deinit();
+
+        var exit_code: u8 = 0;
+        {
+            // Relative paths in the request are resolved against the client's cwd
+            std.posix.chdir(request.cwd) catch {};
+            defer std.posix.chdir("/") catch {};
+
+            self.handler(self.ctx, self.allocator, request.args) catch |err| {
+                exit_code = 1;
+                var buf: [128]u8 = undefined;
+                const msg = std.fmt.bufPrint(&buf, "error: {s}\n", .{@errorName(err)}) catch "error\n";
+                std.fs.File.stderr().writeAll(msg) catch {};
+            };
+        }
+
+        out.end();
+        err_out.end();
+
+        const stdout_data = try out.collect(arena.allocator());
+        const stderr_data = try err_out.collect(arena.allocator());
+
+        try writeHeader(fd, .served, exit_code, stdout_data.len, stderr_data.len);
+        try writeAllFd(fd, stdout_data);
+        try writeAllFd(fd, stderr_data);
+    }
+};
+
+/// Redirects one standard fd into a memfd for the duration of a request
+const Capture = struct {
+    target: std.posix.fd_t,
+    saved: std.posix.fd_t,
+    memfd: std.posix.fd_t,
+    active: bool,
+
+    fn begin(target: std.posix.fd_t, name: [:0]const u8) !Capture {
+        const memfd = try std.posix.memfd_create(name, std.os.linux.MFD.CLOEXEC);
+        errdefer std.posix.close(memfd);
+        const saved = try std.posix.dup(target);
+        errdefer std.posix.close(saved);
+        try std.posix.dup2(memfd, target);
+        return .{ .target = target, .saved = saved, .memfd = memfd, .active = true };
+    }
+
+    fn end(self: *Capture) void {
+        if (!self.active) return;
+        std.posix.dup2(self.saved, self.target) catch {};
+        self.active = false;
+    }
+
+    fn collect(self: *Capture, allocator: std.mem.Allocator) ![]u8 {
+        try std.posix.lseek_SET(self.memfd, 0);
+        const file = std.fs.File{ .handle = self.memfd };
+        return file.readToEndAlloc(allocator, 64 * 1024 * 1024);
+    }
+
+    fn deinit(self: *Capture) void {
+        self.end();
+        std.posix.close(self.saved);
+        std.posix.close(self.memfd);
+    }
+};
+
+const Request = struct {
+    cwd: []const u8,
+    /// Client's forwarded variables, see `forwardedEnv`
+    env: []const u8,
+    /// Client's `configIdentity`
+    config: []const u8,
+    args: []const []const u8,
+};
+
+/// First byte of a reply
+const ReplyStatus = enum(u8) {
+    served = 0,
+    /// The client runs the command itself
+    declined = 1,
+};
+
+/// Reply: status, exit code, u32 stdout length, u32 stderr length, then both streams
+const HEADER_LEN = 10;
+
+fn writeHeader(fd: std.posix.fd_t, status: ReplyStatus, exit_code: u8, stdout_len: usize, stderr_len: usize) !void {
+    var header: [HEADER_LEN]u8 = undefined;
+    header[0] = @intFromEnum(status);
+    header[1] = exit_code;
+    std.mem.writeInt(u32, header[2..6], @intCast(stdout_len), .little);
+    std.mem.writeInt(u32, header[6..10], @intCast(stderr_len), .little);
+    try writeAllFd(fd, &header);
+}
+
+/// Frame: u32 count, then count x (u32 len, bytes): the client cwd, its
+/// environment, its config identity, then the arguments
+fn readRequest(allocator: std.mem.Allocator, fd: std.posix.fd_t) !Request {
+    var len_buf: [4]u8 = undefined;
+    try readExact(fd, &len_buf);
+    const count = std.mem.readInt(u32, &len_buf, .little);
+    if (count < 3 or count > MAX_ARGS) return core.Error.InvalidInput;
+
+    const strings = try allocator.alloc([]const u8, count);
+    var total: usize = 0;
+    for (strings) |*s| {
+        try readExact(fd, &len_buf);
+        const len = std.mem.readInt(u32, &len_buf, .little);
+        total += len;
+        if (total > MAX_REQUEST_BYTES) return core.Error.InvalidInput;
+        const buf = try allocator.alloc(u8, len);
+        try readExact(fd, buf);
+        s.* = buf;
+    }
+
+    return .{ .cwd = strings[0], .env = strings[1], .config = strings[2], .args = strings[3..] };
+}
+
+/// Flags that only take effect when AppContext is set up; the daemon's was
+/// set up once at startup, so a forwarded command would silently lose them
+const STARTUP_FLAGS = [_][]const u8{ "--debug", "--verbose", "--log-file", "--log-level", "--perf-tracking", "--memory-tracking" };
+
+/// Commands that read the client's stdin or need its terminal run locally:
+/// the daemon only has its own fd 0. So do commands with logging flags.
+pub fn canForward(args: []const []const u8) bool {
+    for (args, 0..) |arg, i| {
+        for (STARTUP_FLAGS) |flag| {
+            if (std.mem.eql(u8, arg, flag)) return false;
+        }
+        if (std.mem.eql(u8, arg, "-i") or std.mem.eql(u8, arg, "--interactive") or
+            std.mem.eql(u8, arg, "-t") or std.mem.eql(u8, arg, "--tty")) return false;
+        if (std.mem.eql(u8, arg, "--batch") and i + 1 < args.len and std.mem.eql(u8, args[i + 1], "-")) return false;
+    }
+    return true;
+}
+
+/// NEXCAGE_* settings change how a command runs; the two that pick the
+/// daemon only matter to the client
+fn isForwardedEnv(entry: []const u8) bool {
+    if (!std.mem.startsWith(u8, entry, "NEXCAGE_")) return false;
+    return !std.mem.startsWith(u8, entry, "NEXCAGE_DAEMON_SOCKET=") and
+        !std.mem.startsWith(u8, entry, "NEXCAGE_NO_DAEMON=");
+}
+
+/// This process's forwarded variables as NUL-terminated `KEY=value` entries
+pub fn forwardedEnv(allocator: std.mem.Allocator) ![]u8 {
+    var out: std.ArrayListUnmanaged(u8) = .{};
+    errdefer out.deinit(allocator);
+    for (std.os.environ) |entry_ptr| {
+        const entry = std.mem.span(entry_ptr);
+        if (!isForwardedEnv(entry)) continue;
+        try out.appendSlice(allocator, entry);
+        try out.append(allocator, 0);
+    }
+    return out.toOwnedSlice(allocator);
+}
+
+/// The daemon read its config and logging settings from its own
+/// environment, so it only serves clients whose settings are the same
+pub fn envMatches(forwarded: []const u8) bool {
+    var count: usize = 0;
+    var entries = std.mem.tokenizeScalar(u8, forwarded, 0);
+    while (entries.next()) |entry| {
+        if (!isForwardedEnv(entry)) return false;
+        const eq = std.mem.indexOfScalar(u8, entry, '=') orelse return false;
+        const own = std.posix.getenv(entry[0..eq]) orelse return false;
+        if (!std.mem.eql(u8, own, entry[eq + 1 ..])) return false;
+        count += 1;
+    }
+
+    var own_count: usize = 0;
+    for (std.os.environ) |entry_ptr| {
+        if (isForwardedEnv(std.mem.span(entry_ptr))) own_count += 1;
+    }
+    return count == own_count;
+}
+
+/// Which config file a command started here would load, with its mtime;
+/// empty when the built-in defaults apply. `./config.json` makes this
+/// depend on the cwd, so a client elsewhere may not share the daemon's.
+pub fn configIdentity(allocator: std.mem.Allocator) ![]u8 {
+    const path = core.ConfigLoader.defaultPath() orelse return allocator.alloc(u8, 0);
+    var path_buf: [std.fs.max_path_bytes]u8 = undefined;
+    const resolved = std.fs.cwd().realpath(path, &path_buf) catch path;
+    const stat = std.fs.cwd().statFile(path) catch return allocator.dupe(u8, resolved);
+    return std.fmt.allocPrint(allocator, "{s}@{d}", .{ resolved, stat.mtime });
+}
+
+/// Forward a command line to a running daemon and relay its output.
+/// Returns null when no daemon is listening, or the command has to run
+/// here, so the caller can run locally.
+pub fn forward(allocator: std.mem.Allocator, args: []const []const u8) !?u8 {
+    if (std.posix.getenv("NEXCAGE_NO_DAEMON") != null) return null;
+    return forwardTo(allocator, socketPath(), args, std.fs.File.stdout(), std.fs.File.stderr());
+}
+
+pub fn forwardTo(
+    allocator: std.mem.Allocator,
+    socket_path: []const u8,
+    args: []const []const u8,
+    stdout: std.fs.File,
+    stderr: std.fs.File,
+) !?u8 {
+    if (!canForward(args)) return null;
+
+    const stream = std.net.connectUnixSocket(socket_path) catch return null;
+    defer stream.close();
+    const fd = stream.handle;
+
+    var cwd_buf: [std.fs.max_path_bytes]u8 = undefined;
+    const cwd = try std.posix.getcwd(&cwd_buf);
+    const env = try forwardedEnv(allocator);
+    defer allocator.free(env);
+    const config = try configIdentity(allocator);
+    defer allocator.free(config);
+
+    var len_buf: [4]u8 = undefined;
+    std.mem.writeInt(u32, &len_buf, @intCast(args.len + 3), .little);
+    try writeAllFd(fd, &len_buf);
+    try writeString(fd, cwd);
+    try writeString(fd, env);
+    try writeString(fd, config);
+    for (args) |arg| try writeString(fd, arg);
+
+    var header: [HEADER_LEN]u8 = undefined;
+    try readExact(fd, &header);
+    const status = std.meta.intToEnum(ReplyStatus, header[0]) catch return core.Error.InvalidInput;
+    if (status == .declined) return null;
+    const stdout_len = std.mem.readInt(u32, header[2..6], .little);
+    const stderr_len = std.mem.readInt(u32, header[6..10], .little);
+
+    try relay(allocator, fd, stdout_len, stdout);
+    try relay(allocator, fd, stderr_len, stderr);
+    return header[1];
+}
+
+fn relay(allocator: std.mem.Allocator, fd: std.posix.fd_t, len: u32, dest: std.fs.File) !void {
+    if (len == 0) return;
+    const buf = try allocator.alloc(u8, len);
+    defer allocator.free(buf);
+    try readExact(fd, buf);
+    try dest.writeAll(buf);
+}
+
+fn writeString(fd: std.posix.fd_t, s: []const u8) !void {
+    var len_buf: [4]u8 = undefined;
+    std.mem.writeInt(u32, &len_buf, @intCast(s.len), .little);
+    try writeAllFd(fd, &len_buf);
+    try writeAllFd(fd, s);
+}
+
+fn writeAllFd(fd: std.posix.fd_t, data: []const u8) !void {
+    var written: usize = 0;
+    while (written < data.len) {
+        written += try std.posix.write(fd, data[written..]);
+    }
+}
+
+fn readExact(fd: std.posix.fd_t, buf: []u8) !void {
+    var filled: usize = 0;
+    while (filled < buf.len) {
+        const n = try std.posix.read(fd, buf[filled..]);
+        if (n == 0) return error.EndOfStream;
+        filled += n;
+    }
+}
@@ -66,6 +66,7 @@ pub const HelpCommand = struct {
         try help_text.appendSlice("  delete     Delete a container\n");
         try help_text.appendSlice("  list       List containers\n");
         try help_text.appendSlice("  run        Run a command in a container\n");
+        try help_text.appendSlice("  metrics    Show runtime metrics\n");
         try help_text.appendSlice("  help       Show this help message\n");
         try help_text.appendSlice("  version    Show version information\n");
         try help_text.appendSlice("\nUse 'nexcage <command> --help' for command-specific help\n");
@@ -2,7 +2,6 @@ const std = @import("std");
 const core = @import("core");
 const backends = @import("backends");
 const router = @import("router.zig");
-const constants = core.constants;
 const errors = @import("errors.zig");
 const base_command = @import("base_command.zig");
 
@@ -45,8 +44,8 @@ pub const ListCommand = struct {
         try stdout.writeAll("  nexcage list --debug            # List with debug logging\n");
         try stdout.writeAll("  nexcage list --log-file /tmp/log # List with custom log file\n\n");
         try stdout.writeAll("OUTPUT FORMAT:\n");
-        try stdout.writeAll("  ID      IMAGE   COMMAND  CREATED  STATUS  BACKEND  NAMES\n");
-        try stdout.writeAll("  <id>    <img>   <cmd>    <time>   <state> <type>   <name>\n");
+        try stdout.writeAll("  ID      IMAGE   COMMAND  CREATED  STATUS  BACKEND  NAMES   NODE\n");
+        try stdout.writeAll("  <id>    <img>   <cmd>    <time>   <state> <type>   <name>  <node>\n");
     }
 
     pub fn execute(self: *Self, options: core.types.RuntimeOptions, allocator: std.mem.Allocator) !void {
@@ -56,24 +55,26 @@ pub const ListCommand = struct {
             return;
         }
 
+        // Rows and their strings live until the table is printed; one arena
+        // releases them all instead of a deinit per row
+        var list_arena = std.heap.ArenaAllocator.init(allocator);
+        defer list_arena.deinit();
+        const arena = list_arena.allocator();
+
         // Collect containers from all backends
         var all_containers = std.ArrayListUnmanaged(core.ContainerInfo){};
-        defer {
-            for (all_containers.items) |*container| {
-                container.deinit();
-            }
-            all_containers.deinit(allocator);
-        }
 
-        // List from each backend type
-        try self.listFromBackend(allocator, .proxmox_lxc, &all_containers);
-        try self.listFromBackend(allocator, .crun, &all_containers);
-        try self.listFromBackend(allocator, .runc, &all_containers);
-        try self.listFromBackend(allocator, .vm, &all_containers);
+        // With an API endpoint one /cluster/resources request covers LXC and
+        // VM guests on every node; otherwise each backend asks its own CLI
+        const from_cluster = try self.listFromCluster(allocator, arena, &all_containers);
+        if (!from_cluster) try self.listFromBackend(allocator, arena, .proxmox_lxc, &all_containers);
+        try self.listFromBackend(allocator, arena, .crun, &all_containers);
+        try self.listFromBackend(allocator, arena, .runc, &all_containers);
+        if (!from_cluster) try self.listFromBackend(allocator, arena, .vm, &all_containers);
 
         // Print aggregated results (similar to runc list format)
         const stdout = std.fs.File.stdout();
-        try stdout.writeAll("ID\tIMAGE\tCOMMAND\tCREATED\tSTATUS\tBACKEND\tNAMES\n");
+        try stdout.writeAll("ID\tIMAGE\tCOMMAND\tCREATED\tSTATUS\tBACKEND\tNAMES\tNODE\n");
         
         for (all_containers.items) |*container| {
             const id = container.id;
@@ -83,6 +84,7 @@ pub const ListCommand = struct {
             const status = container.status;
             const backend = container.backend_type;
             const names = container.name;
+            const node = container.node orelse "-";
             
             // Simple output without allocPrint to avoid allocator issues
             _ = try stdout.writeAll(id);
@@ -98,44 +100,46 @@ pub const ListCommand = struct {
             _ = try stdout.writeAll(backend);
             _ = try stdout.writeAll("\t");
             _ = try stdout.writeAll(names);
+            _ = try stdout.writeAll("\t");
+            _ = try stdout.writeAll(node);
             _ = try stdout.writeAll("\n");
         }
 
         // Command completed
     }
 
-    fn listFromBackend(self: *Self, allocator: std.mem.Allocator, backend_type: core.types.RuntimeType, containers: *std.ArrayListUnmanaged(core.ContainerInfo)) !void {
+    /// Append every cluster guest from the Proxmox API; false when no
+    /// endpoint is configured or the request fails, so the caller falls
+    /// back to pct. Rows are allocated in `arena`.
+    fn listFromCluster(self: *Self, allocator: std.mem.Allocator, arena: std.mem.Allocator, containers: *std.ArrayListUnmanaged(core.ContainerInfo)) !bool {
+        var loaded: ?core.config.Config = null;
+        defer if (loaded) |*cfg| cfg.deinit();
+        const app_config: *const core.config.Config = if (router.getSharedState()) |st| st.app_config else blk: {
+            var config_loader = core.config.ConfigLoader.init(allocator);
+            loaded = config_loader.loadDefault() catch return false;
+            break :blk &loaded.?;
+        };
+        const endpoint = app_config.container_config.proxmox_api orelse return false;
+
+        var rest = backends.proxmox_lxc.api_lifecycle.ApiLifecycle.init(allocator, self.base.logger, endpoint) catch |err| {
+            if (self.base.logger) |log| log.warn("Proxmox API unavailable, listing via pct: {}", .{err}) catch {};
+            return false;
+        };
+        const guests = rest.listGuests(arena) catch |err| {
+            if (self.base.logger) |log| log.warn("Cluster listing failed, listing via pct: {}", .{err}) catch {};
+            return false;
+        };
+
+        try containers.appendSlice(arena, guests);
+        return true;
+    }
+
+    /// Drivers get `allocator`; rows are allocated in `arena`
+    fn listFromBackend(self: *Self, allocator: std.mem.Allocator, arena: std.mem.Allocator, backend_type: core.types.RuntimeType, containers: *std.ArrayListUnmanaged(core.ContainerInfo)) !void {
         _ = self; // Avoid unused warnings
         switch (backend_type) {
             .lxc => {
                 // List LXC containers using backend
-                const sandbox_config = core.types.SandboxConfig{
-                    .allocator = allocator,
-                    .name = try allocator.dupe(u8, "default"),
-                    .runtime_type = .lxc,
-                    .resources = core.types.ResourceLimits{
-                        .memory = constants.DEFAULT_MEMORY_BYTES,
-                        .cpu = constants.DEFAULT_CPU_CORES,
-                        .disk = null,
-                        .network_bandwidth = null,
-                    },
-                    .security = null,
-                    .network = core.types.NetworkConfig{
-                        .bridge = try allocator.dupe(u8, constants.DEFAULT_BRIDGE_NAME),
-                        .ip = null,
-                        .gateway = null,
-                        .dns = null,
-                        .port_mappings = null,
-                    },
-                    .storage = null,
-                };
-                defer {
-                    allocator.free(sandbox_config.name);
-                    if (sandbox_config.network) |net| {
-                        if (net.bridge) |b| allocator.free(b);
-                    }
-                }
-
                 const proxmox_config = core.types.ProxmoxLxcBackendConfig{ .allocator = allocator };
 
                 const lxc_backend = backends.proxmox_lxc.driver.ProxmoxLxcDriver.init(allocator, proxmox_config) catch {
@@ -143,12 +147,8 @@ pub const ListCommand = struct {
                 };
                 defer lxc_backend.deinit();
 
-                const lxc_containers = lxc_backend.list(allocator) catch return;
-                defer allocator.free(lxc_containers);
-                
-                for (lxc_containers) |*c| {
-                    try containers.append(allocator, c.*);
-                }
+                const lxc_containers = lxc_backend.list(arena) catch return;
+                try containers.appendSlice(arena, lxc_containers);
             },
             .proxmox_lxc => {
                 // List Proxmox LXC containers via driver
@@ -156,13 +156,10 @@ pub const ListCommand = struct {
 
                 const proxmox_backend = backends.proxmox_lxc.driver.ProxmoxLxcDriver.init(allocator, proxmox_config) catch return;
                 defer proxmox_backend.deinit();
+                if (router.getSharedState()) |st| proxmox_backend.setInventory(st.inventory);
 
-                const proxmox_containers = proxmox_backend.list(allocator) catch return;
-                defer allocator.free(proxmox_containers);
-                
-                for (proxmox_containers) |*c| {
-                    try containers.append(allocator, c.*);
-                }
+                const proxmox_containers = proxmox_backend.list(arena) catch return;
+                try containers.appendSlice(arena, proxmox_containers);
             },
             .crun, .runc => {
                 // Note: CRUN/RUNC listing not yet implemented
@@ -189,10 +186,13 @@ pub const ListCommand = struct {
             "  CREATED  - Creation timestamp\n" ++
             "  STATUS   - Container status\n" ++
             "  BACKEND  - Backend type (lxc, proxmox-lxc, crun, runc, vm)\n" ++
-            "  NAMES    - Container names\n\n" ++
+            "  NAMES    - Container names\n" ++
+            "  NODE     - Proxmox node, when listed through the API\n\n" ++
             "Notes:\n" ++
             "  Automatically detects available backends and skips unavailable ones.\n" ++
-            "  Proxmox LXC containers are listed via 'pct list' command.\n");
+            "  With container_config.proxmox_api set, LXC and VM guests of every cluster\n" ++
+            "  node come from one /cluster/resources request; otherwise Proxmox LXC\n" ++
+            "  containers are listed via 'pct list' command.\n");
     }
 
     pub fn validate(self: *Self, args: []const []const u8) !void {
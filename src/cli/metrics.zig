@@ -0,0 +1,47 @@
+const std = @import("std");
+const core = @import("core");
+const types = core.types;
+const base_command = @import("base_command.zig");
+
+/// Metrics command
+///
+/// Prints the process-wide registry in Prometheus text format. Commands are
+/// forwarded to a running `nexcage daemon`, so this reports what the daemon
+/// has accumulated across every request it served.
+pub const MetricsCommand = struct {
+    const Self = @This();
+
+    name: []const u8 = "metrics",
+    description: []const u8 = "Show runtime metrics in Prometheus format",
+    base: base_command.BaseCommand = .{},
+
+    pub fn setLogger(self: *Self, logger: *core.LogContext) void {
+        self.base.setLogger(logger);
+    }
+
+    pub fn execute(self: *Self, options: types.RuntimeOptions, allocator: std.mem.Allocator) !void {
+        _ = self;
+        _ = options;
+
+        var out = std.Io.Writer.Allocating.init(allocator);
+        defer out.deinit();
+        try core.metrics.global().exportMetrics(&out.writer);
+        try std.fs.File.stdout().writeAll(out.written());
+    }
+
+    pub fn help(self: *Self, allocator: std.mem.Allocator) ![]const u8 {
+        _ = self;
+        _ = allocator;
+
+        return "Usage: nexcage metrics\n\n" ++
+            "Show runtime metrics in Prometheus text format.\n" ++
+            "With a daemon running, the daemon's metrics are shown.\n\n" ++
+            "Options:\n" ++
+            "  -h, --help    Show this help message\n";
+    }
+
+    pub fn validate(self: *Self, args: []const []const u8) !void {
+        _ = self;
+        _ = args;
+    }
+};
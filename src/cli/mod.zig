@@ -12,6 +12,9 @@ pub const start = @import("start.zig");
 pub const stop = @import("stop.zig");
 pub const delete = @import("delete.zig");
 pub const list = @import("list.zig");
+pub const batch = @import("batch.zig");
+pub const daemon = @import("daemon.zig");
+pub const metrics = @import("metrics.zig");
 
 // Re-export commonly used types
 pub const BaseCommand = base_command.BaseCommand;
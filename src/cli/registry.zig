@@ -14,6 +14,7 @@ const list = @import("list.zig");
 const health = @import("health_check.zig");
 const state = @import("state.zig");
 const kill = @import("kill.zig");
+const metrics = @import("metrics.zig");
 // const template = @import("template.zig");
 
 /// CLI command registry using StaticStringMap
@@ -106,6 +107,7 @@ var list_cmd = list.ListCommand{};
 var health_cmd = health.HealthCommand{};
 var state_cmd = state.StateCommand{};
 var kill_cmd = kill.KillCommand{};
+var metrics_cmd = metrics.MetricsCommand{};
 // var template_cmd = template.TemplateCommand{};
 
 /// Generic command registration helper
@@ -221,6 +223,7 @@ pub fn registerBuiltinCommands(registry: *CommandRegistry) !void {
     try registerCommand(registry, &health_cmd, health.HealthCommand);
     try registerCommand(registry, &state_cmd, state.StateCommand);
     try registerCommand(registry, &kill_cmd, kill.KillCommand);
+    try registerCommand(registry, &metrics_cmd, metrics.MetricsCommand);
 }
 
 /// Register all built-in commands with logger
@@ -236,4 +239,5 @@ pub fn registerBuiltinCommandsWithLogger(registry: *CommandRegistry, logger: *co
     try registerCommandWithLogger(registry, &health_cmd, health.HealthCommand, logger);
     try registerCommandWithLogger(registry, &state_cmd, state.StateCommand, logger);
     try registerCommandWithLogger(registry, &kill_cmd, kill.KillCommand, logger);
+    try registerCommandWithLogger(registry, &metrics_cmd, metrics.MetricsCommand, logger);
 }
@@ -6,18 +6,37 @@ const types = core.types;
 const logging = core.logging;
 const config_module = core.config;
 
+/// Process-wide state kept warm by `nexcage daemon`
+pub const SharedState = struct {
+    app_config: *const config_module.Config,
+    inventory: *backends.proxmox_lxc.inventory.ContainerInventory,
+};
+
+var shared_state: ?SharedState = null;
+
+/// Install (or clear) state reused by every router created afterwards
+pub fn setSharedState(state: ?SharedState) void {
+    shared_state = state;
+}
+
+/// State installed by the daemon, if any
+pub fn getSharedState() ?SharedState {
+    return shared_state;
+}
+
 pub const BackendRouter = struct {
     const Self = @This();
 
     allocator: std.mem.Allocator,
     logger: ?*logging.LogContext,
     debug_mode: bool = false,
+    /// Preloaded config reused across calls instead of loadDefault per operation
+    app_config: ?*const config_module.Config = null,
+    /// Container inventory shared by every Proxmox LXC driver this router creates
+    inventory: ?*backends.proxmox_lxc.inventory.ContainerInventory = null,
 
     pub fn init(allocator: std.mem.Allocator, logger: ?*logging.LogContext) Self {
-        return Self{
-            .allocator = allocator,
-            .logger = logger,
-        };
+        return initWithDebug(allocator, logger, false);
     }
 
     pub fn initWithDebug(allocator: std.mem.Allocator, logger: ?*logging.LogContext, debug_mode: bool) Self {
@@ -25,12 +44,16 @@ pub const BackendRouter = struct {
             .allocator = allocator,
             .logger = logger,
             .debug_mode = debug_mode,
+            .app_config = if (shared_state) |st| st.app_config else null,
+            .inventory = if (shared_state) |st| st.inventory else null,
         };
     }
 
-    /// Creates a SandboxConfig for the given operation and runtime type
+    /// Creates a SandboxConfig for the given operation and runtime type;
+    /// everything in it lives in `arena`, so there is nothing to free
     fn createSandboxConfig(
         self: *Self,
+        arena: std.mem.Allocator,
         operation: Operation,
         container_id: []const u8,
         runtime_type: types.RuntimeType,
@@ -46,7 +69,7 @@ pub const BackendRouter = struct {
         }
         
         if (self.debug_mode) try stdout.writeAll("[ROUTER] createSandboxConfig: Duplicating container_id\n");
-        const name_buf = try self.allocator.dupe(u8, container_id);
+        const name_buf = try arena.dupe(u8, container_id);
         if (self.debug_mode) try stdout.writeAll("[ROUTER] createSandboxConfig: name_buf created\n");
 
         if (self.debug_mode) try stdout.writeAll("[ROUTER] createSandboxConfig: Creating SandboxConfig\n");
@@ -60,13 +83,13 @@ pub const BackendRouter = struct {
                     try stdout.writeAll("'\n");
                 }
                 if (self.debug_mode) try stdout.writeAll("[ROUTER] createSandboxConfig: Duplicating image\n");
-                const image_buf = try self.allocator.dupe(u8, create_config.image);
+                const image_buf = try arena.dupe(u8, create_config.image);
                 if (self.debug_mode) try stdout.writeAll("[ROUTER] createSandboxConfig: image_buf created\n");
                 if (self.debug_mode) {
                     try stdout.writeAll("[ROUTER] createSandboxConfig: Building SandboxConfig struct\n");
                 }
                 const sandbox_cfg = types.SandboxConfig{
-                .allocator = self.allocator,
+                .allocator = arena,
                 .name = name_buf,
                 .runtime_type = runtime_type,
                 .image = image_buf,
@@ -81,7 +104,7 @@ pub const BackendRouter = struct {
                     .lxc, .proxmox_lxc => net_blk: {
                         if (self.debug_mode) try stdout.writeAll("[ROUTER] createSandboxConfig: Creating network config for LXC\n");
                         break :net_blk types.NetworkConfig{
-                            .bridge = try self.allocator.dupe(u8, constants.DEFAULT_BRIDGE_NAME),
+                            .bridge = try arena.dupe(u8, constants.DEFAULT_BRIDGE_NAME),
                             .ip = null,
                             .gateway = null,
                             .dns = null,
@@ -96,17 +119,17 @@ pub const BackendRouter = struct {
                 break :blk sandbox_cfg;
             },
             .run => |run_config| types.SandboxConfig{
-                .allocator = self.allocator,
+                .allocator = arena,
                 .name = name_buf,
                 .runtime_type = runtime_type,
-                .image = try self.allocator.dupe(u8, run_config.image),
+                .image = try arena.dupe(u8, run_config.image),
                 .resources = null,
                 .security = null,
                 .network = null,
                 .storage = null,
             },
             else => types.SandboxConfig{
-                .allocator = self.allocator,
+                .allocator = arena,
                 .name = name_buf,
                 .runtime_type = runtime_type,
                 .resources = null,
@@ -117,20 +140,6 @@ pub const BackendRouter = struct {
         };
     }
 
-    /// Cleanup allocated resources in SandboxConfig
-    fn cleanupSandboxConfig(self: *Self, operation: Operation, sandbox_config: *const types.SandboxConfig) void {
-        switch (operation) {
-            .create, .run => {
-                if (sandbox_config.image) |img| self.allocator.free(img);
-                if (sandbox_config.network) |net| {
-                    if (net.bridge) |bridge| self.allocator.free(bridge);
-                }
-            },
-            else => {},
-        }
-        self.allocator.free(sandbox_config.name);
-    }
-
     pub fn routeAndExecute(self: *Self, operation: Operation, container_id: []const u8, config: ?Config) !void {
         // Use stderr for debug output to avoid buffering issues
         const stderr = std.fs.File.stderr();
@@ -155,6 +164,10 @@ pub const BackendRouter = struct {
             stderr.writeAll("'\n") catch {};
         }
         
+        if (self.app_config) |shared_cfg| {
+            return self.routeWithConfig(shared_cfg, operation, container_id, config);
+        }
+
         if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Before ConfigLoader init\n") catch {};
         var config_loader = config_module.ConfigLoader.init(self.allocator);
         if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: ConfigLoader initialized\n") catch {};
@@ -175,6 +188,13 @@ pub const BackendRouter = struct {
             stderr.writeAll("[ROUTER] routeAndExecute: Config loaded, proceeding\n") catch {};
         }
 
+        try self.routeWithConfig(&cfg, operation, container_id, config);
+    }
+
+    /// Route an operation using an already loaded config
+    pub fn routeWithConfig(self: *Self, cfg: *const config_module.Config, operation: Operation, container_id: []const u8, config: ?Config) !void {
+        const stderr = std.fs.File.stderr();
+
         // Use the new routing system that supports regex patterns
         if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Before getRoutedRuntime\n") catch {};
         const runtime_type = cfg.getRoutedRuntime(container_id);
@@ -212,19 +232,31 @@ pub const BackendRouter = struct {
         // }
         if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Before switch statement\n") catch {};
 
+        // Per-operation data comes from one arena released in one go; drivers
+        // keep `self.allocator` for state that outlives the operation or is
+        // shared with worker threads
+        var request_arena = std.heap.ArenaAllocator.init(self.allocator);
+        defer request_arena.deinit();
+        const arena = request_arena.allocator();
+
+        // Feeds nexcage_operation_duration_seconds{backend,op,result}
+        const started = std.time.Instant.now() catch null;
+        var succeeded = false;
+        defer if (started) |t| core.metrics.recordOperation(@tagName(ctype), @tagName(operation), succeeded, t);
+
         switch (ctype) {
             .lxc => {
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Calling executeProxmoxLxc (lxc)\n") catch {};
-                try self.executeProxmoxLxc(operation, container_id, config);
+                try self.executeProxmoxLxc(arena, cfg, operation, container_id, config);
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: executeProxmoxLxc completed\n") catch {};
             },
             .crun => {
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Calling executeCrun\n") catch {};
-                try self.executeCrun(operation, container_id, config);
+                try self.executeCrun(arena, operation, container_id, config);
             },
             .runc => {
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Calling executeRunc\n") catch {};
-                try self.executeRunc(operation, container_id, config);
+                try self.executeRunc(arena, operation, container_id, config);
             },
             .vm => {
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Calling executeVm\n") catch {};
@@ -232,15 +264,16 @@ pub const BackendRouter = struct {
             },
             .proxmox_lxc => {
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Calling executeProxmoxLxc (proxmox_lxc)\n") catch {};
-                try self.executeProxmoxLxc(operation, container_id, config);
+                try self.executeProxmoxLxc(arena, cfg, operation, container_id, config);
                 if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: executeProxmoxLxc completed\n") catch {};
             },
         }
+        succeeded = true;
         if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: Switch completed\n") catch {};
         if (self.debug_mode) stderr.writeAll("[ROUTER] routeAndExecute: FINISHED\n") catch {};
     }
 
-    fn executeProxmoxLxc(self: *Self, operation: Operation, container_id: []const u8, config: ?Config) !void {
+    fn executeProxmoxLxc(self: *Self, arena: std.mem.Allocator, cfg: *const config_module.Config, operation: Operation, container_id: []const u8, config: ?Config) !void {
         const stderr = std.fs.File.stderr();
         
         if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: ENTRY\n") catch {};
@@ -251,37 +284,14 @@ pub const BackendRouter = struct {
         }
         
         if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Before createSandboxConfig\n") catch {};
-        const sandbox_config = try self.createSandboxConfig(operation, container_id, .proxmox_lxc, config);
-        defer self.cleanupSandboxConfig(operation, &sandbox_config);
+        const sandbox_config = try self.createSandboxConfig(arena, operation, container_id, .proxmox_lxc, config);
         if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Sandbox config created\n") catch {};
 
-        // Create Proxmox LXC backend with default config
-        if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Creating ProxmoxLxcBackendConfig\n") catch {};
-        const proxmox_config = types.ProxmoxLxcBackendConfig{
-            .allocator = self.allocator,
-            .default_bridge = if (config) |cfg| if (cfg.network) |net| net.bridge else null else null,
-        };
-        if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Config created\n") catch {};
-
         if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Initializing ProxmoxLxcDriver\n") catch {};
-        const proxmox_backend = try backends.proxmox_lxc.driver.ProxmoxLxcDriver.init(self.allocator, proxmox_config);
+        const proxmox_backend = try self.proxmoxLxcDriver(cfg, container_id, config);
         defer proxmox_backend.deinit();
         if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Driver initialized\n") catch {};
 
-        // Set logger if available
-        if (self.logger) |log| {
-            if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Setting logger\n") catch {};
-            proxmox_backend.setLogger(log);
-            if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Logger set\n") catch {};
-        } else {
-            if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: No logger available\n") catch {};
-        }
-        
-        // Set debug mode
-        if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Setting debug mode\n") catch {};
-        proxmox_backend.setDebugMode(self.debug_mode);
-        if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Debug mode set\n") catch {};
-
         if (self.debug_mode) stderr.writeAll("[ROUTER] executeProxmoxLxc: Before operation switch\n") catch {};
         
         switch (operation) {
@@ -303,16 +313,44 @@ pub const BackendRouter = struct {
                 // Router just ensures backend is initialized
                 // No-op here, command will call backend directly
             },
+            .refill_warm_pool => |refill| try proxmox_backend.refillWarmPool(refill.template),
         }
     }
 
-    fn executeCrun(self: *Self, operation: Operation, container_id: []const u8, config: ?Config) !void {
+    /// Proxmox LXC driver for `container_id` set up from `cfg`, with this
+    /// router's logger, debug mode and shared inventory; caller deinits it
+    pub fn proxmoxLxcDriver(self: *Self, cfg: *const config_module.Config, container_id: []const u8, config: ?Config) !*backends.proxmox_lxc.driver.ProxmoxLxcDriver {
+        const vmid_pool = cfg.getVmidPool(container_id);
+        const proxmox_config = types.ProxmoxLxcBackendConfig{
+            .allocator = self.allocator,
+            .default_bridge = if (config) |c| if (c.network) |net| net.bridge else null else null,
+            .state_dir = cfg.data_dir,
+            .vmid_first = if (vmid_pool) |pool| pool.first else null,
+            .vmid_last = if (vmid_pool) |pool| pool.last else null,
+            .template_zstd_level = cfg.container_config.template_zstd_level,
+            .template_zstd_workers = cfg.container_config.template_zstd_workers,
+            .template_cache_max_bytes = cfg.container_config.template_cache_max_bytes,
+            .template_cache_max_entries = cfg.container_config.template_cache_max_entries,
+            .stop_timeout_ms = cfg.container_config.stop_timeout_ms,
+            .warm_pool_size = cfg.container_config.warm_pool_size,
+            .clone_storage = cfg.container_config.clone_storage,
+            .clone_rootfs_gb = cfg.container_config.clone_rootfs_gb,
+            .proxmox_api = cfg.container_config.proxmox_api,
+        };
+
+        const driver = try backends.proxmox_lxc.driver.ProxmoxLxcDriver.init(self.allocator, proxmox_config);
+        if (self.logger) |log| driver.setLogger(log);
+        driver.setDebugMode(self.debug_mode);
+        if (self.inventory) |inv| driver.setInventory(inv);
+        return driver;
+    }
+
+    fn executeCrun(self: *Self, arena: std.mem.Allocator, operation: Operation, container_id: []const u8, config: ?Config) !void {
         var crun_backend = backends.crun.CrunDriver.init(self.allocator, self.logger);
 
         switch (operation) {
             .create => {
-                const sandbox_config = try self.createSandboxConfig(operation, container_id, .crun, config);
-                defer self.cleanupSandboxConfig(operation, &sandbox_config);
+                const sandbox_config = try self.createSandboxConfig(arena, operation, container_id, .crun, config);
                 try crun_backend.create(sandbox_config);
             },
             .start => try crun_backend.start(container_id),
@@ -327,16 +365,18 @@ pub const BackendRouter = struct {
             .state => {
                 // State operation handled by command
             },
+            .refill_warm_pool => {
+                // Warm pools only exist for Proxmox LXC
+            },
         }
     }
 
-    fn executeRunc(self: *Self, operation: Operation, container_id: []const u8, config: ?Config) !void {
+    fn executeRunc(self: *Self, arena: std.mem.Allocator, operation: Operation, container_id: []const u8, config: ?Config) !void {
         var runc_backend = backends.runc.RuncDriver.init(self.allocator, self.logger);
 
         switch (operation) {
             .create => {
-                const sandbox_config = try self.createSandboxConfig(operation, container_id, .runc, config);
-                defer self.cleanupSandboxConfig(operation, &sandbox_config);
+                const sandbox_config = try self.createSandboxConfig(arena, operation, container_id, .runc, config);
                 try runc_backend.create(sandbox_config);
             },
             .start => try runc_backend.start(container_id),
@@ -351,6 +391,9 @@ pub const BackendRouter = struct {
             .state => {
                 // State operation handled by command
             },
+            .refill_warm_pool => {
+                // Warm pools only exist for Proxmox LXC
+            },
         }
     }
 
@@ -364,7 +407,7 @@ pub const BackendRouter = struct {
                     try log.warn("Proxmox VM backend not fully integrated yet. VM creation for image {s} skipped.", .{create_config.image});
                 }
             },
-            .start, .stop, .delete, .run, .state, .kill => {
+            .start, .stop, .delete, .run, .state, .kill, .refill_warm_pool => {
                 if (self.logger) |log| {
                     try log.warn("Proxmox VM backend not fully integrated yet. VM operation skipped.", .{});
                 }
@@ -419,6 +462,8 @@ pub const Operation = union(enum) {
     run: RunConfig,
     state: void,
     kill: KillConfig,
+    /// Top up the warm pool; started by create through `nexcage warm-pool refill`
+    refill_warm_pool: RefillConfig,
 };
 
 pub const CreateConfig = struct {
@@ -433,6 +478,10 @@ pub const KillConfig = struct {
     signal: []const u8,
 };
 
+pub const RefillConfig = struct {
+    template: []const u8,
+};
+
 pub const Config = struct {
     network: ?types.NetworkConfig = null,
     resources: ?types.ResourceLimits = null,
@@ -3,6 +3,7 @@ const core = @import("core");
 
 const backends = @import("backends");
 const router = @import("router.zig");
+const batch = @import("batch.zig");
 const validation = @import("validation.zig");
 const base_command = @import("base_command.zig");
 
@@ -47,6 +48,10 @@ pub const StartCommand = struct {
             return;
         }
 
+        if (options.batch_file != null) {
+            return batch.executeBatch(allocator, self.base.logger, .start, options);
+        }
+
         // Validate required options using validation utility
         const container_id = try validation.ValidationUtils.requireContainerId(options, self.base.logger, "start");
 
@@ -84,7 +89,9 @@ pub const StartCommand = struct {
         return allocator.dupe(u8, "Usage: nexcage start --name <id> [--runtime <type>]\n\n" ++
             "Options:\n" ++
             "  --name <id>        Container/VM identifier\n" ++
-            "  --runtime <type>   Runtime: lxc|vm|crun (default: lxc)\n\n" ++
+            "  --runtime <type>   Runtime: lxc|vm|crun (default: lxc)\n" ++
+            "  --batch <file|->   Run for every ID in a manifest (one per line) or stdin\n" ++
+            "  --parallel <n>     Worker count for --batch (default: 1)\n\n" ++
             "Notes:\n" ++
             "  If LXC tools are missing, command fails with UnsupportedOperation.\n");
     }
@@ -1,6 +1,7 @@
 const std = @import("std");
 const core = @import("core");
 const backends = @import("backends");
+const router = @import("router.zig");
 const validation = @import("validation.zig");
 const types = core.types;
 const config_module = core.config;
@@ -46,7 +47,9 @@ pub const StateCommand = struct {
 
         // Try to determine runtime type from config or default to proxmox_lxc
         var runtime_type: types.RuntimeType = .proxmox_lxc;
-        {
+        if (router.getSharedState()) |st| {
+            runtime_type = st.app_config.getRoutedRuntime(container_id);
+        } else {
             var config_loader = config_module.ConfigLoader.init(allocator);
             var cfg = try config_loader.loadDefault();
             defer cfg.deinit();
@@ -103,6 +106,7 @@ pub const StateCommand = struct {
                     return types.Error.NotFound;
                 };
                 defer backend.deinit();
+                if (router.getSharedState()) |st| backend.setInventory(st.inventory);
 
                 // Use list() and find the container by ID
                 const containers = try backend.list(allocator);
@@ -0,0 +1,253 @@
+const std = @import("std");
+
+const posix = std.posix;
+
+/// What `write` does when every slot is taken
+pub const Overflow = enum {
+    /// Count and discard the record; the caller never waits on disk
+    drop,
+    /// Wait for the flusher to free a slot
+    block,
+};
+
+pub const Options = struct {
+    /// Ring slots; rounded up to a power of two. Memory is `capacity * SLOT_BYTES`.
+    capacity: usize = 256,
+    overflow: Overflow = .drop,
+    /// Longest the flusher sleeps while records are pending
+    flush_interval_ms: u32 = 50,
+};
+
+/// Largest record; longer ones are truncated. Matches the LogContext line limit.
+pub const SLOT_BYTES = 4096;
+
+/// Records gathered into one writev
+const MAX_BATCH = 64;
+
+const Slot = struct {
+    /// Vyukov sequence: `pos` when free for the producer of `pos`,
+    /// `pos + 1` once that record is published
+    seq: std.atomic.Value(usize),
+    len: u32 = 0,
+    data: [SLOT_BYTES]u8 = undefined,
+};
+
+/// Log sink that keeps disk latency off the logging thread
+///
+/// Records are formatted by the caller and copied into a bounded lock-free
+/// MPSC ring; a background thread writes them out in batches with one
+/// writev each. Memory never grows past the ring: when it is full, records
+/// are dropped (and counted) or the caller waits, per `Overflow`.
+///
+/// Pending records are written on `flush`, `destroy`, a Zig panic (see
+/// `flushAll`) and on SIGTERM, SIGINT, SIGHUP and SIGABRT.
+pub const AsyncSink = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    file: std.fs.File,
+    slots: []Slot,
+    mask: usize,
+    overflow: Overflow,
+    flush_interval_ns: u64,
+
+    enqueue_pos: std.atomic.Value(usize) = .init(0),
+    /// Next record to write; only advanced by the holder of `draining`
+    dequeue_pos: usize = 0,
+    /// Everything before this has been written
+    written_pos: std.atomic.Value(usize) = .init(0),
+    /// Held while writing, so the flusher and a signal handler never interleave
+    draining: std.atomic.Value(bool) = .init(false),
+    dropped: std.atomic.Value(u64) = .init(0),
+    stop: std.atomic.Value(bool) = .init(false),
+    wake: std.Thread.ResetEvent = .{},
+    thread: ?std.Thread = null,
+
+    /// Heap-allocated because the flusher thread keeps a pointer to it
+    pub fn create(allocator: std.mem.Allocator, file: std.fs.File, options: Options) !*Self {
+        const capacity = try std.math.ceilPowerOfTwo(usize, @max(options.capacity, 2));
+        const slots = try allocator.alloc(Slot, capacity);
+        errdefer allocator.free(slots);
+        for (slots, 0..) |*slot, i| slot.* = .{ .seq = .init(i) };
+
+        const self = try allocator.create(Self);
+        errdefer allocator.destroy(self);
+        self.* = Self{
+            .allocator = allocator,
+            .file = file,
+            .slots = slots,
+            .mask = capacity - 1,
+            .overflow = options.overflow,
+            .flush_interval_ns = @as(u64, options.flush_interval_ms) * std.time.ns_per_ms,
+        };
+        self.thread = try std.Thread.spawn(.{}, flusherMain, .{self});
+        register(self);
+        return self;
+    }
+
+    /// Write everything still queued, stop the flusher and free the ring.
+    /// The file stays open; it belongs to the caller.
+    pub fn destroy(self: *Self) void {
+        unregister(self);
+        self.stop.store(true, .release);
+        self.wake.set();
+        if (self.thread) |thread| thread.join();
+        _ = self.drain();
+        self.allocator.free(self.slots);
+        self.allocator.destroy(self);
+    }
+
+    /// Queue one record; never blocks on I/O
+    pub fn write(self: *Self, record: []const u8) void {
+        const len = @min(record.len, SLOT_BYTES);
+        var pos = self.enqueue_pos.load(.monotonic);
+        const slot = while (true) {
+            const slot = &self.slots[pos & self.mask];
+            const seq = slot.seq.load(.acquire);
+            const diff: isize = @bitCast(seq -% pos);
+            if (diff == 0) {
+                pos = self.enqueue_pos.cmpxchgWeak(pos, pos + 1, .monotonic, .monotonic) orelse break slot;
+            } else if (diff < 0) {
+                // Full: the slot still holds the record from one lap ago
+                switch (self.overflow) {
+                    .drop => {
+                        _ = self.dropped.fetchAdd(1, .monotonic);
+                        return;
+                    },
+                    .block => {
+                        self.wake.set();
+                        std.Thread.yield() catch {};
+                        pos = self.enqueue_pos.load(.monotonic);
+                    },
+                }
+            } else {
+                pos = self.enqueue_pos.load(.monotonic);
+            }
+        };
+
+        @memcpy(slot.data[0..len], record[0..len]);
+        slot.len = @intCast(len);
+        slot.seq.store(pos + 1, .release);
+
+        // Wake early once half the ring is pending instead of waiting out the interval
+        if ((pos + 1) -| self.written_pos.load(.monotonic) >= self.slots.len / 2) self.wake.set();
+    }
+
+    /// Block until every record queued before this call is written
+    pub fn flush(self: *Self) void {
+        const target = self.enqueue_pos.load(.acquire);
+        while (self.written_pos.load(.acquire) < target) {
+            self.wake.set();
+            if (self.stop.load(.acquire)) {
+                _ = self.drain();
+                return;
+            }
+            std.Thread.sleep(std.time.ns_per_ms);
+        }
+    }
+
+    /// Records discarded because the ring was full
+    pub fn droppedCount(self: *const Self) u64 {
+        return self.dropped.load(.monotonic);
+    }
+
+    fn flusherMain(self: *Self) void {
+        while (true) {
+            if (self.drain() > 0) continue;
+            if (self.stop.load(.acquire)) return;
+            self.wake.timedWait(self.flush_interval_ns) catch {};
+            self.wake.reset();
+        }
+    }
+
+    /// Write all published records; returns how many were written
+    fn drain(self: *Self) usize {
+        if (self.draining.swap(true, .acquire)) return 0;
+        defer self.draining.store(false, .release);
+        return self.drainLocked();
+    }
+
+    fn drainLocked(self: *Self) usize {
+        var total: usize = 0;
+        var iovecs: [MAX_BATCH]posix.iovec_const = undefined;
+        while (true) {
+            var n: usize = 0;
+            while (n < MAX_BATCH) : (n += 1) {
+                const pos = self.dequeue_pos + n;
+                const slot = &self.slots[pos & self.mask];
+                if (slot.seq.load(.acquire) != pos + 1) break;
+                iovecs[n] = .{ .base = &slot.data, .len = slot.len };
+            }
+            if (n == 0) return total;
+
+            // A failing log file must not take the caller down; the batch is discarded
+            self.file.writevAll(iovecs[0..n]) catch {};
+
+            for (0..n) |i| {
+                const pos = self.dequeue_pos + i;
+                self.slots[pos & self.mask].seq.store(pos + self.slots.len, .release);
+            }
+            self.dequeue_pos += n;
+            self.written_pos.store(self.dequeue_pos, .release);
+            total += n;
+        }
+    }
+
+    /// Signal-handler path: wait briefly for the flusher's batch, then drain
+    fn drainForExit(self: *Self) void {
+        var spins: usize = 0;
+        while (self.draining.swap(true, .acquire)) : (spins += 1) {
+            if (spins >= 100) return;
+            std.Thread.sleep(std.time.ns_per_ms);
+        }
+        defer self.draining.store(false, .release);
+        _ = self.drainLocked();
+    }
+};
+
+const MAX_SINKS = 8;
+var sinks: [MAX_SINKS]std.atomic.Value(?*AsyncSink) = [_]std.atomic.Value(?*AsyncSink){.init(null)} ** MAX_SINKS;
+var handlers_installed = std.atomic.Value(bool).init(false);
+
+const EXIT_SIGNALS = [_]u8{ posix.SIG.TERM, posix.SIG.INT, posix.SIG.HUP, posix.SIG.ABRT };
+
+fn register(sink: *AsyncSink) void {
+    for (&sinks) |*entry| {
+        if (entry.cmpxchgStrong(null, sink, .acq_rel, .monotonic) == null) break;
+    }
+    if (!handlers_installed.swap(true, .acq_rel)) installSignalHandlers();
+}
+
+fn unregister(sink: *AsyncSink) void {
+    for (&sinks) |*entry| {
+        _ = entry.cmpxchgStrong(sink, null, .acq_rel, .monotonic);
+    }
+}
+
+/// Write out every live sink; call from a panic handler before aborting
+pub fn flushAll() void {
+    for (&sinks) |*entry| {
+        if (entry.load(.acquire)) |sink| sink.drainForExit();
+    }
+}
+
+fn installSignalHandlers() void {
+    const action = posix.Sigaction{
+        .handler = .{ .handler = handleExitSignal },
+        .mask = posix.sigemptyset(),
+        .flags = posix.SA.RESETHAND,
+    };
+    for (EXIT_SIGNALS) |sig| {
+        var previous: posix.Sigaction = undefined;
+        posix.sigaction(sig, null, &previous);
+        // SIG_DFL is the null handler; leave custom handlers and SIG_IGN alone
+        if (previous.handler.handler != null) continue;
+        posix.sigaction(sig, &action, null);
+    }
+}
+
+fn handleExitSignal(sig: i32) callconv(.c) void {
+    flushAll();
+    // SA_RESETHAND restored the default action; re-raise to terminate as before
+    posix.raise(@intCast(sig)) catch {};
+}
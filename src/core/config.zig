@@ -18,16 +18,30 @@ pub const ConfigLoader = struct {
         };
     }
 
+    /// Default locations, tried in order; the first is relative to the cwd
+    pub const DEFAULT_PATHS = [_][]const u8{
+        "./config.json",
+        "/etc/nexcage/config.json",
+        "/etc/nexcage/nexcage.json",
+    };
+
+    /// The file loadDefault would read from here; null when it would fall
+    /// back to the built-in defaults
+    pub fn defaultPath() ?[]const u8 {
+        for (DEFAULT_PATHS) |path| {
+            std.fs.cwd().access(path, .{}) catch |err| switch (err) {
+                error.FileNotFound => continue,
+                else => {},
+            };
+            return path;
+        }
+        return null;
+    }
+
     /// Load configuration from default locations
     pub fn loadDefault(self: *Self) !Config {
         // Try to load from default locations in order
-        const default_paths = [_][]const u8{
-            "./config.json",
-            "/etc/nexcage/config.json",
-            "/etc/nexcage/nexcage.json",
-        };
-
-        for (default_paths) |path| {
+        for (DEFAULT_PATHS) |path| {
             if (self.loadFromFile(path)) |config| {
                 return config;
             } else |err| switch (err) {
@@ -466,6 +480,148 @@ pub const ConfigLoader = struct {
                 }
             }
 
+            // Parse VMID pools: [{"pattern": "...", "first": 1000, "last": 1999}]
+            if (obj.get("vmid_pools")) |pools_value| {
+                switch (pools_value) {
+                    .array => |pools_array| {
+                        var pools = std.ArrayListUnmanaged(types.VmidPool){};
+                        errdefer {
+                            for (pools.items) |*pool| pool.deinit(self.allocator);
+                            pools.deinit(self.allocator);
+                        }
+
+                        for (pools_array.items) |pool_item| {
+                            if (pool_item != .object) continue;
+                            const pool_obj = pool_item.object;
+
+                            const pattern = if (pool_obj.get("pattern")) |p| switch (p) {
+                                .string => |str| str,
+                                else => continue,
+                            } else continue;
+                            const first = if (pool_obj.get("first")) |f| switch (f) {
+                                .integer => |i| std.math.cast(u32, i) orelse return types.Error.InvalidConfig,
+                                else => continue,
+                            } else continue;
+                            const last = if (pool_obj.get("last")) |l| switch (l) {
+                                .integer => |i| std.math.cast(u32, i) orelse return types.Error.InvalidConfig,
+                                else => continue,
+                            } else continue;
+                            if (first < 100 or last > 999999 or first > last) return types.Error.InvalidConfig;
+
+                            const pattern_dup = try self.allocator.dupe(u8, pattern);
+                            errdefer self.allocator.free(pattern_dup);
+                            try pools.append(self.allocator, .{ .pattern = pattern_dup, .first = first, .last = last });
+                        }
+
+                        for (container_cfg.vmid_pools) |pool| pool.deinit(self.allocator);
+                        self.allocator.free(container_cfg.vmid_pools);
+                        container_cfg.vmid_pools = try pools.toOwnedSlice(self.allocator);
+                    },
+                    else => {},
+                }
+            }
+
+            // Parse template compression: {"level": 3, "workers": 0}
+            if (obj.get("template_compression")) |compression_value| {
+                if (compression_value == .object) {
+                    const compression_obj = compression_value.object;
+                    if (compression_obj.get("level")) |level_value| {
+                        if (level_value == .integer) {
+                            const level = std.math.cast(u8, level_value.integer) orelse return types.Error.InvalidConfig;
+                            if (level < 1 or level > 19) return types.Error.InvalidConfig;
+                            container_cfg.template_zstd_level = level;
+                        }
+                    }
+                    if (compression_obj.get("workers")) |workers_value| {
+                        if (workers_value == .integer) {
+                            container_cfg.template_zstd_workers = std.math.cast(u32, workers_value.integer) orelse return types.Error.InvalidConfig;
+                        }
+                    }
+                }
+            }
+
+            // Parse template cache limits: {"max_bytes": 21474836480, "max_entries": 64}
+            if (obj.get("template_cache")) |cache_value| {
+                if (cache_value == .object) {
+                    const cache_obj = cache_value.object;
+                    if (cache_obj.get("max_bytes")) |bytes_value| {
+                        if (bytes_value == .integer) {
+                            container_cfg.template_cache_max_bytes = std.math.cast(u64, bytes_value.integer) orelse return types.Error.InvalidConfig;
+                        }
+                    }
+                    if (cache_obj.get("max_entries")) |entries_value| {
+                        if (entries_value == .integer) {
+                            container_cfg.template_cache_max_entries = std.math.cast(u32, entries_value.integer) orelse return types.Error.InvalidConfig;
+                        }
+                    }
+                }
+            }
+
+            if (obj.get("stop_timeout_ms")) |timeout_value| {
+                if (timeout_value == .integer) {
+                    container_cfg.stop_timeout_ms = std.math.cast(u32, timeout_value.integer) orelse return types.Error.InvalidConfig;
+                }
+            }
+
+            // Parse linked-clone rootfs: {"storage": "local-zfs", "size_gb": 8}
+            if (obj.get("rootfs_clone")) |clone_value| {
+                if (clone_value == .object) {
+                    const clone_obj = clone_value.object;
+                    if (clone_obj.get("storage")) |storage_value| {
+                        if (storage_value == .string) {
+                            if (container_cfg.clone_storage) |old| self.allocator.free(old);
+                            container_cfg.clone_storage = try self.allocator.dupe(u8, storage_value.string);
+                        }
+                    }
+                    if (clone_obj.get("size_gb")) |size_value| {
+                        if (size_value == .integer) {
+                            container_cfg.clone_rootfs_gb = std.math.cast(u32, size_value.integer) orelse return types.Error.InvalidConfig;
+                        }
+                    }
+                }
+            }
+
+            // Parse warm container pool: {"size": 3}
+            if (obj.get("warm_pool")) |pool_value| {
+                if (pool_value == .object) {
+                    if (pool_value.object.get("size")) |size_value| {
+                        if (size_value == .integer) {
+                            container_cfg.warm_pool_size = std.math.cast(u32, size_value.integer) orelse return types.Error.InvalidConfig;
+                        }
+                    }
+                }
+            }
+
+            // Parse REST lifecycle: {"host": "10.0.0.1", "port": 8006, "token": "root@pam!nexcage=...", "node": "pve1"}
+            if (obj.get("proxmox_api")) |api_value| {
+                if (api_value == .object) {
+                    const api_obj = api_value.object;
+                    const host = api_obj.get("host") orelse return types.Error.InvalidConfig;
+                    const token = api_obj.get("token") orelse return types.Error.InvalidConfig;
+                    const node = api_obj.get("node") orelse return types.Error.InvalidConfig;
+                    if (host != .string or token != .string or node != .string) return types.Error.InvalidConfig;
+                    var port: u16 = 8006;
+                    if (api_obj.get("port")) |port_value| {
+                        if (port_value == .integer) {
+                            port = std.math.cast(u16, port_value.integer) orelse return types.Error.InvalidConfig;
+                        }
+                    }
+
+                    if (container_cfg.proxmox_api) |old| old.deinit(self.allocator);
+                    container_cfg.proxmox_api = null;
+                    const host_copy = try self.allocator.dupe(u8, host.string);
+                    errdefer self.allocator.free(host_copy);
+                    const token_copy = try self.allocator.dupe(u8, token.string);
+                    errdefer self.allocator.free(token_copy);
+                    container_cfg.proxmox_api = .{
+                        .host = host_copy,
+                        .port = port,
+                        .token = token_copy,
+                        .node = try self.allocator.dupe(u8, node.string),
+                    };
+                }
+            }
+
             // Parse default_runtime if specified
             if (obj.get("default_runtime")) |runtime_value| {
                 switch (runtime_value) {
@@ -653,6 +809,14 @@ pub const Config = struct {
         };
     }
 
+    /// VMID pool for a container name, if one is configured
+    pub fn getVmidPool(self: *const Self, container_name: []const u8) ?types.VmidPool {
+        for (self.container_config.vmid_pools) |pool| {
+            if (self.matchesRoutingPattern(container_name, pool.pattern)) return pool;
+        }
+        return null;
+    }
+
     /// Get runtime type based on routing rules with pattern matching
     pub fn getRoutedRuntime(self: *const Self, container_name: []const u8) types.RuntimeType {
         // Check new routing rules first (takes precedence)
@@ -0,0 +1,465 @@
+const std = @import("std");
+const tracing = @import("tracing.zig");
+
+const posix = std.posix;
+
+/// Receives output as it arrives; `index` is the command's position in `runAll`
+pub const Sink = struct {
+    context: *anyopaque,
+    write: *const fn (context: *anyopaque, index: usize, chunk: []const u8) void,
+};
+
+/// Produces a command's stdin on a thread of its own while the output is
+/// drained; stdin is closed, i.e. the command sees EOF, once `produce` returns
+pub const Source = struct {
+    context: *anyopaque,
+    produce: *const fn (context: *anyopaque, writer: *std.Io.Writer) anyerror!void,
+};
+
+pub const Options = struct {
+    /// Kill the command after this long; 0 waits forever
+    timeout_ms: u32 = 0,
+    /// Per stream; the command is killed and error.StreamTooLong returned past it
+    max_output_bytes: usize = 16 * 1024 * 1024,
+    cwd: ?[]const u8 = null,
+    env_map: ?*const std.process.EnvMap = null,
+    on_stdout: ?Sink = null,
+    on_stderr: ?Sink = null,
+    /// Keep stdout in the result; turn off when `on_stdout` consumes it all
+    retain_stdout: bool = true,
+    /// Single command only; stdin is /dev/null without it
+    stdin: ?Source = null,
+    /// Set from another thread to kill the running commands
+    cancel: ?*const std.atomic.Value(bool) = null,
+};
+
+pub const Status = enum { exited, signaled, timed_out, cancelled };
+
+pub const Result = struct {
+    stdout: []u8,
+    stderr: []u8,
+    /// Exit code; 128+N when killed by signal N, 124 on timeout, 125 when cancelled
+    exit_code: u8,
+    status: Status,
+    duration_ns: u64,
+
+    pub fn deinit(self: *Result, allocator: std.mem.Allocator) void {
+        allocator.free(self.stdout);
+        allocator.free(self.stderr);
+    }
+};
+
+pub const Command = struct {
+    argv: []const []const u8,
+    /// Histogram key; defaults to the program and its subcommand, e.g. "pct create"
+    name: ?[]const u8 = null,
+};
+
+/// Latency histogram of one command name
+pub const Histogram = struct {
+    /// Bucket upper bounds in milliseconds; the last bucket is unbounded
+    pub const BOUNDS_MS = [_]u64{ 1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10_000, 30_000, 60_000 };
+
+    count: u64 = 0,
+    failures: u64 = 0,
+    sum_ns: u64 = 0,
+    max_ns: u64 = 0,
+    buckets: [BOUNDS_MS.len + 1]u64 = [_]u64{0} ** (BOUNDS_MS.len + 1),
+
+    pub fn observe(self: *Histogram, duration_ns: u64, ok: bool) void {
+        self.count += 1;
+        if (!ok) self.failures += 1;
+        self.sum_ns += duration_ns;
+        self.max_ns = @max(self.max_ns, duration_ns);
+        const ms = duration_ns / std.time.ns_per_ms;
+        for (BOUNDS_MS, 0..) |bound, i| {
+            if (ms <= bound) {
+                self.buckets[i] += 1;
+                return;
+            }
+        }
+        self.buckets[BOUNDS_MS.len] += 1;
+    }
+
+    pub fn meanNs(self: Histogram) u64 {
+        return if (self.count == 0) 0 else self.sum_ns / self.count;
+    }
+};
+
+/// Single place every subprocess of the runtime goes through; only the
+/// plugin sandbox, which is not built against `core`, spawns on its own
+///
+/// Children are spawned with std.process.Child and both pipes of every child
+/// are drained from one poll loop, so a command that fills stderr while we
+/// wait on stdout cannot deadlock, and `runAll` fans out any number of
+/// commands without threads. Deadlines and cancellation kill the child.
+/// Every run is recorded in a latency histogram keyed by command name.
+pub const Executor = struct {
+    const Self = @This();
+
+    /// Owns histogram keys
+    allocator: std.mem.Allocator,
+    mutex: std.Thread.Mutex = .{},
+    latencies: std.StringHashMapUnmanaged(Histogram) = .{},
+    /// Children of `spawnDetached` not reaped yet
+    detached: std.ArrayListUnmanaged(posix.pid_t) = .{},
+
+    pub fn init(allocator: std.mem.Allocator) Self {
+        return Self{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *Self) void {
+        var it = self.latencies.keyIterator();
+        while (it.next()) |key| self.allocator.free(key.*);
+        self.latencies.deinit(self.allocator);
+        self.detached.deinit(self.allocator);
+    }
+
+    /// Run one command to completion; caller frees the result with `deinit`
+    pub fn run(self: *Self, allocator: std.mem.Allocator, argv: []const []const u8, options: Options) !Result {
+        var name_buf: [128]u8 = undefined;
+        const span = tracing.begin(defaultName(&name_buf, argv));
+        defer span.end();
+
+        var results: [1]Result = undefined;
+        try self.runInto(allocator, &.{.{ .argv = argv }}, &results, options);
+        return results[0];
+    }
+
+    /// Run commands concurrently; results are in command order and the
+    /// caller frees each of them and the slice
+    pub fn runAll(self: *Self, allocator: std.mem.Allocator, commands: []const Command, options: Options) ![]Result {
+        const span = tracing.begin("exec fan-out");
+        defer span.end();
+
+        const results = try allocator.alloc(Result, commands.len);
+        errdefer allocator.free(results);
+        try self.runInto(allocator, commands, results, options);
+        return results;
+    }
+
+    /// Start a command without waiting for it, e.g. a background `nexcage`
+    ///
+    /// The child gets /dev/null on fds 0-2 and its own process group, so it
+    /// neither writes into our output nor dies with our terminal. Between
+    /// fork and exec it only makes syscalls, unlike running Zig code in a
+    /// forked copy of a threaded process. Exited children are reaped on the
+    /// next call, which keeps a long-lived daemon free of zombies.
+    pub fn spawnDetached(self: *Self, allocator: std.mem.Allocator, argv: []const []const u8) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.reapDetached();
+        try self.detached.ensureUnusedCapacity(self.allocator, 1);
+
+        var child = std.process.Child.init(argv, allocator);
+        child.stdin_behavior = .Ignore;
+        child.stdout_behavior = .Ignore;
+        child.stderr_behavior = .Ignore;
+        child.pgid = 0;
+        try child.spawn();
+        self.detached.appendAssumeCapacity(child.id);
+    }
+
+    /// Caller holds the mutex
+    fn reapDetached(self: *Self) void {
+        var i: usize = 0;
+        while (i < self.detached.items.len) {
+            if (posix.waitpid(self.detached.items[i], posix.W.NOHANG).pid == 0) {
+                i += 1;
+            } else {
+                _ = self.detached.swapRemove(i);
+            }
+        }
+    }
+
+    /// Copy of the histogram for `name`
+    pub fn histogram(self: *Self, name: []const u8) ?Histogram {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        return self.latencies.get(name);
+    }
+
+    /// One line per command name: count, failures, mean, max and bucket counts
+    pub fn writeReport(self: *Self, writer: *std.Io.Writer) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        var it = self.latencies.iterator();
+        while (it.next()) |entry| {
+            const h = entry.value_ptr.*;
+            try writer.print("{s}: count={d} failures={d} mean_ms={d} max_ms={d} buckets=", .{
+                entry.key_ptr.*,
+                h.count,
+                h.failures,
+                h.meanNs() / std.time.ns_per_ms,
+                h.max_ns / std.time.ns_per_ms,
+            });
+            for (h.buckets, 0..) |bucket, i| {
+                if (i > 0) try writer.writeByte(',');
+                try writer.print("{d}", .{bucket});
+            }
+            try writer.writeByte('\n');
+        }
+    }
+
+    fn record(self: *Self, command: Command, result: *const Result) void {
+        var name_buf: [128]u8 = undefined;
+        const name = command.name orelse defaultName(&name_buf, command.argv);
+
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        const entry = self.latencies.getOrPut(self.allocator, name) catch return;
+        if (!entry.found_existing) {
+            entry.key_ptr.* = self.allocator.dupe(u8, name) catch {
+                self.latencies.removeByPtr(entry.key_ptr);
+                return;
+            };
+            entry.value_ptr.* = .{};
+        }
+        entry.value_ptr.observe(result.duration_ns, result.status == .exited and result.exit_code == 0);
+    }
+
+    fn runInto(self: *Self, allocator: std.mem.Allocator, commands: []const Command, results: []Result, options: Options) !void {
+        if (options.stdin != null and commands.len != 1) return error.InvalidInput;
+        const running = try allocator.alloc(Running, commands.len);
+        defer allocator.free(running);
+
+        var spawned: usize = 0;
+        errdefer for (running[0..spawned]) |*r| r.abort(allocator);
+        for (commands, 0..) |command, i| {
+            running[i] = try Running.spawn(allocator, command.argv, options);
+            spawned += 1;
+        }
+
+        var feeder: Feeder = undefined;
+        var feeding = false;
+        if (options.stdin) |source| {
+            feeder = .{ .source = source, .file = running[0].child.stdin.? };
+            running[0].child.stdin = null;
+            feeder.thread = std.Thread.spawn(.{}, Feeder.run, .{&feeder}) catch |err| {
+                feeder.file.close();
+                return err;
+            };
+            feeding = true;
+        }
+        // Killing first unblocks a feeder stuck on a full pipe
+        errdefer if (feeding) {
+            running[0].kill(.cancelled);
+            feeder.thread.join();
+        }
+
+        try drain(allocator, running, options);
+        if (feeding) {
+            feeder.thread.join();
+            feeding = false;
+        }
+
+        var finished: usize = 0;
+        errdefer for (results[0..finished]) |*result| result.deinit(allocator);
+        for (running, 0..) |*r, i| {
+            results[i] = try r.finish(allocator);
+            finished += 1;
+            self.record(commands[i], &results[i]);
+        }
+
+        // A killed command already says why its input stopped
+        if (options.stdin != null and results[0].status == .exited) {
+            if (feeder.err) |err| return err;
+        }
+    }
+};
+
+const Running = struct {
+    child: std.process.Child,
+    start: std.time.Instant,
+    stdout: std.ArrayListUnmanaged(u8) = .{},
+    stderr: std.ArrayListUnmanaged(u8) = .{},
+    killed: ?Status = null,
+    reaped: bool = false,
+
+    fn spawn(allocator: std.mem.Allocator, argv: []const []const u8, options: Options) !Running {
+        var child = std.process.Child.init(argv, allocator);
+        child.stdin_behavior = if (options.stdin != null) .Pipe else .Ignore;
+        child.stdout_behavior = .Pipe;
+        child.stderr_behavior = .Pipe;
+        child.cwd = options.cwd;
+        child.env_map = options.env_map;
+        const start = try std.time.Instant.now();
+        try child.spawn();
+        return Running{ .child = child, .start = start };
+    }
+
+    fn kill(self: *Running, status: Status) void {
+        if (self.killed != null) return;
+        self.killed = status;
+        posix.kill(self.child.id, posix.SIG.KILL) catch {};
+        // Grandchildren may hold the pipes open; stop reading them
+        self.closeStream(.stdout);
+        self.closeStream(.stderr);
+    }
+
+    fn abort(self: *Running, allocator: std.mem.Allocator) void {
+        if (!self.reaped) {
+            self.kill(.cancelled);
+            _ = self.child.wait() catch {};
+        }
+        self.stdout.deinit(allocator);
+        self.stderr.deinit(allocator);
+    }
+
+    fn closeStream(self: *Running, stream: Stream) void {
+        const file = switch (stream) {
+            .stdout => &self.child.stdout,
+            .stderr => &self.child.stderr,
+        };
+        if (file.*) |f| f.close();
+        file.* = null;
+    }
+
+    fn finish(self: *Running, allocator: std.mem.Allocator) !Result {
+        errdefer self.stdout.deinit(allocator);
+        errdefer self.stderr.deinit(allocator);
+        const term = try self.child.wait();
+        self.reaped = true;
+        const now = std.time.Instant.now() catch self.start;
+
+        var status: Status = .exited;
+        const exit_code: u8 = if (self.killed) |killed| blk: {
+            status = killed;
+            break :blk if (killed == .timed_out) 124 else 125;
+        } else switch (term) {
+            .Exited => |code| code,
+            .Signal => |sig| blk: {
+                status = .signaled;
+                break :blk @truncate(128 +| sig);
+            },
+            else => 1,
+        };
+
+        const stdout = try self.stdout.toOwnedSlice(allocator);
+        errdefer allocator.free(stdout);
+        return Result{
+            .stdout = stdout,
+            .stderr = try self.stderr.toOwnedSlice(allocator),
+            .exit_code = exit_code,
+            .status = status,
+            .duration_ns = now.since(self.start),
+        };
+    }
+};
+
+const Stream = enum { stdout, stderr };
+
+/// Runs a `Source` into the child's stdin pipe
+const Feeder = struct {
+    source: Source,
+    file: std.fs.File,
+    thread: std.Thread = undefined,
+    err: ?anyerror = null,
+
+    fn run(self: *Feeder) void {
+        defer self.file.close();
+        var buf: [64 * 1024]u8 = undefined;
+        var writer = self.file.writerStreaming(&buf);
+        self.source.produce(self.source.context, &writer.interface) catch |err| {
+            self.err = if (err == error.WriteFailed) writer.err orelse err else err;
+            return;
+        };
+        writer.interface.flush() catch |err| {
+            self.err = writer.err orelse err;
+        };
+    }
+};
+
+/// Poll slice while a cancel flag is set, so cancellation is noticed promptly
+const CANCEL_POLL_MS: i32 = 50;
+
+fn drain(allocator: std.mem.Allocator, running: []Running, options: Options) !void {
+    const fds = try allocator.alloc(posix.pollfd, running.len * 2);
+    defer allocator.free(fds);
+    const owners = try allocator.alloc(struct { index: usize, stream: Stream }, running.len * 2);
+    defer allocator.free(owners);
+
+    const start = try std.time.Instant.now();
+    var buf: [64 * 1024]u8 = undefined;
+
+    while (true) {
+        var n: usize = 0;
+        for (running, 0..) |*r, i| {
+            inline for (.{ Stream.stdout, Stream.stderr }) |stream| {
+                const file = if (stream == .stdout) r.child.stdout else r.child.stderr;
+                if (file) |f| {
+                    fds[n] = .{ .fd = f.handle, .events = posix.POLL.IN, .revents = 0 };
+                    owners[n] = .{ .index = i, .stream = stream };
+                    n += 1;
+                }
+            }
+        }
+        if (n == 0) return;
+
+        if (options.cancel) |cancel| if (cancel.load(.acquire)) {
+            for (running) |*r| r.kill(.cancelled);
+            return;
+        };
+
+        var wait_ms: i32 = -1;
+        if (options.timeout_ms > 0) {
+            const elapsed_ms = (std.time.Instant.now() catch start).since(start) / std.time.ns_per_ms;
+            if (elapsed_ms >= options.timeout_ms) {
+                for (running) |*r| r.kill(.timed_out);
+                return;
+            }
+            wait_ms = @intCast(@min(options.timeout_ms - elapsed_ms, std.math.maxInt(i32)));
+        }
+        if (options.cancel != null) wait_ms = if (wait_ms < 0) CANCEL_POLL_MS else @min(wait_ms, CANCEL_POLL_MS);
+
+        if (try posix.poll(fds[0..n], wait_ms) == 0) continue;
+
+        for (fds[0..n], owners[0..n]) |fd, owner| {
+            if (fd.revents == 0) continue;
+            const r = &running[owner.index];
+            const read = posix.read(fd.fd, &buf) catch 0;
+            if (read == 0) {
+                r.closeStream(owner.stream);
+                continue;
+            }
+            const chunk = buf[0..read];
+            if (owner.stream == .stderr or options.retain_stdout) {
+                const output = if (owner.stream == .stdout) &r.stdout else &r.stderr;
+                if (output.items.len + chunk.len > options.max_output_bytes) {
+                    for (running) |*other| other.kill(.cancelled);
+                    return error.StreamTooLong;
+                }
+                try output.appendSlice(allocator, chunk);
+            }
+            const sink = if (owner.stream == .stdout) options.on_stdout else options.on_stderr;
+            if (sink) |s| s.write(s.context, owner.index, chunk);
+        }
+    }
+}
+
+/// "pct create" for `pct create 100 ...`, "zfs" for `zfs -H list`
+fn defaultName(buf: []u8, argv: []const []const u8) []const u8 {
+    if (argv.len == 0) return "";
+    const program = std.fs.path.basename(argv[0]);
+    if (argv.len < 2 or argv[1].len == 0 or argv[1][0] == '-' or std.ascii.isDigit(argv[1][0])) return program;
+    return std.fmt.bufPrint(buf, "{s} {s}", .{ program, argv[1] }) catch program;
+}
+
+var default_executor = Executor{ .allocator = std.heap.page_allocator };
+
+/// Process-wide executor behind `run` and `runAll`
+pub fn global() *Executor {
+    return &default_executor;
+}
+
+pub fn run(allocator: std.mem.Allocator, argv: []const []const u8, options: Options) !Result {
+    return default_executor.run(allocator, argv, options);
+}
+
+pub fn runAll(allocator: std.mem.Allocator, commands: []const Command, options: Options) ![]Result {
+    return default_executor.runAll(allocator, commands, options);
+}
+
+pub fn spawnDetached(allocator: std.mem.Allocator, argv: []const []const u8) !void {
+    return default_executor.spawnDetached(allocator, argv);
+}
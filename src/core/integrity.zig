@@ -1,5 +1,6 @@
 const std = @import("std");
 const logging = @import("logging.zig");
+const exec = @import("exec.zig");
 
 /// System integrity checker for monitoring critical components
 pub const IntegrityChecker = struct {
@@ -165,34 +166,7 @@ pub const IntegrityChecker = struct {
     
     /// Run a command and return result
     fn runCommand(self: *IntegrityChecker, args: []const []const u8) !CommandResult {
-        var result = CommandResult{
-            .exit_code = 0,
-            .stdout = &[_]u8{},
-            .stderr = &[_]u8{},
-        };
-        
-        var child = std.process.Child.init(args, self.allocator);
-        
-        child.stdout_behavior = .Pipe;
-        child.stderr_behavior = .Pipe;
-        
-        try child.spawn();
-        
-        const stdout = try child.stdout.?.readToEndAlloc(self.allocator, 1024 * 1024);
-        defer self.allocator.free(stdout);
-        
-        const stderr = try child.stderr.?.readToEndAlloc(self.allocator, 1024 * 1024);
-        defer self.allocator.free(stderr);
-        
-        const term = try child.wait();
-        result.exit_code = switch (term) {
-            .Exited => |code| code,
-            else => 1,
-        };
-        result.stdout = try self.allocator.dupe(u8, stdout);
-        result.stderr = try self.allocator.dupe(u8, stderr);
-        
-        return result;
+        return exec.run(self.allocator, args, .{ .max_output_bytes = 1024 * 1024 });
     }
     
     /// Check if Proxmox API is accessible
@@ -305,16 +279,7 @@ pub const IntegrityChecker = struct {
 };
 
 /// Command execution result
-const CommandResult = struct {
-    exit_code: u32,
-    stdout: []u8,
-    stderr: []u8,
-    
-    pub fn deinit(self: *CommandResult, allocator: std.mem.Allocator) void {
-        allocator.free(self.stdout);
-        allocator.free(self.stderr);
-    }
-};
+const CommandResult = exec.Result;
 
 /// Integrity check result
 pub const CheckResult = enum {
@@ -24,10 +24,11 @@ pub const BackendInterface = struct {
     /// Delete a container
     delete: *const fn (self: *Self, container_id: []const u8) Error!void,
 
-    /// List containers
+    /// List containers; results come from `allocator`, normally the
+    /// caller's per-command arena
     list: *const fn (self: *Self, allocator: std.mem.Allocator) Error![]ContainerInfo,
 
-    /// Get container info
+    /// Get container info, allocated like `list`
     info: *const fn (self: *Self, container_id: []const u8, allocator: std.mem.Allocator) Error!ContainerInfo,
 
     /// Execute command in container
@@ -35,6 +36,9 @@ pub const BackendInterface = struct {
 };
 
 /// Standardized container information structure
+///
+/// With a request arena as `allocator`, `deinit` can be skipped: the arena
+/// frees every row at once.
 pub const ContainerInfo = struct {
     allocator: std.mem.Allocator,
     id: []const u8,
@@ -44,6 +48,8 @@ pub const ContainerInfo = struct {
     created: ?[]const u8 = null,
     image: ?[]const u8 = null,
     runtime: ?[]const u8 = null,
+    /// Proxmox node the guest runs on, when known
+    node: ?[]const u8 = null,
 
     pub fn deinit(self: *ContainerInfo) void {
         self.allocator.free(self.id);
@@ -53,6 +59,7 @@ pub const ContainerInfo = struct {
         if (self.created) |c| self.allocator.free(c);
         if (self.image) |i| self.allocator.free(i);
         if (self.runtime) |r| self.allocator.free(r);
+        if (self.node) |n| self.allocator.free(n);
     }
 };
 
@@ -1,74 +1,43 @@
 const std = @import("std");
 const logging = @import("logging.zig");
+const async_log = @import("async_log.zig");
 
 /// JSON-structured logging system
+///
+/// Each record is formatted into a stack buffer on the calling thread and
+/// emitted with one write, or queued on an AsyncSink when one is attached.
 pub const JsonLogger = struct {
     const Self = @This();
-    
+
     allocator: std.mem.Allocator,
-    writer: std.fs.File.Writer,
+    file: std.fs.File,
     component: []const u8,
-    
+    sink: ?*async_log.AsyncSink = null,
+
     /// Initialize JSON logger
     pub fn init(allocator: std.mem.Allocator, writer: std.fs.File.Writer, component: []const u8) Self {
         return Self{
             .allocator = allocator,
-            .writer = writer,
+            .file = writer.file,
             .component = component,
         };
     }
-    
-    /// Log message as JSON
-    pub fn log(self: *Self, level: logging.LogLevel, comptime format: []const u8, args: anytype) !void {
-        const timestamp = std.time.timestamp();
-        const message = try std.fmt.allocPrint(self.allocator, format, args);
-        defer self.allocator.free(message);
-        
-        // Build JSON structure
-        try self.writer.writeAll("{\"timestamp\":");
-        try std.fmt.format(self.writer, "{d}", .{timestamp});
-        
-        try self.writer.writeAll(",\"level\":\"");
-        try self.writeLevel(level);
-        try self.writer.writeAll("\"");
-        
-        try self.writer.writeAll(",\"component\":\"");
-        try self.writer.writeAll(self.component);
-        try self.writer.writeAll("\"");
-        
-        try self.writer.writeAll(",\"message\":");
-        try self.writeJsonString(message);
-        
-        try self.writer.writeAll("}\n");
-    }
-    
-    fn writeLevel(self: *Self, level: logging.LogLevel) !void {
-        const level_str = switch (level) {
-            .trace => "trace",
-            .debug => "debug",
-            .info => "info",
-            .warn => "warn",
-            .@"error" => "error",
-            .fatal => "fatal",
+
+    /// JSON logger that queues records on `sink` instead of writing inline
+    pub fn initAsync(allocator: std.mem.Allocator, sink: *async_log.AsyncSink, component: []const u8) Self {
+        return Self{
+            .allocator = allocator,
+            .file = sink.file,
+            .component = component,
+            .sink = sink,
         };
-        try self.writer.writeAll(level_str);
     }
-    
-    fn writeJsonString(self: *Self, str: []const u8) !void {
-        try self.writer.writeAll("\"");
-        for (str) |byte| {
-            switch (byte) {
-                '"' => try self.writer.writeAll("\\\""),
-                '\\' => try self.writer.writeAll("\\\\"),
-                '\n' => try self.writer.writeAll("\\n"),
-                '\r' => try self.writer.writeAll("\\r"),
-                '\t' => try self.writer.writeAll("\\t"),
-                else => try self.writer.writeByte(byte),
-            }
-        }
-        try self.writer.writeAll("\"");
+
+    /// Log message as JSON
+    pub fn log(self: *Self, level: logging.LogLevel, comptime format: []const u8, args: anytype) !void {
+        self.emit(level, format, args, {});
     }
-    
+
     /// Log with additional fields
     pub fn logWithFields(
         self: *Self,
@@ -77,120 +46,71 @@ pub const JsonLogger = struct {
         args: anytype,
         fields: anytype,
     ) !void {
-        const timestamp = std.time.timestamp();
-        const message = try std.fmt.allocPrint(self.allocator, format, args);
-        defer self.allocator.free(message);
-        
-        try self.writer.writeAll("{\"timestamp\":");
-        try std.fmt.format(self.writer, "{d}", .{timestamp});
-        
-        try self.writer.writeAll(",\"level\":\"");
-        try self.writeLevel(level);
-        try self.writer.writeAll("\"");
-        
-        try self.writer.writeAll(",\"component\":\"");
-        try self.writer.writeAll(self.component);
-        try self.writer.writeAll("\"");
-        
-        try self.writer.writeAll(",\"message\":");
-        try self.writeJsonString(message);
-        
-        // Add custom fields
-        if (@TypeOf(fields) != @TypeOf({})) {
-            try self.writer.writeAll(",\"fields\":{");
-            const fields_info = @typeInfo(@TypeOf(fields));
-            if (fields_info == .Struct) {
-                var first = true;
-                inline for (fields_info.Struct.fields) |field| {
-                    if (!first) try self.writer.writeAll(",");
-                    first = false;
-                    
-                    try self.writer.writeAll("\"");
-                    try self.writer.writeAll(field.name);
-                    try self.writer.writeAll("\":");
-                    
-                    const field_value = @field(fields, field.name);
-                    try self.writeJsonValue(field_value);
-                }
-            }
-            try self.writer.writeAll("}");
+        self.emit(level, format, args, fields);
+    }
+
+    fn emit(self: *Self, level: logging.LogLevel, comptime format: []const u8, args: anytype, fields: anytype) void {
+        var buf: [async_log.SLOT_BYTES]u8 = undefined;
+        var writer = std.Io.Writer.fixed(&buf);
+        self.writeRecord(&writer, level, format, args, fields) catch {
+            // Escaping blew the record past the buffer; keep it valid JSON
+            writer = std.Io.Writer.fixed(&buf);
+            self.writeRecord(&writer, level, "<record too long>", .{}, {}) catch return;
+        };
+
+        const record = writer.buffered();
+        if (self.sink) |sink| {
+            sink.write(record);
+        } else {
+            self.file.writeAll(record) catch {};
         }
-        
-        try self.writer.writeAll("}\n");
     }
-    
-    fn writeJsonValue(self: *Self, value: anytype) !void {
-        const T = @TypeOf(value);
-        switch (@typeInfo(T)) {
-            .Int, .ComptimeInt => {
-                try std.fmt.format(self.writer, "{d}", .{value});
-            },
-            .Float, .ComptimeFloat => {
-                try std.fmt.format(self.writer, "{d}", .{value});
-            },
-            .Bool => {
-                if (value) {
-                    try self.writer.writeAll("true");
-                } else {
-                    try self.writer.writeAll("false");
-                }
-            },
-            .Optional => {
-                if (value) |v| {
-                    try self.writeJsonValue(v);
-                } else {
-                    try self.writer.writeAll("null");
-                }
-            },
-            .Pointer => |ptr_info| {
-                switch (ptr_info.size) {
-                    .Slice => {
-                        if (ptr_info.child == u8) {
-                            try self.writeJsonString(value);
-                        } else {
-                            // Array of values
-                            try self.writer.writeAll("[");
-                            for (value, 0..) |item, i| {
-                                if (i > 0) try self.writer.writeAll(",");
-                                try self.writeJsonValue(item);
-                            }
-                            try self.writer.writeAll("]");
-                        }
-                    },
-                    else => {
-                        try self.writeJsonString(try std.fmt.allocPrint(self.allocator, "{any}", .{value}));
-                    },
-                }
-            },
-            else => {
-                // Fallback to string representation
-                try self.writeJsonString(try std.fmt.allocPrint(self.allocator, "{any}", .{value}));
-            },
+
+    fn writeRecord(
+        self: *Self,
+        writer: *std.Io.Writer,
+        level: logging.LogLevel,
+        comptime format: []const u8,
+        args: anytype,
+        fields: anytype,
+    ) !void {
+        // Long messages are cut rather than failing the whole record
+        var message_buf: [async_log.SLOT_BYTES / 2]u8 = undefined;
+        const message = std.fmt.bufPrint(&message_buf, format, args) catch &message_buf;
+
+        try writer.print("{{\"timestamp\":{d},\"level\":\"{s}\",\"component\":{f},\"message\":{f}", .{
+            std.time.timestamp(),
+            @tagName(level),
+            std.json.fmt(self.component, .{}),
+            std.json.fmt(message, .{}),
+        });
+        if (@TypeOf(fields) != void) {
+            try writer.print(",\"fields\":{f}", .{std.json.fmt(fields, .{})});
         }
+        try writer.writeAll("}\n");
     }
-    
+
     pub fn trace(self: *Self, comptime format: []const u8, args: anytype) !void {
         try self.log(.trace, format, args);
     }
-    
+
     pub fn debug(self: *Self, comptime format: []const u8, args: anytype) !void {
         try self.log(.debug, format, args);
     }
-    
+
     pub fn info(self: *Self, comptime format: []const u8, args: anytype) !void {
         try self.log(.info, format, args);
     }
-    
+
     pub fn warn(self: *Self, comptime format: []const u8, args: anytype) !void {
         try self.log(.warn, format, args);
     }
-    
+
     pub fn err(self: *Self, comptime format: []const u8, args: anytype) !void {
         try self.log(.@"error", format, args);
     }
-    
+
     pub fn fatal(self: *Self, comptime format: []const u8, args: anytype) !void {
         try self.log(.fatal, format, args);
     }
 };
-
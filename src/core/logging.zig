@@ -1,4 +1,5 @@
 const std = @import("std");
+const async_log = @import("async_log.zig");
 
 /// Logging system for the application
 /// Log levels
@@ -11,6 +12,14 @@ pub const LogLevel = enum(u8) {
     fatal = 5,
 };
 
+/// Messages below this level are compiled out entirely; set with -Dmin-log-level
+pub const min_level: LogLevel = blk: {
+    // Imported here, like version.zig, to keep build_options out of module scope
+    const build_options = @import("build_options");
+    break :blk std.meta.stringToEnum(LogLevel, build_options.min_log_level) orelse
+        @compileError("invalid -Dmin-log-level: " ++ build_options.min_log_level);
+};
+
 /// Log context
 pub const LogContext = struct {
     allocator: std.mem.Allocator,
@@ -19,6 +28,8 @@ pub const LogContext = struct {
     component: []const u8,
     timestamp: bool = true,
     colorize: bool = true,
+    /// When set, lines are queued here instead of written to `file` directly
+    sink: ?*async_log.AsyncSink = null,
 
     pub fn init(allocator: std.mem.Allocator, _: std.fs.File.Writer, level: LogLevel, component: []const u8) LogContext {
         // In Zig 0.15.1, Writer doesn't expose file directly, so we store File separately
@@ -60,125 +71,73 @@ pub const LogContext = struct {
         try self.log(.fatal, format, args);
     }
 
-    fn log(self: *LogContext, level: LogLevel, comptime format: []const u8, args: anytype) !void {
-        // Safety check: validate self pointer and fields before any access
-        // Use stderr for debug output to avoid recursion
-        const stderr = std.fs.File.stderr();
-        stderr.writeAll("[LOG] log: Starting\n") catch {};
-        
-        // Check self pointer validity by accessing fields
-        stderr.writeAll("[LOG] log: Checking self.level\n") catch {};
-        const current_level = self.level;
-        const current_level_int: u8 = @intFromEnum(current_level);
-        stderr.writeAll("[LOG] log: self.level checked\n") catch {};
-        
-        // Early return if log level is below threshold
-        stderr.writeAll("[LOG] log: Checking log level threshold\n") catch {};
-        const level_int = @intFromEnum(level);
-        const threshold_int: u8 = if (current_level_int <= @intFromEnum(LogLevel.fatal)) current_level_int else @intFromEnum(LogLevel.info);
-        
-        if (level_int < threshold_int) {
-            stderr.writeAll("[LOG] log: Log level below threshold, returning\n") catch {};
-            return;
-        }
-        stderr.writeAll("[LOG] log: Log level OK, continuing\n") catch {};
-        
-        // Use page_allocator for logger to avoid segfault from invalid allocator
-        // The logger's allocator might become invalid during execution
-        const safe_allocator = std.heap.page_allocator;
-        
-        stderr.writeAll("[LOG] log: Before allocator test\n") catch {};
-        const test_alloc = safe_allocator.alloc(u8, 1) catch {
-            stderr.writeAll("[LOG] log: Allocator test failed, skipping\n") catch {};
-            return;
-        };
-        defer safe_allocator.free(test_alloc);
-        stderr.writeAll("[LOG] log: Allocator test passed\n") catch {};
-
-        stderr.writeAll("[LOG] log: Getting timestamp\n") catch {};
-        const timestamp = if (self.timestamp) blk: {
-            const now = std.time.timestamp();
-            const seconds = @as(u64, @intCast(now));
-            break :blk seconds;
-        } else 0;
-        stderr.writeAll("[LOG] log: Timestamp obtained\n") catch {};
-
-        stderr.writeAll("[LOG] log: Getting level strings\n") catch {};
-        const level_str = self.getLevelString(level);
-        const color = if (self.colorize) self.getLevelColor(level) else "";
-        const reset = if (self.colorize) "\x1b[0m" else "";
-        stderr.writeAll("[LOG] log: Level strings obtained\n") catch {};
-
-        stderr.writeAll("[LOG] log: Before allocPrint\n") catch {};
-        
-        if (self.timestamp) {
-            const message = std.fmt.allocPrint(safe_allocator, "{s}[{d}] {s}{s} {s}: " ++ format ++ "{s}\n", .{
-                color,
-                timestamp,
-                level_str,
-                reset,
-                self.component,
-            } ++ args ++ .{reset}) catch {
-                stderr.writeAll("[LOG] log: allocPrint failed, skipping\n") catch {};
-                return;
-            };
-            defer safe_allocator.free(message);
-            stderr.writeAll("[LOG] log: allocPrint succeeded, len = ") catch {};
-            const len_str = try std.fmt.allocPrint(safe_allocator, "{d}", .{message.len});
-            defer safe_allocator.free(len_str);
-            stderr.writeAll(len_str) catch {};
-            stderr.writeAll("\n") catch {};
-            stderr.writeAll("[LOG] log: Before file.writeAll\n") catch {};
-            // Use file.writeAll directly to avoid segfault
-            self.file.writeAll(message) catch {
-                stderr.writeAll("[LOG] log: file.writeAll failed\n") catch {};
-            };
-            stderr.writeAll("[LOG] log: file.writeAll completed\n") catch {};
-        } else {
-            const message = std.fmt.allocPrint(safe_allocator, "{s}{s} {s}: " ++ format ++ "{s}\n", .{
-                color,
-                level_str,
-                self.component,
-            } ++ args ++ .{reset}) catch {
-                stderr.writeAll("[LOG] log: allocPrint failed (no timestamp), skipping\n") catch {};
-                return;
-            };
-            defer safe_allocator.free(message);
-            stderr.writeAll("[LOG] log: Before file.writeAll (no timestamp)\n") catch {};
-            // Use file.writeAll directly to avoid segfault
-            self.file.writeAll(message) catch {
-                stderr.writeAll("[LOG] log: file.writeAll failed (no timestamp)\n") catch {};
-            };
-            stderr.writeAll("[LOG] log: file.writeAll completed (no timestamp)\n") catch {};
-        }
-        stderr.writeAll("[LOG] log: Finished\n") catch {};
+    /// Whether `level` passes the runtime threshold; always false below `min_level`
+    pub fn enabled(self: *const LogContext, comptime level: LogLevel) bool {
+        if (comptime @intFromEnum(level) < @intFromEnum(min_level)) return false;
+        return @intFromEnum(level) >= @intFromEnum(self.level);
     }
 
-    fn getLevelString(self: *LogContext, level: LogLevel) []const u8 {
-        _ = self;
-        return switch (level) {
-            .trace => "TRACE",
-            .debug => "DEBUG",
-            .info => "INFO ",
-            .warn => "WARN ",
-            .@"error" => "ERROR",
-            .fatal => "FATAL",
-        };
-    }
+    /// Formats into a stack buffer and emits one write; no heap allocation.
+    /// Messages longer than the buffer are truncated.
+    fn log(self: *LogContext, comptime level: LogLevel, comptime format: []const u8, args: anytype) !void {
+        // Resolved per instantiation, so a filtered call has an empty body
+        // whether or not `enabled` is inlined
+        if (comptime @intFromEnum(level) < @intFromEnum(min_level)) return;
+        if (@intFromEnum(level) < @intFromEnum(self.level)) return;
 
-    fn getLevelColor(self: *LogContext, level: LogLevel) []const u8 {
-        _ = self;
-        return switch (level) {
-            .trace => "\x1b[90m", // gray
-            .debug => "\x1b[36m", // cyan
-            .info => "\x1b[32m", // green
-            .warn => "\x1b[33m", // yellow
-            .@"error" => "\x1b[31m", // red
-            .fatal => "\x1b[35m", // magenta
+        var buf: [MAX_MESSAGE_BYTES]u8 = undefined;
+        var writer = std.Io.Writer.fixed(buf[0 .. buf.len - TRUNCATED.len]);
+        const color = if (self.colorize) comptime levelColor(level) else "";
+        const reset = if (self.colorize) "\x1b[0m" else "";
+        const complete = blk: {
+            if (self.timestamp) {
+                writer.print("{s}[{d}] ", .{ color, std.time.timestamp() }) catch break :blk false;
+            } else {
+                writer.writeAll(color) catch break :blk false;
+            }
+            writer.print(comptime levelString(level) ++ "{s} {s}: " ++ format ++ "{s}\n", .{ reset, self.component } ++ args ++ .{reset}) catch break :blk false;
+            break :blk true;
         };
+
+        var message = writer.buffered();
+        if (!complete) {
+            @memcpy(buf[message.len..][0..TRUNCATED.len], TRUNCATED);
+            message = buf[0 .. message.len + TRUNCATED.len];
+        }
+        if (self.sink) |sink| {
+            sink.write(message);
+        } else {
+            self.file.writeAll(message) catch {};
+        }
     }
 };
 
+/// Longest formatted log line; longer messages are truncated
+const MAX_MESSAGE_BYTES = 4096;
+const TRUNCATED = "...\n";
+
+fn levelString(comptime level: LogLevel) []const u8 {
+    return switch (level) {
+        .trace => "TRACE",
+        .debug => "DEBUG",
+        .info => "INFO ",
+        .warn => "WARN ",
+        .@"error" => "ERROR",
+        .fatal => "FATAL",
+    };
+}
+
+fn levelColor(comptime level: LogLevel) []const u8 {
+    return switch (level) {
+        .trace => "\x1b[90m", // gray
+        .debug => "\x1b[36m", // cyan
+        .info => "\x1b[32m", // green
+        .warn => "\x1b[33m", // yellow
+        .@"error" => "\x1b[31m", // red
+        .fatal => "\x1b[35m", // magenta
+    };
+}
+
 /// Structured logging
 pub const StructuredLogger = struct {
     allocator: std.mem.Allocator,
@@ -296,6 +255,20 @@ pub const LoggerFactory = struct {
 
     pub fn createFileLogger(self: *LoggerFactory, level: LogLevel, component: []const u8, file_path: []const u8) !LogContext {
         const file = try std.fs.cwd().createFile(file_path, .{});
-        return LogContext.init(self.allocator, file.writer(), level, component);
+        var empty_buffer: [0]u8 = undefined;
+        var logger = LogContext.init(self.allocator, file.writer(&empty_buffer), level, component);
+        logger.file = file;
+        logger.colorize = false;
+        return logger;
+    }
+
+    /// Logger that queues lines on `sink` and never waits for the disk
+    pub fn createAsyncLogger(self: *LoggerFactory, level: LogLevel, component: []const u8, sink: *async_log.AsyncSink) LogContext {
+        var empty_buffer: [0]u8 = undefined;
+        var logger = LogContext.init(self.allocator, sink.file.writer(&empty_buffer), level, component);
+        logger.file = sink.file;
+        logger.sink = sink;
+        logger.colorize = false;
+        return logger;
     }
 };
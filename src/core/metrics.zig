@@ -1,269 +1,424 @@
 const std = @import("std");
 
-/// Prometheus-style metrics exporter
-pub const MetricsRegistry = struct {
-    const Self = @This();
-    
-    allocator: std.mem.Allocator,
-    counters: std.StringHashMap(Counter),
-    gauges: std.StringHashMap(Gauge),
-    histograms: std.StringHashMap(Histogram),
-    
-    /// Initialize metrics registry
-    pub fn init(allocator: std.mem.Allocator) Self {
-        return Self{
-            .allocator = allocator,
-            .counters = std.StringHashMap(Counter).init(allocator),
-            .gauges = std.StringHashMap(Gauge).init(allocator),
-            .histograms = std.StringHashMap(Histogram).init(allocator),
-        };
+/// Default histogram buckets in seconds, from 5 ms to a minute
+pub const DEFAULT_BUCKETS = [_]f64{ 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60 };
+pub const DEFAULT_QUANTILES = [_]f64{ 0.5, 0.9, 0.99 };
+
+/// Samples a summary keeps for its quantiles
+pub const SUMMARY_WINDOW = 1024;
+
+/// Longest label set key (values joined by 0x1f)
+const MAX_LABEL_KEY = 512;
+
+/// f64 updated with a CAS loop on its bit pattern
+const AtomicF64 = struct {
+    bits: std.atomic.Value(u64) = .init(0),
+
+    fn load(self: *const AtomicF64) f64 {
+        return @bitCast(self.bits.load(.monotonic));
     }
-    
-    pub fn deinit(self: *Self) void {
-        var counter_it = self.counters.iterator();
-        while (counter_it.next()) |entry| {
-            self.allocator.free(entry.key_ptr.*);
-            entry.value_ptr.*.deinit(self.allocator);
-        }
-        self.counters.deinit();
-        
-        var gauge_it = self.gauges.iterator();
-        while (gauge_it.next()) |entry| {
-            self.allocator.free(entry.key_ptr.*);
-            entry.value_ptr.*.deinit(self.allocator);
-        }
-        self.gauges.deinit();
-        
-        var histogram_it = self.histograms.iterator();
-        while (histogram_it.next()) |entry| {
-            self.allocator.free(entry.key_ptr.*);
-            entry.value_ptr.*.deinit(self.allocator);
-        }
-        self.histograms.deinit();
+
+    fn store(self: *AtomicF64, value: f64) void {
+        self.bits.store(@bitCast(value), .monotonic);
     }
-    
-    /// Create or get counter
-    pub fn counter(self: *Self, name: []const u8, help: []const u8) !*Counter {
-        if (self.counters.get(name)) |existing| {
-            return existing;
+
+    fn add(self: *AtomicF64, delta: f64) void {
+        var old = self.bits.load(.monotonic);
+        while (true) {
+            const new: u64 = @bitCast(@as(f64, @bitCast(old)) + delta);
+            old = self.bits.cmpxchgWeak(old, new, .monotonic, .monotonic) orelse return;
         }
-        
-        const name_owned = try self.allocator.dupe(u8, name);
-        errdefer self.allocator.free(name_owned);
-        
-        const help_owned = try self.allocator.dupe(u8, help);
-        errdefer self.allocator.free(help_owned);
-        
-        var counter_metric = Counter.init(self.allocator, name_owned, help_owned);
-        errdefer counter_metric.deinit(self.allocator);
-        
-        try self.counters.put(name_owned, counter_metric);
-        return self.counters.getPtr(name_owned).?;
     }
-    
-    /// Create or get gauge
-    pub fn gauge(self: *Self, name: []const u8, help: []const u8) !*Gauge {
-        if (self.gauges.get(name)) |existing| {
-            return existing;
-        }
-        
-        const name_owned = try self.allocator.dupe(u8, name);
-        errdefer self.allocator.free(name_owned);
-        
-        const help_owned = try self.allocator.dupe(u8, help);
-        errdefer self.allocator.free(help_owned);
-        
-        var gauge_metric = Gauge.init(self.allocator, name_owned, help_owned);
-        errdefer gauge_metric.deinit(self.allocator);
-        
-        try self.gauges.put(name_owned, gauge_metric);
-        return self.gauges.getPtr(name_owned).?;
+};
+
+/// Monotonic counter; lock-free
+pub const Counter = struct {
+    value: AtomicF64 = .{},
+
+    pub fn inc(self: *Counter) void {
+        self.value.add(1);
     }
-    
-    /// Export metrics in Prometheus format
-    pub fn exportMetrics(self: *Self, writer: anytype) !void {
-        // Export counters
-        var counter_it = self.counters.iterator();
-        while (counter_it.next()) |entry| {
-            try entry.value_ptr.exportMetric(writer);
-        }
-        
-        // Export gauges
-        var gauge_it = self.gauges.iterator();
-        while (gauge_it.next()) |entry| {
-            try entry.value_ptr.exportMetric(writer);
-        }
-        
-        // Export histograms
-        var histogram_it = self.histograms.iterator();
-        while (histogram_it.next()) |entry| {
-            try entry.value_ptr.exportMetric(writer);
-        }
+
+    pub fn add(self: *Counter, delta: f64) void {
+        std.debug.assert(delta >= 0);
+        self.value.add(delta);
+    }
+
+    pub fn get(self: *const Counter) f64 {
+        return self.value.load();
     }
 };
 
-/// Counter metric
-pub const Counter = struct {
-    const Self = @This();
-    
-    allocator: std.mem.Allocator,
-    name: []const u8,
-    help: []const u8,
-    value: f64 = 0.0,
-    labels: std.StringHashMap([]const u8),
-    
-    pub fn init(allocator: std.mem.Allocator, name: []const u8, help: []const u8) Self {
-        return Self{
-            .allocator = allocator,
-            .name = name,
-            .help = help,
-            .value = 0.0,
-            .labels = std.StringHashMap([]const u8).init(allocator),
-        };
+/// Value that goes up and down; lock-free
+pub const Gauge = struct {
+    value: AtomicF64 = .{},
+
+    pub fn set(self: *Gauge, value: f64) void {
+        self.value.store(value);
     }
-    
-    pub fn deinit(self: *Self, allocator: std.mem.Allocator) void {
-        var it = self.labels.iterator();
-        while (it.next()) |entry| {
-            allocator.free(entry.key_ptr.*);
-            allocator.free(entry.value_ptr.*);
-        }
-        self.labels.deinit();
-        allocator.free(self.name);
-        allocator.free(self.help);
+
+    pub fn add(self: *Gauge, delta: f64) void {
+        self.value.add(delta);
     }
-    
-    pub fn inc(self: *Self, delta: f64) void {
-        self.value += delta;
+
+    pub fn inc(self: *Gauge) void {
+        self.value.add(1);
     }
-    
-    pub fn exportMetric(self: *Self, writer: anytype) !void {
-        // Write help
-        try writer.print("# HELP {s} {s}\n", .{ self.name, self.help });
-        
-        // Write type
-        try writer.print("# TYPE {s} counter\n", .{self.name});
-        
-        // Write value with labels
-        if (self.labels.count() > 0) {
-            try writer.print("{s}{{", .{self.name});
-            var first = true;
-            var it = self.labels.iterator();
-            while (it.next()) |entry| {
-                if (!first) try writer.writeAll(",");
-                first = false;
-                try writer.print("{s}=\"{s}\"", .{ entry.key_ptr.*, entry.value_ptr.* });
-            }
-            try writer.print("}} {d}\n", .{self.value});
-        } else {
-            try writer.print("{s} {d}\n", .{ self.name, self.value });
-        }
+
+    pub fn dec(self: *Gauge) void {
+        self.value.add(-1);
+    }
+
+    pub fn get(self: *const Gauge) f64 {
+        return self.value.load();
     }
 };
 
-/// Gauge metric
-pub const Gauge = struct {
-    const Self = @This();
-    
-    allocator: std.mem.Allocator,
-    name: []const u8,
-    help: []const u8,
-    value: f64 = 0.0,
-    labels: std.StringHashMap([]const u8),
-    
-    pub fn init(allocator: std.mem.Allocator, name: []const u8, help: []const u8) Self {
-        return Self{
-            .allocator = allocator,
-            .name = name,
-            .help = help,
-            .value = 0.0,
-            .labels = std.StringHashMap([]const u8).init(allocator),
-        };
+/// Bucketed histogram; lock-free
+pub const Histogram = struct {
+    /// Shared with the family
+    upper_bounds: []const f64,
+    /// Per bucket, not cumulative; the last one is +Inf
+    bucket_counts: []std.atomic.Value(u64),
+    count: std.atomic.Value(u64) = .init(0),
+    sum: AtomicF64 = .{},
+
+    fn init(allocator: std.mem.Allocator, upper_bounds: []const f64) !Histogram {
+        const counts = try allocator.alloc(std.atomic.Value(u64), upper_bounds.len + 1);
+        for (counts) |*c| c.* = .init(0);
+        return Histogram{ .upper_bounds = upper_bounds, .bucket_counts = counts };
     }
-    
-    pub fn deinit(self: *Self, allocator: std.mem.Allocator) void {
-        var it = self.labels.iterator();
-        while (it.next()) |entry| {
-            allocator.free(entry.key_ptr.*);
-            allocator.free(entry.value_ptr.*);
-        }
-        self.labels.deinit();
-        allocator.free(self.name);
-        allocator.free(self.help);
+
+    pub fn observe(self: *Histogram, value: f64) void {
+        var i: usize = 0;
+        while (i < self.upper_bounds.len and value > self.upper_bounds[i]) i += 1;
+        _ = self.bucket_counts[i].fetchAdd(1, .monotonic);
+        _ = self.count.fetchAdd(1, .monotonic);
+        self.sum.add(value);
     }
-    
-    pub fn set(self: *Self, value: f64) void {
-        self.value = value;
+
+    /// Observe the seconds elapsed since `start`
+    pub fn observeSince(self: *Histogram, start: std.time.Instant) void {
+        const now = std.time.Instant.now() catch return;
+        self.observe(@as(f64, @floatFromInt(now.since(start))) / std.time.ns_per_s);
     }
-    
-    pub fn inc(self: *Self, delta: f64) void {
-        self.value += delta;
+
+    pub fn getCount(self: *const Histogram) u64 {
+        return self.count.load(.monotonic);
     }
-    
-    pub fn dec(self: *Self, delta: f64) void {
-        self.value -= delta;
+
+    pub fn getSum(self: *const Histogram) f64 {
+        return self.sum.load();
     }
-    
-    pub fn exportMetric(self: *Self, writer: anytype) !void {
-        try writer.print("# HELP {s} {s}\n", .{ self.name, self.help });
-        try writer.print("# TYPE {s} gauge\n", .{self.name});
-        
-        if (self.labels.count() > 0) {
-            try writer.print("{s}{{", .{self.name});
-            var first = true;
-            var it = self.labels.iterator();
-            while (it.next()) |entry| {
-                if (!first) try writer.writeAll(",");
-                first = false;
-                try writer.print("{s}=\"{s}\"", .{ entry.key_ptr.*, entry.value_ptr.* });
+};
+
+/// Count, sum and quantiles over the last `SUMMARY_WINDOW` samples
+pub const Summary = struct {
+    /// Shared with the family
+    quantiles: []const f64,
+    count: std.atomic.Value(u64) = .init(0),
+    sum: AtomicF64 = .{},
+    mutex: std.Thread.Mutex = .{},
+    window: [SUMMARY_WINDOW]f64 = undefined,
+    next: usize = 0,
+    filled: usize = 0,
+
+    pub fn observe(self: *Summary, value: f64) void {
+        _ = self.count.fetchAdd(1, .monotonic);
+        self.sum.add(value);
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.window[self.next] = value;
+        self.next = (self.next + 1) % SUMMARY_WINDOW;
+        self.filled = @min(self.filled + 1, SUMMARY_WINDOW);
+    }
+
+    /// Nearest-rank quantile of the window; NaN before the first sample
+    pub fn quantile(self: *Summary, q: f64) f64 {
+        var sorted: [SUMMARY_WINDOW]f64 = undefined;
+        const n = blk: {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+            @memcpy(sorted[0..self.filled], self.window[0..self.filled]);
+            break :blk self.filled;
+        };
+        if (n == 0) return std.math.nan(f64);
+        std.mem.sort(f64, sorted[0..n], {}, std.sort.asc(f64));
+        const rank: usize = @intFromFloat(@ceil(std.math.clamp(q, 0, 1) * @as(f64, @floatFromInt(n))));
+        return sorted[@max(rank, 1) - 1];
+    }
+
+    pub fn getCount(self: *const Summary) u64 {
+        return self.count.load(.monotonic);
+    }
+
+    pub fn getSum(self: *const Summary) f64 {
+        return self.sum.load();
+    }
+};
+
+/// One metric name with a child per label set
+///
+/// `with` returns a stable pointer: children are never moved or freed
+/// before the registry is, so hot paths can look a handle up once and
+/// update it without locking.
+pub fn Family(comptime M: type) type {
+    return struct {
+        const Self = @This();
+
+        const Child = struct {
+            label_values: []const []const u8,
+            metric: M,
+        };
+
+        name: []const u8,
+        help: []const u8,
+        label_names: []const []const u8,
+        /// Histogram bucket bounds or summary quantiles
+        params: []const f64,
+        mutex: std.Thread.Mutex = .{},
+        /// Owns the family, its children and every string
+        arena: std.heap.ArenaAllocator,
+        /// Keyed by label values joined with 0x1f; insertion order is export order
+        children: std.StringArrayHashMapUnmanaged(*Child) = .{},
+
+        /// Child for `label_values`, in the order of the family's label names
+        pub fn with(self: *Self, label_values: []const []const u8) !*M {
+            if (label_values.len != self.label_names.len) return error.LabelMismatch;
+            var key_buf: [MAX_LABEL_KEY]u8 = undefined;
+            var key_writer = std.Io.Writer.fixed(&key_buf);
+            for (label_values, 0..) |value, i| {
+                if (i > 0) key_writer.writeByte(0x1f) catch return error.LabelsTooLong;
+                key_writer.writeAll(value) catch return error.LabelsTooLong;
+            }
+            const key = key_writer.buffered();
+
+            self.mutex.lock();
+            defer self.mutex.unlock();
+            if (self.children.get(key)) |child| return &child.metric;
+
+            const arena = self.arena.allocator();
+            const child = try arena.create(Child);
+            const values = try arena.alloc([]const u8, label_values.len);
+            for (label_values, 0..) |value, i| values[i] = try arena.dupe(u8, value);
+            child.* = .{
+                .label_values = values,
+                .metric = switch (M) {
+                    Histogram => try Histogram.init(arena, self.params),
+                    Summary => Summary{ .quantiles = self.params },
+                    else => M{},
+                },
+            };
+            try self.children.put(arena, try arena.dupe(u8, key), child);
+            return &child.metric;
+        }
+
+        fn writeTo(self: *Self, writer: *std.Io.Writer) !void {
+            self.mutex.lock();
+            defer self.mutex.unlock();
+
+            const kind = switch (M) {
+                Counter => "counter",
+                Gauge => "gauge",
+                Histogram => "histogram",
+                Summary => "summary",
+                else => @compileError("unsupported metric type"),
+            };
+            try writer.print("# HELP {s} {s}\n# TYPE {s} {s}\n", .{ self.name, self.help, self.name, kind });
+
+            for (self.children.values()) |child| {
+                const m = &child.metric;
+                switch (M) {
+                    Counter, Gauge => {
+                        try writer.writeAll(self.name);
+                        try writeLabels(writer, self.label_names, child.label_values, null);
+                        try writer.print(" {d}\n", .{m.get()});
+                    },
+                    Histogram => {
+                        var cumulative: u64 = 0;
+                        for (m.bucket_counts, 0..) |*bucket, i| {
+                            cumulative += bucket.load(.monotonic);
+                            var le_buf: [32]u8 = undefined;
+                            const le = if (i < m.upper_bounds.len)
+                                std.fmt.bufPrint(&le_buf, "{d}", .{m.upper_bounds[i]}) catch unreachable
+                            else
+                                "+Inf";
+                            try writer.print("{s}_bucket", .{self.name});
+                            try writeLabels(writer, self.label_names, child.label_values, .{ "le", le });
+                            try writer.print(" {d}\n", .{cumulative});
+                        }
+                        try writeSumCount(writer, self.name, self.label_names, child.label_values, m.getSum(), m.getCount());
+                    },
+                    Summary => {
+                        for (m.quantiles) |q| {
+                            var q_buf: [32]u8 = undefined;
+                            const q_str = std.fmt.bufPrint(&q_buf, "{d}", .{q}) catch unreachable;
+                            try writer.writeAll(self.name);
+                            try writeLabels(writer, self.label_names, child.label_values, .{ "quantile", q_str });
+                            try writer.print(" {d}\n", .{m.quantile(q)});
+                        }
+                        try writeSumCount(writer, self.name, self.label_names, child.label_values, m.getSum(), m.getCount());
+                    },
+                    else => unreachable,
+                }
             }
-            try writer.print("}} {d}\n", .{self.value});
-        } else {
-            try writer.print("{s} {d}\n", .{ self.name, self.value });
         }
+    };
+}
+
+fn writeSumCount(writer: *std.Io.Writer, name: []const u8, names: []const []const u8, values: []const []const u8, sum: f64, count: u64) !void {
+    try writer.print("{s}_sum", .{name});
+    try writeLabels(writer, names, values, null);
+    try writer.print(" {d}\n{s}_count", .{ sum, name });
+    try writeLabels(writer, names, values, null);
+    try writer.print(" {d}\n", .{count});
+}
+
+/// `{a="x",b="y"}` with Prometheus escaping; nothing for an empty set
+fn writeLabels(writer: *std.Io.Writer, names: []const []const u8, values: []const []const u8, extra: ?[2][]const u8) !void {
+    if (names.len == 0 and extra == null) return;
+    try writer.writeByte('{');
+    for (names, values, 0..) |name, value, i| {
+        if (i > 0) try writer.writeByte(',');
+        try writeLabel(writer, name, value);
     }
-};
+    if (extra) |e| {
+        if (names.len > 0) try writer.writeByte(',');
+        try writeLabel(writer, e[0], e[1]);
+    }
+    try writer.writeByte('}');
+}
 
-/// Histogram metric (simplified)
-pub const Histogram = struct {
+fn writeLabel(writer: *std.Io.Writer, name: []const u8, value: []const u8) !void {
+    try writer.print("{s}=\"", .{name});
+    for (value) |c| switch (c) {
+        '\\' => try writer.writeAll("\\\\"),
+        '"' => try writer.writeAll("\\\""),
+        '\n' => try writer.writeAll("\\n"),
+        else => try writer.writeByte(c),
+    };
+    try writer.writeByte('"');
+}
+
+/// Prometheus-style metrics exporter
+pub const MetricsRegistry = struct {
     const Self = @This();
-    
+
+    const Entry = union(enum) {
+        counter: *Family(Counter),
+        gauge: *Family(Gauge),
+        histogram: *Family(Histogram),
+        summary: *Family(Summary),
+
+        fn name(self: Entry) []const u8 {
+            return switch (self) {
+                inline else => |f| f.name,
+            };
+        }
+    };
+
     allocator: std.mem.Allocator,
-    name: []const u8,
-    help: []const u8,
-    buckets: std.ArrayList(f64),
-    counts: std.ArrayList(u64),
-    sum: f64 = 0.0,
-    
-    pub fn init(allocator: std.mem.Allocator, name: []const u8, help: []const u8) Self {
-        return Self{
-            .allocator = allocator,
-            .name = name,
-            .help = help,
-            .buckets = std.ArrayList(f64).init(allocator),
-            .counts = std.ArrayList(u64).init(allocator),
-            .sum = 0.0,
+    mutex: std.Thread.Mutex = .{},
+    families: std.ArrayListUnmanaged(Entry) = .{},
+
+    /// Initialize metrics registry
+    pub fn init(allocator: std.mem.Allocator) Self {
+        return Self{ .allocator = allocator };
+    }
+
+    pub fn deinit(self: *Self) void {
+        for (self.families.items) |entry| switch (entry) {
+            inline else => |f| {
+                var arena = f.arena;
+                arena.deinit();
+            },
         };
+        self.families.deinit(self.allocator);
     }
-    
-    pub fn deinit(self: *Self, allocator: std.mem.Allocator) void {
-        self.buckets.deinit();
-        self.counts.deinit();
-        allocator.free(self.name);
-        allocator.free(self.help);
+
+    /// Create or get a counter family
+    pub fn counter(self: *Self, name: []const u8, help: []const u8, label_names: []const []const u8) !*Family(Counter) {
+        return self.family(Counter, .counter, name, help, label_names, &.{});
     }
-    
-    pub fn observe(self: *Self, value: f64) !void {
-        self.sum += value;
-        // Simplified histogram - just track sum and count
-        // Full implementation would bucket values
+
+    /// Create or get a gauge family
+    pub fn gauge(self: *Self, name: []const u8, help: []const u8, label_names: []const []const u8) !*Family(Gauge) {
+        return self.family(Gauge, .gauge, name, help, label_names, &.{});
     }
-    
-    pub fn exportMetric(self: *Self, writer: anytype) !void {
-        try writer.print("# HELP {s} {s}\n", .{ self.name, self.help });
-        try writer.print("# TYPE {s} histogram\n", .{self.name});
-        try writer.print("{s}_sum {d}\n", .{ self.name, self.sum });
-        // Additional histogram metrics would go here
+
+    /// Create or get a histogram family; `buckets` are ascending upper bounds
+    pub fn histogram(self: *Self, name: []const u8, help: []const u8, label_names: []const []const u8, buckets: []const f64) !*Family(Histogram) {
+        if (!std.sort.isSorted(f64, buckets, {}, std.sort.asc(f64))) return error.InvalidBuckets;
+        return self.family(Histogram, .histogram, name, help, label_names, buckets);
+    }
+
+    /// Create or get a summary family reporting `quantiles` (each in 0..1)
+    pub fn summary(self: *Self, name: []const u8, help: []const u8, label_names: []const []const u8, quantiles: []const f64) !*Family(Summary) {
+        return self.family(Summary, .summary, name, help, label_names, quantiles);
+    }
+
+    fn family(
+        self: *Self,
+        comptime M: type,
+        comptime tag: std.meta.Tag(Entry),
+        name: []const u8,
+        help: []const u8,
+        label_names: []const []const u8,
+        params: []const f64,
+    ) !*Family(M) {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        for (self.families.items) |entry| {
+            if (!std.mem.eql(u8, entry.name(), name)) continue;
+            if (entry != tag) return error.MetricTypeMismatch;
+            return @field(entry, @tagName(tag));
+        }
+
+        var arena = std.heap.ArenaAllocator.init(self.allocator);
+        errdefer arena.deinit();
+        const a = arena.allocator();
+        const names = try a.alloc([]const u8, label_names.len);
+        for (label_names, 0..) |label, i| names[i] = try a.dupe(u8, label);
+        const f = try a.create(Family(M));
+        f.* = .{
+            .name = try a.dupe(u8, name),
+            .help = try a.dupe(u8, help),
+            .label_names = names,
+            .params = try a.dupe(f64, params),
+            .arena = undefined,
+        };
+        try self.families.append(self.allocator, @unionInit(Entry, @tagName(tag), f));
+        // The family lives in the arena it owns; hand it over after the last local allocation
+        f.arena = arena;
+        return f;
+    }
+
+    /// Export metrics in Prometheus text format
+    pub fn exportMetrics(self: *Self, writer: *std.Io.Writer) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        for (self.families.items) |entry| switch (entry) {
+            inline else => |f| try f.writeTo(writer),
+        };
     }
 };
 
+var default_registry = MetricsRegistry{ .allocator = std.heap.page_allocator };
+
+/// Process-wide registry; the daemon serves it through `nexcage metrics`
+pub fn global() *MetricsRegistry {
+    return &default_registry;
+}
+
+/// Record one backend operation in `nexcage_operation_duration_seconds{backend,op,result}`
+pub fn recordOperation(backend: []const u8, op: []const u8, ok: bool, start: std.time.Instant) void {
+    const durations = global().histogram(
+        "nexcage_operation_duration_seconds",
+        "Duration of container operations by backend, operation and result",
+        &.{ "backend", "op", "result" },
+        &DEFAULT_BUCKETS,
+    ) catch return;
+    const h = durations.with(&.{ backend, op, if (ok) "ok" else "error" }) catch return;
+    h.observeSince(start);
+}
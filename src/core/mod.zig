@@ -3,6 +3,7 @@ pub const types = @import("types.zig");
 pub const interfaces = @import("interfaces.zig");
 pub const errors = @import("errors.zig");
 pub const logging = @import("logging.zig");
+pub const async_log = @import("async_log.zig");
 pub const simple_advanced_logging = @import("simple_advanced_logging.zig");
 pub const logging_config = @import("logging_config.zig");
 pub const config = @import("config.zig");
@@ -12,6 +13,8 @@ pub const validation = @import("validation.zig");
 pub const comptime_validation = @import("comptime_validation.zig");
 pub const json_logging = @import("json_logging.zig");
 pub const metrics = @import("metrics.zig");
+pub const exec = @import("exec.zig");
+pub const tracing = @import("tracing.zig");
 pub const version = @import("version.zig");
 
 // Re-export commonly used types
@@ -6,6 +6,9 @@ pub const SimpleAdvancedLogging = struct {
     allocator: std.mem.Allocator,
     console_logger: LogContext,
     file_logger: ?LogContext = null,
+    /// Backs `file_logger`; flushed and closed in deinit
+    log_file: ?std.fs.File = null,
+    log_sink: ?*AsyncSink = null,
     debug_mode: bool = false,
     log_file_path: ?[]const u8 = null,
     command_start_time: ?u64 = null,
@@ -17,16 +20,29 @@ pub const SimpleAdvancedLogging = struct {
         const console_logger = LogContext.init(allocator, std.fs.File.stdout().writer(&[_]u8{} ** 0), .debug, "nexcage");
         
         var file_logger: ?LogContext = null;
+        var log_file: ?std.fs.File = null;
+        var log_sink: ?*AsyncSink = null;
         if (log_file_path) |path| {
             const file = try std.fs.cwd().createFile(path, .{});
-            var buffer: [1024]u8 = undefined;
-            file_logger = LogContext.init(allocator, file.writer(&buffer), .debug, "nexcage");
+            errdefer file.close();
+            // Batch and daemon runs log heavily; keep file writes off the calling thread
+            const sink = try AsyncSink.create(allocator, file, .{});
+            var empty_buffer: [0]u8 = undefined;
+            var logger = LogContext.init(allocator, file.writer(&empty_buffer), .debug, "nexcage");
+            logger.file = file;
+            logger.sink = sink;
+            logger.colorize = false;
+            file_logger = logger;
+            log_file = file;
+            log_sink = sink;
         }
 
         return Self{
             .allocator = allocator,
             .console_logger = console_logger,
             .file_logger = file_logger,
+            .log_file = log_file,
+            .log_sink = log_sink,
             .debug_mode = debug_mode,
             .log_file_path = log_file_path,
         };
@@ -38,6 +54,8 @@ pub const SimpleAdvancedLogging = struct {
         if (self.file_logger) |*logger| {
             logger.deinit();
         }
+        if (self.log_sink) |sink| sink.destroy();
+        if (self.log_file) |file| file.close();
 
         // Note: log_file_path is owned by LoggingConfig, not by us
     }
@@ -191,3 +209,4 @@ pub const SimpleAdvancedLogging = struct {
 /// Re-export LogLevel and LogContext for compatibility
 pub const LogLevel = @import("logging.zig").LogLevel;
 pub const LogContext = @import("logging.zig").LogContext;
+const AsyncSink = @import("async_log.zig").AsyncSink;
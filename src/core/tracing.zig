@@ -0,0 +1,188 @@
+const std = @import("std");
+
+pub const Format = enum {
+    /// Chrome trace event JSON; open in chrome://tracing or Perfetto
+    chrome,
+    /// OTLP/JSON `ExportTraceServiceRequest`, as written by the OTel file exporter
+    otlp,
+
+    pub fn parse(value: []const u8) ?Format {
+        if (std.mem.eql(u8, value, "chrome")) return .chrome;
+        if (std.mem.eql(u8, value, "otlp")) return .otlp;
+        return null;
+    }
+};
+
+/// A finished or running span; `end_ns` is 0 while it runs
+pub const Record = struct {
+    name: []const u8,
+    id: u32,
+    /// 0 for root spans
+    parent: u32,
+    tid: u32,
+    /// Relative to the tracer's origin
+    start_ns: u64,
+    end_ns: u64 = 0,
+};
+
+/// Handle returned by `begin`; call `end` exactly once, typically via defer
+pub const Span = struct {
+    tracer: ?*Tracer = null,
+    id: u32 = 0,
+    parent: u32 = 0,
+
+    pub fn end(self: Span) void {
+        const tracer = self.tracer orelse return;
+        tracer.finish(self);
+    }
+};
+
+/// Innermost open span of the calling thread; parent of the next `begin`
+threadlocal var current_span: u32 = 0;
+
+/// Collects nested spans in memory and exports them once the command is done
+///
+/// Spans nest per thread: `begin` parents the new span to the innermost open
+/// span of the calling thread. Nothing is written until `writeFile`, so
+/// tracing costs a clock read and an append per span.
+pub const Tracer = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    mutex: std.Thread.Mutex = .{},
+    /// Span names
+    arena: std.heap.ArenaAllocator,
+    spans: std.ArrayListUnmanaged(Record) = .{},
+    origin: std.time.Instant,
+    /// Wall clock at `origin`, for OTLP's absolute timestamps
+    origin_unix_ns: i128,
+    trace_id: [16]u8,
+
+    pub fn init(allocator: std.mem.Allocator) !Self {
+        var trace_id: [16]u8 = undefined;
+        std.crypto.random.bytes(&trace_id);
+        return Self{
+            .allocator = allocator,
+            .arena = std.heap.ArenaAllocator.init(allocator),
+            .origin = try std.time.Instant.now(),
+            .origin_unix_ns = std.time.nanoTimestamp(),
+            .trace_id = trace_id,
+        };
+    }
+
+    pub fn deinit(self: *Self) void {
+        self.spans.deinit(self.allocator);
+        self.arena.deinit();
+    }
+
+    pub fn begin(self: *Self, name: []const u8) Span {
+        const now = self.elapsedNs();
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const id: u32 = @intCast(self.spans.items.len + 1);
+        const owned = self.arena.allocator().dupe(u8, name) catch return .{};
+        self.spans.append(self.allocator, .{
+            .name = owned,
+            .id = id,
+            .parent = current_span,
+            .tid = @truncate(std.Thread.getCurrentId()),
+            .start_ns = now,
+        }) catch return .{};
+
+        const span = Span{ .tracer = self, .id = id, .parent = current_span };
+        current_span = id;
+        return span;
+    }
+
+    fn finish(self: *Self, span: Span) void {
+        const now = self.elapsedNs();
+        self.mutex.lock();
+        defer self.mutex.unlock();
+        self.spans.items[span.id - 1].end_ns = @max(now, 1);
+        current_span = span.parent;
+    }
+
+    fn elapsedNs(self: *const Self) u64 {
+        const now = std.time.Instant.now() catch return 0;
+        return now.since(self.origin);
+    }
+
+    /// Chrome "complete" (ph=X) events; the viewer nests them by time per thread
+    pub fn writeChrome(self: *Self, writer: *std.Io.Writer) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        const pid = std.os.linux.getpid();
+        try writer.writeAll("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        var first = true;
+        for (self.spans.items) |span| {
+            if (span.end_ns == 0) continue;
+            if (!first) try writer.writeByte(',');
+            first = false;
+            try writer.print("{{\"name\":{f},\"cat\":\"nexcage\",\"ph\":\"X\",\"ts\":{d}.{d:0>3},\"dur\":{d}.{d:0>3},\"pid\":{d},\"tid\":{d},\"args\":{{\"id\":{d},\"parent\":{d}}}}}", .{
+                std.json.fmt(span.name, .{}),
+                span.start_ns / std.time.ns_per_us,
+                span.start_ns % std.time.ns_per_us,
+                (span.end_ns - span.start_ns) / std.time.ns_per_us,
+                (span.end_ns - span.start_ns) % std.time.ns_per_us,
+                pid,
+                span.tid,
+                span.id,
+                span.parent,
+            });
+        }
+        try writer.writeAll("]}\n");
+    }
+
+    /// One OTLP/JSON resource with every finished span
+    pub fn writeOtlp(self: *Self, writer: *std.Io.Writer) !void {
+        self.mutex.lock();
+        defer self.mutex.unlock();
+
+        try writer.writeAll("{\"resourceSpans\":[{\"resource\":{\"attributes\":[{\"key\":\"service.name\",\"value\":{\"stringValue\":\"nexcage\"}}]},");
+        try writer.writeAll("\"scopeSpans\":[{\"scope\":{\"name\":\"nexcage\"},\"spans\":[");
+        const trace_id = std.fmt.bytesToHex(self.trace_id, .lower);
+        var first = true;
+        for (self.spans.items) |span| {
+            if (span.end_ns == 0) continue;
+            if (!first) try writer.writeByte(',');
+            first = false;
+            try writer.print("{{\"traceId\":\"{s}\",\"spanId\":\"{x:0>16}\",", .{ &trace_id, span.id });
+            if (span.parent != 0) try writer.print("\"parentSpanId\":\"{x:0>16}\",", .{span.parent});
+            try writer.print("\"name\":{f},\"kind\":1,\"startTimeUnixNano\":\"{d}\",\"endTimeUnixNano\":\"{d}\",\"attributes\":[{{\"key\":\"thread.id\",\"value\":{{\"intValue\":\"{d}\"}}}}]}}", .{
+                std.json.fmt(span.name, .{}),
+                self.origin_unix_ns + span.start_ns,
+                self.origin_unix_ns + span.end_ns,
+                span.tid,
+            });
+        }
+        try writer.writeAll("]}]}]}\n");
+    }
+
+    pub fn writeFile(self: *Self, path: []const u8, format: Format) !void {
+        const file = try std.fs.cwd().createFile(path, .{ .truncate = true });
+        defer file.close();
+        var buf: [16 * 1024]u8 = undefined;
+        var file_writer = file.writer(&buf);
+        switch (format) {
+            .chrome => try self.writeChrome(&file_writer.interface),
+            .otlp => try self.writeOtlp(&file_writer.interface),
+        }
+        try file_writer.interface.flush();
+    }
+};
+
+var active: ?*Tracer = null;
+
+/// Route `begin` to `tracer`, or turn tracing off with null
+pub fn install(tracer: ?*Tracer) void {
+    active = tracer;
+    current_span = 0;
+}
+
+/// Open a span on the installed tracer; a no-op when tracing is off
+pub fn begin(name: []const u8) Span {
+    const tracer = active orelse return .{};
+    return tracer.begin(name);
+}
@@ -196,6 +196,7 @@ pub const Command = enum {
     version,
     state,
     kill,
+    metrics,
 };
 
 /// Runtime options
@@ -216,9 +217,14 @@ pub const RuntimeOptions = struct {
     workdir: ?[]const u8 = null,
     env: ?[]const []const u8 = null,
     args: ?[]const []const u8 = null,
+    /// Manifest path for batch mode, "-" reads IDs from stdin
+    batch_file: ?[]const u8 = null,
+    /// Worker count for batch mode
+    parallel: u32 = 1,
 
     pub fn deinit(self: *RuntimeOptions) void {
         if (self.container_id) |id| self.allocator.free(id);
+        if (self.batch_file) |path| self.allocator.free(path);
         if (self.image) |img| self.allocator.free(img);
         if (self.config_file) |cfg| self.allocator.free(cfg);
         if (self.user) |u| self.allocator.free(u);
@@ -258,6 +264,17 @@ pub const RoutingRule = struct {
     }
 };
 
+/// VMID range for containers whose name matches `pattern`
+pub const VmidPool = struct {
+    pattern: []const u8,
+    first: u32,
+    last: u32,
+
+    pub fn deinit(self: *const VmidPool, allocator: std.mem.Allocator) void {
+        allocator.free(self.pattern);
+    }
+};
+
 /// Container configuration
 pub const ContainerConfig = struct {
     // Legacy pattern support (deprecated - use routing instead)
@@ -268,6 +285,30 @@ pub const ContainerConfig = struct {
     routing: []const RoutingRule,
     default_runtime: RuntimeType,
 
+    // Per-tenant/pool VMID ranges, first match wins
+    vmid_pools: []const VmidPool = &[_]VmidPool{},
+
+    // Template archive compression: zstd level (1-19) and threads (0 = all cores)
+    template_zstd_level: ?u8 = null,
+    template_zstd_workers: ?u32 = null,
+
+    // Content-addressed template cache limits; unreferenced templates are evicted past these
+    template_cache_max_bytes: ?u64 = null,
+    template_cache_max_entries: ?u32 = null,
+
+    // Deadline for stop/kill to observe the container exit
+    stop_timeout_ms: ?u32 = null,
+
+    // Pre-created stopped containers kept per template; 0 disables the pool
+    warm_pool_size: ?u32 = null,
+
+    // Proxmox ZFS storage for template bases; set to give containers linked-clone rootfs
+    clone_storage: ?[]const u8 = null,
+    clone_rootfs_gb: ?u32 = null,
+
+    // Drive LXC lifecycle through the Proxmox REST API instead of forking pct
+    proxmox_api: ?ProxmoxApiEndpoint = null,
+
     pub fn deinit(self: *ContainerConfig, allocator: std.mem.Allocator) void {
         // Clean up legacy patterns
         for (self.crun_name_patterns) |pattern| {
@@ -280,6 +321,30 @@ pub const ContainerConfig = struct {
             rule.deinit(allocator);
         }
         allocator.free(self.routing);
+
+        for (self.vmid_pools) |pool| {
+            pool.deinit(allocator);
+        }
+        allocator.free(self.vmid_pools);
+
+        if (self.clone_storage) |storage| allocator.free(storage);
+        if (self.proxmox_api) |api| api.deinit(allocator);
+    }
+};
+
+/// Proxmox REST endpoint and API token
+pub const ProxmoxApiEndpoint = struct {
+    host: []const u8,
+    port: u16 = 8006,
+    /// "user@realm!tokenid=secret"
+    token: []const u8,
+    /// Node that owns new containers
+    node: []const u8,
+
+    pub fn deinit(self: ProxmoxApiEndpoint, allocator: std.mem.Allocator) void {
+        allocator.free(self.host);
+        allocator.free(self.token);
+        allocator.free(self.node);
     }
 };
 
@@ -298,6 +363,25 @@ pub const ProxmoxLxcBackendConfig = struct {
     default_bridge: ?[]const u8 = null,
     default_ostype: ?[]const u8 = null,
     default_unprivileged: ?bool = null,
+    // Persistent state such as the VMID bitmap; not owned
+    state_dir: ?[]const u8 = null,
+    // VMID pool for new containers, inclusive
+    vmid_first: ?u32 = null,
+    vmid_last: ?u32 = null,
+    // Template archive compression overrides
+    template_zstd_level: ?u8 = null,
+    template_zstd_workers: ?u32 = null,
+    template_cache_max_bytes: ?u64 = null,
+    template_cache_max_entries: ?u32 = null,
+    // How long stop/kill wait for the container to exit
+    stop_timeout_ms: ?u32 = null,
+    // Warm containers kept per template
+    warm_pool_size: ?u32 = null,
+    // ZFS storage for linked-clone template bases; not owned
+    clone_storage: ?[]const u8 = null,
+    clone_rootfs_gb: ?u32 = null,
+    // Lifecycle over the REST API instead of pct; not owned
+    proxmox_api: ?ProxmoxApiEndpoint = null,
 
     pub fn deinit(self: *ProxmoxLxcBackendConfig) void {
         if (self.zfs_pool) |p| self.allocator.free(p);
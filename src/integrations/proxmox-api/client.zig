@@ -2,299 +2,258 @@ const std = @import("std");
 const core = @import("core");
 const types = @import("types.zig");
 
+const USER_AGENT = "nexcage/0.3";
+
+/// Largest response body accepted from the API
+pub const MAX_RESPONSE_BYTES = 64 * 1024 * 1024;
+
 /// Proxmox API HTTP client
-/// Proxmox API client
+///
+/// One `std.http.Client` lives as long as this struct. Its connection pool
+/// keeps TLS connections to each host alive between calls, so a burst of
+/// requests pays for one handshake and one CA bundle scan, not one per call.
+/// Safe to share between threads; `max_in_flight` caps concurrent requests.
+///
+/// Only GET and HEAD use the pool. pveproxy closes idle connections, and a
+/// request written to one it has closed can fail after the server may
+/// have acted on it; those two are simply sent again, anything else goes
+/// out on a connection of its own.
 pub const ProxmoxApiClient = struct {
     const Self = @This();
 
     allocator: std.mem.Allocator,
     config: types.ProxmoxApiConfig,
     logger: ?*core.LogContext = null,
-    current_host_index: usize = 0,
+    current_host_index: std.atomic.Value(usize) = .init(0),
     hosts: []const []const u8,
     port: u16,
     token: []const u8,
     node: []const u8,
+    http: std.http.Client,
+    /// Never keeps connections, so each request through it opens a fresh one
+    oneshot_http: std.http.Client,
+    /// "PVEAPIToken=..." built once
+    auth_header: []const u8,
+    in_flight: std.Thread.Semaphore,
 
     pub fn init(allocator: std.mem.Allocator, config: types.ProxmoxApiConfig) !*Self {
-        const client = try allocator.alloc(Self, 1);
-        client[0] = Self{
+        const hosts = try allocator.alloc([]const u8, 1);
+        errdefer allocator.free(hosts);
+        hosts[0] = try allocator.dupe(u8, config.host);
+        errdefer allocator.free(hosts[0]);
+        const token = try allocator.dupe(u8, config.token);
+        errdefer allocator.free(token);
+        const node = try allocator.dupe(u8, config.node);
+        errdefer allocator.free(node);
+        const auth_header = try std.fmt.allocPrint(allocator, "PVEAPIToken={s}", .{config.token});
+        errdefer allocator.free(auth_header);
+
+        const client = try allocator.create(Self);
+        client.* = Self{
             .allocator = allocator,
             .config = config,
-            .hosts = try allocator.dupe([]const u8, &[_][]const u8{config.host}),
+            .hosts = hosts,
             .port = config.port,
-            .token = try allocator.dupe(u8, config.token),
-            .node = try allocator.dupe(u8, config.node),
+            .token = token,
+            .node = node,
+            .http = .{ .allocator = allocator },
+            .oneshot_http = .{ .allocator = allocator },
+            .auth_header = auth_header,
+            .in_flight = .{ .permits = @max(config.max_in_flight, 1) },
         };
-        return &client[0];
+        client.http.connection_pool.free_size = config.max_idle_connections;
+        client.oneshot_http.connection_pool.free_size = 0;
+        return client;
     }
 
     pub fn deinit(self: *Self) void {
+        self.http.deinit();
+        self.oneshot_http.deinit();
         for (self.hosts) |host| {
             self.allocator.free(host);
         }
         self.allocator.free(self.hosts);
         self.allocator.free(self.token);
         self.allocator.free(self.node);
-        self.allocator.free(self);
+        self.allocator.free(self.auth_header);
+        self.allocator.destroy(self);
     }
 
     /// Make HTTP request to Proxmox API
     pub fn makeRequest(self: *Self, method: std.http.Method, path: []const u8) !types.ProxmoxResponse {
-        const max_retries = 3;
-        var retry_count: u32 = 0;
-        var last_error: anyerror = undefined;
-
-        retry_loop: while (retry_count < max_retries) : (retry_count += 1) {
-            const host = self.hosts[self.current_host_index];
-            const url = try std.fmt.allocPrint(self.allocator, "https://{s}:{d}/api2/json{s}", .{ host, self.port, path });
-            defer self.allocator.free(url);
-
-            const uri = std.Uri.parse(url) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            var client = std.http.Client{ .allocator = self.allocator };
-            defer client.deinit();
-
-            var req = client.open(method, uri, .{}) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-            defer req.deinit();
-
-            // Add authentication header
-            req.headers.append("Authorization", try std.fmt.allocPrint(self.allocator, "PVEAPIToken={s}", .{self.token})) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            req.headers.append("Accept", "application/json") catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            req.headers.append("User-Agent", "nexcage/0.3") catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            req.send() catch |err| {
-                if (err == error.ConnectionResetByPeer) {
-                    if (self.logger) |log| {
-                        try log.warn("Connection reset during send, retrying... (attempt {d}/{d})", .{ retry_count + 1, max_retries });
-                    }
-                    last_error = err;
-                    if (self.tryNextHost()) continue :retry_loop;
-                    return err;
-                }
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            req.wait() catch |err| {
-                if (err == error.ConnectionResetByPeer) {
-                    if (self.logger) |log| {
-                        try log.warn("Connection reset during wait, retrying... (attempt {d}/{d})", .{ retry_count + 1, max_retries });
-                    }
-                    last_error = err;
-                    if (self.tryNextHost()) continue :retry_loop;
-                    return err;
-                }
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            const response_body = req.reader().readAllAlloc(self.allocator, std.math.maxInt(usize)) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-            defer self.allocator.free(response_body);
-
-            const parsed = std.json.parseFromSlice(std.json.Value, self.allocator, response_body, .{}) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            return types.ProxmoxResponse{
-                .allocator = self.allocator,
-                .data = parsed.value,
-                .success = true,
-                .status_code = @intCast(req.response.status.code),
-            };
-        }
-
-        return last_error;
+        return self.respond(method, path, null);
     }
 
     /// Make HTTP request with content type
     pub fn makeRequestWithContentType(self: *Self, method: std.http.Method, path: []const u8, body: []const u8, content_type: []const u8) !types.ProxmoxResponse {
-        const max_retries = 3;
-        var retry_count: u32 = 0;
-        var last_error: anyerror = undefined;
-
-        retry_loop: while (retry_count < max_retries) : (retry_count += 1) {
-            const host = self.hosts[self.current_host_index];
-            const url = try std.fmt.allocPrint(self.allocator, "https://{s}:{d}/api2/json{s}", .{ host, self.port, path });
-            defer self.allocator.free(url);
-
-            const uri = std.Uri.parse(url) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            var client = std.http.Client{ .allocator = self.allocator };
-            defer client.deinit();
-
-            var req = client.open(method, uri, .{}) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-            defer req.deinit();
-
-            // Add headers
-            req.headers.append("Authorization", try std.fmt.allocPrint(self.allocator, "PVEAPIToken={s}", .{self.token})) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
+        return self.respond(method, path, .{ .body = body, .content_type = content_type });
+    }
 
-            req.headers.append("Accept", "application/json") catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
+    /// GET `path` and decode the `data` member of the reply straight into `T`
+    ///
+    /// The body is read into `arena` and decoded in one pass with no
+    /// `std.json.Value` tree in between. Strings without escapes are slices
+    /// of the body, so the result lives exactly as long as the arena.
+    /// Fields not in `T` are skipped.
+    pub fn get(self: *Self, comptime T: type, arena: std.mem.Allocator, path: []const u8) !T {
+        const raw = try self.send(.GET, path, null, arena);
+        if (raw.status < 200 or raw.status >= 300) return types.ProxmoxApiError.OperationFailed;
+        const envelope = std.json.parseFromSliceLeaky(struct { data: T }, arena, raw.body, .{
+            .allocate = .alloc_if_needed,
+            .ignore_unknown_fields = true,
+        }) catch |err| switch (err) {
+            error.OutOfMemory => return error.OutOfMemory,
+            else => {
+                if (self.logger) |log| log.warn("Unexpected reply to GET {s}: {s}", .{ path, @errorName(err) }) catch {};
+                return types.ProxmoxApiError.InvalidResponse;
+            },
+        };
+        return envelope.data;
+    }
 
-            req.headers.append("Content-Type", content_type) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
+    const Payload = struct {
+        body: []const u8,
+        content_type: []const u8,
+    };
+
+    const RawResponse = struct {
+        status: u16,
+        /// Proxmox puts its error message in the status line
+        reason: []u8,
+        body: []u8,
+    };
+
+    fn respond(self: *Self, method: std.http.Method, path: []const u8, payload: ?Payload) !types.ProxmoxResponse {
+        const raw = try self.send(method, path, payload, self.allocator);
+        defer self.allocator.free(raw.body);
+        defer self.allocator.free(raw.reason);
+        const success = raw.status >= 200 and raw.status < 300;
+
+        // Error replies are not always JSON; their text is kept regardless
+        const parsed: ?std.json.Parsed(std.json.Value) = std.json.parseFromSlice(std.json.Value, self.allocator, raw.body, .{}) catch |err| blk: {
+            if (success) return err;
+            break :blk null;
+        };
+        var response = types.ProxmoxResponse{
+            .allocator = self.allocator,
+            .parsed = parsed,
+            .data = if (parsed) |p| p.value else null,
+            .success = success,
+            .status_code = raw.status,
+        };
+        errdefer response.deinit();
+        if (!success) response.message = try self.allocator.dupe(u8, errorText(response.data, raw.reason));
+        return response;
+    }
 
-            req.headers.append("Content-Length", try std.fmt.allocPrint(self.allocator, "{d}", .{body.len})) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
+    /// The body's `message` when it has one, else the reason phrase
+    fn errorText(data: ?std.json.Value, reason: []const u8) []const u8 {
+        if (data) |value| if (value == .object) if (value.object.get("message")) |message| if (message == .string) {
+            const text = std.mem.trim(u8, message.string, " \t\r\n");
+            if (text.len > 0) return text;
+        };
+        return std.mem.trim(u8, reason, " \t");
+    }
 
-            req.headers.append("User-Agent", "nexcage/0.3") catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
+    /// Send with retries; the body is allocated with `body_allocator`
+    ///
+    /// A request that failed after it was fully written may already have
+    /// taken effect, so only GET and HEAD are sent again then; anything
+    /// else is retried only when it never left this process.
+    fn send(self: *Self, method: std.http.Method, path: []const u8, payload: ?Payload, body_allocator: std.mem.Allocator) !RawResponse {
+        self.in_flight.wait();
+        defer self.in_flight.post();
 
-            req.headers.append("Host", host) catch |err| {
+        const max_retries = 3;
+        var last_error: anyerror = types.ProxmoxApiError.ConnectionFailed;
+        var attempt: u32 = 0;
+        while (attempt < max_retries) : (attempt += 1) {
+            const host_index = self.current_host_index.load(.monotonic);
+            var written = false;
+            if (self.sendOnce(self.hosts[host_index], method, path, payload, body_allocator, &written)) |response| {
+                return response;
+            } else |err| {
                 last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            req.send() catch |err| {
-                if (err == error.ConnectionResetByPeer) {
-                    if (self.logger) |log| {
-                        try log.warn("Connection reset during send, retrying... (attempt {d}/{d})", .{ retry_count + 1, max_retries });
-                    }
-                    last_error = err;
-                    if (self.tryNextHost()) continue :retry_loop;
-                    return err;
+                if (self.logger) |log| {
+                    log.warn("Proxmox API {s} {s} failed: {s} (attempt {d}/{d})", .{ @tagName(method), path, @errorName(err), attempt + 1, max_retries }) catch {};
                 }
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            // Chunked write to mitigate ConnectionResetByPeer on large bodies
-            const chunk_size: usize = 4 * 1024;
-            var offset: usize = 0;
-            while (offset < body.len) {
-                const end = @min(offset + chunk_size, body.len);
-                const slice = body[offset..end];
-                req.writeAll(slice) catch |err| {
-                    if (err == error.ConnectionResetByPeer) {
-                        if (self.logger) |log| {
-                            try log.warn("Connection reset during write, retrying... (attempt {d}/{d})", .{ retry_count + 1, max_retries });
-                        }
-                        last_error = err;
-                        if (self.tryNextHost()) continue :retry_loop;
-                        return err;
-                    }
-                    last_error = err;
-                    if (self.tryNextHost()) continue :retry_loop;
-                    return err;
-                };
-                offset = end;
-                // short pacing to avoid aggressive proxy resets
-                std.time.sleep(5 * std.time.ms_per_s / 1000 * std.time.ns_per_ms);
+                if (written and !isIdempotent(method)) return err;
+                // A pooled connection the server has since closed fails on first use; retry it
+                if (!self.tryNextHost(host_index) and !isStaleConnection(err)) return err;
             }
+        }
 
-            req.finish() catch |err| {
-                if (err == error.ConnectionResetByPeer) {
-                    if (self.logger) |log| {
-                        try log.warn("Connection reset during finish, retrying... (attempt {d}/{d})", .{ retry_count + 1, max_retries });
-                    }
-                    last_error = err;
-                    if (self.tryNextHost()) continue :retry_loop;
-                    return err;
-                }
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            req.wait() catch |err| {
-                if (err == error.ConnectionResetByPeer) {
-                    if (self.logger) |log| {
-                        try log.warn("Connection reset during wait, retrying... (attempt {d}/{d})", .{ retry_count + 1, max_retries });
-                    }
-                    last_error = err;
-                    if (self.tryNextHost()) continue :retry_loop;
-                    return err;
-                }
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-
-            const response_body = req.reader().readAllAlloc(self.allocator, std.math.maxInt(usize)) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
-            defer self.allocator.free(response_body);
-
-            const parsed = std.json.parseFromSlice(std.json.Value, self.allocator, response_body, .{}) catch |err| {
-                last_error = err;
-                if (self.tryNextHost()) continue :retry_loop;
-                return err;
-            };
+        return last_error;
+    }
 
-            return types.ProxmoxResponse{
-                .allocator = self.allocator,
-                .data = parsed.value,
-                .success = true,
-                .status_code = @intCast(req.response.status.code),
-            };
+    /// Sets `written` once the whole request has been handed to the connection
+    fn sendOnce(self: *Self, host: []const u8, method: std.http.Method, path: []const u8, payload: ?Payload, body_allocator: std.mem.Allocator, written: *bool) !RawResponse {
+        var url_buf: [2048]u8 = undefined;
+        const url = std.fmt.bufPrint(&url_buf, "{s}://{s}:{d}/api2/json{s}", .{ self.config.scheme, host, self.port, path }) catch
+            return types.ProxmoxApiError.InvalidConfiguration;
+        const uri = try std.Uri.parse(url);
+        const reuse = isIdempotent(method);
+        const http = if (reuse) &self.http else &self.oneshot_http;
+
+        var req = try http.request(method, uri, .{
+            .redirect_behavior = .unhandled,
+            .keep_alive = reuse,
+            .headers = .{
+                .authorization = .{ .override = self.auth_header },
+                .user_agent = .{ .override = USER_AGENT },
+                .accept_encoding = .omit,
+                .content_type = if (payload) |p| .{ .override = p.content_type } else .default,
+            },
+            .extra_headers = &.{.{ .name = "Accept", .value = "application/json" }},
+        });
+        defer req.deinit();
+
+        if (payload) |p| {
+            req.transfer_encoding = .{ .content_length = p.body.len };
+            var body_buffer: [4096]u8 = undefined;
+            var body_writer = try req.sendBody(&body_buffer);
+            try body_writer.writer.writeAll(p.body);
+            try body_writer.end();
+        } else {
+            try req.sendBodiless();
         }
+        written.* = true;
+
+        var redirect_buffer: [0]u8 = undefined;
+        var response = try req.receiveHead(&redirect_buffer);
+        // The head points into the connection buffer, which reading the body reuses
+        const status: u16 = @intFromEnum(response.head.status);
+        const reason = try body_allocator.dupe(u8, response.head.reason);
+        errdefer body_allocator.free(reason);
+
+        // Reading to the end hands the connection back to the pool
+        var transfer_buffer: [4096]u8 = undefined;
+        const body = try response.reader(&transfer_buffer).allocRemaining(body_allocator, .limited(MAX_RESPONSE_BYTES));
+        return .{ .status = status, .reason = reason, .body = body };
+    }
 
-        return last_error;
+    /// Safe to send again after it may have reached the server
+    fn isIdempotent(method: std.http.Method) bool {
+        return method == .GET or method == .HEAD;
     }
 
-    /// Try to switch to next host
-    fn tryNextHost(self: *Self) bool {
+    fn isStaleConnection(err: anyerror) bool {
+        return switch (err) {
+            error.ConnectionResetByPeer,
+            error.BrokenPipe,
+            error.EndOfStream,
+            error.ReadFailed,
+            error.WriteFailed,
+            error.HttpConnectionClosing,
+            => true,
+            else => false,
+        };
+    }
+
+    /// Try to switch to the host after `from`; false with a single host
+    fn tryNextHost(self: *Self, from: usize) bool {
         if (self.hosts.len <= 1) return false;
-        self.current_host_index = (self.current_host_index + 1) % self.hosts.len;
+        _ = self.current_host_index.cmpxchgStrong(from, (from + 1) % self.hosts.len, .monotonic, .monotonic);
         return true;
     }
 
@@ -303,3 +262,22 @@ pub const ProxmoxApiClient = struct {
         self.logger = logger;
     }
 };
+
+/// Percent-encode everything but RFC 3986 unreserved characters
+pub fn writeEscaped(writer: *std.Io.Writer, value: []const u8) !void {
+    for (value) |c| {
+        if (std.ascii.isAlphanumeric(c) or c == '-' or c == '.' or c == '_' or c == '~') {
+            try writer.writeByte(c);
+        } else {
+            try writer.print("%{X:0>2}", .{c});
+        }
+    }
+}
+
+/// Append `key=value` to an x-www-form-urlencoded body
+pub fn writeFormParam(writer: *std.Io.Writer, key: []const u8, value: []const u8) !void {
+    if (writer.end > 0) try writer.writeByte('&');
+    try writeEscaped(writer, key);
+    try writer.writeByte('=');
+    try writeEscaped(writer, value);
+}
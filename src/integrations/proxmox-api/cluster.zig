@@ -0,0 +1,66 @@
+const std = @import("std");
+const client = @import("client.zig");
+
+pub const GuestKind = enum { lxc, qemu };
+
+/// One guest as reported by /cluster/resources
+pub const Guest = struct {
+    vmid: u32,
+    kind: GuestKind,
+    name: []const u8,
+    node: []const u8,
+    status: []const u8,
+    template: bool = false,
+};
+
+/// Guests of every cluster node; strings live in the arena
+pub const GuestList = struct {
+    arena: std.heap.ArenaAllocator,
+    guests: []Guest,
+
+    pub fn deinit(self: *GuestList) void {
+        self.arena.deinit();
+    }
+};
+
+/// One /cluster/resources entry as sent; every other field is skipped
+const Resource = struct {
+    type: []const u8,
+    vmid: ?u32 = null,
+    name: ?[]const u8 = null,
+    node: ?[]const u8 = null,
+    status: ?[]const u8 = null,
+    template: ?u8 = null,
+};
+
+/// Every LXC and QEMU guest in the cluster, with status, in one request
+///
+/// pvestatd already gathers this on each node, so one GET against any node
+/// replaces a `pct list`/`qm list` per node. Guests are decoded straight
+/// from the body and their strings point into it.
+pub fn listGuests(api: *client.ProxmoxApiClient, allocator: std.mem.Allocator) !GuestList {
+    var list = GuestList{ .arena = std.heap.ArenaAllocator.init(allocator), .guests = &.{} };
+    errdefer list.deinit();
+    const arena = list.arena.allocator();
+
+    const resources = try api.get([]const Resource, arena, "/cluster/resources?type=vm");
+    list.guests = try guestsFrom(arena, resources);
+    return list;
+}
+
+/// Entries of other resource types or without a vmid are skipped
+fn guestsFrom(arena: std.mem.Allocator, resources: []const Resource) ![]Guest {
+    var guests = try std.ArrayListUnmanaged(Guest).initCapacity(arena, resources.len);
+    for (resources) |resource| {
+        const kind = std.meta.stringToEnum(GuestKind, resource.type) orelse continue;
+        guests.appendAssumeCapacity(.{
+            .vmid = resource.vmid orelse continue,
+            .kind = kind,
+            .name = resource.name orelse "",
+            .node = resource.node orelse "",
+            .status = resource.status orelse "unknown",
+            .template = (resource.template orelse 0) != 0,
+        });
+    }
+    return guests.items;
+}
@@ -5,3 +5,5 @@
 pub const types = @import("types.zig");
 pub const client = @import("client.zig");
 pub const operations = @import("operations.zig");
+pub const tasks = @import("tasks.zig");
+pub const cluster = @import("cluster.zig");
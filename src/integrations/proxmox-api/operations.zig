@@ -2,6 +2,7 @@ const std = @import("std");
 const core = @import("core");
 const types = @import("types.zig");
 const client = @import("client.zig");
+const tasks = @import("tasks.zig");
 
 /// Proxmox API operations
 /// Proxmox API operations manager
@@ -19,348 +20,270 @@ pub const ProxmoxApiOperations = struct {
     }
 
     /// List available templates
-    pub fn listTemplates(self: *Self) ![]types.ProxmoxTemplate {
-        const response = try self.api_client.makeRequest(.GET, "/nodes/{s}/storage/local/content?content=vztmpl");
-        defer response.deinit();
-
-        if (!response.success or response.data == null) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+    pub fn listTemplates(self: *Self) !std.json.Parsed([]types.ProxmoxTemplate) {
+        const Content = struct {
+            volid: []const u8,
+            format: ?[]const u8 = null,
+            size: u64 = 0,
+            ctime: i64 = 0,
+            notes: ?[]const u8 = null,
+        };
 
-        const data = response.data.?;
-        if (data.object.get("data")) |templates_array| {
-            if (templates_array.array) |templates| {
-                var result = try self.allocator.alloc(types.ProxmoxTemplate, templates.items.len);
-
-                for (templates.items, 0..) |template_value, i| {
-                    if (template_value.object) |template_obj| {
-                        result[i] = types.ProxmoxTemplate{
-                            .allocator = self.allocator,
-                            .volid = try self.allocator.dupe(u8, template_obj.get("volid").?.string.?),
-                            .format = try self.allocator.dupe(u8, template_obj.get("format").?.string orelse "unknown"),
-                            .size = template_obj.get("size").?.integer orelse 0,
-                            .ctime = template_obj.get("ctime").?.integer orelse 0,
-                            .description = if (template_obj.get("description")) |desc|
-                                try self.allocator.dupe(u8, desc.string.?)
-                            else
-                                null,
-                        };
-                    }
-                }
-
-                return result;
-            }
+        var result = try self.initResult([]types.ProxmoxTemplate);
+        errdefer result.deinit();
+        const arena = result.arena.allocator();
+
+        const path = try std.fmt.allocPrint(arena, "/nodes/{s}/storage/local/content?content=vztmpl", .{self.api_client.node});
+        const entries = try self.api_client.get([]const Content, arena, path);
+        result.value = try arena.alloc(types.ProxmoxTemplate, entries.len);
+        for (entries, result.value) |entry, *template| {
+            template.* = .{
+                .allocator = arena,
+                .volid = entry.volid,
+                .format = entry.format orelse "unknown",
+                .size = entry.size,
+                .ctime = entry.ctime,
+                .description = entry.notes,
+            };
         }
-
-        return try self.allocator.alloc(types.ProxmoxTemplate, 0);
+        return result;
     }
 
-    /// Create LXC container
+    /// Create LXC container and wait for its task
     pub fn createLxcContainer(self: *Self, config: types.ProxmoxLxcConfig) !void {
-        var params = std.ArrayList(u8).init(self.allocator);
-        defer params.deinit();
-
-        try params.appendSlice("vmid=");
-        try params.writer().print("{d}", .{config.vmid});
-        try params.appendSlice("&hostname=");
-        try params.appendSlice(config.hostname);
-        try params.appendSlice("&memory=");
-        try params.writer().print("{d}", .{config.memory});
-        try params.appendSlice("&cores=");
-        try params.writer().print("{d}", .{config.cores});
-        try params.appendSlice("&rootfs=");
-        try params.appendSlice(config.rootfs);
-        try params.appendSlice("&unprivileged=");
-        try params.appendSlice(if (config.unprivileged) "1" else "0");
-        try params.appendSlice("&onboot=");
-        try params.appendSlice(if (config.onboot) "1" else "0");
-        try params.appendSlice("&start=");
-        try params.appendSlice(if (config.start) "1" else "0");
-
-        if (config.net0) |net| {
-            try params.appendSlice("&net0=");
-            try params.appendSlice(net);
-        }
-
-        if (config.ostemplate) |ost| {
-            try params.appendSlice("&ostemplate=");
-            try params.appendSlice(ost);
-        }
-
-        if (config.password) |pass| {
-            try params.appendSlice("&password=");
-            try params.appendSlice(pass);
-        }
-
-        if (config.ssh_public_keys) |keys| {
-            try params.appendSlice("&ssh-public-keys=");
-            try params.appendSlice(keys);
-        }
+        var form = std.Io.Writer.Allocating.init(self.allocator);
+        defer form.deinit();
+        const w = &form.writer;
+
+        var num_buf: [32]u8 = undefined;
+        try client.writeFormParam(w, "vmid", try std.fmt.bufPrint(&num_buf, "{d}", .{config.vmid}));
+        try client.writeFormParam(w, "hostname", config.hostname);
+        try client.writeFormParam(w, "memory", try std.fmt.bufPrint(&num_buf, "{d}", .{config.memory}));
+        try client.writeFormParam(w, "cores", try std.fmt.bufPrint(&num_buf, "{d}", .{config.cores}));
+        try client.writeFormParam(w, "rootfs", config.rootfs);
+        try client.writeFormParam(w, "unprivileged", if (config.unprivileged) "1" else "0");
+        try client.writeFormParam(w, "onboot", if (config.onboot) "1" else "0");
+        try client.writeFormParam(w, "start", if (config.start) "1" else "0");
+        if (config.net0) |net| try client.writeFormParam(w, "net0", net);
+        if (config.ostemplate) |ost| try client.writeFormParam(w, "ostemplate", ost);
+        if (config.password) |pass| try client.writeFormParam(w, "password", pass);
+        if (config.ssh_public_keys) |keys| try client.writeFormParam(w, "ssh-public-keys", keys);
 
         const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/lxc", .{self.api_client.node});
         defer self.allocator.free(path);
 
-        const response = try self.api_client.makeRequestWithContentType(.POST, path, params.items, "application/x-www-form-urlencoded");
+        var response = try self.api_client.makeRequestWithContentType(.POST, path, form.written(), "application/x-www-form-urlencoded");
         defer response.deinit();
-
-        if (!response.success) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+        try self.awaitTask(&response, config.hostname);
     }
 
-    /// Create VM
+    /// Create VM and wait for its task
     pub fn createVm(self: *Self, config: types.ProxmoxVmConfig) !void {
-        var params = std.ArrayList(u8).init(self.allocator);
-        defer params.deinit();
-
-        try params.appendSlice("vmid=");
-        try params.writer().print("{d}", .{config.vmid});
-        try params.appendSlice("&name=");
-        try params.appendSlice(config.name);
-        try params.appendSlice("&memory=");
-        try params.writer().print("{d}", .{config.memory});
-        try params.appendSlice("&cores=");
-        try params.writer().print("{d}", .{config.cores});
-        try params.appendSlice("&sockets=");
-        try params.writer().print("{d}", .{config.sockets});
-        try params.appendSlice("&cpu=");
-        try params.appendSlice(config.cpu);
-        try params.appendSlice("&onboot=");
-        try params.appendSlice(if (config.onboot) "1" else "0");
-        try params.appendSlice("&start=");
-        try params.appendSlice(if (config.start) "1" else "0");
-
-        if (config.scsi0) |scsi| {
-            try params.appendSlice("&scsi0=");
-            try params.appendSlice(scsi);
-        }
-
-        if (config.ide0) |ide| {
-            try params.appendSlice("&ide0=");
-            try params.appendSlice(ide);
-        }
-
-        if (config.net0) |net| {
-            try params.appendSlice("&net0=");
-            try params.appendSlice(net);
-        }
-
-        if (config.bootdisk) |boot| {
-            try params.appendSlice("&bootdisk=");
-            try params.appendSlice(boot);
-        }
+        var form = std.Io.Writer.Allocating.init(self.allocator);
+        defer form.deinit();
+        const w = &form.writer;
+
+        var num_buf: [32]u8 = undefined;
+        try client.writeFormParam(w, "vmid", try std.fmt.bufPrint(&num_buf, "{d}", .{config.vmid}));
+        try client.writeFormParam(w, "name", config.name);
+        try client.writeFormParam(w, "memory", try std.fmt.bufPrint(&num_buf, "{d}", .{config.memory}));
+        try client.writeFormParam(w, "cores", try std.fmt.bufPrint(&num_buf, "{d}", .{config.cores}));
+        try client.writeFormParam(w, "sockets", try std.fmt.bufPrint(&num_buf, "{d}", .{config.sockets}));
+        try client.writeFormParam(w, "cpu", config.cpu);
+        try client.writeFormParam(w, "onboot", if (config.onboot) "1" else "0");
+        try client.writeFormParam(w, "start", if (config.start) "1" else "0");
+        if (config.scsi0) |scsi| try client.writeFormParam(w, "scsi0", scsi);
+        if (config.ide0) |ide| try client.writeFormParam(w, "ide0", ide);
+        if (config.net0) |net| try client.writeFormParam(w, "net0", net);
+        if (config.bootdisk) |boot| try client.writeFormParam(w, "bootdisk", boot);
 
         const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/qemu", .{self.api_client.node});
         defer self.allocator.free(path);
 
-        const response = try self.api_client.makeRequestWithContentType(.POST, path, params.items, "application/x-www-form-urlencoded");
+        var response = try self.api_client.makeRequestWithContentType(.POST, path, form.written(), "application/x-www-form-urlencoded");
         defer response.deinit();
-
-        if (!response.success) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+        try self.awaitTask(&response, config.name);
     }
 
-    /// Start container/VM
+    /// Start container/VM and wait for its task
     pub fn start(self: *Self, vmid: u32, is_lxc: bool) !void {
-        const path = if (is_lxc)
-            try std.fmt.allocPrint(self.allocator, "/nodes/{s}/lxc/{d}/status/start", .{ self.api_client.node, vmid })
-        else
-            try std.fmt.allocPrint(self.allocator, "/nodes/{s}/qemu/{d}/status/start", .{ self.api_client.node, vmid });
+        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/{s}/{d}/status/start", .{ self.api_client.node, guestKind(is_lxc), vmid });
         defer self.allocator.free(path);
 
-        const response = try self.api_client.makeRequest(.POST, path);
+        var response = try self.api_client.makeRequest(.POST, path);
         defer response.deinit();
-
-        if (!response.success) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+        try self.awaitTask(&response, "start");
     }
 
-    /// Stop container/VM
+    /// Stop container/VM and wait for its task
     pub fn stop(self: *Self, vmid: u32, is_lxc: bool) !void {
-        const path = if (is_lxc)
-            try std.fmt.allocPrint(self.allocator, "/nodes/{s}/lxc/{d}/status/stop", .{ self.api_client.node, vmid })
-        else
-            try std.fmt.allocPrint(self.allocator, "/nodes/{s}/qemu/{d}/status/stop", .{ self.api_client.node, vmid });
+        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/{s}/{d}/status/stop", .{ self.api_client.node, guestKind(is_lxc), vmid });
         defer self.allocator.free(path);
 
-        const response = try self.api_client.makeRequest(.POST, path);
+        var response = try self.api_client.makeRequest(.POST, path);
         defer response.deinit();
-
-        if (!response.success) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+        try self.awaitTask(&response, "stop");
     }
 
-    /// Delete container/VM
+    /// Delete container/VM and wait for its task
     pub fn delete(self: *Self, vmid: u32, is_lxc: bool) !void {
-        const path = if (is_lxc)
-            try std.fmt.allocPrint(self.allocator, "/nodes/{s}/lxc/{d}", .{ self.api_client.node, vmid })
-        else
-            try std.fmt.allocPrint(self.allocator, "/nodes/{s}/qemu/{d}", .{ self.api_client.node, vmid });
+        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/{s}/{d}", .{ self.api_client.node, guestKind(is_lxc), vmid });
         defer self.allocator.free(path);
 
-        const response = try self.api_client.makeRequest(.DELETE, path);
+        var response = try self.api_client.makeRequest(.DELETE, path);
         defer response.deinit();
-
-        if (!response.success) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+        try self.awaitTask(&response, "delete");
     }
 
-    /// List containers
-    pub fn listContainers(self: *Self) ![]types.ProxmoxLxcConfig {
-        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/lxc", .{self.api_client.node});
-        defer self.allocator.free(path);
-
-        const response = try self.api_client.makeRequest(.GET, path);
-        defer response.deinit();
-
-        if (!response.success or response.data == null) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+    fn guestKind(is_lxc: bool) []const u8 {
+        return if (is_lxc) "lxc" else "qemu";
+    }
 
-        const data = response.data.?;
-        if (data.object.get("data")) |containers_array| {
-            if (containers_array.array) |containers| {
-                var result = try self.allocator.alloc(types.ProxmoxLxcConfig, containers.items.len);
-
-                for (containers.items, 0..) |container_value, i| {
-                    if (container_value.object) |container_obj| {
-                        result[i] = types.ProxmoxLxcConfig{
-                            .allocator = self.allocator,
-                            .vmid = @intCast(container_obj.get("vmid").?.integer.?),
-                            .hostname = try self.allocator.dupe(u8, container_obj.get("hostname").?.string.?),
-                            .memory = container_obj.get("maxmem").?.integer orelse 512,
-                            .cores = @intCast(container_obj.get("cpus").?.integer orelse 1),
-                            .rootfs = try self.allocator.dupe(u8, container_obj.get("rootfs").?.string.?),
-                            .unprivileged = container_obj.get("unprivileged").?.bool orelse true,
-                            .onboot = container_obj.get("onboot").?.bool orelse false,
-                            .start = container_obj.get("status").?.string.?.eql("running"),
-                        };
-                    }
-                }
-
-                return result;
-            }
-        }
+    /// Wait for the worker task a call started; calls that finish inline return no UPID
+    fn awaitTask(self: *Self, response: *const types.ProxmoxResponse, label: []const u8) !void {
+        if (!response.success) return types.ProxmoxApiError.OperationFailed;
+        const upid = tasks.responseUpid(response) orelse return;
 
-        return try self.allocator.alloc(types.ProxmoxLxcConfig, 0);
+        var tracker = tasks.TaskTracker.init(self.allocator, self.api_client, .{});
+        defer tracker.deinit();
+        try tracker.track(upid, label);
+        tracker.wait(null, null);
+        if (!tracker.allOk()) return types.ProxmoxApiError.OperationFailed;
     }
 
-    /// List VMs
-    pub fn listVms(self: *Self) ![]types.ProxmoxVmConfig {
-        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/qemu", .{self.api_client.node});
-        defer self.allocator.free(path);
+    /// Typed results share one arena with the response they were decoded
+    /// from; free them with `deinit` on the result, not per item
+    fn initResult(self: *Self, comptime T: type) !std.json.Parsed(T) {
+        const arena = try self.allocator.create(std.heap.ArenaAllocator);
+        arena.* = std.heap.ArenaAllocator.init(self.allocator);
+        return .{ .arena = arena, .value = undefined };
+    }
 
-        const response = try self.api_client.makeRequest(.GET, path);
-        defer response.deinit();
+    /// Guest as listed under /nodes/{node}/lxc or /nodes/{node}/qemu
+    const GuestEntry = struct {
+        vmid: u32,
+        name: ?[]const u8 = null,
+        status: []const u8 = "unknown",
+        maxmem: u64 = 0,
+        cpus: u32 = 1,
+    };
 
-        if (!response.success or response.data == null) {
-            return types.ProxmoxApiError.OperationFailed;
+    /// List containers
+    pub fn listContainers(self: *Self) !std.json.Parsed([]types.ProxmoxLxcConfig) {
+        var result = try self.initResult([]types.ProxmoxLxcConfig);
+        errdefer result.deinit();
+        const arena = result.arena.allocator();
+
+        const path = try std.fmt.allocPrint(arena, "/nodes/{s}/lxc", .{self.api_client.node});
+        const entries = try self.api_client.get([]const GuestEntry, arena, path);
+        result.value = try arena.alloc(types.ProxmoxLxcConfig, entries.len);
+        for (entries, result.value) |entry, *container| {
+            container.* = .{
+                .allocator = arena,
+                .vmid = entry.vmid,
+                .hostname = entry.name orelse "",
+                .memory = entry.maxmem / (1024 * 1024),
+                .cores = entry.cpus,
+                .rootfs = "",
+                .start = std.mem.eql(u8, entry.status, "running"),
+            };
         }
+        return result;
+    }
 
-        const data = response.data.?;
-        if (data.object.get("data")) |vms_array| {
-            if (vms_array.array) |vms| {
-                var result = try self.allocator.alloc(types.ProxmoxVmConfig, vms.items.len);
-
-                for (vms.items, 0..) |vm_value, i| {
-                    if (vm_value.object) |vm_obj| {
-                        result[i] = types.ProxmoxVmConfig{
-                            .allocator = self.allocator,
-                            .vmid = @intCast(vm_obj.get("vmid").?.integer.?),
-                            .name = try self.allocator.dupe(u8, vm_obj.get("name").?.string.?),
-                            .memory = vm_obj.get("maxmem").?.integer orelse 1024,
-                            .cores = @intCast(vm_obj.get("cpus").?.integer orelse 1),
-                            .sockets = @intCast(vm_obj.get("sockets").?.integer orelse 1),
-                            .cpu = try self.allocator.dupe(u8, vm_obj.get("cpu").?.string.?),
-                            .onboot = vm_obj.get("onboot").?.bool orelse false,
-                            .start = vm_obj.get("status").?.string.?.eql("running"),
-                        };
-                    }
-                }
-
-                return result;
-            }
+    /// List VMs
+    pub fn listVms(self: *Self) !std.json.Parsed([]types.ProxmoxVmConfig) {
+        var result = try self.initResult([]types.ProxmoxVmConfig);
+        errdefer result.deinit();
+        const arena = result.arena.allocator();
+
+        const path = try std.fmt.allocPrint(arena, "/nodes/{s}/qemu", .{self.api_client.node});
+        const entries = try self.api_client.get([]const GuestEntry, arena, path);
+        result.value = try arena.alloc(types.ProxmoxVmConfig, entries.len);
+        for (entries, result.value) |entry, *vm| {
+            vm.* = .{
+                .allocator = arena,
+                .vmid = entry.vmid,
+                .name = entry.name orelse "",
+                .memory = entry.maxmem / (1024 * 1024),
+                .cores = entry.cpus,
+                .start = std.mem.eql(u8, entry.status, "running"),
+            };
         }
-
-        return try self.allocator.alloc(types.ProxmoxVmConfig, 0);
+        return result;
     }
 
     /// Get node information
-    pub fn getNodeInfo(self: *Self) !types.ProxmoxNode {
-        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/status", .{self.api_client.node});
-        defer self.allocator.free(path);
-
-        const response = try self.api_client.makeRequest(.GET, path);
-        defer response.deinit();
-
-        if (!response.success or response.data == null) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+    pub fn getNodeInfo(self: *Self) !std.json.Parsed(types.ProxmoxNode) {
+        // /nodes carries the same fields as ProxmoxNode, for every node at once
+        const NodeEntry = struct {
+            node: []const u8,
+            status: []const u8 = "unknown",
+            cpu: f64 = 0,
+            maxcpu: u32 = 0,
+            mem: u64 = 0,
+            maxmem: u64 = 0,
+            uptime: u64 = 0,
+            level: ?[]const u8 = null,
+        };
 
-        const data = response.data.?;
-        if (data.object.get("data")) |node_data| {
-            if (node_data.object) |node_obj| {
-                return types.ProxmoxNode{
-                    .allocator = self.allocator,
-                    .node = try self.allocator.dupe(u8, self.api_client.node),
-                    .status = try self.allocator.dupe(u8, node_obj.get("status").?.string.?),
-                    .cpu = node_obj.get("cpu").?.float.?,
-                    .maxcpu = @intCast(node_obj.get("maxcpu").?.integer.?),
-                    .mem = node_obj.get("mem").?.integer.?,
-                    .maxmem = node_obj.get("maxmem").?.integer.?,
-                    .uptime = node_obj.get("uptime").?.integer.?,
-                    .level = if (node_obj.get("level")) |level|
-                        try self.allocator.dupe(u8, level.string.?)
-                    else
-                        null,
-                };
-            }
+        var result = try self.initResult(types.ProxmoxNode);
+        errdefer result.deinit();
+        const arena = result.arena.allocator();
+
+        const entries = try self.api_client.get([]const NodeEntry, arena, "/nodes");
+        for (entries) |entry| {
+            if (!std.mem.eql(u8, entry.node, self.api_client.node)) continue;
+            result.value = .{
+                .allocator = arena,
+                .node = entry.node,
+                .status = entry.status,
+                .cpu = entry.cpu,
+                .maxcpu = entry.maxcpu,
+                .mem = entry.mem,
+                .maxmem = entry.maxmem,
+                .uptime = entry.uptime,
+                .level = entry.level,
+            };
+            return result;
         }
-
-        return types.ProxmoxApiError.OperationFailed;
+        return types.ProxmoxApiError.ResourceNotFound;
     }
 
     /// List storage
-    pub fn listStorage(self: *Self) ![]types.ProxmoxStorage {
-        const path = try std.fmt.allocPrint(self.allocator, "/nodes/{s}/storage", .{self.api_client.node});
-        defer self.allocator.free(path);
-
-        const response = try self.api_client.makeRequest(.GET, path);
-        defer response.deinit();
-
-        if (!response.success or response.data == null) {
-            return types.ProxmoxApiError.OperationFailed;
-        }
+    pub fn listStorage(self: *Self) !std.json.Parsed([]types.ProxmoxStorage) {
+        // Booleans arrive as 0/1
+        const StorageEntry = struct {
+            storage: []const u8,
+            type: []const u8 = "",
+            content: []const u8 = "",
+            shared: u8 = 0,
+            enabled: u8 = 1,
+            used: ?u64 = null,
+            avail: ?u64 = null,
+            total: ?u64 = null,
+        };
 
-        const data = response.data.?;
-        if (data.object.get("data")) |storage_array| {
-            if (storage_array.array) |storage_list| {
-                var result = try self.allocator.alloc(types.ProxmoxStorage, storage_list.items.len);
-
-                for (storage_list.items, 0..) |storage_value, i| {
-                    if (storage_value.object) |storage_obj| {
-                        result[i] = types.ProxmoxStorage{
-                            .allocator = self.allocator,
-                            .storage = try self.allocator.dupe(u8, storage_obj.get("storage").?.string.?),
-                            .type = try self.allocator.dupe(u8, storage_obj.get("type").?.string.?),
-                            .content = try self.allocator.dupe(u8, storage_obj.get("content").?.string.?),
-                            .shared = storage_obj.get("shared").?.bool orelse false,
-                            .enabled = storage_obj.get("enabled").?.bool orelse true,
-                            .used = if (storage_obj.get("used")) |used| @intCast(used.integer.?) else null,
-                            .avail = if (storage_obj.get("avail")) |avail| @intCast(avail.integer.?) else null,
-                            .total = if (storage_obj.get("total")) |total| @intCast(total.integer.?) else null,
-                        };
-                    }
-                }
-
-                return result;
-            }
+        var result = try self.initResult([]types.ProxmoxStorage);
+        errdefer result.deinit();
+        const arena = result.arena.allocator();
+
+        const path = try std.fmt.allocPrint(arena, "/nodes/{s}/storage", .{self.api_client.node});
+        const entries = try self.api_client.get([]const StorageEntry, arena, path);
+        result.value = try arena.alloc(types.ProxmoxStorage, entries.len);
+        for (entries, result.value) |entry, *storage| {
+            storage.* = .{
+                .allocator = arena,
+                .storage = entry.storage,
+                .type = entry.type,
+                .content = entry.content,
+                .shared = entry.shared != 0,
+                .enabled = entry.enabled != 0,
+                .used = entry.used,
+                .avail = entry.avail,
+                .total = entry.total,
+            };
         }
-
-        return try self.allocator.alloc(types.ProxmoxStorage, 0);
+        return result;
     }
 };
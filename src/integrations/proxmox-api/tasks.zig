@@ -0,0 +1,143 @@
+const std = @import("std");
+const types = @import("types.zig");
+const client = @import("client.zig");
+
+pub const Options = struct {
+    /// First wait before re-polling a running task; doubles up to `max_interval_ms`
+    initial_interval_ms: u32 = 100,
+    max_interval_ms: u32 = 2000,
+    /// Tasks still running after this are reported as timed out
+    timeout_ms: u32 = 10 * 60 * 1000,
+};
+
+pub const Outcome = enum { pending, ok, failed, timed_out };
+
+pub const Task = struct {
+    upid: []const u8,
+    /// Caller's name for the task, e.g. the container id; not owned
+    label: []const u8,
+    outcome: Outcome = .pending,
+    /// Proxmox `exitstatus`: "OK" or the error line
+    exit_status: ?[]const u8 = null,
+    interval_ms: u32,
+    next_poll_ms: i64,
+};
+
+/// Called once per task as it completes
+pub const DoneFn = *const fn (ctx: ?*anyopaque, task: *const Task) void;
+
+/// Waits on many Proxmox worker tasks (UPIDs) at once
+///
+/// One loop polls every task that is due and then sleeps until the next
+/// one is, so N operations in flight cost N cheap status GETs over the
+/// client's keep-alive connection rather than N waiting threads.
+pub const TaskTracker = struct {
+    const Self = @This();
+
+    allocator: std.mem.Allocator,
+    api: *client.ProxmoxApiClient,
+    options: Options,
+    tasks: std.ArrayListUnmanaged(Task) = .{},
+
+    pub fn init(allocator: std.mem.Allocator, api: *client.ProxmoxApiClient, options: Options) Self {
+        return Self{ .allocator = allocator, .api = api, .options = options };
+    }
+
+    pub fn deinit(self: *Self) void {
+        for (self.tasks.items) |task| {
+            self.allocator.free(task.upid);
+            if (task.exit_status) |status| self.allocator.free(status);
+        }
+        self.tasks.deinit(self.allocator);
+    }
+
+    /// Start tracking `upid`
+    pub fn track(self: *Self, upid: []const u8, label: []const u8) !void {
+        if (upidNode(upid) == null) return types.ProxmoxApiError.InvalidResponse;
+        const owned = try self.allocator.dupe(u8, upid);
+        errdefer self.allocator.free(owned);
+        try self.tasks.append(self.allocator, .{
+            .upid = owned,
+            .label = label,
+            .interval_ms = self.options.initial_interval_ms,
+            .next_poll_ms = std.time.milliTimestamp() + self.options.initial_interval_ms,
+        });
+    }
+
+    /// Poll until every tracked task has finished or timed out
+    pub fn wait(self: *Self, ctx: ?*anyopaque, on_done: ?DoneFn) void {
+        const deadline = std.time.milliTimestamp() + self.options.timeout_ms;
+        while (true) {
+            var now = std.time.milliTimestamp();
+            var next_due: ?i64 = null;
+            for (self.tasks.items) |*task| {
+                if (task.outcome != .pending) continue;
+                if (task.next_poll_ms <= now) {
+                    // A failed poll is retried with backoff until the deadline
+                    self.poll(task) catch |err| {
+                        if (self.api.logger) |log| log.warn("Polling task {s} failed: {}", .{ task.upid, err }) catch {};
+                    };
+                    now = std.time.milliTimestamp();
+                    if (task.outcome == .pending and now >= deadline) task.outcome = .timed_out;
+                    if (task.outcome != .pending) {
+                        if (on_done) |done| done(ctx, task);
+                        continue;
+                    }
+                    task.interval_ms = @min(task.interval_ms * 2, self.options.max_interval_ms);
+                    task.next_poll_ms = now + task.interval_ms;
+                }
+                next_due = if (next_due) |due| @min(due, task.next_poll_ms) else task.next_poll_ms;
+            }
+            const due = next_due orelse return;
+            if (due > now) std.Thread.sleep(@as(u64, @intCast(due - now)) * std.time.ns_per_ms);
+        }
+    }
+
+    /// Whether every task finished with exit status OK
+    pub fn allOk(self: *const Self) bool {
+        for (self.tasks.items) |task| {
+            if (task.outcome != .ok) return false;
+        }
+        return true;
+    }
+
+    const TaskStatus = struct {
+        status: []const u8,
+        exitstatus: ?[]const u8 = null,
+    };
+
+    fn poll(self: *Self, task: *Task) !void {
+        var path_buf: [512]u8 = undefined;
+        var path_writer = std.Io.Writer.fixed(&path_buf);
+        path_writer.print("/nodes/{s}/tasks/", .{upidNode(task.upid).?}) catch return types.ProxmoxApiError.InvalidResponse;
+        client.writeEscaped(&path_writer, task.upid) catch return types.ProxmoxApiError.InvalidResponse;
+        path_writer.writeAll("/status") catch return types.ProxmoxApiError.InvalidResponse;
+
+        var arena = std.heap.ArenaAllocator.init(self.allocator);
+        defer arena.deinit();
+        const status = try self.api.get(TaskStatus, arena.allocator(), path_writer.buffered());
+        if (!std.mem.eql(u8, status.status, "stopped")) return;
+
+        const exit_status = status.exitstatus orelse "unknown";
+        task.exit_status = try self.allocator.dupe(u8, exit_status);
+        task.outcome = if (std.mem.eql(u8, exit_status, "OK")) .ok else .failed;
+    }
+};
+
+/// Node that runs the task, from "UPID:<node>:<pid>:..."
+pub fn upidNode(upid: []const u8) ?[]const u8 {
+    var fields = std.mem.splitScalar(u8, upid, ':');
+    const tag = fields.next() orelse return null;
+    if (!std.mem.eql(u8, tag, "UPID")) return null;
+    const node = fields.next() orelse return null;
+    return if (node.len == 0) null else node;
+}
+
+/// UPID a lifecycle call returned, if it started a worker task
+pub fn responseUpid(response: *const types.ProxmoxResponse) ?[]const u8 {
+    const data = response.data orelse return null;
+    if (data != .object) return null;
+    const value = data.object.get("data") orelse return null;
+    if (value != .string or upidNode(value.string) == null) return null;
+    return value.string;
+}
@@ -8,8 +8,14 @@ pub const ProxmoxApiConfig = struct {
     port: u16 = 8006,
     token: []const u8,
     node: []const u8,
+    /// "https" against Proxmox; "http" only reaches local test stubs
+    scheme: []const u8 = "https",
     verify_ssl: bool = false,
     timeout: ?u64 = null,
+    /// Requests allowed in flight at once; the rest wait
+    max_in_flight: usize = 16,
+    /// Idle keep-alive connections kept open
+    max_idle_connections: u32 = 8,
 
     pub fn deinit(self: *ProxmoxApiConfig) void {
         self.allocator.free(self.host);
@@ -21,14 +27,17 @@ pub const ProxmoxApiConfig = struct {
 /// Proxmox API response
 pub const ProxmoxResponse = struct {
     allocator: std.mem.Allocator,
+    /// Owns `data`
+    parsed: ?std.json.Parsed(std.json.Value) = null,
     data: ?std.json.Value = null,
     success: bool = false,
+    /// Error text of a failed call: the body's `message` or the HTTP reason phrase
     message: ?[]const u8 = null,
     status_code: u16 = 0,
 
     pub fn deinit(self: *ProxmoxResponse) void {
-        if (self.data) |d| {
-            d.deinit();
+        if (self.parsed) |p| {
+            p.deinit();
         }
         if (self.message) |m| {
             self.allocator.free(m);
@@ -5,6 +5,14 @@ const backends = @import("backends");
 const integrations = @import("integrations");
 const utils = @import("utils");
 
+/// Queued log records are written out before the default panic handler runs
+pub const panic = std.debug.FullPanic(panicWithLogFlush);
+
+fn panicWithLogFlush(msg: []const u8, first_trace_addr: ?usize) noreturn {
+    core.async_log.flushAll();
+    std.debug.defaultPanic(msg, first_trace_addr);
+}
+
 /// Main entry point for the modular architecture
 /// Application context
 pub const AppContext = struct {
@@ -90,6 +98,14 @@ pub fn main() !void {
     const args = try std.process.argsAlloc(allocator);
     defer std.process.argsFree(allocator, args);
 
+    // Hand the command to a running daemon before paying for config and registry setup
+    if (args.len >= 2 and !runsInProcess(splitCommandLine(args[1..]).name)) {
+        if (try cli.daemon.forward(allocator, args[1..])) |exit_code| {
+            if (exit_code != 0) std.process.exit(exit_code);
+            return;
+        }
+    }
+
     // Initialize application context with command line arguments
     var app = try AppContext.init(allocator, args);
     defer app.deinit();
@@ -105,12 +121,32 @@ pub fn main() !void {
         return;
     }
 
-    // Find the actual command (skip flags)
-    var command_name = args[1];
-    var command_args = args[2..];
-    
-    // Skip debug/verbose flags to find the actual command
-    var i: usize = 1;
+    const command_line = splitCommandLine(args[1..]);
+    if (std.mem.eql(u8, command_line.name, "daemon")) {
+        return runDaemon(&app);
+    }
+    if (std.mem.eql(u8, command_line.name, "warm-pool")) {
+        return runWarmPoolRefill(&app, allocator, command_line.args);
+    }
+
+    try executeCommandLine(&app, allocator, args[1..]);
+}
+
+/// The daemon itself and background refills are never forwarded: a refill
+/// would hold the daemon for the whole pct create
+fn runsInProcess(name: []const u8) bool {
+    return std.mem.eql(u8, name, "daemon") or std.mem.eql(u8, name, "warm-pool");
+}
+
+/// Command name and its arguments
+const CommandLine = struct {
+    name: []const u8,
+    args: []const []const u8,
+};
+
+/// Find the actual command, skipping global debug/logging flags
+fn splitCommandLine(args: []const []const u8) CommandLine {
+    var i: usize = 0;
     while (i < args.len) {
         if (std.mem.eql(u8, args[i], "--debug") or std.mem.eql(u8, args[i], "--verbose")) {
             i += 1;
@@ -124,12 +160,70 @@ pub fn main() !void {
             i += 2; // Skip --log-level and its value
             continue;
         }
+        if ((std.mem.eql(u8, args[i], "--trace") or std.mem.eql(u8, args[i], "--trace-format")) and i + 1 < args.len) {
+            i += 2; // Skip tracing flags and their values
+            continue;
+        }
         // Found the actual command
-        command_name = args[i];
-        command_args = args[i + 1..];
-        break;
+        return .{ .name = args[i], .args = args[i + 1 ..] };
     }
-    
+    return .{ .name = args[0], .args = args[1..] };
+}
+
+/// `--trace <file>` and `--trace-format chrome|otlp` from the global flags
+const TraceRequest = struct {
+    path: []const u8,
+    format: core.tracing.Format = .chrome,
+};
+
+fn parseTraceRequest(args: []const []const u8) !?TraceRequest {
+    var request: ?TraceRequest = null;
+    var format: core.tracing.Format = .chrome;
+    var i: usize = 0;
+    while (i + 1 < args.len) : (i += 1) {
+        if (std.mem.eql(u8, args[i], "--trace")) {
+            request = .{ .path = args[i + 1] };
+            i += 1;
+        } else if (std.mem.eql(u8, args[i], "--trace-format")) {
+            format = core.tracing.Format.parse(args[i + 1]) orelse return core.Error.InvalidInput;
+            i += 1;
+        } else if (!std.mem.startsWith(u8, args[i], "-")) {
+            break; // Global flags end at the command
+        }
+    }
+    if (request) |*r| r.format = format;
+    return request;
+}
+
+/// Execute one command line (without argv[0]); shared by main and the daemon
+fn executeCommandLine(app: *AppContext, allocator: std.mem.Allocator, args: []const []const u8) !void {
+    const trace_request = parseTraceRequest(args) catch |err| {
+        try app.logger.err("Invalid --trace-format; expected chrome or otlp", .{});
+        return err;
+    };
+    if (trace_request) |request| {
+        var tracer = try core.tracing.Tracer.init(allocator);
+        defer tracer.deinit();
+        core.tracing.install(&tracer);
+        defer core.tracing.install(null);
+
+        const result = executeTracedCommandLine(app, allocator, args);
+        // Failed runs are the interesting ones, so the trace is written either way
+        tracer.writeFile(request.path, request.format) catch |err| {
+            app.logger.warn("Failed to write trace to {s}: {}", .{ request.path, err }) catch {};
+        };
+        return result;
+    }
+    return executeTracedCommandLine(app, allocator, args);
+}
+
+fn executeTracedCommandLine(app: *AppContext, allocator: std.mem.Allocator, args: []const []const u8) !void {
+    const command_line = splitCommandLine(args);
+    const span = core.tracing.begin(command_line.name);
+    defer span.end();
+    const command_name = command_line.name;
+    const command_args = command_line.args;
+
     // Log command execution start - safely handle logger errors
     if (app.advanced_logger) |*logger| {
         logger.logCommandStart(command_name, command_args) catch {};
@@ -147,6 +241,8 @@ pub fn main() !void {
         try app.logger.info("  list      List containers", .{});
         try app.logger.info("  kill      Send a signal to a container", .{});
         try app.logger.info("  run       Run a command in a container", .{});
+        try app.logger.info("  daemon    Serve commands over a Unix socket", .{});
+        try app.logger.info("  metrics   Show runtime metrics", .{});
         try app.logger.info("  help      Show this help message", .{});
         try app.logger.info("  version   Show version information", .{});
         try app.logger.info("", .{});
@@ -183,6 +279,35 @@ pub fn main() !void {
     }
 }
 
+/// Run as a long-lived daemon, keeping config, registry and inventory warm
+fn runDaemon(app: *AppContext) !void {
+    var inventory = backends.proxmox_lxc.inventory.ContainerInventory.init(app.allocator, &app.logger);
+    defer inventory.deinit();
+
+    cli.router.setSharedState(.{ .app_config = &app.config, .inventory = &inventory });
+    defer cli.router.setSharedState(null);
+
+    var server = cli.daemon.Server.init(app.allocator, &app.logger, cli.daemon.socketPath(), app, handleDaemonRequest);
+    defer server.deinit();
+    try server.serve();
+}
+
+/// Hidden `warm-pool refill <template> <container-id>`, spawned by create
+fn runWarmPoolRefill(app: *AppContext, allocator: std.mem.Allocator, args: []const []const u8) !void {
+    if (args.len != 3 or !std.mem.eql(u8, args[0], "refill")) {
+        try app.logger.err("Usage: warm-pool refill <template> <container-id>", .{});
+        return core.Error.InvalidInput;
+    }
+    var router = cli.router.BackendRouter.init(allocator, &app.logger);
+    try router.routeWithConfig(&app.config, .{ .refill_warm_pool = .{ .template = args[1] } }, args[2], null);
+}
+
+fn handleDaemonRequest(ctx: *anyopaque, allocator: std.mem.Allocator, args: []const []const u8) anyerror!void {
+    const app: *AppContext = @ptrCast(@alignCast(ctx));
+    if (args.len == 0) return core.Error.InvalidInput;
+    try executeCommandLine(app, allocator, args);
+}
+
 /// Parse runtime options from command line arguments
 fn parseRuntimeOptions(allocator: std.mem.Allocator, command_name: []const u8, args: []const []const u8, config: *core.Config) !core.RuntimeOptions {
     var options = core.RuntimeOptions{
@@ -242,6 +367,13 @@ fn parseRuntimeOptions(allocator: std.mem.Allocator, command_name: []const u8, a
         } else if (std.mem.eql(u8, arg, "--workdir") and i + 1 < args.len) {
             options.workdir = try allocator.dupe(u8, args[i + 1]);
             i += 2;
+        } else if (std.mem.eql(u8, arg, "--batch") and i + 1 < args.len) {
+            options.batch_file = try allocator.dupe(u8, args[i + 1]);
+            i += 2;
+        } else if (std.mem.eql(u8, arg, "--parallel") and i + 1 < args.len) {
+            options.parallel = std.fmt.parseInt(u32, args[i + 1], 10) catch 1;
+            if (options.parallel == 0) options.parallel = 1;
+            i += 2;
         } else if (!std.mem.startsWith(u8, arg, "-")) {
             // This is likely the image name, container ID, or command
             if (options.command == .start or options.command == .stop or options.command == .delete or options.command == .state or options.command == .kill) {
@@ -287,6 +419,7 @@ fn parseCommand(command_str: []const u8) core.Command {
     if (std.mem.eql(u8, command_str, "version")) return .version;
     if (std.mem.eql(u8, command_str, "state")) return .state;
     if (std.mem.eql(u8, command_str, "kill")) return .kill;
+    if (std.mem.eql(u8, command_str, "metrics")) return .metrics;
     return .help; // Default to help
 }
 
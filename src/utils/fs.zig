@@ -318,3 +318,8 @@ pub const DefaultFSOperations = struct {
         return entries.toOwnedSlice();
     }
 };
+
+/// Run a command through the core executor; caller frees stdout and stderr
+pub fn runCommand(allocator: std.mem.Allocator, argv: []const []const u8, options: core.exec.Options) !core.exec.Result {
+    return core.exec.run(allocator, argv, options);
+}
@@ -0,0 +1,298 @@
+const std = @import("std");
+const testing = std.testing;
+const core = @import("core");
+const integrations = @import("integrations");
+const api_lifecycle = @import("api_lifecycle.zig");
+
+test "pct create maps onto POST /nodes/{node}/lxc" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectCreateForm() else return error.SkipZigTest;
+}
+
+fn expectCreateForm() !void {
+    const argv = [_][]const u8{ "pct", "create", "101", "local:vztmpl/ubuntu.tar.zst", "--hostname", "web-1", "--net0", "name=eth0,bridge=vmbr0" };
+    var call = (try api_lifecycle.translate(testing.allocator, "pve1", &argv)).?;
+    defer call.deinit();
+
+    try testing.expectEqual(std.http.Method.POST, call.method);
+    try testing.expectEqualStrings("/nodes/pve1/lxc", call.path);
+    try testing.expectEqualStrings("vmid=101&ostemplate=local%3Avztmpl%2Fubuntu.tar.zst&hostname=web-1&net0=name%3Deth0%2Cbridge%3Dvmbr0", call.form);
+}
+
+test "lifecycle verbs map onto their endpoints" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectEndpoints() else return error.SkipZigTest;
+}
+
+fn expectEndpoints() !void {
+    {
+        var call = (try api_lifecycle.translate(testing.allocator, "pve1", &.{ "pct", "start", "101" })).?;
+        defer call.deinit();
+        try testing.expectEqualStrings("/nodes/pve1/lxc/101/status/start", call.path);
+        try testing.expectEqualStrings("", call.form);
+    }
+    {
+        var call = (try api_lifecycle.translate(testing.allocator, "pve1", &.{ "pct", "destroy", "101", "--purge" })).?;
+        defer call.deinit();
+        try testing.expectEqual(std.http.Method.DELETE, call.method);
+        try testing.expectEqualStrings("/nodes/pve1/lxc/101?purge=1", call.path);
+    }
+    {
+        var call = (try api_lifecycle.translate(testing.allocator, "pve1", &.{ "pct", "clone", "900", "101", "--hostname", "web-1" })).?;
+        defer call.deinit();
+        try testing.expectEqualStrings("/nodes/pve1/lxc/900/clone", call.path);
+        try testing.expectEqualStrings("newid=101&hostname=web-1", call.form);
+    }
+    {
+        var call = (try api_lifecycle.translate(testing.allocator, "pve1", &.{ "pct", "set", "101", "--hostname", "web-2" })).?;
+        defer call.deinit();
+        try testing.expectEqual(std.http.Method.PUT, call.method);
+        try testing.expectEqualStrings("/nodes/pve1/lxc/101/config", call.path);
+    }
+}
+
+test "verbs without a REST equivalent stay on pct" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectUntranslated() else return error.SkipZigTest;
+}
+
+fn expectUntranslated() !void {
+    try testing.expect((try api_lifecycle.translate(testing.allocator, "pve1", &.{ "pct", "exec", "101", "--", "ls" })) == null);
+    try testing.expect((try api_lifecycle.translate(testing.allocator, "pve1", &.{ "zfs", "list" })) == null);
+    try testing.expectError(error.InvalidInput, api_lifecycle.translate(testing.allocator, "pve1", &.{ "pct", "start", "../101" }));
+}
+
+/// Answers one plain-HTTP request with a canned reply
+const Stub = struct {
+    server: std.net.Server,
+    reply: []const u8,
+    request: [4096]u8 = undefined,
+    request_len: usize = 0,
+
+    fn serve(self: *Stub) void {
+        const conn = self.server.accept() catch return;
+        defer conn.stream.close();
+        while (self.request_len < self.request.len) {
+            const n = conn.stream.read(self.request[self.request_len..]) catch return;
+            if (n == 0) return;
+            self.request_len += n;
+            if (requestComplete(self.request[0..self.request_len])) break;
+        }
+        conn.stream.writeAll(self.reply) catch {};
+    }
+
+    fn requestComplete(data: []const u8) bool {
+        const head_end = std.mem.indexOf(u8, data, "\r\n\r\n") orelse return false;
+        var lower_buf: [4096]u8 = undefined;
+        const head = std.ascii.lowerString(&lower_buf, data[0..head_end]);
+        const marker = "content-length: ";
+        const at = std.mem.indexOf(u8, head, marker) orelse return true;
+        const rest = head[at + marker.len ..];
+        const len = std.fmt.parseInt(usize, rest[0 .. std.mem.indexOf(u8, rest, "\r\n") orelse rest.len], 10) catch return true;
+        return data.len >= head_end + 4 + len;
+    }
+};
+
+test "API failures keep Proxmox's error text for mapPctError" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectErrorText() else return error.SkipZigTest;
+}
+
+fn expectErrorText() !void {
+    const api = integrations.proxmox_api;
+    var stub = Stub{
+        .server = try (try std.net.Address.parseIp("127.0.0.1", 0)).listen(.{}),
+        // Proxmox reports the failure in the status line, with no message in the body
+        .reply = "HTTP/1.1 500 CT 101 already exists on node 'pve1'\r\n" ++
+            "Content-Type: application/json\r\nContent-Length: 13\r\nConnection: close\r\n\r\n{\"data\":null}",
+    };
+    defer stub.server.deinit();
+    const thread = try std.Thread.spawn(.{}, Stub.serve, .{&stub});
+    defer thread.join();
+
+    const client = try api.client.ProxmoxApiClient.init(testing.allocator, .{
+        .allocator = testing.allocator,
+        .host = "127.0.0.1",
+        .port = stub.server.listen_address.getPort(),
+        .token = "root@pam!ci=secret",
+        .node = "pve1",
+        .scheme = "http",
+    });
+    defer client.deinit();
+    var lifecycle = api_lifecycle.ApiLifecycle{ .allocator = testing.allocator, .logger = null, .client = client, .node = "pve1" };
+
+    var result = (try lifecycle.run(&.{ "pct", "create", "101", "local:vztmpl/alpine.tar.zst" })).?;
+    defer result.deinit(testing.allocator);
+    try testing.expectEqual(@as(u8, 1), result.exit_code);
+    try testing.expectEqualStrings("HTTP 500: CT 101 already exists on node 'pve1'", result.stderr);
+    try testing.expect(std.mem.startsWith(u8, stub.request[0..stub.request_len], "POST /api2/json/nodes/pve1/lxc "));
+}
+
+/// Plain-HTTP keep-alive server playing a node that runs lifecycle calls as
+/// worker tasks: CT 101's task stops OK after one running poll, CT 102's
+/// fails
+const TaskStub = struct {
+    server: std.net.Server,
+    status_polls: std.atomic.Value(u32) = .init(0),
+    stopping: std.atomic.Value(bool) = .init(false),
+    handlers: [16]std.Thread = undefined,
+    handler_count: usize = 0,
+    acceptor: ?std.Thread = null,
+
+    fn start(self: *TaskStub) !void {
+        self.server = try (try std.net.Address.parseIp("127.0.0.1", 0)).listen(.{});
+        self.acceptor = try std.Thread.spawn(.{}, accept, .{self});
+    }
+
+    /// Call after the client is gone, so every handler sees its connection close
+    fn stop(self: *TaskStub) void {
+        self.stopping.store(true, .release);
+        // Wake the blocked accept
+        if (std.net.tcpConnectToAddress(self.server.listen_address)) |stream| stream.close() else |_| {}
+        if (self.acceptor) |t| t.join();
+        for (self.handlers[0..self.handler_count]) |t| t.join();
+        self.server.deinit();
+    }
+
+    fn accept(self: *TaskStub) void {
+        while (true) {
+            const conn = self.server.accept() catch return;
+            if (self.stopping.load(.acquire) or self.handler_count == self.handlers.len) {
+                conn.stream.close();
+                return;
+            }
+            self.handlers[self.handler_count] = std.Thread.spawn(.{}, handle, .{ self, conn.stream }) catch {
+                conn.stream.close();
+                continue;
+            };
+            self.handler_count += 1;
+        }
+    }
+
+    fn handle(self: *TaskStub, stream: std.net.Stream) void {
+        defer stream.close();
+        var buf: [4096]u8 = undefined;
+        var len: usize = 0;
+        while (true) {
+            while (!Stub.requestComplete(buf[0..len])) {
+                if (len == buf.len) return;
+                const n = stream.read(buf[len..]) catch return;
+                if (n == 0) return;
+                len += n;
+            }
+            const body = self.reply(buf[0..len]);
+            var head_buf: [128]u8 = undefined;
+            const head = std.fmt.bufPrint(&head_buf, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {d}\r\n\r\n", .{body.len}) catch return;
+            stream.writeAll(head) catch return;
+            stream.writeAll(body) catch return;
+            // Clients here never pipeline, so a reply consumes everything read
+            len = 0;
+        }
+    }
+
+    fn reply(self: *TaskStub, request: []const u8) []const u8 {
+        const line = request[0 .. std.mem.indexOf(u8, request, "\r\n") orelse request.len];
+        if (std.mem.startsWith(u8, line, "POST ")) {
+            if (std.mem.indexOf(u8, line, "/lxc/101/") != null) return "{\"data\":\"UPID:pve1:0000B001:ok\"}";
+            if (std.mem.indexOf(u8, line, "/lxc/102/") != null) return "{\"data\":\"UPID:pve1:0000B002:fail\"}";
+            return "{\"data\":null}";
+        }
+        if (std.mem.indexOf(u8, line, "%3Aok/status ") != null) {
+            const polls = self.status_polls.fetchAdd(1, .monotonic) + 1;
+            return if (polls < 2) "{\"data\":{\"status\":\"running\"}}" else "{\"data\":{\"status\":\"stopped\",\"exitstatus\":\"OK\"}}";
+        }
+        if (std.mem.indexOf(u8, line, "%3Afail/status ") != null) {
+            return "{\"data\":{\"status\":\"stopped\",\"exitstatus\":\"CT 102 is locked (backup)\"}}";
+        }
+        return "{\"data\":null}";
+    }
+};
+
+fn initTaskClient(stub: *const TaskStub) !*integrations.proxmox_api.client.ProxmoxApiClient {
+    return integrations.proxmox_api.client.ProxmoxApiClient.init(testing.allocator, .{
+        .allocator = testing.allocator,
+        .host = "127.0.0.1",
+        .port = stub.server.listen_address.getPort(),
+        .token = "root@pam!ci=secret",
+        .node = "pve1",
+        .scheme = "http",
+    });
+}
+
+test "run waits for the worker task the call started" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectTaskAwaited() else return error.SkipZigTest;
+}
+
+fn expectTaskAwaited() !void {
+    var stub = TaskStub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const client = try initTaskClient(&stub);
+    defer client.deinit();
+    var lifecycle = api_lifecycle.ApiLifecycle{ .allocator = testing.allocator, .logger = null, .client = client, .node = "pve1" };
+
+    var result = (try lifecycle.run(&.{ "pct", "start", "101" })).?;
+    defer result.deinit(testing.allocator);
+    try testing.expectEqual(@as(u8, 0), result.exit_code);
+    try testing.expectEqualStrings("", result.stderr);
+    try testing.expectEqual(@as(u32, 2), stub.status_polls.load(.monotonic));
+}
+
+test "a failed worker task fails run with its exit status" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectTaskFailure() else return error.SkipZigTest;
+}
+
+fn expectTaskFailure() !void {
+    var stub = TaskStub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const client = try initTaskClient(&stub);
+    defer client.deinit();
+    var lifecycle = api_lifecycle.ApiLifecycle{ .allocator = testing.allocator, .logger = null, .client = client, .node = "pve1" };
+
+    var result = (try lifecycle.run(&.{ "pct", "stop", "102" })).?;
+    defer result.deinit(testing.allocator);
+    try testing.expectEqual(@as(u8, 1), result.exit_code);
+    try testing.expectEqualStrings("CT 102 is locked (backup)", result.stderr);
+}
+
+/// Results a `TaskGroup` handed back, by `add` index
+const GroupResults = struct {
+    results: [2]?core.exec.Result = .{ null, null },
+    calls: usize = 0,
+
+    fn record(ctx: ?*anyopaque, index: usize, result: core.exec.Result) void {
+        const self: *GroupResults = @ptrCast(@alignCast(ctx.?));
+        self.results[index] = result;
+        self.calls += 1;
+    }
+};
+
+test "submitted calls are awaited together" {
+    if (comptime integrations.isProxmoxApiEnabled()) try expectGroupWait() else return error.SkipZigTest;
+}
+
+fn expectGroupWait() !void {
+    var stub = TaskStub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const client = try initTaskClient(&stub);
+    defer client.deinit();
+    var lifecycle = api_lifecycle.ApiLifecycle{ .allocator = testing.allocator, .logger = null, .client = client, .node = "pve1" };
+
+    var group = api_lifecycle.TaskGroup.init(&lifecycle);
+    defer group.deinit();
+    for ([_][]const u8{ "101", "102" }) |vmid| {
+        const upid = switch ((try lifecycle.submit(&.{ "pct", "start", vmid })).?) {
+            .task => |task| task,
+            .done => return error.TestUnexpectedResult,
+        };
+        defer testing.allocator.free(upid);
+        try group.add(upid, vmid);
+    }
+
+    var done = GroupResults{};
+    defer for (&done.results) |*r| if (r.*) |*result| result.deinit(testing.allocator);
+    group.wait(&done, GroupResults.record);
+
+    try testing.expectEqual(@as(usize, 2), done.calls);
+    try testing.expectEqual(@as(u8, 0), done.results[0].?.exit_code);
+    try testing.expectEqual(@as(u8, 1), done.results[1].?.exit_code);
+    try testing.expectEqualStrings("CT 102 is locked (backup)", done.results[1].?.stderr);
+}
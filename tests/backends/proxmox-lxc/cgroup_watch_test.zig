@@ -0,0 +1,64 @@
+const std = @import("std");
+const testing = std.testing;
+const cgroup_watch = @import("cgroup_watch.zig");
+const pve_config = @import("pve_config.zig");
+
+fn setPopulated(dir: std.fs.Dir, populated: bool) !void {
+    try dir.writeFile(.{ .sub_path = "lxc/300/cgroup.events", .data = if (populated) "populated 1\nfrozen 0\n" else "populated 0\nfrozen 0\n" });
+}
+
+fn stopLater(dir: std.fs.Dir) void {
+    std.Thread.sleep(50 * std.time.ns_per_ms);
+    setPopulated(dir, false) catch {};
+}
+
+test "waitStopped wakes on cgroup.events change" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.makePath("lxc/300");
+    try setPopulated(tmp.dir, true);
+    const root = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(root);
+
+    const pve = pve_config.PveConfigReader.initWithRoots(testing.allocator, "tests/fixtures/pmxcfs", root);
+    const thread = try std.Thread.spawn(.{}, stopLater, .{tmp.dir});
+    defer thread.join();
+
+    const start = std.time.milliTimestamp();
+    try testing.expectEqual(@as(?bool, true), try cgroup_watch.waitStopped(&pve, "300", 10_000));
+    try testing.expect(std.time.milliTimestamp() - start < 5_000);
+}
+
+test "waitStopped gives up at the deadline" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.makePath("lxc/300");
+    try setPopulated(tmp.dir, true);
+    const root = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(root);
+
+    const pve = pve_config.PveConfigReader.initWithRoots(testing.allocator, "tests/fixtures/pmxcfs", root);
+    try testing.expectEqual(@as(?bool, false), try cgroup_watch.waitStopped(&pve, "300", 100));
+    // Without a cgroup to look at the caller has to ask pct
+    try testing.expectEqual(@as(?bool, null), try cgroup_watch.waitStopped(&pve, "999", 100));
+}
+
+fn removeLater(dir: std.fs.Dir) void {
+    std.Thread.sleep(50 * std.time.ns_per_ms);
+    dir.deleteTree("lxc/300") catch {};
+}
+
+test "waitStopped treats a cgroup removed while running as stopped" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.makePath("lxc/300");
+    try setPopulated(tmp.dir, true);
+    const root = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(root);
+
+    const pve = pve_config.PveConfigReader.initWithRoots(testing.allocator, "tests/fixtures/pmxcfs", root);
+    const thread = try std.Thread.spawn(.{}, removeLater, .{tmp.dir});
+    defer thread.join();
+
+    try testing.expectEqual(@as(?bool, true), try cgroup_watch.waitStopped(&pve, "300", 10_000));
+}
@@ -0,0 +1,56 @@
+const std = @import("std");
+const testing = std.testing;
+const clone_bases = @import("clone_bases.zig");
+
+fn goneIfB(_: void, template: []const u8) bool {
+    return std.mem.indexOf(u8, template, "/b.") != null;
+}
+
+test "bases track their clones across instances" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    {
+        var bases = clone_bases.CloneBases.init(testing.allocator, null, state_dir);
+        defer bases.deinit();
+        try testing.expectEqual(@as(?u32, null), try bases.lookup("local:vztmpl/a.tar.zst"));
+        try bases.register("local:vztmpl/a.tar.zst", 900);
+        try bases.addDependent("local:vztmpl/a.tar.zst", 301);
+        try bases.addDependent("local:vztmpl/a.tar.zst", 302);
+        try bases.addDependent("local:vztmpl/a.tar.zst", 302);
+    }
+
+    var bases = clone_bases.CloneBases.init(testing.allocator, null, state_dir);
+    defer bases.deinit();
+    try testing.expectEqual(@as(?u32, 900), try bases.lookup("local:vztmpl/a.tar.zst"));
+    const listed = try bases.list();
+    try testing.expectEqual(@as(usize, 1), listed.len);
+    try testing.expectEqualSlices(u32, &.{ 301, 302 }, listed[0].dependents.items);
+}
+
+test "collect only takes stale bases without dependents" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    var bases = clone_bases.CloneBases.init(testing.allocator, null, state_dir);
+    defer bases.deinit();
+    try bases.register("local:vztmpl/a.tar.zst", 900);
+    try bases.register("local:vztmpl/b.tar.zst", 901);
+    try bases.addDependent("local:vztmpl/b.tar.zst", 310);
+
+    // b is stale but still has a clone
+    const none = try bases.collect(testing.allocator, {}, goneIfB);
+    defer testing.allocator.free(none);
+    try testing.expectEqual(@as(usize, 0), none.len);
+
+    try bases.removeDependent(310);
+    const collected = try bases.collect(testing.allocator, {}, goneIfB);
+    defer testing.allocator.free(collected);
+    try testing.expectEqualSlices(u32, &.{901}, collected);
+    try testing.expectEqual(@as(?u32, null), try bases.lookup("local:vztmpl/b.tar.zst"));
+    try testing.expectEqual(@as(?u32, 900), try bases.lookup("local:vztmpl/a.tar.zst"));
+}
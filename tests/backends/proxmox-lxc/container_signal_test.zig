@@ -0,0 +1,69 @@
+const std = @import("std");
+const testing = std.testing;
+const container_signal = @import("container_signal.zig");
+const pve_config = @import("pve_config.zig");
+
+test "parseSignal accepts names, SIG prefixes and numbers" {
+    try testing.expectEqual(@as(?u8, std.posix.SIG.TERM), container_signal.parseSignal("TERM"));
+    try testing.expectEqual(@as(?u8, std.posix.SIG.KILL), container_signal.parseSignal("SIGKILL"));
+    try testing.expectEqual(@as(?u8, std.posix.SIG.HUP), container_signal.parseSignal("hup"));
+    try testing.expectEqual(@as(?u8, 10), container_signal.parseSignal("10"));
+    try testing.expectEqual(@as(?u8, null), container_signal.parseSignal("BOGUS"));
+    try testing.expectEqual(@as(?u8, null), container_signal.parseSignal("0"));
+}
+
+fn writeStatus(dir: std.fs.Dir, pid: []const u8, nspid: []const u8) !void {
+    try dir.makePath(pid);
+    var path_buf: [64]u8 = undefined;
+    const path = try std.fmt.bufPrint(&path_buf, "{s}/status", .{pid});
+    var data_buf: [128]u8 = undefined;
+    const data = try std.fmt.bufPrint(&data_buf, "Name:\tinit\nNSpid:\t{s}\nNSsid:\t1\n", .{nspid});
+    try dir.writeFile(.{ .sub_path = path, .data = data });
+}
+
+test "initPid finds a systemd init nested below the payload cgroup" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.makePath("cgroup/lxc/300/ns/init.scope");
+    try tmp.dir.makePath("cgroup/lxc/300/ns/system.slice/docker-1.scope");
+    try tmp.dir.writeFile(.{ .sub_path = "cgroup/lxc/300/cgroup.procs", .data = "" });
+    // A guest daemon, a container nested in the guest, and the guest's init
+    try tmp.dir.writeFile(.{ .sub_path = "cgroup/lxc/300/ns/cgroup.procs", .data = "4300\n" });
+    try tmp.dir.writeFile(.{ .sub_path = "cgroup/lxc/300/ns/system.slice/docker-1.scope/cgroup.procs", .data = "5000\n" });
+    try tmp.dir.writeFile(.{ .sub_path = "cgroup/lxc/300/ns/init.scope/cgroup.procs", .data = "4242\n" });
+    // Only tasks outside a child PID namespace
+    try tmp.dir.makePath("cgroup/lxc/301/ns");
+    try tmp.dir.writeFile(.{ .sub_path = "cgroup/lxc/301/ns/cgroup.procs", .data = "4300\n6000\n" });
+
+    try tmp.dir.makePath("proc");
+    var proc = try tmp.dir.openDir("proc", .{});
+    defer proc.close();
+    try writeStatus(proc, "self", "777");
+    try writeStatus(proc, "4242", "4242\t1");
+    try writeStatus(proc, "4300", "4300\t57");
+    try writeStatus(proc, "5000", "5000\t90\t1");
+    try writeStatus(proc, "6000", "6000");
+
+    const root = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(root);
+    const cgroup_root = try std.fmt.allocPrint(testing.allocator, "{s}/cgroup", .{root});
+    defer testing.allocator.free(cgroup_root);
+    const proc_root = try std.fmt.allocPrint(testing.allocator, "{s}/proc", .{root});
+    defer testing.allocator.free(proc_root);
+
+    var pve = pve_config.PveConfigReader.initWithRoots(testing.allocator, "tests/fixtures/pmxcfs", cgroup_root);
+    pve.proc_root = proc_root;
+    try testing.expectEqual(@as(?std.os.linux.pid_t, 4242), container_signal.initPid(&pve, "300"));
+    // No task is PID 1 of the container, and no other task stands in for it
+    try testing.expectEqual(@as(?std.os.linux.pid_t, null), container_signal.initPid(&pve, "301"));
+    try testing.expectEqual(@as(?std.os.linux.pid_t, null), container_signal.initPid(&pve, "302"));
+}
+
+test "sendSignal delivers through a pidfd" {
+    var child = std.process.Child.init(&.{ "sleep", "30" }, testing.allocator);
+    try child.spawn();
+
+    try container_signal.sendSignal(child.id, std.posix.SIG.TERM);
+    const term = try child.wait();
+    try testing.expectEqual(std.process.Child.Term{ .Signal = std.posix.SIG.TERM }, term);
+}
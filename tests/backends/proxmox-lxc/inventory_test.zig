@@ -0,0 +1,56 @@
+const std = @import("std");
+const testing = std.testing;
+const inventory = @import("inventory.zig");
+
+const sample_pct_list =
+    \\VMID       Status     Lock         Name
+    \\101        running                 web-1
+    \\102        stopped    backup       db-1
+    \\205        stopped                 web-1
+    \\
+;
+
+test "ContainerInventory load indexes by name and VMID" {
+    var inv = inventory.ContainerInventory.init(testing.allocator, null);
+    defer inv.deinit();
+
+    try inv.load(sample_pct_list);
+
+    try testing.expectEqual(@as(usize, 3), inv.items().len);
+    try testing.expectEqual(@as(?u32, 102), inv.lookupVmid("db-1"));
+    try testing.expect(inv.contains(205));
+    try testing.expect(!inv.contains(999));
+    try testing.expectEqualStrings("running", inv.statusOf(101).?);
+    try testing.expectEqualStrings("stopped", inv.statusOf(102).?);
+}
+
+test "ContainerInventory keeps first match for duplicate names" {
+    var inv = inventory.ContainerInventory.init(testing.allocator, null);
+    defer inv.deinit();
+
+    try inv.load(sample_pct_list);
+
+    try testing.expectEqual(@as(?u32, 101), inv.lookupVmid("web-1"));
+}
+
+test "ContainerInventory reload replaces previous entries" {
+    var inv = inventory.ContainerInventory.init(testing.allocator, null);
+    defer inv.deinit();
+
+    try inv.load(sample_pct_list);
+    try inv.load("VMID Status Lock Name\n300 running  other\n");
+
+    try testing.expectEqual(@as(usize, 1), inv.items().len);
+    try testing.expect(inv.lookupVmid("db-1") == null);
+    try testing.expectEqual(@as(?u32, 300), inv.lookupVmid("other"));
+}
+
+test "ContainerInventory invalidate forces reload" {
+    var inv = inventory.ContainerInventory.init(testing.allocator, null);
+    defer inv.deinit();
+
+    try inv.load(sample_pct_list);
+    try testing.expect(inv.loaded);
+    inv.invalidate();
+    try testing.expect(!inv.loaded);
+}
@@ -0,0 +1,221 @@
+const std = @import("std");
+const testing = std.testing;
+const layer_extractor = @import("layer_extractor.zig");
+
+/// Minimal ustar writer for building test layers in memory
+const TarBuilder = struct {
+    data: std.ArrayListUnmanaged(u8) = .{},
+
+    fn deinit(self: *TarBuilder) void {
+        self.data.deinit(testing.allocator);
+    }
+
+    fn entry(self: *TarBuilder, typeflag: u8, name: []const u8, link: []const u8, body: []const u8) !void {
+        var block = [_]u8{0} ** 512;
+        @memcpy(block[0..name.len], name);
+        const mode: u32 = if (typeflag == '5') 0o755 else 0o644;
+        _ = try std.fmt.bufPrint(block[100..108], "{o:0>7}", .{mode});
+        _ = try std.fmt.bufPrint(block[108..116], "{o:0>7}", .{@as(u32, 0)});
+        _ = try std.fmt.bufPrint(block[116..124], "{o:0>7}", .{@as(u32, 0)});
+        _ = try std.fmt.bufPrint(block[124..136], "{o:0>11}", .{body.len});
+        _ = try std.fmt.bufPrint(block[136..148], "{o:0>11}", .{@as(u32, 1700000000)});
+        block[156] = typeflag;
+        @memcpy(block[157 .. 157 + link.len], link);
+        @memcpy(block[257..263], "ustar\x00");
+        @memcpy(block[263..265], "00");
+
+        @memset(block[148..156], ' ');
+        var sum: u32 = 0;
+        for (block) |b| sum += b;
+        _ = try std.fmt.bufPrint(block[148..155], "{o:0>6}\x00", .{sum});
+
+        try self.data.appendSlice(testing.allocator, &block);
+        try self.data.appendSlice(testing.allocator, body);
+        const pad = (512 - body.len % 512) % 512;
+        try self.data.appendNTimes(testing.allocator, 0, pad);
+    }
+
+    fn pax(self: *TarBuilder, key: []const u8, value: []const u8) !void {
+        // Record length includes its own digits
+        var buf: [256]u8 = undefined;
+        const base = key.len + value.len + 3;
+        var len = base + 1;
+        while (std.math.log10_int(len) + 1 + base != len) len += 1;
+        const record = try std.fmt.bufPrint(&buf, "{d} {s}={s}\n", .{ len, key, value });
+        try self.entry('x', "PaxHeader", "", record);
+    }
+
+    fn finish(self: *TarBuilder) ![]const u8 {
+        try self.data.appendNTimes(testing.allocator, 0, 1024);
+        return self.data.items;
+    }
+};
+
+fn extract(dir: std.fs.Dir, tar: []const u8) !layer_extractor.ExtractStats {
+    var extractor = try layer_extractor.LayerExtractor.init(testing.allocator, null, dir, .{ .preserve_owner = false });
+    defer extractor.deinit();
+    var reader = std.Io.Reader.fixed(tar);
+    try extractor.extractStream(&reader);
+    return extractor.stats;
+}
+
+test "Compression.detect recognises gzip and zstd magic" {
+    try testing.expectEqual(layer_extractor.Compression.gzip, layer_extractor.Compression.detect("\x1f\x8b\x08\x00"));
+    try testing.expectEqual(layer_extractor.Compression.zstd, layer_extractor.Compression.detect("\x28\xb5\x2f\xfd"));
+    try testing.expectEqual(layer_extractor.Compression.none, layer_extractor.Compression.detect("etc/"));
+}
+
+test "LayerExtractor writes files, links and directories" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var tar = TarBuilder{};
+    defer tar.deinit();
+    try tar.entry('5', "etc/", "", "");
+    try tar.entry('0', "etc/hostname", "", "box\n");
+    try tar.entry('2', "etc/name", "hostname", "");
+    try tar.entry('1', "etc/hostname.bak", "etc/hostname", "");
+    try tar.entry('0', "../escape", "", "nope");
+
+    const stats = try extract(tmp.dir, try tar.finish());
+    try testing.expectEqual(@as(u64, 4), stats.bytes);
+    try testing.expectEqual(@as(u64, 1), stats.skipped);
+
+    var buf: [16]u8 = undefined;
+    try testing.expectEqualStrings("box\n", try tmp.dir.readFile("etc/hostname", &buf));
+    try testing.expectEqualStrings("box\n", try tmp.dir.readFile("etc/hostname.bak", &buf));
+    try testing.expectEqualStrings("hostname", try tmp.dir.readLink("etc/name", &buf));
+    try testing.expectError(error.FileNotFound, tmp.dir.access("../escape", .{}));
+}
+
+test "LayerExtractor honours PAX long paths" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    const long_name = "usr/share/" ++ ("x" ** 120);
+    var tar = TarBuilder{};
+    defer tar.deinit();
+    try tar.pax("path", long_name);
+    try tar.entry('0', "truncated", "", "data");
+
+    _ = try extract(tmp.dir, try tar.finish());
+    var buf: [8]u8 = undefined;
+    try testing.expectEqualStrings("data", try tmp.dir.readFile(long_name, &buf));
+}
+
+test "LayerExtractor applies whiteouts from upper layers" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var lower = TarBuilder{};
+    defer lower.deinit();
+    try lower.entry('0', "app/old.conf", "", "1");
+    try lower.entry('0', "opaque/stale", "", "1");
+    try lower.entry('0', "keep", "", "1");
+    _ = try extract(tmp.dir, try lower.finish());
+
+    var upper = TarBuilder{};
+    defer upper.deinit();
+    try upper.entry('0', "app/.wh.old.conf", "", "");
+    try upper.entry('0', "opaque/fresh", "", "2");
+    try upper.entry('0', "opaque/.wh..wh..opq", "", "");
+    const stats = try extract(tmp.dir, try upper.finish());
+
+    try testing.expectEqual(@as(u64, 2), stats.whiteouts);
+    try testing.expectError(error.FileNotFound, tmp.dir.access("app/old.conf", .{}));
+    try testing.expectError(error.FileNotFound, tmp.dir.access("opaque/stale", .{}));
+    try testing.expectError(error.FileNotFound, tmp.dir.access("opaque/.wh..wh..opq", .{}));
+    try tmp.dir.access("opaque/fresh", .{});
+    try tmp.dir.access("keep", .{});
+}
+
+test "LayerExtractor rejects corrupt headers" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+
+    var tar = TarBuilder{};
+    defer tar.deinit();
+    try tar.entry('0', "file", "", "x");
+    tar.data.items[0] = 'F';
+
+    try testing.expectError(error.InvalidArchive, extract(tmp.dir, try tar.finish()));
+}
+
+/// `root` to extract into, and a sibling `outside` a layer must never reach
+const EscapeFixture = struct {
+    tmp: testing.TmpDir,
+    root: std.fs.Dir,
+    outside_path: []const u8,
+
+    fn init() !EscapeFixture {
+        var tmp = testing.tmpDir(.{});
+        errdefer tmp.cleanup();
+        try tmp.dir.makeDir("root");
+        try tmp.dir.makeDir("outside");
+        try tmp.dir.writeFile(.{ .sub_path = "outside/victim", .data = "keep" });
+        return .{
+            .tmp = tmp,
+            .root = try tmp.dir.openDir("root", .{}),
+            .outside_path = try tmp.dir.realpathAlloc(testing.allocator, "outside"),
+        };
+    }
+
+    fn deinit(self: *EscapeFixture) void {
+        testing.allocator.free(self.outside_path);
+        self.root.close();
+        self.tmp.cleanup();
+    }
+};
+
+test "LayerExtractor does not write through a symlinked parent" {
+    var fx = try EscapeFixture.init();
+    defer fx.deinit();
+
+    var tar = TarBuilder{};
+    defer tar.deinit();
+    try tar.entry('2', "a", fx.outside_path, "");
+    try tar.entry('0', "a/passwd", "", "owned");
+    try tar.entry('5', "a/sub/", "", "");
+    const stats = try extract(fx.root, try tar.finish());
+
+    try testing.expectEqual(@as(u64, 2), stats.skipped);
+    try testing.expectError(error.FileNotFound, fx.tmp.dir.access("outside/passwd", .{}));
+    try testing.expectError(error.FileNotFound, fx.tmp.dir.access("outside/sub", .{}));
+}
+
+test "LayerExtractor does not hardlink through a symlink" {
+    var fx = try EscapeFixture.init();
+    defer fx.deinit();
+
+    var tar = TarBuilder{};
+    defer tar.deinit();
+    try tar.entry('2', "s", fx.outside_path, "");
+    try tar.entry('1', "stolen", "s/victim", "");
+    try tar.entry('1', "stolen2", "../outside/victim", "");
+    const stats = try extract(fx.root, try tar.finish());
+
+    try testing.expectEqual(@as(u64, 2), stats.skipped);
+    try testing.expectError(error.FileNotFound, fx.root.access("stolen", .{}));
+    try testing.expectError(error.FileNotFound, fx.root.access("stolen2", .{}));
+}
+
+test "LayerExtractor does not apply whiteouts through a symlink" {
+    var fx = try EscapeFixture.init();
+    defer fx.deinit();
+
+    var lower = TarBuilder{};
+    defer lower.deinit();
+    try lower.entry('2', "d", fx.outside_path, "");
+    _ = try extract(fx.root, try lower.finish());
+
+    var upper = TarBuilder{};
+    defer upper.deinit();
+    try upper.entry('0', "d/.wh.victim", "", "");
+    try upper.entry('0', "d/.wh..wh..opq", "", "");
+    try upper.entry('0', ".wh...", "", "");
+    _ = try extract(fx.root, try upper.finish());
+
+    var buf: [8]u8 = undefined;
+    try testing.expectEqualStrings("keep", try fx.tmp.dir.readFile("outside/victim", &buf));
+    try fx.root.access(".", .{});
+}
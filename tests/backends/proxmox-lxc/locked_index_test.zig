@@ -0,0 +1,62 @@
+const std = @import("std");
+const testing = std.testing;
+const locked_index = @import("locked_index.zig");
+
+const Pair = struct {
+    key: []const u8,
+    value: u32,
+
+    pub fn parseLine(arena: std.mem.Allocator, line: []const u8) !?Pair {
+        _ = arena;
+        const tab = std.mem.indexOfScalar(u8, line, '\t') orelse return null;
+        const value = std.fmt.parseInt(u32, line[tab + 1 ..], 10) catch return null;
+        return .{ .key = line[0..tab], .value = value };
+    }
+
+    pub fn writeLine(self: Pair, allocator: std.mem.Allocator, out: *std.ArrayListUnmanaged(u8)) !void {
+        try out.print(allocator, "{s}\t{d}\n", .{ self.key, self.value });
+    }
+};
+
+const PairIndex = locked_index.LockedIndex(Pair, "pairs", 1024);
+
+test "saved records are reloaded by the next lock" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    var writer = PairIndex.init(testing.allocator, state_dir);
+    defer writer.deinit();
+    {
+        var lock = try writer.lock();
+        defer lock.close();
+        try writer.records.append(writer.recordAllocator(), .{ .key = try writer.recordAllocator().dupe(u8, "a"), .value = 1 });
+        try writer.records.append(writer.recordAllocator(), .{ .key = "b", .value = 2 });
+        try writer.save();
+    }
+
+    var reader = PairIndex.init(testing.allocator, state_dir);
+    defer reader.deinit();
+    var lock = try reader.lock();
+    defer lock.close();
+    try testing.expectEqual(@as(usize, 2), reader.records.items.len);
+    try testing.expectEqualStrings("b", reader.records.items[1].key);
+    try testing.expectEqual(@as(u32, 2), reader.records.items[1].value);
+    try tmp.dir.access("pairs.lock", .{});
+}
+
+test "malformed lines are skipped" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.writeFile(.{ .sub_path = "pairs.idx", .data = "a\t1\nbroken\nc\tx\n\nd\t4\n" });
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    var index = PairIndex.init(testing.allocator, state_dir);
+    defer index.deinit();
+    var lock = try index.lock();
+    defer lock.close();
+    try testing.expectEqual(@as(usize, 2), index.records.items.len);
+    try testing.expectEqualStrings("d", index.records.items[1].key);
+}
@@ -0,0 +1,104 @@
+const std = @import("std");
+const testing = std.testing;
+const lxc_config = @import("lxc_config.zig");
+const oci_bundle = @import("oci_bundle.zig");
+
+fn argAfter(argv: []const []const u8, flag: []const u8) ?[]const u8 {
+    for (argv, 0..) |arg, i| {
+        if (std.mem.eql(u8, arg, flag) and i + 1 < argv.len) return argv[i + 1];
+    }
+    return null;
+}
+
+test "compile without a bundle uses sandbox resources and the fallback bridge" {
+    var compiled = try lxc_config.compile(testing.allocator, null, .{
+        .vmid = "300",
+        .template = "local:vztmpl/base.tar.zst",
+        .hostname = "web",
+        .memory_bytes = 1024 * 1024 * 1024,
+        .cpu = 2.0,
+        .bridge = "vmbr0",
+        .ostype = "ubuntu",
+        .unprivileged = true,
+    });
+    defer compiled.deinit();
+
+    const argv = compiled.argv.items;
+    try testing.expectEqualStrings("pct", argv[0]);
+    try testing.expectEqualStrings("create", argv[1]);
+    try testing.expectEqualStrings("1024", argAfter(argv, "--memory").?);
+    try testing.expectEqualStrings("2", argAfter(argv, "--cores").?);
+    try testing.expectEqualStrings("name=eth0,bridge=vmbr0,ip=dhcp", argAfter(argv, "--net0").?);
+    try testing.expectEqualStrings("1", argAfter(argv, "--unprivileged").?);
+    try testing.expectEqual(@as(?[]const u8, null), argAfter(argv, "--features"));
+    try testing.expectEqual(@as(?[]const u8, null), argAfter(argv, "--rootfs"));
+    try testing.expectEqual(@as(usize, 1), compiled.net_devices.items.len);
+}
+
+test "compile folds bundle resources, features and mounts into one argv" {
+    const mounts = [_]oci_bundle.MountConfig{
+        .{ .allocator = testing.allocator, .source = "proc", .destination = "/proc", .type = "proc" },
+        .{ .allocator = testing.allocator, .source = "/srv/data", .destination = "/data", .options = "rbind,ro,nosuid,nodev" },
+        .{ .allocator = testing.allocator, .source = "local-zfs:subvol-300-disk-1", .destination = "/cache" },
+        .{ .allocator = testing.allocator, .source = "tmpfs", .destination = "/run", .type = "tmpfs" },
+    };
+    const namespaces = [_]oci_bundle.NamespaceConfig{
+        .{ .allocator = testing.allocator, .type = "pid" },
+        .{ .allocator = testing.allocator, .type = "user" },
+    };
+    const bundle = oci_bundle.OciBundleConfig{
+        .allocator = testing.allocator,
+        .rootfs_path = "rootfs",
+        .mounts = &mounts,
+        .namespaces = &namespaces,
+        .memory_limit = 256 * 1024 * 1024,
+        .cpu_limit = 512,
+    };
+
+    var compiled = try lxc_config.compile(testing.allocator, null, .{
+        .vmid = "300",
+        .template = "local:vztmpl/base.tar.zst",
+        .hostname = "web",
+        .bundle = &bundle,
+        .memory_bytes = 1024 * 1024 * 1024,
+        .bridge = "vmbr0",
+        .ostype = "ubuntu",
+        .unprivileged = false,
+        .rootfs = "local-zfs:8",
+    });
+    defer compiled.deinit();
+
+    const argv = compiled.argv.items;
+    try testing.expectEqualStrings("256", argAfter(argv, "--memory").?);
+    // 512 shares is half a core, rounded up to the one-core minimum
+    try testing.expectEqualStrings("1", argAfter(argv, "--cores").?);
+    try testing.expectEqualStrings("nesting=1,keyctl=1", argAfter(argv, "--features").?);
+    try testing.expectEqualStrings("local-zfs:8", argAfter(argv, "--rootfs").?);
+
+    try testing.expectEqual(@as(usize, 2), compiled.mount_count);
+    try testing.expectEqualStrings("/srv/data,mp=/data,ro=1,mountoptions=nosuid;nodev", argAfter(argv, "--mp0").?);
+    try testing.expectEqualStrings("local-zfs:subvol-300-disk-1,mp=/cache", argAfter(argv, "--mp1").?);
+    try testing.expectEqual(@as(?[]const u8, null), argAfter(argv, "--mp2"));
+}
+
+test "compileRebind emits pct set without creation-only options" {
+    var compiled = try lxc_config.compileRebind(testing.allocator, null, .{
+        .vmid = "300",
+        .template = "local:vztmpl/base.tar.zst",
+        .hostname = "web",
+        .bridge = "vmbr0",
+        .ostype = "ubuntu",
+        .unprivileged = true,
+        .rootfs = "local-zfs:8",
+    });
+    defer compiled.deinit();
+
+    const argv = compiled.argv.items;
+    try testing.expectEqualStrings("set", argv[1]);
+    try testing.expectEqualStrings("300", argv[2]);
+    try testing.expectEqualStrings("web", argAfter(argv, "--hostname").?);
+    try testing.expectEqualStrings("name=eth0,bridge=vmbr0,ip=dhcp", argAfter(argv, "--net0").?);
+    try testing.expectEqual(@as(?[]const u8, null), argAfter(argv, "--ostype"));
+    try testing.expectEqual(@as(?[]const u8, null), argAfter(argv, "--rootfs"));
+    for (argv) |arg| try testing.expect(!std.mem.eql(u8, arg, "local:vztmpl/base.tar.zst"));
+}
@@ -0,0 +1,113 @@
+const std = @import("std");
+const testing = std.testing;
+const mapping_store = @import("mapping_store.zig");
+
+test "MappingStore put, get and remove" {
+    const tmp_dir = "test_mapping_store";
+    try std.fs.cwd().makePath(tmp_dir);
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var store = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer store.deinit();
+
+    try store.put("web-1", 101, 1700000000, "/tmp/web-1");
+    try store.put("db-1", 102, 1700000001, "/tmp/db-1");
+
+    const entry = (try store.get("web-1")).?;
+    try testing.expectEqual(@as(u32, 101), entry.vmid);
+    try testing.expectEqualStrings("/tmp/web-1", entry.bundle_path);
+    try testing.expect(try store.vmidInUse(102));
+
+    try testing.expect(try store.remove("db-1"));
+    try testing.expect(!try store.remove("db-1"));
+    try testing.expect((try store.get("db-1")) == null);
+    try testing.expect(!try store.vmidInUse(102));
+    try testing.expectEqual(@as(usize, 1), try store.count());
+}
+
+test "MappingStore sees appends from another instance" {
+    const tmp_dir = "test_mapping_store_shared";
+    try std.fs.cwd().makePath(tmp_dir);
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var a = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer a.deinit();
+    var b = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer b.deinit();
+
+    try a.put("web-1", 101, 0, "/b1");
+    try b.put("web-2", 102, 0, "/b2");
+    try a.put("web-1", 103, 0, "/b1");
+
+    try testing.expectEqual(@as(u32, 103), (try b.get("web-1")).?.vmid);
+    try testing.expectEqual(@as(u32, 102), (try a.get("web-2")).?.vmid);
+    try testing.expect(!try b.vmidInUse(101));
+}
+
+test "MappingStore skips torn and corrupt records" {
+    const tmp_dir = "test_mapping_store_torn";
+    try std.fs.cwd().makePath(tmp_dir);
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    {
+        var store = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+        defer store.deinit();
+        try store.put("web-1", 101, 0, "/b1");
+    }
+
+    // Simulate a flipped byte followed by a crash mid-append
+    {
+        const file = try std.fs.cwd().openFile(tmp_dir ++ "/mapping.log", .{ .mode = .read_write });
+        defer file.close();
+        try file.seekFromEnd(0);
+        try file.writeAll("00000000\t+\tbad\t200\t0\t/x\n");
+        try file.writeAll("deadbeef\t+\tweb-2\t10");
+    }
+
+    var store = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer store.deinit();
+
+    try testing.expectEqual(@as(usize, 1), try store.count());
+    try testing.expect((try store.get("bad")) == null);
+
+    // The next append must not be glued onto the torn tail
+    try store.put("web-3", 103, 0, "/b3");
+
+    var reread = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer reread.deinit();
+    try testing.expectEqual(@as(u32, 103), (try reread.get("web-3")).?.vmid);
+    try testing.expectEqual(@as(usize, 2), try reread.count());
+}
+
+test "MappingStore compact keeps live entries" {
+    const tmp_dir = "test_mapping_store_compact";
+    try std.fs.cwd().makePath(tmp_dir);
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var store = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer store.deinit();
+
+    var i: u32 = 0;
+    while (i < 200) : (i += 1) {
+        try store.put("churn", 500 + i, 0, "/c");
+    }
+    try store.put("keep", 101, 0, "/k");
+    try store.compact();
+
+    const stat = try std.fs.cwd().statFile(tmp_dir ++ "/mapping.log");
+    try testing.expect(stat.size < 256);
+    try testing.expectEqual(@as(u32, 699), (try store.get("churn")).?.vmid);
+    try testing.expectEqual(@as(u32, 101), (try store.get("keep")).?.vmid);
+}
+
+test "MappingStore rejects separators in fields" {
+    const tmp_dir = "test_mapping_store_invalid";
+    try std.fs.cwd().makePath(tmp_dir);
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var store = try mapping_store.MappingStore.init(testing.allocator, null, tmp_dir);
+    defer store.deinit();
+
+    try testing.expectError(error.InvalidInput, store.put("a\tb", 101, 0, "/b"));
+    try testing.expectError(error.InvalidInput, store.put("a", 101, 0, "/b\n"));
+}
@@ -135,3 +135,32 @@ test "parseBundle with valid bundle" {
     try testing.expect(bundle_config.environment.?.len == 1);
     try testing.expectEqualStrings("PATH=/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin", bundle_config.environment.?[0]);
 }
+
+test "parseBundle keeps mount options" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.writeFile(.{
+        .sub_path = "config.json",
+        .data =
+        \\{
+        \\  "root": {"path": "rootfs"},
+        \\  "mounts": [
+        \\    {"source": "/srv/data", "destination": "/data", "type": "bind", "options": ["rbind", "ro", "nosuid"]},
+        \\    {"source": "/srv/cache", "destination": "/cache", "type": "bind"}
+        \\  ]
+        \\}
+        ,
+    });
+    try tmp.dir.makeDir("rootfs");
+    const bundle_path = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(bundle_path);
+
+    var parser = oci_bundle.OciBundleParser.init(testing.allocator, null);
+    var bundle_config = try parser.parseBundle(bundle_path);
+    defer bundle_config.deinit();
+
+    const mounts = bundle_config.mounts.?;
+    try testing.expectEqual(@as(usize, 2), mounts.len);
+    try testing.expectEqualStrings("rbind,ro,nosuid", mounts[0].options.?);
+    try testing.expect(mounts[1].options == null);
+}
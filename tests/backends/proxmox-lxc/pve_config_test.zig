@@ -0,0 +1,78 @@
+const std = @import("std");
+const testing = std.testing;
+const pve_config = @import("pve_config.zig");
+
+const fixture_pve = "tests/fixtures/pmxcfs";
+const fixture_cgroup = "tests/fixtures/cgroup";
+
+test "LineTokenizer yields slices without line endings" {
+    var it = pve_config.LineTokenizer.init("a: 1\r\nb: 2\n\nc: 3");
+    try testing.expectEqualStrings("a: 1", it.next().?);
+    try testing.expectEqualStrings("b: 2", it.next().?);
+    try testing.expectEqualStrings("", it.next().?);
+    try testing.expectEqualStrings("c: 3", it.next().?);
+    try testing.expect(it.next() == null);
+}
+
+test "nextMpIndexIn ignores snapshot sections" {
+    const data =
+        \\mp0: /a,mp=/a
+        \\mp4: /b,mp=/b
+        \\[snap]
+        \\mp9: /c,mp=/c
+    ;
+    try testing.expectEqual(@as(u32, 5), pve_config.nextMpIndexIn(data));
+    try testing.expectEqual(@as(u32, 0), pve_config.nextMpIndexIn("hostname: x\n"));
+}
+
+test "PveConfigReader reads LXC config from fixture" {
+    const reader = pve_config.PveConfigReader.initWithRoots(testing.allocator, fixture_pve, fixture_cgroup);
+    var conf = try reader.openLxcConfig("101");
+    defer conf.deinit();
+
+    try testing.expectEqualStrings("web-1", conf.get("hostname").?);
+    try testing.expectEqualStrings("1024", conf.get("memory").?);
+    try testing.expectEqual(@as(usize, 2), conf.mountCount());
+    try testing.expectEqual(@as(u32, 4), conf.nextMpIndex());
+    try testing.expect(conf.get("swap") == null);
+}
+
+test "PveConfigReader missing config is NotFound" {
+    const reader = pve_config.PveConfigReader.initWithRoots(testing.allocator, fixture_pve, fixture_cgroup);
+    try testing.expectError(error.NotFound, reader.openLxcConfig("999"));
+}
+
+test "PveConfigReader parses vmlist" {
+    const reader = pve_config.PveConfigReader.initWithRoots(testing.allocator, fixture_pve, fixture_cgroup);
+    var vmlist = try reader.openVmlist();
+    defer vmlist.deinit();
+
+    var count: usize = 0;
+    var it = vmlist.iterator();
+    while (it.next()) |_| count += 1;
+    try testing.expectEqual(@as(usize, 3), count);
+
+    const vm = vmlist.find(200).?;
+    try testing.expectEqual(pve_config.GuestType.qemu, vm.guest_type);
+    try testing.expectEqualStrings("pve2", vm.node);
+    try testing.expect(vmlist.find(300) == null);
+}
+
+test "PveConfigReader runState follows cgroup.events" {
+    const reader = pve_config.PveConfigReader.initWithRoots(testing.allocator, fixture_pve, fixture_cgroup);
+    try testing.expectEqual(pve_config.RunState.running, reader.runState("101"));
+    try testing.expectEqual(pve_config.RunState.stopped, reader.runState("102"));
+    // No cgroup directory is not proof of anything; pct status has to decide
+    try testing.expectEqual(pve_config.RunState.unknown, reader.runState("103"));
+}
+
+test "PveConfigReader runState is unknown without cgroup.events" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    try tmp.dir.makePath("lxc/104");
+    const root = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(root);
+
+    const reader = pve_config.PveConfigReader.initWithRoots(testing.allocator, fixture_pve, root);
+    try testing.expectEqual(pve_config.RunState.unknown, reader.runState("104"));
+}
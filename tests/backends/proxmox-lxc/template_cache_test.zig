@@ -0,0 +1,95 @@
+const std = @import("std");
+const testing = std.testing;
+const template_cache = @import("template_cache.zig");
+const oci_bundle = @import("oci_bundle.zig");
+
+fn templateName(rootfs_path: []const u8, hostname: ?[]const u8) ![template_cache.NAME_LEN]u8 {
+    const cfg = oci_bundle.OciBundleConfig{
+        .allocator = testing.allocator,
+        .rootfs_path = rootfs_path,
+        .hostname = hostname,
+    };
+    return template_cache.bundleTemplateName(testing.allocator, &cfg);
+}
+
+fn touchTemplate(dir: std.fs.Dir, name: []const u8) !void {
+    var buf: [64]u8 = undefined;
+    try dir.writeFile(.{ .sub_path = try std.fmt.bufPrint(&buf, "{s}.tar.zst", .{name}), .data = "zstd" });
+}
+
+test "bundleTemplateName follows rootfs content and config" {
+    var tmp = testing.tmpDir(.{ .iterate = true });
+    defer tmp.cleanup();
+    try tmp.dir.makePath("etc");
+    try tmp.dir.writeFile(.{ .sub_path = "etc/os-release", .data = "ID=alpine\n" });
+    const rootfs_path = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(rootfs_path);
+
+    const first = try templateName(rootfs_path, "web");
+    try testing.expect(std.mem.startsWith(u8, &first, template_cache.NAME_PREFIX));
+    try testing.expectEqualSlices(u8, &first, &(try templateName(rootfs_path, "web")));
+    try testing.expect(!std.mem.eql(u8, &first, &(try templateName(rootfs_path, "db"))));
+
+    try tmp.dir.writeFile(.{ .sub_path = "etc/os-release", .data = "ID=debian\n" });
+    try testing.expect(!std.mem.eql(u8, &first, &(try templateName(rootfs_path, "web"))));
+}
+
+test "TemplateCache evicts least recently used unreferenced templates" {
+    var state = testing.tmpDir(.{});
+    defer state.cleanup();
+    var templates = testing.tmpDir(.{});
+    defer templates.cleanup();
+    const state_path = try state.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_path);
+    const template_path = try templates.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(template_path);
+
+    var cache = template_cache.TemplateCache.init(testing.allocator, null, state_path, template_path, .{ .max_entries = 2 });
+    defer cache.deinit();
+
+    for ([_][]const u8{ "nexcage-a", "nexcage-b", "nexcage-c" }) |name| try touchTemplate(templates.dir, name);
+
+    try cache.insert("nexcage-a", 10);
+    try cache.acquire("nexcage-a", "ct1");
+    try cache.insert("nexcage-b", 10);
+    // a is pinned and c was just built, so b goes
+    try cache.insert("nexcage-c", 10);
+
+    try testing.expect(try cache.lookup("nexcage-a"));
+    try testing.expect(!try cache.lookup("nexcage-b"));
+    try testing.expect(try cache.lookup("nexcage-c"));
+    try testing.expectError(error.FileNotFound, templates.dir.access("nexcage-b.tar.zst", .{}));
+
+    // A second process sees the same index and refs
+    var other = template_cache.TemplateCache.init(testing.allocator, null, state_path, template_path, .{ .max_entries = 1 });
+    defer other.deinit();
+    try testing.expectEqual(@as(usize, 1), try other.evict());
+    const entries = try other.list();
+    try testing.expectEqual(@as(usize, 1), entries.len);
+    try testing.expectEqualStrings("nexcage-a", entries[0].name);
+    try testing.expectEqualStrings("ct1", entries[0].refs.items[0]);
+
+    try other.release("ct1");
+    try testing.expectEqual(@as(usize, 0), (try other.list())[0].refs.items.len);
+}
+
+test "TemplateCache drops entries whose file disappeared" {
+    var state = testing.tmpDir(.{});
+    defer state.cleanup();
+    var templates = testing.tmpDir(.{});
+    defer templates.cleanup();
+    const state_path = try state.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_path);
+    const template_path = try templates.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(template_path);
+
+    var cache = template_cache.TemplateCache.init(testing.allocator, null, state_path, template_path, .{});
+    defer cache.deinit();
+
+    try touchTemplate(templates.dir, "nexcage-gone");
+    try cache.insert("nexcage-gone", 4);
+    try templates.dir.deleteFile("nexcage-gone.tar.zst");
+
+    try testing.expect(!try cache.lookup("nexcage-gone"));
+    try testing.expectEqual(@as(usize, 0), (try cache.list()).len);
+}
@@ -0,0 +1,114 @@
+const std = @import("std");
+const testing = std.testing;
+const template_packer = @import("template_packer.zig");
+const layer_extractor = @import("layer_extractor.zig");
+
+fn makeRootfs(dir: std.fs.Dir) !void {
+    try dir.makePath("etc");
+    try dir.writeFile(.{ .sub_path = "etc/hostname", .data = "box\n" });
+    try dir.symLink("hostname", "etc/name", .{});
+    try dir.makePath("usr/bin");
+    try dir.writeFile(.{ .sub_path = "usr/bin/tool", .data = "#!/bin/sh\n", .flags = .{ .mode = 0o755 } });
+    try dir.makePath("usr/share/" ++ ("x" ** 120));
+    try dir.writeFile(.{ .sub_path = "usr/share/" ++ ("x" ** 120) ++ "/deep", .data = "deep" });
+    try std.posix.linkat(dir.fd, "usr/bin/tool", dir.fd, "usr/bin/tool-alias", 0);
+}
+
+fn extract(dir: std.fs.Dir, reader: *std.Io.Reader) !void {
+    var extractor = try layer_extractor.LayerExtractor.init(testing.allocator, null, dir, .{ .preserve_owner = false });
+    defer extractor.deinit();
+    try extractor.extractStream(reader);
+}
+
+fn expectRootfs(dir: std.fs.Dir) !void {
+    var buf: [16]u8 = undefined;
+    try testing.expectEqualStrings("box\n", try dir.readFile("etc/hostname", &buf));
+    try testing.expectEqualStrings("hostname", try dir.readLink("etc/name", &buf));
+    try testing.expectEqualStrings("deep", try dir.readFile("usr/share/" ++ ("x" ** 120) ++ "/deep", &buf));
+
+    const tool = try dir.statFile("usr/bin/tool");
+    const alias = try dir.statFile("usr/bin/tool-alias");
+    try testing.expectEqual(@as(std.fs.File.Mode, 0o755), tool.mode & 0o777);
+    try testing.expectEqual(tool.inode, alias.inode);
+}
+
+test "TemplatePacker round-trips through LayerExtractor" {
+    var src = testing.tmpDir(.{ .iterate = true });
+    defer src.cleanup();
+    var dst = testing.tmpDir(.{});
+    defer dst.cleanup();
+    try makeRootfs(src.dir);
+
+    var packer = try template_packer.TemplatePacker.init(testing.allocator, null, .{ .preserve_owner = false });
+    defer packer.deinit();
+
+    var archive = std.Io.Writer.Allocating.init(testing.allocator);
+    defer archive.deinit();
+    try packer.writeArchive(src.dir, &archive.writer);
+
+    // ./, etc/, hostname, name, usr/, bin/, tool, tool-alias, share/, x.../, deep
+    try testing.expectEqual(@as(u64, 11), packer.stats.entries);
+    try testing.expectEqual(@as(usize, 0), archive.written().len % 512);
+
+    var reader = std.Io.Reader.fixed(archive.written());
+    try extract(dst.dir, &reader);
+    try expectRootfs(dst.dir);
+}
+
+test "TemplatePacker output is deterministic" {
+    var src = testing.tmpDir(.{ .iterate = true });
+    defer src.cleanup();
+    try makeRootfs(src.dir);
+
+    var packer = try template_packer.TemplatePacker.init(testing.allocator, null, .{ .preserve_owner = false });
+    defer packer.deinit();
+
+    var first = std.Io.Writer.Allocating.init(testing.allocator);
+    defer first.deinit();
+    try packer.writeArchive(src.dir, &first.writer);
+
+    var second = std.Io.Writer.Allocating.init(testing.allocator);
+    defer second.deinit();
+    try packer.writeArchive(src.dir, &second.writer);
+
+    try testing.expectEqualSlices(u8, first.written(), second.written());
+}
+
+test "TemplatePacker publishes a zstd archive atomically" {
+    var src = testing.tmpDir(.{ .iterate = true });
+    defer src.cleanup();
+    var cache = testing.tmpDir(.{ .iterate = true });
+    defer cache.cleanup();
+    var dst = testing.tmpDir(.{});
+    defer dst.cleanup();
+    try makeRootfs(src.dir);
+    try cache.dir.writeFile(.{ .sub_path = "tmpl.tar.zst", .data = "stale" });
+
+    var packer = try template_packer.TemplatePacker.init(testing.allocator, null, .{ .level = 1, .workers = 2, .preserve_owner = false });
+    defer packer.deinit();
+    const stats = packer.pack(src.dir, cache.dir, "tmpl.tar.zst") catch |err| switch (err) {
+        // zstd binary not installed on this host
+        error.FileNotFound => return error.SkipZigTest,
+        else => return err,
+    };
+
+    // Only the published archive is left behind
+    var it = cache.dir.iterate();
+    var count: usize = 0;
+    while (try it.next()) |_| count += 1;
+    try testing.expectEqual(@as(usize, 1), count);
+
+    const archive = try cache.dir.openFile("tmpl.tar.zst", .{});
+    defer archive.close();
+    const st = try archive.stat();
+    try testing.expectEqual(stats.archive_bytes, st.size);
+    try testing.expectEqual(@as(std.fs.File.Mode, 0o644), st.mode & 0o777);
+
+    var read_buf: [4096]u8 = undefined;
+    var file_reader = archive.reader(&read_buf);
+    const window = try testing.allocator.alloc(u8, std.compress.zstd.default_window_len + std.compress.zstd.block_size_max);
+    defer testing.allocator.free(window);
+    var zstd = std.compress.zstd.Decompress.init(&file_reader.interface, window, .{});
+    try extract(dst.dir, &zstd.reader);
+    try expectRootfs(dst.dir);
+}
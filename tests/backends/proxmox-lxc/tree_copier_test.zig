@@ -0,0 +1,56 @@
+const std = @import("std");
+const testing = std.testing;
+const tree_copier = @import("tree_copier.zig");
+
+test "TreeCopier copies nested trees with modes and symlinks" {
+    var src = testing.tmpDir(.{ .iterate = true });
+    defer src.cleanup();
+    var dst = testing.tmpDir(.{});
+    defer dst.cleanup();
+
+    // Wide and deep enough that several workers pick up directories
+    var i: usize = 0;
+    while (i < 20) : (i += 1) {
+        var name_buf: [32]u8 = undefined;
+        const dir_name = try std.fmt.bufPrint(&name_buf, "d{d}/sub/leaf", .{i});
+        try src.dir.makePath(dir_name);
+        var leaf = try src.dir.openDir(dir_name, .{});
+        defer leaf.close();
+        try leaf.writeFile(.{ .sub_path = "data", .data = dir_name });
+    }
+    try src.dir.writeFile(.{ .sub_path = "run.sh", .data = "#!/bin/sh\n", .flags = .{ .mode = 0o755 } });
+    try src.dir.symLink("run.sh", "link", .{});
+
+    var copier = tree_copier.TreeCopier.init(testing.allocator, null, src.dir, dst.dir, .{ .jobs = 4, .preserve_owner = false });
+    const stats = try copier.run();
+
+    try testing.expectEqual(@as(u64, 21), stats.files);
+    try testing.expectEqual(@as(u64, 60), stats.dirs);
+    try testing.expectEqual(@as(u64, 1), stats.symlinks);
+
+    var buf: [64]u8 = undefined;
+    try testing.expectEqualStrings("d7/sub/leaf", try dst.dir.readFile("d7/sub/leaf/data", &buf));
+    try testing.expectEqualStrings("run.sh", try dst.dir.readLink("link", &buf));
+
+    const st = try dst.dir.statFile("run.sh");
+    try testing.expectEqual(@as(std.fs.File.Mode, 0o755), st.mode & 0o777);
+}
+
+test "TreeCopier without reflink falls back to copy_file_range" {
+    var src = testing.tmpDir(.{ .iterate = true });
+    defer src.cleanup();
+    var dst = testing.tmpDir(.{});
+    defer dst.cleanup();
+
+    const payload = "x" ** 10000;
+    try src.dir.writeFile(.{ .sub_path = "big", .data = payload });
+
+    var copier = tree_copier.TreeCopier.init(testing.allocator, null, src.dir, dst.dir, .{ .jobs = 1, .reflink = false });
+    const stats = try copier.run();
+
+    try testing.expectEqual(@as(u64, 0), stats.reflinked);
+    try testing.expectEqual(@as(u64, payload.len), stats.bytes);
+
+    var buf: [payload.len]u8 = undefined;
+    try testing.expectEqualStrings(payload, try dst.dir.readFile("big", &buf));
+}
@@ -0,0 +1,84 @@
+const std = @import("std");
+const testing = std.testing;
+const vmid_allocator = @import("vmid_allocator.zig");
+const pve_config = @import("pve_config.zig");
+
+const fixture_pve = "tests/fixtures/pmxcfs";
+const fixture_cgroup = "tests/fixtures/cgroup";
+
+fn openAllocator(state_dir: []const u8) !vmid_allocator.VmidAllocator {
+    const reader = pve_config.PveConfigReader.initWithRoots(testing.allocator, fixture_pve, fixture_cgroup);
+    return vmid_allocator.VmidAllocator.initWithReader(testing.allocator, null, state_dir, reader);
+}
+
+test "VmidAllocator skips VMIDs in the cluster vmlist" {
+    const tmp_dir = "test_vmid_bitmap";
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var vmids = try openAllocator(tmp_dir);
+    defer vmids.deinit();
+
+    try testing.expect(!try vmids.isFree(101));
+    try testing.expect(!try vmids.isFree(200));
+    try testing.expect(try vmids.isFree(103));
+
+    // 101 and 102 are taken, so the search moves on
+    try testing.expectEqual(@as(u32, 103), try vmids.reserve(.{ .first = 100, .last = 199 }, 101));
+    try testing.expectEqual(@as(u32, 100), try vmids.reserve(.{ .first = 100, .last = 199 }, null));
+}
+
+test "VmidAllocator reserve and release persist across instances" {
+    const tmp_dir = "test_vmid_bitmap_persist";
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    {
+        var vmids = try openAllocator(tmp_dir);
+        defer vmids.deinit();
+        try testing.expect(try vmids.reserveExact(5000));
+        try testing.expect(!try vmids.reserveExact(5000));
+    }
+
+    var vmids = try openAllocator(tmp_dir);
+    defer vmids.deinit();
+    try testing.expect(!try vmids.isFree(5000));
+    try testing.expectEqual(@as(u32, 5001), try vmids.reserve(.{ .first = 5000, .last = 5001 }, 5000));
+
+    try vmids.release(5000);
+    try testing.expect(try vmids.isFree(5000));
+}
+
+test "VmidAllocator wraps within a pool and reports exhaustion" {
+    const tmp_dir = "test_vmid_bitmap_pool";
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var vmids = try openAllocator(tmp_dir);
+    defer vmids.deinit();
+
+    const pool = vmid_allocator.VmidRange{ .first = 1000, .last = 1129 };
+    var seen = std.AutoHashMap(u32, void).init(testing.allocator);
+    defer seen.deinit();
+
+    var i: usize = 0;
+    while (i < 130) : (i += 1) {
+        const vmid = try vmids.reserve(pool, 1100);
+        try testing.expect(pool.contains(vmid));
+        try testing.expect(!seen.contains(vmid));
+        try seen.put(vmid, {});
+    }
+
+    try testing.expectError(error.VmidRangeExhausted, vmids.reserve(pool, 1100));
+}
+
+test "VmidAllocator covers the top of the VMID range" {
+    const tmp_dir = "test_vmid_bitmap_top";
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    var vmids = try openAllocator(tmp_dir);
+    defer vmids.deinit();
+
+    const top = vmid_allocator.VmidRange{ .first = vmid_allocator.VMID_MAX - 1, .last = vmid_allocator.VMID_MAX };
+    try testing.expectEqual(vmid_allocator.VMID_MAX, try vmids.reserve(top, vmid_allocator.VMID_MAX));
+    try testing.expectEqual(vmid_allocator.VMID_MAX - 1, try vmids.reserve(top, vmid_allocator.VMID_MAX));
+    try testing.expectError(error.VmidRangeExhausted, vmids.reserve(top, null));
+    try testing.expectError(error.InvalidInput, vmids.reserve(.{ .first = 50, .last = 99 }, null));
+}
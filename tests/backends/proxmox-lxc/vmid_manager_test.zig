@@ -72,6 +72,29 @@ test "VmidManager storeMapping and getVmid" {
     try testing.expectEqual(vmid, retrieved_vmid);
 }
 
+test "VmidManager migrates legacy mapping.json" {
+    const tmp_dir = "test_state_legacy";
+    defer std.fs.cwd().deleteTree(tmp_dir) catch {};
+
+    try std.fs.cwd().makePath(tmp_dir);
+    try std.fs.cwd().writeFile(.{
+        .sub_path = tmp_dir ++ "/mapping.json",
+        .data =
+        \\{
+        \\  "legacy-1": {"vmid": 4242, "created_at": 1700000000, "bundle_path": "/bundles/legacy-1", "extra": true},
+        \\  "legacy-2": {"vmid": 4243, "bundle_path": "/bundles/legacy\u002d2"}
+        \\}
+        ,
+    });
+
+    var manager = try vmid_manager.VmidManager.init(testing.allocator, null, tmp_dir);
+    defer manager.deinit();
+
+    try testing.expectEqual(@as(u32, 4242), try manager.getVmid("legacy-1"));
+    try testing.expectEqual(@as(u32, 4243), try manager.getVmid("legacy-2"));
+    try std.fs.cwd().access(tmp_dir ++ "/mapping.json.migrated", .{});
+}
+
 test "VmidManager removeMapping" {
     const tmp_dir = "test_state_remove";
     defer std.fs.cwd().deleteTree(tmp_dir) catch {};
@@ -0,0 +1,65 @@
+const std = @import("std");
+const testing = std.testing;
+const warm_pool = @import("warm_pool.zig");
+
+test "claim pops the oldest member of the matching template" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    var pool = warm_pool.WarmPool.init(testing.allocator, null, state_dir);
+    defer pool.deinit();
+
+    try pool.add("local:vztmpl/a.tar.zst", 200);
+    try pool.add("local:vztmpl/b.tar.zst", 201);
+    try pool.add("local:vztmpl/a.tar.zst", 202);
+    try testing.expectEqual(@as(usize, 2), try pool.count("local:vztmpl/a.tar.zst"));
+
+    try testing.expectEqual(@as(?u32, 200), try pool.claim("local:vztmpl/a.tar.zst"));
+    try testing.expectEqual(@as(?u32, 202), try pool.claim("local:vztmpl/a.tar.zst"));
+    try testing.expectEqual(@as(?u32, null), try pool.claim("local:vztmpl/a.tar.zst"));
+    try testing.expectEqual(@as(usize, 1), try pool.count("local:vztmpl/b.tar.zst"));
+}
+
+test "index is shared between pool instances" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    {
+        var pool = warm_pool.WarmPool.init(testing.allocator, null, state_dir);
+        defer pool.deinit();
+        try pool.add("local:vztmpl/a.tar.zst", 300);
+        try pool.add("local:vztmpl/a.tar.zst", 301);
+    }
+
+    var pool = warm_pool.WarmPool.init(testing.allocator, null, state_dir);
+    defer pool.deinit();
+    try testing.expect(try pool.remove(300));
+    try testing.expect(!try pool.remove(300));
+    const members = try pool.list();
+    try testing.expectEqual(@as(usize, 1), members.len);
+    try testing.expectEqual(@as(u32, 301), members[0].vmid);
+}
+
+test "only one refill holds the refill lock" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const state_dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(state_dir);
+
+    var pool = warm_pool.WarmPool.init(testing.allocator, null, state_dir);
+    defer pool.deinit();
+    const first = (try pool.tryLockRefill()).?;
+    try testing.expectEqual(@as(?std.fs.File, null), try pool.tryLockRefill());
+    first.close();
+    const again = (try pool.tryLockRefill()).?;
+    again.close();
+}
+
+test "warmHostname" {
+    var buf: [64]u8 = undefined;
+    try testing.expectEqualStrings("nexcage-warm-512", try warm_pool.warmHostname(&buf, 512));
+}
@@ -0,0 +1,28 @@
+const std = @import("std");
+const testing = std.testing;
+const cli = @import("cli");
+
+test "parseManifest reads ids and optional images" {
+    const manifest =
+        \\# CI sandboxes
+        \\ci-1 local:vztmpl/alpine.tar.zst
+        \\
+        \\ci-2
+        \\  ci-3	ubuntu:22.04  
+    ;
+    const items = try cli.batch.parseManifest(testing.allocator, manifest);
+    defer testing.allocator.free(items);
+
+    try testing.expectEqual(@as(usize, 3), items.len);
+    try testing.expectEqualStrings("ci-1", items[0].container_id);
+    try testing.expectEqualStrings("local:vztmpl/alpine.tar.zst", items[0].image.?);
+    try testing.expect(items[1].image == null);
+    try testing.expectEqualStrings("ci-3", items[2].container_id);
+    try testing.expectEqualStrings("ubuntu:22.04", items[2].image.?);
+}
+
+test "parseManifest empty input" {
+    const items = try cli.batch.parseManifest(testing.allocator, "\n# nothing\n");
+    defer testing.allocator.free(items);
+    try testing.expectEqual(@as(usize, 0), items.len);
+}
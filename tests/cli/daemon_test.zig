@@ -0,0 +1,143 @@
+const std = @import("std");
+const testing = std.testing;
+const cli = @import("cli");
+const daemon = cli.daemon;
+
+/// Echoes its arguments to stdout; "fail" makes it return an error
+fn echoHandler(ctx: *anyopaque, allocator: std.mem.Allocator, args: []const []const u8) anyerror!void {
+    _ = ctx;
+    _ = allocator;
+    const stdout = std.fs.File.stdout();
+    for (args) |arg| {
+        try stdout.writeAll(arg);
+        try stdout.writeAll("\n");
+    }
+    try std.fs.File.stderr().writeAll("note\n");
+    if (args.len > 0 and std.mem.eql(u8, args[0], "fail")) return error.Boom;
+}
+
+fn serveOnce(server: *daemon.Server) void {
+    server.serveOne();
+}
+
+const Fixture = struct {
+    tmp: testing.TmpDir,
+    socket_path: []u8,
+    server: daemon.Server,
+    ctx: u8 = 0,
+
+    fn init(self: *Fixture) !void {
+        self.tmp = testing.tmpDir(.{});
+        const root = try self.tmp.dir.realpathAlloc(testing.allocator, ".");
+        defer testing.allocator.free(root);
+        self.socket_path = try std.fmt.allocPrint(testing.allocator, "{s}/run/daemon.sock", .{root});
+        self.server = daemon.Server.init(testing.allocator, null, self.socket_path, &self.ctx, echoHandler);
+        try self.server.bind();
+    }
+
+    fn deinit(self: *Fixture) void {
+        self.server.deinit();
+        testing.allocator.free(self.socket_path);
+        self.tmp.cleanup();
+    }
+
+    /// Forward `args` to a server answering one request; output lands in tmp files
+    fn forward(self: *Fixture, args: []const []const u8, out: []u8, err_out: []u8) !struct { exit_code: ?u8, stdout: []const u8, stderr: []const u8 } {
+        const thread = try std.Thread.spawn(.{}, serveOnce, .{&self.server});
+        defer thread.join();
+
+        const stdout = try self.tmp.dir.createFile("stdout", .{ .read = true, .truncate = true });
+        defer stdout.close();
+        const stderr = try self.tmp.dir.createFile("stderr", .{ .read = true, .truncate = true });
+        defer stderr.close();
+
+        const exit_code = try daemon.forwardTo(testing.allocator, self.socket_path, args, stdout, stderr);
+        return .{
+            .exit_code = exit_code,
+            .stdout = out[0..try stdout.preadAll(out, 0)],
+            .stderr = err_out[0..try stderr.preadAll(err_out, 0)],
+        };
+    }
+};
+
+test "forward relays output and the exit code of a served command" {
+    var fixture: Fixture = undefined;
+    try fixture.init();
+    defer fixture.deinit();
+
+    var out: [256]u8 = undefined;
+    var err_out: [256]u8 = undefined;
+    const ok = try fixture.forward(&.{ "list", "--all" }, &out, &err_out);
+    try testing.expectEqual(@as(?u8, 0), ok.exit_code);
+    try testing.expectEqualStrings("list\n--all\n", ok.stdout);
+    try testing.expectEqualStrings("note\n", ok.stderr);
+
+    const failed = try fixture.forward(&.{"fail"}, &out, &err_out);
+    try testing.expectEqual(@as(?u8, 1), failed.exit_code);
+    try testing.expectEqualStrings("fail\n", failed.stdout);
+    try testing.expectEqualStrings("note\nerror: Boom\n", failed.stderr);
+}
+
+test "the socket is created owner-only" {
+    var fixture: Fixture = undefined;
+    try fixture.init();
+    defer fixture.deinit();
+
+    const stat = try std.posix.fstatat(std.posix.AT.FDCWD, fixture.socket_path, 0);
+    try testing.expectEqual(@as(u32, 0), stat.mode & 0o077);
+}
+
+test "forward falls back when no daemon is listening" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const root = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(root);
+    const socket_path = try std.fmt.allocPrint(testing.allocator, "{s}/missing.sock", .{root});
+    defer testing.allocator.free(socket_path);
+
+    try testing.expectEqual(@as(?u8, null), try daemon.forwardTo(testing.allocator, socket_path, &.{"list"}, std.fs.File.stdout(), std.fs.File.stderr()));
+}
+
+test "commands reading stdin or needing a terminal are not forwarded" {
+    try testing.expect(daemon.canForward(&.{ "create", "--name", "ci-1", "alpine" }));
+    try testing.expect(daemon.canForward(&.{ "create", "--batch", "jobs.txt" }));
+    try testing.expect(!daemon.canForward(&.{ "create", "--batch", "-" }));
+    try testing.expect(!daemon.canForward(&.{ "run", "-i", "alpine" }));
+    try testing.expect(!daemon.canForward(&.{ "run", "--tty", "alpine" }));
+}
+
+test "commands with logging flags are not forwarded" {
+    try testing.expect(!daemon.canForward(&.{ "--debug", "list" }));
+    try testing.expect(!daemon.canForward(&.{ "--log-level", "trace", "list" }));
+    try testing.expect(!daemon.canForward(&.{ "list", "--verbose" }));
+    try testing.expect(daemon.canForward(&.{ "--trace", "out.json", "list" }));
+}
+
+test "the daemon only serves clients with its own NEXCAGE_* environment" {
+    const own = try daemon.forwardedEnv(testing.allocator);
+    defer testing.allocator.free(own);
+    try testing.expect(daemon.envMatches(own));
+
+    const extra = try std.fmt.allocPrint(testing.allocator, "{s}NEXCAGE_TEST_ONLY_SETTING=1\x00", .{own});
+    defer testing.allocator.free(extra);
+    try testing.expect(!daemon.envMatches(extra));
+    try testing.expect(!daemon.envMatches("PATH=/tmp\x00"));
+}
+
+test "a client that would load another config.json runs locally" {
+    var fixture: Fixture = undefined;
+    try fixture.init();
+    defer fixture.deinit();
+
+    const own_cwd = try std.process.getCwdAlloc(testing.allocator);
+    defer testing.allocator.free(own_cwd);
+    try fixture.tmp.dir.writeFile(.{ .sub_path = "config.json", .data = "{}" });
+    try fixture.tmp.dir.setAsCwd();
+    defer std.posix.chdir(own_cwd) catch {};
+
+    var out: [256]u8 = undefined;
+    var err_out: [256]u8 = undefined;
+    const declined = try fixture.forward(&.{"list"}, &out, &err_out);
+    try testing.expectEqual(@as(?u8, null), declined.exit_code);
+    try testing.expectEqualStrings("", declined.stdout);
+}
@@ -0,0 +1,89 @@
+const std = @import("std");
+const testing = std.testing;
+const core = @import("core");
+const async_log = core.async_log;
+
+fn readAll(dir: std.fs.Dir, buf: []u8) ![]const u8 {
+    return dir.readFile("log", buf);
+}
+
+test "records from several threads all reach the file in one piece" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const file = try tmp.dir.createFile("log", .{});
+    defer file.close();
+
+    const sink = try async_log.AsyncSink.create(testing.allocator, file, .{ .capacity = 64, .overflow = .block });
+    const Producer = struct {
+        fn run(s: *async_log.AsyncSink, id: usize) void {
+            var buf: [64]u8 = undefined;
+            for (0..250) |i| {
+                s.write(std.fmt.bufPrint(&buf, "thread {d} record {d}\n", .{ id, i }) catch unreachable);
+            }
+        }
+    };
+    var threads: [4]std.Thread = undefined;
+    for (&threads, 0..) |*t, id| t.* = try std.Thread.spawn(.{}, Producer.run, .{ sink, id });
+    for (threads) |t| t.join();
+    sink.destroy();
+
+    var buf: [64 * 1024]u8 = undefined;
+    const data = try readAll(tmp.dir, &buf);
+    var lines: usize = 0;
+    var it = std.mem.splitScalar(u8, data, '\n');
+    while (it.next()) |line| {
+        if (line.len == 0) continue;
+        try testing.expect(std.mem.startsWith(u8, line, "thread "));
+        lines += 1;
+    }
+    try testing.expectEqual(@as(usize, 1000), lines);
+}
+
+test "flush waits until queued records are on disk" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const file = try tmp.dir.createFile("log", .{});
+    defer file.close();
+
+    const sink = try async_log.AsyncSink.create(testing.allocator, file, .{ .flush_interval_ms = 60_000 });
+    defer sink.destroy();
+    sink.write("first\n");
+    sink.write("second\n");
+    sink.flush();
+
+    var buf: [64]u8 = undefined;
+    try testing.expectEqualStrings("first\nsecond\n", try readAll(tmp.dir, &buf));
+}
+
+test "a full ring drops and counts instead of blocking" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const file = try tmp.dir.createFile("log", .{});
+    defer file.close();
+
+    const sink = try async_log.AsyncSink.create(testing.allocator, file, .{ .capacity = 4, .flush_interval_ms = 60_000 });
+    defer sink.destroy();
+    // Hold the drain lock so nothing frees a slot while the ring fills
+    while (sink.draining.swap(true, .acquire)) std.Thread.yield() catch {};
+    for (0..10) |_| sink.write("x\n");
+    try testing.expectEqual(@as(u64, 6), sink.droppedCount());
+    sink.draining.store(false, .release);
+}
+
+test "LogContext queues on its sink" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const file = try tmp.dir.createFile("log", .{});
+    defer file.close();
+
+    const sink = try async_log.AsyncSink.create(testing.allocator, file, .{});
+    defer sink.destroy();
+    var factory = core.logging.LoggerFactory.init(testing.allocator);
+    var logger = factory.createAsyncLogger(.info, "test", sink);
+    logger.timestamp = false;
+    try logger.info("queued {d}", .{1});
+    sink.flush();
+
+    var buf: [64]u8 = undefined;
+    try testing.expectEqualStrings("INFO  test: queued 1\n", try readAll(tmp.dir, &buf));
+}
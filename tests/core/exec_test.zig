@@ -0,0 +1,168 @@
+const std = @import("std");
+const testing = std.testing;
+const core = @import("core");
+const exec = core.exec;
+
+test "run drains both pipes without deadlocking" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    // Far more than a pipe buffer on each stream
+    var result = try executor.run(testing.allocator, &.{
+        "sh", "-c", "head -c 300000 /dev/zero >&2; head -c 200000 /dev/zero; exit 3",
+    }, .{});
+    defer result.deinit(testing.allocator);
+
+    try testing.expectEqual(exec.Status.exited, result.status);
+    try testing.expectEqual(@as(u8, 3), result.exit_code);
+    try testing.expectEqual(@as(usize, 200000), result.stdout.len);
+    try testing.expectEqual(@as(usize, 300000), result.stderr.len);
+}
+
+test "run kills commands past their deadline" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    var result = try executor.run(testing.allocator, &.{ "sleep", "30" }, .{ .timeout_ms = 100 });
+    defer result.deinit(testing.allocator);
+
+    try testing.expectEqual(exec.Status.timed_out, result.status);
+    try testing.expectEqual(@as(u8, 124), result.exit_code);
+    try testing.expect(result.duration_ns < 10 * std.time.ns_per_s);
+}
+
+test "run enforces the output cap" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    try testing.expectError(error.StreamTooLong, executor.run(testing.allocator, &.{ "head", "-c", "4096", "/dev/zero" }, .{ .max_output_bytes = 1024 }));
+}
+
+test "runAll keeps results in command order" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    const results = try executor.runAll(testing.allocator, &.{
+        .{ .argv = &.{ "sh", "-c", "sleep 0.2; echo first" } },
+        .{ .argv = &.{ "echo", "second" } },
+        .{ .argv = &.{ "false" } },
+    }, .{});
+    defer {
+        for (results) |*result| result.deinit(testing.allocator);
+        testing.allocator.free(results);
+    }
+
+    try testing.expectEqualStrings("first\n", results[0].stdout);
+    try testing.expectEqualStrings("second\n", results[1].stdout);
+    try testing.expectEqual(@as(u8, 1), results[2].exit_code);
+}
+
+test "sinks see output as it arrives" {
+    const Collector = struct {
+        data: std.ArrayListUnmanaged(u8) = .{},
+
+        fn write(context: *anyopaque, index: usize, chunk: []const u8) void {
+            _ = index;
+            const self: *@This() = @ptrCast(@alignCast(context));
+            self.data.appendSlice(testing.allocator, chunk) catch {};
+        }
+    };
+    var collector = Collector{};
+    defer collector.data.deinit(testing.allocator);
+
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    var result = try executor.run(testing.allocator, &.{ "echo", "streamed" }, .{
+        .on_stdout = .{ .context = &collector, .write = Collector.write },
+    });
+    defer result.deinit(testing.allocator);
+
+    try testing.expectEqualStrings("streamed\n", collector.data.items);
+}
+
+test "every run lands in its command's histogram" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    for (0..3) |_| {
+        var result = try executor.run(testing.allocator, &.{ "sh", "-c", "exit 0" }, .{});
+        result.deinit(testing.allocator);
+    }
+    var failed = try executor.run(testing.allocator, &.{"false"}, .{});
+    failed.deinit(testing.allocator);
+
+    const sh = executor.histogram("sh") orelse return error.TestUnexpectedResult;
+    try testing.expectEqual(@as(u64, 3), sh.count);
+    try testing.expectEqual(@as(u64, 0), sh.failures);
+    const f = executor.histogram("false") orelse return error.TestUnexpectedResult;
+    try testing.expectEqual(@as(u64, 1), f.failures);
+
+    var buf: [1024]u8 = undefined;
+    var writer = std.Io.Writer.fixed(&buf);
+    try executor.writeReport(&writer);
+    try testing.expect(std.mem.indexOf(u8, writer.buffered(), "sh: count=3") != null);
+}
+
+test "spawnDetached runs the command and reaps it on the next call" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const dir = try tmp.dir.realpathAlloc(testing.allocator, ".");
+    defer testing.allocator.free(dir);
+    const script = try std.fmt.allocPrint(testing.allocator, "echo noise; touch {s}/ran", .{dir});
+    defer testing.allocator.free(script);
+
+    try executor.spawnDetached(testing.allocator, &.{ "sh", "-c", script });
+    var waited: usize = 0;
+    while (true) : (waited += 1) {
+        tmp.dir.access("ran", .{}) catch {
+            if (waited == 100) return error.TestUnexpectedResult;
+            std.Thread.sleep(20 * std.time.ns_per_ms);
+            continue;
+        };
+        break;
+    }
+    std.Thread.sleep(100 * std.time.ns_per_ms);
+
+    try executor.spawnDetached(testing.allocator, &.{"true"});
+    try testing.expectEqual(@as(usize, 1), executor.detached.items.len);
+}
+
+const Producer = struct {
+    fn produce(context: *anyopaque, writer: *std.Io.Writer) anyerror!void {
+        _ = context;
+        // More than a pipe buffer, so the feeder and the drain loop must interleave
+        for (0..4096) |_| try writer.writeAll("0123456789abcdef0123456789abcdef");
+    }
+};
+
+const Counter = struct {
+    bytes: usize = 0,
+
+    fn write(context: *anyopaque, index: usize, chunk: []const u8) void {
+        _ = index;
+        const self: *Counter = @ptrCast(@alignCast(context));
+        self.bytes += chunk.len;
+    }
+};
+
+test "stdin sources stream through a filter without retaining stdout" {
+    var executor = exec.Executor.init(testing.allocator);
+    defer executor.deinit();
+
+    var dummy: u8 = 0;
+    var counter = Counter{};
+    var result = try executor.run(testing.allocator, &.{"cat"}, .{
+        .stdin = .{ .context = &dummy, .produce = Producer.produce },
+        .on_stdout = .{ .context = &counter, .write = Counter.write },
+        .retain_stdout = false,
+    });
+    defer result.deinit(testing.allocator);
+
+    try testing.expectEqual(@as(u8, 0), result.exit_code);
+    try testing.expectEqual(@as(usize, 4096 * 32), counter.bytes);
+    try testing.expectEqual(@as(usize, 0), result.stdout.len);
+}
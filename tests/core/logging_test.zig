@@ -0,0 +1,50 @@
+const std = @import("std");
+const testing = std.testing;
+const core = @import("core");
+
+fn testLogger(file: std.fs.File, level: core.LogLevel) core.LogContext {
+    var empty_buffer: [0]u8 = undefined;
+    var logger = core.LogContext.init(testing.allocator, file.writer(&empty_buffer), level, "test");
+    logger.file = file;
+    logger.timestamp = false;
+    logger.colorize = false;
+    return logger;
+}
+
+test "enabled honours the runtime threshold" {
+    const logger = testLogger(std.fs.File.stdout(), .warn);
+    try testing.expect(!logger.enabled(.info));
+    try testing.expect(logger.enabled(.warn));
+    try testing.expect(logger.enabled(.@"error"));
+}
+
+test "log writes exactly the formatted line" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const file = try tmp.dir.createFile("log", .{ .read = true });
+    defer file.close();
+
+    var logger = testLogger(file, .info);
+    try logger.debug("hidden {d}", .{1});
+    try logger.info("created {s} (vmid {d})", .{ "web-1", 101 });
+
+    var buf: [256]u8 = undefined;
+    const n = try file.preadAll(&buf, 0);
+    try testing.expectEqualStrings("INFO  test: created web-1 (vmid 101)\n", buf[0..n]);
+}
+
+test "oversized messages are truncated, not allocated" {
+    var tmp = testing.tmpDir(.{});
+    defer tmp.cleanup();
+    const file = try tmp.dir.createFile("log", .{ .read = true });
+    defer file.close();
+
+    var logger = testLogger(file, .info);
+    const long = [_]u8{'x'} ** 8192;
+    try logger.info("{s}", .{&long});
+
+    var buf: [16 * 1024]u8 = undefined;
+    const n = try file.preadAll(&buf, 0);
+    try testing.expect(n < long.len);
+    try testing.expect(std.mem.endsWith(u8, buf[0..n], "...\n"));
+}
@@ -0,0 +1,90 @@
+const std = @import("std");
+const testing = std.testing;
+const core = @import("core");
+const metrics = core.metrics;
+
+fn exposition(registry: *metrics.MetricsRegistry, buf: []u8) ![]const u8 {
+    var writer = std.Io.Writer.fixed(buf);
+    try registry.exportMetrics(&writer);
+    return writer.buffered();
+}
+
+test "histogram fills cumulative buckets, sum and count" {
+    var registry = metrics.MetricsRegistry.init(testing.allocator);
+    defer registry.deinit();
+
+    const family = try registry.histogram("op_seconds", "Op time", &.{"op"}, &.{ 0.1, 1 });
+    const h = try family.with(&.{"create"});
+    h.observe(0.0625);
+    h.observe(0.5);
+    h.observe(3);
+
+    var buf: [1024]u8 = undefined;
+    try testing.expectEqualStrings(
+        \\# HELP op_seconds Op time
+        \\# TYPE op_seconds histogram
+        \\op_seconds_bucket{op="create",le="0.1"} 1
+        \\op_seconds_bucket{op="create",le="1"} 2
+        \\op_seconds_bucket{op="create",le="+Inf"} 3
+        \\op_seconds_sum{op="create"} 3.5625
+        \\op_seconds_count{op="create"} 3
+        \\
+    , try exposition(&registry, &buf));
+}
+
+test "with returns the same handle for the same labels" {
+    var registry = metrics.MetricsRegistry.init(testing.allocator);
+    defer registry.deinit();
+
+    const family = try registry.counter("ops_total", "Ops", &.{ "backend", "result" });
+    const a = try family.with(&.{ "lxc", "ok" });
+    const b = try family.with(&.{ "lxc", "ok" });
+    const c = try family.with(&.{ "lxc", "error" });
+    try testing.expect(a == b);
+    try testing.expect(a != c);
+    try testing.expectError(error.LabelMismatch, family.with(&.{"lxc"}));
+
+    // Registering again hands back the existing family; a new type is refused
+    try testing.expect(family == try registry.counter("ops_total", "Ops", &.{ "backend", "result" }));
+    try testing.expectError(error.MetricTypeMismatch, registry.gauge("ops_total", "Ops", &.{}));
+}
+
+test "counters stay exact under concurrent increments" {
+    var registry = metrics.MetricsRegistry.init(testing.allocator);
+    defer registry.deinit();
+
+    const counter = try (try registry.counter("hits_total", "Hits", &.{})).with(&.{});
+    const Worker = struct {
+        fn run(c: *metrics.Counter) void {
+            for (0..10_000) |_| c.inc();
+        }
+    };
+    var threads: [4]std.Thread = undefined;
+    for (&threads) |*t| t.* = try std.Thread.spawn(.{}, Worker.run, .{counter});
+    for (threads) |t| t.join();
+    try testing.expectEqual(@as(f64, 40_000), counter.get());
+}
+
+test "summary reports quantiles over its window" {
+    var registry = metrics.MetricsRegistry.init(testing.allocator);
+    defer registry.deinit();
+
+    const s = try (try registry.summary("latency", "Latency", &.{}, &metrics.DEFAULT_QUANTILES)).with(&.{});
+    try testing.expect(std.math.isNan(s.quantile(0.5)));
+    for (1..101) |i| s.observe(@floatFromInt(i));
+    try testing.expectEqual(@as(f64, 50), s.quantile(0.5));
+    try testing.expectEqual(@as(f64, 99), s.quantile(0.99));
+    try testing.expectEqual(@as(u64, 100), s.getCount());
+}
+
+test "label values are escaped" {
+    var registry = metrics.MetricsRegistry.init(testing.allocator);
+    defer registry.deinit();
+
+    const g = try (try registry.gauge("pool", "Pool", &.{"name"})).with(&.{"a\"b\\c"});
+    g.set(2);
+
+    var buf: [256]u8 = undefined;
+    const text = try exposition(&registry, &buf);
+    try testing.expect(std.mem.indexOf(u8, text, "pool{name=\"a\\\"b\\\\c\"} 2\n") != null);
+}
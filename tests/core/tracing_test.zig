@@ -0,0 +1,80 @@
+const std = @import("std");
+const testing = std.testing;
+const core = @import("core");
+const tracing = core.tracing;
+
+test "begin is a no-op without an installed tracer" {
+    tracing.install(null);
+    const span = tracing.begin("ignored");
+    try testing.expect(span.tracer == null);
+    span.end();
+}
+
+test "spans nest under the innermost open span" {
+    var tracer = try tracing.Tracer.init(testing.allocator);
+    defer tracer.deinit();
+    tracing.install(&tracer);
+    defer tracing.install(null);
+
+    const root = tracing.begin("create");
+    const parse = tracing.begin("create.bundle_parse");
+    parse.end();
+    const pct = tracing.begin("pct create");
+    pct.end();
+    root.end();
+    const next = tracing.begin("start");
+    next.end();
+
+    const spans = tracer.spans.items;
+    try testing.expectEqual(@as(usize, 4), spans.len);
+    try testing.expectEqual(@as(u32, 0), spans[0].parent);
+    try testing.expectEqual(spans[0].id, spans[1].parent);
+    try testing.expectEqual(spans[0].id, spans[2].parent);
+    try testing.expectEqual(@as(u32, 0), spans[3].parent);
+    for (spans) |span| try testing.expect(span.end_ns >= span.start_ns and span.end_ns > 0);
+    try testing.expect(spans[0].end_ns >= spans[2].end_ns);
+}
+
+test "chrome export holds complete events for finished spans only" {
+    var tracer = try tracing.Tracer.init(testing.allocator);
+    defer tracer.deinit();
+
+    const done = tracer.begin("create \"quoted\"");
+    done.end();
+    const running = tracer.begin("still running");
+    defer running.end();
+
+    var out = std.Io.Writer.Allocating.init(testing.allocator);
+    defer out.deinit();
+    try tracer.writeChrome(&out.writer);
+
+    const parsed = try std.json.parseFromSlice(std.json.Value, testing.allocator, out.written(), .{});
+    defer parsed.deinit();
+    const events = parsed.value.object.get("traceEvents").?.array.items;
+    try testing.expectEqual(@as(usize, 1), events.len);
+    try testing.expectEqualStrings("create \"quoted\"", events[0].object.get("name").?.string);
+    try testing.expectEqualStrings("X", events[0].object.get("ph").?.string);
+}
+
+test "otlp export links children to their parent span" {
+    var tracer = try tracing.Tracer.init(testing.allocator);
+    defer tracer.deinit();
+
+    const root = tracer.begin("create");
+    const child = tracer.begin("create.dataset");
+    child.end();
+    root.end();
+
+    var out = std.Io.Writer.Allocating.init(testing.allocator);
+    defer out.deinit();
+    try tracer.writeOtlp(&out.writer);
+
+    const parsed = try std.json.parseFromSlice(std.json.Value, testing.allocator, out.written(), .{});
+    defer parsed.deinit();
+    const scope = parsed.value.object.get("resourceSpans").?.array.items[0].object.get("scopeSpans").?.array.items[0];
+    const spans = scope.object.get("spans").?.array.items;
+    try testing.expectEqual(@as(usize, 2), spans.len);
+    try testing.expect(spans[0].object.get("parentSpanId") == null);
+    try testing.expectEqualStrings(spans[0].object.get("spanId").?.string, spans[1].object.get("parentSpanId").?.string);
+    try testing.expectEqual(@as(usize, 32), spans[0].object.get("traceId").?.string.len);
+}
@@ -0,0 +1,199 @@
+const std = @import("std");
+const testing = std.testing;
+const client = @import("client.zig");
+
+const REPLY = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 10\r\n\r\n{\"data\":1}";
+
+/// Plain-HTTP keep-alive server answering every request with `REPLY`
+const Stub = struct {
+    server: std.net.Server,
+    /// Close the first connection after reading its request, without replying
+    drop_first: bool = false,
+    /// Close every connection after its first reply, as pveproxy does to idle ones
+    close_after_reply: bool = false,
+    delay_ms: u64 = 0,
+    connections: std.atomic.Value(u32) = .init(0),
+    requests: std.atomic.Value(u32) = .init(0),
+    active: std.atomic.Value(u32) = .init(0),
+    max_active: std.atomic.Value(u32) = .init(0),
+    stopping: std.atomic.Value(bool) = .init(false),
+    handlers: [16]std.Thread = undefined,
+    handler_count: usize = 0,
+    acceptor: ?std.Thread = null,
+
+    fn start(self: *Stub) !void {
+        self.server = try (try std.net.Address.parseIp("127.0.0.1", 0)).listen(.{});
+        self.acceptor = try std.Thread.spawn(.{}, accept, .{self});
+    }
+
+    fn port(self: *const Stub) u16 {
+        return self.server.listen_address.getPort();
+    }
+
+    /// Call after the client is gone, so every handler sees its connection close
+    fn stop(self: *Stub) void {
+        self.stopping.store(true, .release);
+        // Wake the blocked accept
+        if (std.net.tcpConnectToAddress(self.server.listen_address)) |stream| stream.close() else |_| {}
+        if (self.acceptor) |t| t.join();
+        for (self.handlers[0..self.handler_count]) |t| t.join();
+        self.server.deinit();
+    }
+
+    fn accept(self: *Stub) void {
+        while (true) {
+            const conn = self.server.accept() catch return;
+            if (self.stopping.load(.acquire) or self.handler_count == self.handlers.len) {
+                conn.stream.close();
+                return;
+            }
+            const first = self.connections.fetchAdd(1, .monotonic) == 0;
+            self.handlers[self.handler_count] = std.Thread.spawn(.{}, handle, .{ self, conn.stream, first }) catch {
+                conn.stream.close();
+                continue;
+            };
+            self.handler_count += 1;
+        }
+    }
+
+    fn handle(self: *Stub, stream: std.net.Stream, first: bool) void {
+        defer stream.close();
+        var buf: [8192]u8 = undefined;
+        var len: usize = 0;
+        while (true) {
+            const end = readRequest(stream, &buf, &len) orelse return;
+            _ = self.requests.fetchAdd(1, .monotonic);
+            if (first and self.drop_first) return;
+
+            const active = self.active.fetchAdd(1, .monotonic) + 1;
+            _ = self.max_active.fetchMax(active, .monotonic);
+            if (self.delay_ms > 0) std.Thread.sleep(self.delay_ms * std.time.ns_per_ms);
+            _ = self.active.fetchSub(1, .monotonic);
+
+            stream.writeAll(REPLY) catch return;
+            if (self.close_after_reply) return;
+            std.mem.copyForwards(u8, buf[0 .. len - end], buf[end..len]);
+            len -= end;
+        }
+    }
+
+    /// Length of the first complete request in `buf`, reading more as needed;
+    /// null once the peer closes
+    fn readRequest(stream: std.net.Stream, buf: []u8, len: *usize) ?usize {
+        while (true) {
+            if (std.mem.indexOf(u8, buf[0..len.*], "\r\n\r\n")) |head_end| {
+                const body_len = contentLength(buf[0..head_end]);
+                const total = head_end + 4 + body_len;
+                if (len.* >= total) return total;
+            }
+            if (len.* == buf.len) return null;
+            const n = stream.read(buf[len.*..]) catch return null;
+            if (n == 0) return null;
+            len.* += n;
+        }
+    }
+
+    fn contentLength(head: []const u8) usize {
+        var lines = std.mem.splitSequence(u8, head, "\r\n");
+        while (lines.next()) |line| {
+            const colon = std.mem.indexOfScalar(u8, line, ':') orelse continue;
+            if (!std.ascii.eqlIgnoreCase(line[0..colon], "content-length")) continue;
+            return std.fmt.parseInt(usize, std.mem.trim(u8, line[colon + 1 ..], " "), 10) catch 0;
+        }
+        return 0;
+    }
+};
+
+fn initClient(stub: *const Stub, max_in_flight: usize) !*client.ProxmoxApiClient {
+    return client.ProxmoxApiClient.init(testing.allocator, .{
+        .allocator = testing.allocator,
+        .host = "127.0.0.1",
+        .port = stub.port(),
+        .token = "root@pam!ci=secret",
+        .node = "pve1",
+        .scheme = "http",
+        .max_in_flight = max_in_flight,
+    });
+}
+
+fn getOne(api: *client.ProxmoxApiClient) !u32 {
+    var arena = std.heap.ArenaAllocator.init(testing.allocator);
+    defer arena.deinit();
+    return api.get(u32, arena.allocator(), "/version");
+}
+
+fn getInThread(api: *client.ProxmoxApiClient, failed: *std.atomic.Value(bool)) void {
+    _ = getOne(api) catch failed.store(true, .monotonic);
+}
+
+test "sequential requests reuse one keep-alive connection" {
+    var stub = Stub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub, 16);
+    defer api.deinit();
+
+    for (0..3) |_| try testing.expectEqual(@as(u32, 1), try getOne(api));
+    try testing.expectEqual(@as(u32, 3), stub.requests.load(.monotonic));
+    try testing.expectEqual(@as(u32, 1), stub.connections.load(.monotonic));
+}
+
+test "max_in_flight caps concurrent requests" {
+    var stub = Stub{ .server = undefined, .delay_ms = 50 };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub, 2);
+    defer api.deinit();
+
+    var failed = std.atomic.Value(bool).init(false);
+    var threads: [6]std.Thread = undefined;
+    for (&threads) |*t| t.* = try std.Thread.spawn(.{}, getInThread, .{ api, &failed });
+    for (threads) |t| t.join();
+
+    try testing.expect(!failed.load(.monotonic));
+    try testing.expectEqual(@as(u32, 6), stub.requests.load(.monotonic));
+    try testing.expect(stub.max_active.load(.monotonic) <= 2);
+}
+
+test "a GET that lost its reply is sent again" {
+    var stub = Stub{ .server = undefined, .drop_first = true };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub, 16);
+    defer api.deinit();
+
+    try testing.expectEqual(@as(u32, 1), try getOne(api));
+    try testing.expectEqual(@as(u32, 2), stub.requests.load(.monotonic));
+}
+
+test "a POST that reached the server is never sent twice" {
+    var stub = Stub{ .server = undefined, .drop_first = true };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub, 16);
+    defer api.deinit();
+
+    if (api.makeRequestWithContentType(.POST, "/nodes/pve1/lxc", "vmid=101", "application/x-www-form-urlencoded")) |response| {
+        var unexpected = response;
+        unexpected.deinit();
+        return error.TestUnexpectedResult;
+    } else |_| {}
+    try testing.expectEqual(@as(u32, 1), stub.requests.load(.monotonic));
+}
+
+test "a POST after the server closed the pooled connection goes out on a fresh one" {
+    var stub = Stub{ .server = undefined, .close_after_reply = true };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub, 16);
+    defer api.deinit();
+
+    // Leaves a pooled connection behind that the server has closed
+    try testing.expectEqual(@as(u32, 1), try getOne(api));
+
+    var response = try api.makeRequestWithContentType(.POST, "/nodes/pve1/lxc", "vmid=101", "application/x-www-form-urlencoded");
+    defer response.deinit();
+    try testing.expect(response.success);
+    try testing.expectEqual(@as(u32, 2), stub.requests.load(.monotonic));
+    try testing.expectEqual(@as(u32, 2), stub.connections.load(.monotonic));
+}
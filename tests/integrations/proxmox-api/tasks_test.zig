@@ -0,0 +1,236 @@
+const std = @import("std");
+const testing = std.testing;
+const client = @import("client.zig");
+const tasks = @import("tasks.zig");
+
+const RUNNING = "{\"data\":{\"status\":\"running\"}}";
+const STOPPED_OK = "{\"data\":{\"status\":\"stopped\",\"exitstatus\":\"OK\"}}";
+const STOPPED_FAILED = "{\"data\":{\"status\":\"stopped\",\"exitstatus\":\"startup for container '101' failed\"}}";
+
+/// How a stubbed task behaves, picked by the last field of its UPID
+const Script = enum {
+    /// Running on the first poll, stopped with OK on the next
+    ok,
+    /// Stopped with an error line on the first poll
+    fail,
+    /// Never stops
+    hang,
+};
+
+/// Plain-HTTP keep-alive server playing Proxmox's task status endpoint
+const Stub = struct {
+    server: std.net.Server,
+    polls: [3]std.atomic.Value(u32) = .{ .init(0), .init(0), .init(0) },
+    stopping: std.atomic.Value(bool) = .init(false),
+    handlers: [16]std.Thread = undefined,
+    handler_count: usize = 0,
+    acceptor: ?std.Thread = null,
+
+    fn start(self: *Stub) !void {
+        self.server = try (try std.net.Address.parseIp("127.0.0.1", 0)).listen(.{});
+        self.acceptor = try std.Thread.spawn(.{}, accept, .{self});
+    }
+
+    fn port(self: *const Stub) u16 {
+        return self.server.listen_address.getPort();
+    }
+
+    fn pollsOf(self: *Stub, script: Script) u32 {
+        return self.polls[@intFromEnum(script)].load(.monotonic);
+    }
+
+    /// Call after the client is gone, so every handler sees its connection close
+    fn stop(self: *Stub) void {
+        self.stopping.store(true, .release);
+        // Wake the blocked accept
+        if (std.net.tcpConnectToAddress(self.server.listen_address)) |stream| stream.close() else |_| {}
+        if (self.acceptor) |t| t.join();
+        for (self.handlers[0..self.handler_count]) |t| t.join();
+        self.server.deinit();
+    }
+
+    fn accept(self: *Stub) void {
+        while (true) {
+            const conn = self.server.accept() catch return;
+            if (self.stopping.load(.acquire) or self.handler_count == self.handlers.len) {
+                conn.stream.close();
+                return;
+            }
+            self.handlers[self.handler_count] = std.Thread.spawn(.{}, handle, .{ self, conn.stream }) catch {
+                conn.stream.close();
+                continue;
+            };
+            self.handler_count += 1;
+        }
+    }
+
+    fn handle(self: *Stub, stream: std.net.Stream) void {
+        defer stream.close();
+        var buf: [8192]u8 = undefined;
+        var len: usize = 0;
+        while (true) {
+            const end = readRequest(stream, &buf, &len) orelse return;
+            const body = self.reply(buf[0..end]);
+            var head_buf: [128]u8 = undefined;
+            const head = std.fmt.bufPrint(&head_buf, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {d}\r\n\r\n", .{body.len}) catch return;
+            stream.writeAll(head) catch return;
+            stream.writeAll(body) catch return;
+            std.mem.copyForwards(u8, buf[0 .. len - end], buf[end..len]);
+            len -= end;
+        }
+    }
+
+    fn reply(self: *Stub, request: []const u8) []const u8 {
+        const script = std.meta.stringToEnum(Script, taskScript(request) orelse return "{\"data\":null}") orelse return "{\"data\":null}";
+        const polls = self.polls[@intFromEnum(script)].fetchAdd(1, .monotonic) + 1;
+        return switch (script) {
+            .ok => if (polls < 2) RUNNING else STOPPED_OK,
+            .fail => STOPPED_FAILED,
+            .hang => RUNNING,
+        };
+    }
+
+    /// Last UPID field of a `GET .../tasks/<escaped upid>/status` request
+    fn taskScript(request: []const u8) ?[]const u8 {
+        const line = request[0 .. std.mem.indexOf(u8, request, "\r\n") orelse return null];
+        const upid = line[0 .. std.mem.indexOf(u8, line, "/status ") orelse return null];
+        const colon = std.mem.lastIndexOf(u8, upid, "%3A") orelse return null;
+        return upid[colon + 3 ..];
+    }
+
+    /// Length of the first complete request in `buf`, reading more as needed;
+    /// null once the peer closes
+    fn readRequest(stream: std.net.Stream, buf: []u8, len: *usize) ?usize {
+        while (true) {
+            if (std.mem.indexOf(u8, buf[0..len.*], "\r\n\r\n")) |head_end| {
+                if (len.* >= head_end + 4) return head_end + 4;
+            }
+            if (len.* == buf.len) return null;
+            const n = stream.read(buf[len.*..]) catch return null;
+            if (n == 0) return null;
+            len.* += n;
+        }
+    }
+};
+
+fn initClient(stub: *const Stub) !*client.ProxmoxApiClient {
+    return client.ProxmoxApiClient.init(testing.allocator, .{
+        .allocator = testing.allocator,
+        .host = "127.0.0.1",
+        .port = stub.port(),
+        .token = "root@pam!ci=secret",
+        .node = "pve1",
+        .scheme = "http",
+    });
+}
+
+/// Labels of finished tasks, in the order `wait` reported them
+const Done = struct {
+    labels: [4][]const u8 = undefined,
+    count: usize = 0,
+
+    fn record(ctx: ?*anyopaque, task: *const tasks.Task) void {
+        const self: *Done = @ptrCast(@alignCast(ctx.?));
+        self.labels[self.count] = task.label;
+        self.count += 1;
+    }
+};
+
+const FAST = tasks.Options{ .initial_interval_ms = 1, .max_interval_ms = 4, .timeout_ms = 30 };
+
+test "a running task is re-polled with backoff until it stops OK" {
+    var stub = Stub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub);
+    defer api.deinit();
+
+    var tracker = tasks.TaskTracker.init(testing.allocator, api, FAST);
+    defer tracker.deinit();
+    try tracker.track("UPID:pve1:0000A001:ok", "101");
+    var done = Done{};
+    tracker.wait(&done, Done.record);
+
+    const task = tracker.tasks.items[0];
+    try testing.expectEqual(tasks.Outcome.ok, task.outcome);
+    try testing.expectEqualStrings("OK", task.exit_status.?);
+    // Doubled once after the running poll
+    try testing.expectEqual(@as(u32, 2), task.interval_ms);
+    try testing.expectEqual(@as(u32, 2), stub.pollsOf(.ok));
+    try testing.expectEqual(@as(usize, 1), done.count);
+    try testing.expect(tracker.allOk());
+}
+
+test "a non-OK exitstatus fails the task" {
+    var stub = Stub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub);
+    defer api.deinit();
+
+    var tracker = tasks.TaskTracker.init(testing.allocator, api, FAST);
+    defer tracker.deinit();
+    try tracker.track("UPID:pve1:0000A002:fail", "101");
+    tracker.wait(null, null);
+
+    const task = tracker.tasks.items[0];
+    try testing.expectEqual(tasks.Outcome.failed, task.outcome);
+    try testing.expectEqualStrings("startup for container '101' failed", task.exit_status.?);
+    try testing.expectEqual(@as(u32, 1), stub.pollsOf(.fail));
+    try testing.expect(!tracker.allOk());
+}
+
+test "a task still running at the deadline times out" {
+    var stub = Stub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub);
+    defer api.deinit();
+
+    var tracker = tasks.TaskTracker.init(testing.allocator, api, FAST);
+    defer tracker.deinit();
+    try tracker.track("UPID:pve1:0000A003:hang", "101");
+    tracker.wait(null, null);
+
+    const task = tracker.tasks.items[0];
+    try testing.expectEqual(tasks.Outcome.timed_out, task.outcome);
+    try testing.expect(task.exit_status == null);
+    // Backoff stops growing at max_interval_ms
+    try testing.expectEqual(FAST.max_interval_ms, task.interval_ms);
+    try testing.expect(stub.pollsOf(.hang) >= 3);
+}
+
+test "every task is reported once, as it ends" {
+    var stub = Stub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub);
+    defer api.deinit();
+
+    var tracker = tasks.TaskTracker.init(testing.allocator, api, FAST);
+    defer tracker.deinit();
+    try tracker.track("UPID:pve1:0000A004:ok", "slow");
+    try tracker.track("UPID:pve1:0000A005:fail", "fast");
+    try tracker.track("UPID:pve1:0000A006:hang", "stuck");
+    var done = Done{};
+    tracker.wait(&done, Done.record);
+
+    try testing.expectEqual(@as(usize, 3), done.count);
+    try testing.expectEqualStrings("fast", done.labels[0]);
+    try testing.expectEqualStrings("slow", done.labels[1]);
+    try testing.expectEqualStrings("stuck", done.labels[2]);
+}
+
+test "UPIDs without a node are refused" {
+    var stub = Stub{ .server = undefined };
+    try stub.start();
+    defer stub.stop();
+    const api = try initClient(&stub);
+    defer api.deinit();
+
+    var tracker = tasks.TaskTracker.init(testing.allocator, api, FAST);
+    defer tracker.deinit();
+    try testing.expectError(error.InvalidResponse, tracker.track("UPID::0000A007:ok", "101"));
+    try testing.expectError(error.InvalidResponse, tracker.track("101", "101"));
+    try testing.expectEqual(@as(usize, 0), tracker.tasks.items.len);
+}